@@ -0,0 +1,45 @@
+##########################################################################
+# Benchmark.pro
+#
+# QXlsx  # MIT License # https://github.com/j2doll/QXlsx
+# QtXlsx # https://github.com/dbzhang800/QtXlsxWriter # http://qtxlsx.debao.me/ # MIT License
+
+TARGET = Benchmark
+TEMPLATE = app
+
+QT += core
+
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+##########################################################################
+# NOTE: You can fix value of QXlsx path of source code.
+#  QXLSX_PARENTPATH=./
+#  QXLSX_HEADERPATH=./header/
+#  QXLSX_SOURCEPATH=./source/
+include(../QXlsx/QXlsx.pri)
+
+SOURCES += main.cpp \
+    savebenchmark.cpp \
+    formulabenchmark.cpp \
+    calcbenchmark.cpp \
+    parallelcalcbenchmark.cpp \
+    aggregatebenchmark.cpp \
+    validatebenchmark.cpp \
+    csvbenchmark.cpp \
+    csvimportbenchmark.cpp \
+    htmlbenchmark.cpp \
+    arrowbenchmark.cpp \
+    modelbenchmark.cpp \
+    codecbenchmark.cpp
+
+HEADERS += benchmark.h
+
+# SqliteImporter is only built when the Qt SQL module is there
+qtHaveModule(sql) {
+    QT += sql
+    DEFINES += QXLSX_HAVE_SQL
+    SOURCES += sqlitebenchmark.cpp
+}
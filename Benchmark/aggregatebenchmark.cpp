@@ -0,0 +1,61 @@
+// aggregatebenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Sum of a column of numbers, through Worksheet::aggregate() and
+// through a SUM() formula.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet.h"
+#include "xlsxcell.h"
+#include "xlsxcellrange.h"
+#include "xlsxcellformula.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int aggregateBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 1000000;
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    for (int row = 1; row <= rows; ++row)
+        sheet->writeNumeric(row, 1, row * 0.5);
+
+    const CellRange range(1, 1, rows, 1);
+    QElapsedTimer timer;
+    timer.start();
+    QVariant first = sheet->aggregate(range, Worksheet::AO_Sum);
+    qint64 firstElapsed = timer.nsecsElapsed();
+
+    timer.restart();
+    QVariant again = sheet->aggregate(range, Worksheet::AO_Sum);
+    qint64 againElapsed = timer.nsecsElapsed();
+
+    // The formula reads the numbers gathered above; one changed cell
+    // gathers its column again.
+    sheet->writeFormula(1, 2, CellFormula(QString("SUM(A1:A%1)").arg(rows)));
+    timer.restart();
+    xlsx.workbook()->recalculate();
+    qint64 formulaElapsed = timer.nsecsElapsed();
+
+    sheet->writeNumeric(rows / 2, 1, 0);
+    timer.restart();
+    xlsx.workbook()->recalculate();
+    qint64 changedElapsed = timer.nsecsElapsed();
+
+    cout << "first sum: " << first.toDouble() << ", " << firstElapsed / 1000000.0 << " ms" << endl
+         << "cached sum: " << again.toDouble() << ", " << againElapsed / 1000000.0 << " ms" << endl
+         << "SUM formula: " << formulaElapsed / 1000000.0 << " ms" << endl
+         << "SUM formula after a change: " << xlsx.cellAt(1, 2)->value().toDouble()
+         << ", " << changedElapsed / 1000000.0 << " ms" << endl;
+    return 0;
+}
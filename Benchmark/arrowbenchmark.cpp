@@ -0,0 +1,82 @@
+// arrowbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Export of a large sheet to an Arrow IPC stream, against the export
+// to CSV which the Arrow readers would have to parse again. Both go to
+// memory, so that the disk is left out of the numbers.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxformat.h"
+#include "xlsxcsvoptions.h"
+#include "xlsxarrowexporter.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int arrowExportBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 100000;
+    int repeat = args.size() > 1 ? args.at(1).toInt() : 5;
+
+    Format date;
+    date.setNumberFormat("yyyy-mm-dd");
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    sheet->write(1, 1, "sku");
+    sheet->write(1, 2, "category");
+    sheet->write(1, 3, "price");
+    sheet->write(1, 4, "quantity");
+    sheet->write(1, 5, "date");
+    sheet->write(1, 6, "available");
+    for (int row = 2; row <= rows + 1; ++row)
+    {
+        sheet->write(row, 1, QString("SKU-%1").arg(row));
+        sheet->write(row, 2, QString("Category %1").arg(row % 50));
+        sheet->write(row, 3, row * 0.01);
+        sheet->write(row, 4, row * 3);
+        sheet->write(row, 5, QDate(2000, 1, 1).addDays(row % 5000), date);
+        sheet->write(row, 6, row % 3 != 0);
+    }
+
+    qint64 bestArrow = -1;
+    qint64 bestCsv = -1;
+    qint64 arrowSize = 0;
+    qint64 csvSize = 0;
+    for (int i = 0; i < repeat; ++i)
+    {
+        QBuffer arrow;
+        arrow.open(QIODevice::WriteOnly);
+        QElapsedTimer timer;
+        timer.start();
+        ArrowExporter exporter(sheet);
+        exporter.exportStream(&arrow);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (bestArrow < 0 || elapsed < bestArrow)
+            bestArrow = elapsed;
+        arrowSize = arrow.size();
+
+        QBuffer csv;
+        csv.open(QIODevice::WriteOnly);
+        timer.restart();
+        sheet->exportCsv(&csv);
+        elapsed = timer.nsecsElapsed();
+        if (bestCsv < 0 || elapsed < bestCsv)
+            bestCsv = elapsed;
+        csvSize = csv.size();
+    }
+
+    cout << rows << " rows, best of " << repeat << endl
+         << "  arrow: " << arrowSize << " bytes, " << bestArrow / 1000000.0 << " ms" << endl
+         << "  csv:   " << csvSize << " bytes, " << bestCsv / 1000000.0 << " ms" << endl;
+    return 0;
+}
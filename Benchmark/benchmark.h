@@ -0,0 +1,30 @@
+// benchmark.h
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+
+// Each benchmark takes the command line arguments following its name.
+int saveBenchmark(const QStringList &args);
+int sparseSaveBenchmark(const QStringList &args);
+int formulaParseBenchmark(const QStringList &args);
+int calcBenchmark(const QStringList &args);
+int parallelCalcBenchmark(const QStringList &args);
+int aggregateBenchmark(const QStringList &args);
+int validateBenchmark(const QStringList &args);
+int csvExportBenchmark(const QStringList &args);
+int csvImportBenchmark(const QStringList &args);
+int csvImportCheck(const QStringList &args);
+int htmlExportBenchmark(const QStringList &args);
+int arrowExportBenchmark(const QStringList &args);
+#ifdef QXLSX_HAVE_SQL
+int sqliteImportBenchmark(const QStringList &args);
+#endif
+int modelBenchmark(const QStringList &args);
+int codecBenchmark(const QStringList &args);
+int codecCheck(const QStringList &args);
+
+#endif // BENCHMARK_H
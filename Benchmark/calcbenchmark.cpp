@@ -0,0 +1,51 @@
+// calcbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Full calculation of a sheet of formulas, then the incremental
+// calculation after one input cell is changed.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet.h"
+#include "xlsxcell.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int calcBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 100000;
+
+    Document xlsx;
+    for (int row = 1; row <= rows; ++row)
+    {
+        QString r = QString::number(row);
+        xlsx.write(row, 1, row);
+        xlsx.write(row, 2, QString("=A%1*2+1").arg(r));
+        xlsx.write(row, 3, row == 1 ? QString("=B1") : QString("=C%1+B%2").arg(row - 1).arg(r));
+        xlsx.write(row, 4, QString("=IF(MOD(A%1,3)=0,SUM(A%1:C%1),MAX(A%1,B%1))").arg(r));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int full = xlsx.workbook()->recalculate();
+    qint64 fullElapsed = timer.elapsed();
+
+    // Changes the running total of the second half of the rows only
+    xlsx.write(rows / 2, 1, -1);
+    timer.restart();
+    int incremental = xlsx.workbook()->recalculate();
+    qint64 incrementalElapsed = timer.elapsed();
+
+    cout << "full: " << full << " formulas, " << fullElapsed << " ms" << endl
+         << "incremental: " << incremental << " formulas, " << incrementalElapsed << " ms" << endl
+         << "C" << rows << " = " << xlsx.cellAt(rows, 3)->value().toDouble() << endl;
+    return 0;
+}
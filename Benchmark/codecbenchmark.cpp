@@ -0,0 +1,204 @@
+// codecbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// The numbers of the cells as xsd:double text: the save and the load of
+// a sheet of numbers, and the check that every double reads back to the
+// very same bits.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <limits>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxnumericcodec_p.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+namespace {
+
+// xorshift64*, the same numbers on every platform
+class Random
+{
+public:
+    Random() : m_state(Q_UINT64_C(0x9E3779B97F4A7C15)) {}
+
+    quint64 next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * Q_UINT64_C(2685821657736338717);
+    }
+
+    // In [0, 1)
+    double nextDouble() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    quint64 m_state;
+};
+
+quint64 bitsOf(double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double doubleOf(quint64 bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Counts and reports the values which don't read back to the same bits
+class RoundTrip
+{
+public:
+    RoundTrip() : m_count(0), m_failures(0) {}
+
+    void check(double value)
+    {
+        ++m_count;
+
+        char buffer[XLSX_DOUBLE_BUFFER_SIZE];
+        int size = formatXsdDouble(value, buffer);
+        bool ok = false;
+        double utf8 = parseXsdDouble(buffer, size, &ok);
+        if (ok && bitsOf(utf8) == bitsOf(value)) {
+            QString text = xsdDoubleToString(value);
+            double utf16 = parseXsdDouble(text, &ok);
+            if (ok && bitsOf(utf16) == bitsOf(value))
+                return;
+        }
+
+        if (++m_failures <= 20) {
+            cout << "  mismatch: " << hex << bitsOf(value) << dec
+                 << " written as " << buffer << endl;
+        }
+    }
+
+    int count() const { return m_count; }
+    int failures() const { return m_failures; }
+
+private:
+    int m_count;
+    int m_failures;
+};
+
+qint64 timeSave(Document &xlsx, QByteArray *data)
+{
+    QBuffer buffer(data);
+    buffer.open(QIODevice::WriteOnly);
+    QElapsedTimer timer;
+    timer.start();
+    xlsx.saveAs(&buffer);
+    return timer.elapsed();
+}
+
+qint64 timeLoad(QByteArray *data, int *cells)
+{
+    QBuffer buffer(data);
+    buffer.open(QIODevice::ReadOnly);
+    QElapsedTimer timer;
+    timer.start();
+    Document xlsx(&buffer);
+    qint64 elapsed = timer.elapsed();
+    *cells = xlsx.dimension().isValid() ? xlsx.dimension().rowCount() * xlsx.dimension().columnCount() : 0;
+    return elapsed;
+}
+
+} //namespace
+
+int codecBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 200000;
+    const int cols = 10;
+
+    // Prices, ratios, counts and measures, as a numeric report has
+    Random random;
+    Document xlsx;
+    for (int row = 1; row <= rows; ++row)
+    {
+        for (int col = 1; col <= cols; ++col)
+        {
+            switch (col % 4)
+            {
+            case 1:
+                xlsx.write(row, col, qRound(random.nextDouble() * 1000000) / 100.0);
+                break;
+            case 2:
+                xlsx.write(row, col, random.nextDouble());
+                break;
+            case 3:
+                xlsx.write(row, col, int(random.next() % 100000));
+                break;
+            default:
+                xlsx.write(row, col, (random.nextDouble() - 0.5) * 1e9);
+                break;
+            }
+        }
+    }
+
+    QByteArray data;
+    qint64 saved = timeSave(xlsx, &data);
+    int cells = 0;
+    qint64 loaded = timeLoad(&data, &cells);
+
+    cout << rows << " x " << cols << " numbers, " << data.size() << " bytes" << endl
+         << "  save: " << saved << " ms" << endl
+         << "  load: " << loaded << " ms, " << cells << " cells" << endl;
+    return 0;
+}
+
+int codecCheck(const QStringList &args)
+{
+    int count = args.size() > 0 ? args.at(0).toInt() : 1000000;
+
+    RoundTrip roundTrip;
+
+    const double limits[] = {
+        0.0, -0.0, 1.0, -1.0, 0.1, 0.2, 0.3, 1e-4, 1e15, 1e16, 1e22, 1e23,
+        1e308, -1e308, 1e-308, -1e-308,
+        std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::min(), -std::numeric_limits<double>::min(),
+        std::numeric_limits<double>::denorm_min(), -std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::epsilon(), 9007199254740992.0, 9007199254740993.0,
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()
+    };
+    for (unsigned i = 0; i < sizeof(limits) / sizeof(limits[0]); ++i)
+        roundTrip.check(limits[i]);
+
+    Random random;
+    for (int i = 0; i < count; ++i)
+    {
+        // Any bit pattern but NaN, which doesn't equal itself
+        double any = doubleOf(random.next());
+        if (any == any)
+            roundTrip.check(any);
+
+        // Subnormals
+        roundTrip.check(doubleOf(random.next() & Q_UINT64_C(0x800FFFFFFFFFFFFF)));
+
+        // Two decimals, as prices are
+        roundTrip.check(double(qint64(random.next() % Q_UINT64_C(100000000000)) - 50000000000) / 100.0);
+
+        // Uniform in [0, 1), and scaled over the whole range of exponents
+        double uniform = random.nextDouble();
+        roundTrip.check(uniform);
+        roundTrip.check(std::ldexp(uniform + 0.5, int(random.next() % 2045) - 1022));
+    }
+
+    cout << roundTrip.count() << " doubles, " << roundTrip.failures()
+         << " not read back to the same bits" << endl;
+    return roundTrip.failures() ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+// csvbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Export of a large sheet to CSV, to memory, so that
+// the disk is left out of the numbers.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxformat.h"
+#include "xlsxcsvoptions.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int csvExportBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 100000;
+    int repeat = args.size() > 1 ? args.at(1).toInt() : 5;
+
+    // Text with quotes and delimiters, plain and formatted numbers, dates
+    Format money;
+    money.setNumberFormat("#,##0.00");
+    Format date;
+    date.setNumberFormat("yyyy-mm-dd");
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    for (int row = 1; row <= rows; ++row)
+    {
+        sheet->write(row, 1, QString("SKU-%1").arg(row));
+        sheet->write(row, 2, QString("Item \"%1\", size %2").arg(row % 1000).arg(row % 7));
+        sheet->write(row, 3, row * 0.01, money);
+        sheet->write(row, 4, row * 3);
+        sheet->write(row, 5, QDate(2000, 1, 1).addDays(row % 5000), date);
+    }
+
+    qint64 best = -1;
+    qint64 size = 0;
+    for (int i = 0; i < repeat; ++i)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        QElapsedTimer timer;
+        timer.start();
+        sheet->exportCsv(&buffer);
+        qint64 elapsed = timer.nsecsElapsed();
+
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+        size = buffer.size();
+    }
+
+    cout << rows << " rows, " << size << " bytes, best of " << repeat << ": "
+         << best / 1000000.0 << " ms, "
+         << (best > 0 ? size * 1000.0 / best : 0.0) << " MB/s" << endl;
+    return 0;
+}
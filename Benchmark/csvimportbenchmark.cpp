@@ -0,0 +1,126 @@
+// csvimportbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Import of a large CSV file, from memory, on one thread
+// and on the given number of threads, and the check that a file
+// with stray quotes imports the same on any number of threads.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxcell.h"
+#include "xlsxcsvoptions.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+static qint64 timeImport(const QByteArray &csv, int threads)
+{
+    QBuffer buffer;
+    buffer.setData(csv);
+    buffer.open(QIODevice::ReadOnly);
+
+    CsvOptions options;
+    options.threadCount = threads;
+
+    Document xlsx;
+    QElapsedTimer timer;
+    timer.start();
+    xlsx.currentWorksheet()->importCsv(&buffer, options);
+    return timer.nsecsElapsed();
+}
+
+// Row, column and value of each cell of the imported sheet
+static QStringList importedCells(const QByteArray &csv, int threads)
+{
+    QBuffer buffer;
+    buffer.setData(csv);
+    buffer.open(QIODevice::ReadOnly);
+
+    CsvOptions options;
+    options.threadCount = threads;
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    QStringList cells;
+    if (!sheet->importCsv(&buffer, options))
+        return cells;
+
+    const CellRange range = sheet->dimension();
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row)
+    {
+        for (int col = range.firstColumn(); col <= range.lastColumn(); ++col)
+        {
+            Cell *cell = sheet->cellAt(row, col);
+            if (cell)
+                cells << QString("%1,%2,%3").arg(row).arg(col).arg(cell->value().toString());
+        }
+    }
+    return cells;
+}
+
+int csvImportBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 200000;
+    int threads = args.size() > 1 ? args.at(1).toInt() : 0;
+
+    // Repeated labels, quoted text with line breaks, numbers, dates, flags
+    QByteArray csv;
+    for (int row = 1; row <= rows; ++row)
+    {
+        csv += "SKU-" + QByteArray::number(row % 5000) + ',';
+        csv += "\"Item \"\"" + QByteArray::number(row % 1000) + "\"\",\nsize " + QByteArray::number(row % 7) + "\",";
+        csv += QByteArray::number(row * 0.01, 'f', 2) + ',';
+        csv += "2020-01-" + QByteArray::number(10 + row % 20) + ',';
+        csv += (row % 2 ? "TRUE" : "FALSE");
+        csv += "\r\n";
+    }
+
+    qint64 single = timeImport(csv, 1);
+    qint64 parallel = timeImport(csv, threads);
+    cout << rows << " rows, " << csv.size() << " bytes" << endl
+         << "1 thread: " << single / 1000000.0 << " ms" << endl
+         << (threads > 0 ? threads : QThread::idealThreadCount()) << " threads: "
+         << parallel / 1000000.0 << " ms" << endl;
+    return 0;
+}
+
+int csvImportCheck(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 200000;
+
+    // Quote characters inside unquoted fields, text after closing quotes,
+    // quoted line breaks and doubled quotes, which a split of the input
+    // must not take for the start or end of a quoted field
+    QByteArray csv;
+    for (int row = 1; row <= rows; ++row)
+    {
+        csv += QByteArray::number(row % 50) + "\" pipe,";
+        csv += (row % 3 ? "plain" : "a\"b") + QByteArray(",");
+        csv += "\"closed\"" + QByteArray(row % 5 ? "" : " after\"") + ',';
+        csv += "\"line\nbreak \"\"" + QByteArray::number(row % 7) + "\"\"\",";
+        csv += (row % 11 ? "x" : "x\"");
+        csv += (row % 2 ? "\n" : "\r\n");
+    }
+
+    QStringList expected = importedCells(csv, 1);
+    int failures = 0;
+    const int threadCounts[] = { 2, 3, 4, 8, 16 };
+    for (unsigned i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+    {
+        QStringList cells = importedCells(csv, threadCounts[i]);
+        bool same = !cells.isEmpty() && cells == expected;
+        if (!same)
+            ++failures;
+        cout << threadCounts[i] << " threads: " << cells.size() << " cells, "
+             << (same ? "same as" : "NOT the same as") << " on 1 thread" << endl;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+// formulabenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Formula parsing rate.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxformulaparser_p.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int formulaParseBenchmark(const QStringList &args)
+{
+    int count = args.size() > 0 ? args.at(0).toInt() : 1000000;
+
+    QStringList formulas;
+    formulas << "SUM(A1:B10)*2+C3"
+             << "IF(A1>0,VLOOKUP(B1,Sheet2!$A$1:$D$100,3,FALSE),\"\")"
+             << "A1*B1-C1/D1"
+             << "ROUND(AVERAGE('Raw Data'!C2:C500),2)"
+             << "SUMIF(Table1[Region],\"North\",Table1[Sales])"
+             << "INDEX({1,2,3;4,5,6},2,3)^-2%";
+
+    qint64 tokens = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i)
+    {
+        FormulaExpression expression = FormulaExpression::parse(formulas.at(i % formulas.size()));
+        tokens += expression.tokens().size();
+    }
+    qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+
+    cout << count << " formulas, " << tokens << " tokens, " << elapsed << " ms, "
+         << (count * 1000LL / elapsed) << " formulas/s" << endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+// htmlbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// HTML of a large sheet: the whole page built by string concatenation,
+// as the WebServer example used to, against HtmlExporter, whose first
+// chunk is ready long before the end of the table.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxformat.h"
+#include "xlsxhtmlexporter.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+namespace {
+
+// Takes the time of the first write
+class FirstChunkBuffer : public QBuffer
+{
+public:
+    explicit FirstChunkBuffer(const QElapsedTimer &timer) : m_timer(timer), m_first(-1) {}
+    qint64 first() const { return m_first; }
+
+protected:
+    qint64 writeData(const char *data, qint64 size)
+    {
+        if (m_first < 0)
+            m_first = m_timer.nsecsElapsed();
+        return QBuffer::writeData(data, size);
+    }
+
+private:
+    const QElapsedTimer &m_timer;
+    qint64 m_first;
+};
+
+QString concatenatedHtml(Worksheet *sheet)
+{
+    QString ret;
+    ret = ret + QString("<html>\n<head>\n<title>") + sheet->sheetName() + QString("</title>\n</head>\n<body>\n");
+    ret = ret + QString("<table>");
+    CellRange range = sheet->dimension();
+    for (int row = range.firstRow(); row <= range.lastRow(); ++row)
+    {
+        QString record;
+        record = record + QString("<tr>");
+        for (int col = range.firstColumn(); col <= range.lastColumn(); ++col)
+            record = record + QString("<td>") + sheet->read(row, col).toString() + QString("</td>");
+        record = record + QString("</tr>\n");
+        ret = ret + record;
+    }
+    ret = ret + QString("</table>\n</body>\n</html>\n");
+    return ret;
+}
+
+} //namespace
+
+int htmlExportBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 20000;
+
+    Format bold;
+    bold.setFontBold(true);
+    Format money;
+    money.setNumberFormat("#,##0.00");
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    for (int row = 1; row <= rows; ++row)
+    {
+        sheet->write(row, 1, QString("SKU-%1").arg(row), bold);
+        sheet->write(row, 2, QString("Item <%1> & co").arg(row % 1000));
+        sheet->write(row, 3, row * 0.01, money);
+        sheet->write(row, 4, row * 3);
+        if (row % 100 == 0)
+            sheet->mergeCells(CellRange(row, 5, row + 1, 6));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray concatenated = concatenatedHtml(sheet).toUtf8();
+    qint64 concatenation = timer.nsecsElapsed();
+
+    timer.restart();
+    FirstChunkBuffer buffer(timer);
+    buffer.open(QIODevice::WriteOnly);
+    HtmlExporter exporter(sheet);
+    exporter.exportDocument(&buffer);
+    qint64 exported = timer.nsecsElapsed();
+
+    cout << rows << " rows" << endl
+         << "  concatenation: " << concatenated.size() << " bytes, "
+         << concatenation / 1000000.0 << " ms" << endl
+         << "  HtmlExporter:  " << buffer.size() << " bytes, "
+         << exported / 1000000.0 << " ms, first chunk after "
+         << buffer.first() / 1000000.0 << " ms" << endl;
+    return 0;
+}
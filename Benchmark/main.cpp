@@ -0,0 +1,78 @@
+// main.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Timings of the heavy operations of QXlsx.
+// Build and run it on two revisions of QXlsx to compare them.
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QtCore>
+
+#include <iostream>
+using namespace std;
+
+#include "benchmark.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+    QString name = args.isEmpty() ? QString("save") : args.takeFirst();
+
+    if (name == "save")
+        return saveBenchmark(args);
+    if (name == "sparse")
+        return sparseSaveBenchmark(args);
+    if (name == "formula")
+        return formulaParseBenchmark(args);
+    if (name == "calc")
+        return calcBenchmark(args);
+    if (name == "parallel")
+        return parallelCalcBenchmark(args);
+    if (name == "aggregate")
+        return aggregateBenchmark(args);
+    if (name == "validate")
+        return validateBenchmark(args);
+    if (name == "csv")
+        return csvExportBenchmark(args);
+    if (name == "csvimport")
+        return csvImportBenchmark(args);
+    if (name == "csvcheck")
+        return csvImportCheck(args);
+    if (name == "html")
+        return htmlExportBenchmark(args);
+    if (name == "arrow")
+        return arrowExportBenchmark(args);
+#ifdef QXLSX_HAVE_SQL
+    if (name == "sqlite")
+        return sqliteImportBenchmark(args);
+#endif
+    if (name == "model")
+        return modelBenchmark(args);
+    if (name == "codec")
+        return codecBenchmark(args);
+    if (name == "codeccheck")
+        return codecCheck(args);
+
+    cout << "usage: Benchmark save [rows] [columns] [repeat]" << endl
+         << "       Benchmark sparse [repeat]" << endl
+         << "       Benchmark formula [count]" << endl
+         << "       Benchmark calc [rows]" << endl
+         << "       Benchmark parallel [rows] [threads]" << endl
+         << "       Benchmark aggregate [rows]" << endl
+         << "       Benchmark validate [rows]" << endl
+         << "       Benchmark csv [rows] [repeat]" << endl
+         << "       Benchmark csvimport [rows] [threads]" << endl
+         << "       Benchmark csvcheck [rows]" << endl
+         << "       Benchmark html [rows]" << endl
+         << "       Benchmark arrow [rows] [repeat]" << endl
+#ifdef QXLSX_HAVE_SQL
+         << "       Benchmark sqlite [rows]" << endl
+#endif
+         << "       Benchmark model [rows]" << endl
+         << "       Benchmark codec [rows]" << endl
+         << "       Benchmark codeccheck [count]" << endl;
+    return 1;
+}
@@ -0,0 +1,108 @@
+// modelbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Opening a large sheet in a view: the copy of every cell the examples
+// used to make before showing anything, against WorksheetModel, which
+// only reads the cells of the rows fetched, once per cell.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxformat.h"
+#include "xlsxworksheetmodel.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+namespace {
+
+// The roles an item view asks for each cell it paints
+const int viewRoles[] = {
+    Qt::DisplayRole, Qt::FontRole, Qt::ForegroundRole, Qt::BackgroundRole, Qt::TextAlignmentRole
+};
+
+int dataOfRows(const WorksheetModel &model, int firstRow, int lastRow)
+{
+    int count = 0;
+    for (int row = firstRow; row <= lastRow; ++row)
+        for (int col = 0; col < model.columnCount(); ++col)
+            for (unsigned i = 0; i < sizeof(viewRoles) / sizeof(viewRoles[0]); ++i)
+                count += model.data(model.index(row, col), viewRoles[i]).isValid() ? 1 : 0;
+    return count;
+}
+
+} //namespace
+
+int modelBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 1000000;
+
+    Format money;
+    money.setNumberFormat("#,##0.00");
+    Format percent;
+    percent.setNumberFormat("0.00%");
+    Format date;
+    date.setNumberFormat("yyyy-mm-dd");
+    Format bold;
+    bold.setFontBold(true);
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    sheet->setColumnFormat(1, 1, bold);
+    for (int row = 1; row <= rows; ++row)
+    {
+        sheet->write(row, 1, QString("SKU-%1").arg(row));
+        sheet->write(row, 2, row * 0.01, money);
+        sheet->write(row, 3, (row % 100) / 100.0, percent);
+        sheet->write(row, 4, 43000 + row % 3650, date);
+        sheet->write(row, 5, row * 3);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int maxRow = -1;
+    int maxCol = -1;
+    QVector<CellLocation> cells = sheet->getFullCells(&maxRow, &maxCol);
+    QList<QStringList> copy;
+    for (int row = 0; row < maxRow; ++row)
+        copy.append(QStringList());
+    foreach (const CellLocation &location, cells)
+        copy[location.row - 1].append(location.cell->value().toString());
+    qint64 copied = timer.nsecsElapsed();
+
+    timer.restart();
+    WorksheetModel model(sheet);
+    qint64 created = timer.nsecsElapsed();
+
+    timer.restart();
+    int firstPage = dataOfRows(model, 0, model.rowCount() - 1);
+    qint64 firstData = timer.nsecsElapsed();
+
+    timer.restart();
+    dataOfRows(model, 0, model.rowCount() - 1);
+    qint64 cachedData = timer.nsecsElapsed();
+
+    timer.restart();
+    int fetched = model.rowCount();
+    if (model.canFetchMore(QModelIndex()))
+        model.fetchMore(QModelIndex());
+    dataOfRows(model, fetched, model.rowCount() - 1);
+    qint64 nextPage = timer.nsecsElapsed();
+
+    cout << rows << " rows" << endl
+         << "  copy of all cells: " << copy.size() << " rows, "
+         << copied / 1000000.0 << " ms" << endl
+         << "  WorksheetModel:    created in " << created / 1000000.0 << " ms" << endl
+         << "    first page data(): " << firstPage << " values of "
+         << fetched << " rows, " << firstData / 1000000.0 << " ms, again "
+         << cachedData / 1000000.0 << " ms" << endl
+         << "    fetchMore() and data() of the next page: "
+         << nextPage / 1000000.0 << " ms" << endl;
+    return 0;
+}
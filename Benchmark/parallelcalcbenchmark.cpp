@@ -0,0 +1,75 @@
+// parallelcalcbenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Full calculation of a wide and shallow sheet of formulas with one
+// thread, then with several threads.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet.h"
+#include "xlsxcell.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+static void fillSheet(Document &xlsx, int rows)
+{
+    for (int row = 1; row <= rows; ++row)
+    {
+        QString r = QString::number(row);
+        xlsx.write(row, 1, row % 1000);
+        xlsx.write(row, 2, (row * 7) % 13);
+        xlsx.write(row, 3, QString("=A%1*B%1").arg(r));
+        xlsx.write(row, 4, QString("=C%1+SUM(A%1:B%1)").arg(r));
+        xlsx.write(row, 5, QString("=IF(D%1>100,D%1/2,D%1*2)").arg(r));
+        xlsx.write(row, 6, QString("=ROUND(AVERAGE(C%1:E%1),2)").arg(r));
+    }
+}
+
+static qint64 timeCalculation(Document &xlsx, int threads, int *formulas)
+{
+    xlsx.workbook()->setCalculationThreadCount(threads);
+    QElapsedTimer timer;
+    timer.start();
+    *formulas = xlsx.workbook()->recalculate();
+    return timer.elapsed();
+}
+
+int parallelCalcBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 100000;
+    int threads = args.size() > 1 ? args.at(1).toInt() : QThread::idealThreadCount();
+
+    Document serial;
+    Document parallel;
+    fillSheet(serial, rows);
+    fillSheet(parallel, rows);
+
+    int formulas = 0;
+    qint64 serialElapsed = timeCalculation(serial, 1, &formulas);
+    qint64 parallelElapsed = timeCalculation(parallel, threads, &formulas);
+
+    bool identical = true;
+    for (int row = 1; row <= rows && identical; ++row)
+    {
+        for (int col = 3; col <= 6; ++col)
+        {
+            if (serial.cellAt(row, col)->value() != parallel.cellAt(row, col)->value())
+                identical = false;
+        }
+    }
+
+    cout << formulas << " formulas" << endl
+         << "1 thread: " << serialElapsed << " ms" << endl
+         << threads << " threads: " << parallelElapsed << " ms" << endl
+         << (identical ? "same results" : "DIFFERENT RESULTS") << endl;
+    return identical ? 0 : 1;
+}
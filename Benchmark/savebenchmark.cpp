@@ -0,0 +1,93 @@
+// savebenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Times the saving of a large sheet, to memory, so that
+// the disk is left out of the numbers.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QBuffer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+static qint64 timeSave(Document &xlsx, int repeat, qint64 *size)
+{
+    qint64 best = -1;
+    for (int i = 0; i < repeat; ++i)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+
+        QElapsedTimer timer;
+        timer.start();
+        xlsx.saveAs(&buffer);
+        qint64 elapsed = timer.elapsed();
+
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+        *size = buffer.size();
+    }
+    return best;
+}
+
+int saveBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 100000;
+    int cols = args.size() > 1 ? args.at(1).toInt() : 10;
+    int repeat = args.size() > 2 ? args.at(2).toInt() : 5;
+
+    // Fill a sheet like a product catalog: sku, name, price, stock...
+    Document xlsx;
+    for (int row = 1; row <= rows; ++row)
+    {
+        for (int col = 1; col <= cols; ++col)
+        {
+            switch (col % 4)
+            {
+            case 1:
+                xlsx.write(row, col, QString("SKU-%1-%2").arg(row).arg(col));
+                break;
+            case 2:
+                xlsx.write(row, col, QString("Item <%1> & \"co\"").arg(row % 1000));
+                break;
+            case 3:
+                xlsx.write(row, col, row * 0.01 + col);
+                break;
+            default:
+                xlsx.write(row, col, row * col);
+                break;
+            }
+        }
+    }
+
+    qint64 size = 0;
+    qint64 best = timeSave(xlsx, repeat, &size);
+    cout << rows << " x " << cols << " cells, " << size << " bytes, best of "
+         << repeat << ": " << best << " ms" << endl;
+    return 0;
+}
+
+int sparseSaveBenchmark(const QStringList &args)
+{
+    int repeat = args.size() > 0 ? args.at(0).toInt() : 5;
+
+    // A few cells spread over the whole sheet: A1:XFD1048576
+    Document xlsx;
+    xlsx.write(1, 1, "first");
+    xlsx.write(500000, 8000, 42);
+    xlsx.write(1048576, 16384, "last");
+
+    qint64 size = 0;
+    qint64 best = timeSave(xlsx, repeat, &size);
+    cout << "sparse A1:XFD1048576, " << size << " bytes, best of "
+         << repeat << ": " << best << " ms" << endl;
+    return 0;
+}
@@ -0,0 +1,101 @@
+// sqlitebenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Load of a large sheet into an SQLite file: with SqliteImporter,
+// and the naive way, reading each cell with read() and inserting each
+// row in a transaction of its own.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxformat.h"
+#include "xlsxsqliteimporter.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+static qint64 timeNaive(Worksheet *sheet, const QString &fileName)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "naive");
+    db.setDatabaseName(fileName);
+    db.open();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery query(db);
+    query.exec("CREATE TABLE naive (sku TEXT, category TEXT, price REAL, quantity INTEGER, date TEXT)");
+    CellRange range = sheet->dimension();
+    for (int row = 2; row <= range.lastRow(); ++row)
+    {
+        query.prepare("INSERT INTO naive VALUES (?, ?, ?, ?, ?)");
+        for (int col = 1; col <= 5; ++col)
+            query.addBindValue(sheet->read(row, col));
+        query.exec();
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+
+    query.clear();
+    db.close();
+    return elapsed;
+}
+
+static qint64 timeImporter(Worksheet *sheet, const QString &fileName)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "importer");
+    db.setDatabaseName(fileName);
+    db.open();
+
+    QElapsedTimer timer;
+    timer.start();
+    SqliteImporter importer(db);
+    importer.importSheet(sheet, "imported");
+    qint64 elapsed = timer.nsecsElapsed();
+
+    db.close();
+    return elapsed;
+}
+
+int sqliteImportBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 10000;
+
+    Format date;
+    date.setNumberFormat("yyyy-mm-dd");
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    sheet->write(1, 1, "sku");
+    sheet->write(1, 2, "category");
+    sheet->write(1, 3, "price");
+    sheet->write(1, 4, "quantity");
+    sheet->write(1, 5, "date");
+    for (int row = 2; row <= rows + 1; ++row)
+    {
+        sheet->write(row, 1, QString("SKU-%1").arg(row));
+        sheet->write(row, 2, QString("Category %1").arg(row % 50));
+        sheet->write(row, 3, row * 0.01);
+        sheet->write(row, 4, row * 3);
+        sheet->write(row, 5, QDate(2000, 1, 1).addDays(row % 5000), date);
+    }
+
+    QTemporaryDir dir;
+    qint64 importer = timeImporter(sheet, dir.filePath("importer.db"));
+    qint64 naive = timeNaive(sheet, dir.filePath("naive.db"));
+
+    cout << rows << " rows" << endl
+         << "  SqliteImporter:       " << importer / 1000000.0 << " ms, "
+         << (importer > 0 ? rows * 1e9 / importer : 0.0) << " rows/s" << endl
+         << "  read() + INSERT/row:  " << naive / 1000000.0 << " ms, "
+         << (naive > 0 ? rows * 1e9 / naive : 0.0) << " rows/s" << endl;
+    return 0;
+}
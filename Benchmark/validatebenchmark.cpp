@@ -0,0 +1,53 @@
+// validatebenchmark.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Check of a filled-in template: a list, a whole number and a text
+// length validation over every row, with a few bad cells.
+
+#include <QtGlobal>
+#include <QtCore>
+#include <QElapsedTimer>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxdatavalidation.h"
+#include "xlsxcellrange.h"
+using namespace QXlsx;
+
+#include "benchmark.h"
+
+int validateBenchmark(const QStringList &args)
+{
+    int rows = args.size() > 0 ? args.at(0).toInt() : 200000;
+
+    Document xlsx;
+    Worksheet *sheet = xlsx.currentWorksheet();
+    const QStringList colors = QStringList() << "Red" << "Green" << "Blue";
+    for (int row = 1; row <= rows; ++row) {
+        sheet->writeString(row, 1, row % 1000 == 0 ? QString("Purple") : colors[row % 3]);
+        sheet->writeNumeric(row, 2, row % 1000 == 1 ? 1.5 : row % 100);
+        sheet->writeString(row, 3, QString("Item %1").arg(row));
+    }
+
+    DataValidation list(DataValidation::List, DataValidation::Between, "\"Red,Green,Blue\"");
+    list.addRange(CellRange(1, 1, rows, 1));
+    sheet->addDataValidation(list);
+    DataValidation whole(DataValidation::Whole, DataValidation::Between, "0", "99");
+    whole.addRange(CellRange(1, 2, rows, 2));
+    sheet->addDataValidation(whole);
+    DataValidation length(DataValidation::TextLength, DataValidation::LessThanOrEqual, "10");
+    length.addRange(CellRange(1, 3, rows, 3));
+    sheet->addDataValidation(length);
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<QPair<CellReference, DataValidation> > errors = sheet->validateData();
+    qint64 elapsed = timer.nsecsElapsed();
+
+    cout << rows << " rows, " << errors.size() << " invalid cells, "
+         << elapsed / 1000000.0 << " ms" << endl;
+    return 0;
+}
@@ -85,24 +85,13 @@ bool MainWindow::loadXlsx(QString fileName)
         return false; // failed to load
     }
 
-    // clear xlsxDoc
-    if ( NULL != xlsxDoc )
-    {
-        delete xlsxDoc;
-        xlsxDoc = NULL;
-    }
-
-    // load new xlsx using new document
-    xlsxDoc = new QXlsx::Document( fileName );
-    xlsxDoc->isLoadPackage();
-
     // clear tab widget
     tabWidget->clear();
     // Removes all the pages, but does not delete them.
     // Calling this function is equivalent to calling removeTab()
     // until the tab widget is empty.
 
-    // clear sub-items of every tab
+    // clear sub-items of every tab, whose models read the old document
     foreach ( XlsxTab* ptrTab, xlsxTabList )
     {
         if ( NULL == ptrTab )
@@ -111,6 +100,17 @@ bool MainWindow::loadXlsx(QString fileName)
     }
     xlsxTabList.clear();
 
+    // clear xlsxDoc
+    if ( NULL != xlsxDoc )
+    {
+        delete xlsxDoc;
+        xlsxDoc = NULL;
+    }
+
+    // load new xlsx using new document
+    xlsxDoc = new QXlsx::Document( fileName );
+    xlsxDoc->isLoadPackage();
+
     int sheetIndexNumber = 0;
     int activeSheetNumber = -1;
 
@@ -11,10 +11,10 @@
 #include <QObject>
 #include <QString>
 #include <QWidget>
-#include <QTableWidget>
 #include <QVBoxLayout>
 
 #include "xlsx.h"
+#include "xlsxworksheetmodel.h"
 #include "XlsxTableWidget.h"
 
 /**
@@ -40,11 +40,11 @@ protected:
 
 protected:
     XlsxTableWidget* table;
+    QXlsx::WorksheetModel* model;
     QVBoxLayout *vLayout;
 
 protected:
     bool setSheet();
-    std::string convertFromNumberToExcelColumn(int n);
 
 };
 
@@ -4,12 +4,13 @@
 #include <QTime>
 
 #include <QList>
-#include <QTableWidgetSelectionRange>
+#include <QItemSelection>
+#include <QItemSelectionModel>
 
 #include "XlsxTableWidget.h"
 
 XlsxTableWidget::XlsxTableWidget(QWidget* parent)
-    : QTableWidget(parent)
+    : QTableView(parent)
 {
     //
 }
@@ -21,30 +22,31 @@ XlsxTableWidget::~XlsxTableWidget()
 
 void XlsxTableWidget::mousePressEvent(QMouseEvent *event)
 {
-    QTableWidget::mousePressEvent(event);
+    QTableView::mousePressEvent(event);
 
     if ( event->button() == Qt::RightButton )
     {
         // qDebug() << "right button is pressed";
 
-        QList<QTableWidgetItem *> items = this->selectedItems();
+        if ( NULL == this->selectionModel() )
+            return;
 
         // selected range
 
-        QList<QTableWidgetSelectionRange> ranges = this->selectedRanges();
+        QItemSelection ranges = this->selectionModel()->selection();
         for (int ic = 0 ; ic < ranges.size(); ic++ )
         {
-            QTableWidgetSelectionRange range = ranges.at(ic);
+            QItemSelectionRange range = ranges.at(ic);
 
-            int rowCount = range.rowCount();
+            int rowCount = range.height();
 
-            int topRow = range.topRow();
-            int bottomRow = range.bottomRow();
+            int topRow = range.top();
+            int bottomRow = range.bottom();
 
-            int colCount = range.columnCount();
+            int colCount = range.width();
 
-            int leftCol = range.leftColumn();
-            int rightCol = range.rightColumn();
+            int leftCol = range.left();
+            int rightCol = range.right();
 
             qDebug()
             << QTime::currentTime();
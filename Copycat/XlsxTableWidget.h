@@ -10,12 +10,10 @@
 #include <QVector>
 
 #include <QWidget>
-#include <QTableWidget>
+#include <QTableView>
 #include <QMouseEvent>
-#include <QTableWidgetItem>
-#include <QTableWidgetSelectionRange>
 
-class XlsxTableWidget : public QTableWidget
+class XlsxTableWidget : public QTableView
 {
 	Q_OBJECT	
 public:
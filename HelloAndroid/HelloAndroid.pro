@@ -26,8 +26,7 @@ DEFINES += QT_DEPRECATED_WARNINGS
 include(../QXlsx/QXlsx.pri)
 
 HEADERS += \
-XlsxTableModel.h \
-    DynArray2D.h
+XlsxTableModel.h
 
 SOURCES += \
 main.cpp \
@@ -9,145 +9,38 @@
 #include <QDebug>
 #include <QVariant>
 
-#include <sstream>
-
-
-XlsxTableModel::XlsxTableModel(QList<QString> colTitle, QList<VLIST> data, QObject *parent)
-    : QAbstractTableModel(parent)
+XlsxTableModel::XlsxTableModel(QXlsx::Worksheet* sheet, QObject *parent)
+    : QIdentityProxyModel(parent)
 {
-        // [1] set name of column
-
-        for (int ic = 0; ic < colTitle.size() ; ic++ )
-        {
-            QString strCol = colTitle.at(ic);
-            m_colNames.append( strCol );
-        }
-        m_roleCount = m_colNames.size();
-
-        // [2]  set data
-
-        for (int dc = 0; dc < data.size() ; dc++ )
-        {
-            VLIST vList = data.at(dc);
-            m_the_data.append( vList );
-        }
-}
-
-void XlsxTableModel::testData()
-{
-    // test code
-
-    // | 1     | 2  | 3     | col.count is 3.
-    // |-------|----|-------|
-    // | Alpha | 10 | 100.0 | row count is 4.
-    // | Beta  | 20 | 200.0 |
-    // | Gamma | 30 | 300.0 |
-    // | Delta | 40 | 400.0 |
-
-    // set name of column
-
-    m_colNames.append( QString( "COL1" ) );
-    m_colNames.append( QString( "COL2" ) );
-    m_colNames.append( QString( "COL3" ) );
-
-    m_roleCount = m_colNames.size();
-
-    // set data
-
-    VLIST list1;
-    list1.append(QVariant("Alpha"));
-    list1.append(QVariant(10));
-    list1.append(QVariant(100.0));
-    m_the_data.append( list1 );
-
-    VLIST list2;
-    list2.append(QVariant("Beta"));
-    list2.append(QVariant(20));
-    list2.append(QVariant(200.0));
-    m_the_data.append( list2 );
-
-    VLIST list3;
-    list3.append(QVariant("Gamma"));
-    list3.append(QVariant(30));
-    list3.append(QVariant(300.0));
-    m_the_data.append( list3 );
-
-    VLIST list4;
-    list4.append(QVariant("Delta"));
-    list4.append(QVariant(40));
-    list4.append(QVariant(400.0));
-    m_the_data.append( list4 );
-
-}
-
-int XlsxTableModel::rowCount(const QModelIndex& parent) const
-{
-    Q_UNUSED(parent)
-    return m_the_data.size();
-}
-
-int XlsxTableModel::columnCount(const QModelIndex& parent) const
-{
-    Q_UNUSED(parent)
-    return m_roleCount;
+    m_sheetModel = new QXlsx::WorksheetModel( sheet, this );
+    setSourceModel( m_sheetModel );
 }
 
 QVariant XlsxTableModel::data(const QModelIndex& index, int role) const
 {
-    // current column & row
-    int col = index.column();
-    int row = index.row();
+    // roles of the columns are (Qt::UserRole + 1), (Qt::UserRole + 2), ...
+    int col = role - ( (int)(Qt::UserRole) + 1 );
+    if ( col < 0 )
+        return QIdentityProxyModel::data( index, role );
 
     // check boudaries
-    if ( col < 0 || columnCount() <= col ||
-         row < 0 || rowCount()    <= row )
+    if ( !index.isValid() || columnCount() <= col )
     {
-        qDebug() << "[Warning]" << " col=" << col << ", row="  << row;
+        qDebug() << "[Warning]" << " col=" << col << ", row="  << index.row();
         return QVariant();
     }
 
-    // Nominal case
-
-    QVariant ret;
-    int cmpRole;
-
-    for (int ic = 0; ic < m_the_data.size() ; ic++)
-    {
-        if ( row == ic )
-        {
-            QList<QVariant> vList = m_the_data.at(ic);
-            for (int jc = 0; jc < vList.size() ; jc++ )
-            {
-                int plusOneRole = (int)(Qt::UserRole);
-                plusOneRole = plusOneRole + 1;
-                cmpRole = plusOneRole + jc;
-                if ( role == cmpRole )
-                {
-                    QVariant var = vList.at(jc);
-                    if ( ! var.isValid() ) var.setValue( QString("") ) ;
-                    if ( var.isNull() ) var.setValue( QString("") ) ;
-                    ret = var;
-                }
-            }
-        }
-    }
-
-    qDebug()
-        << "data: "
-        << " col="    << col << ", row="   << row
-        << ", role=" << role << ", cmpRole=" << cmpRole
-        << ", value=" << ret.toString();
-
-    return ret;
+    return QIdentityProxyModel::data( this->index( index.row(), col ), Qt::DisplayRole );
 }
 
 QHash<int, QByteArray> XlsxTableModel::roleNames() const
 {
     QHash<int, QByteArray> roles;
 
-    for ( int ic = 0 ; ic < m_roleCount ; ic++)
+    // column names of the sheet: 'A', 'B', 'C', ...
+    for ( int ic = 0 ; ic < columnCount() ; ic++)
     {
-        QString strRole = m_colNames.at(ic);
+        QString strRole = headerData( ic, Qt::Horizontal ).toString();
         int roleNo = (Qt::UserRole+1) + ic;
         roles.insert( roleNo, strRole.toLatin1() );
     }
@@ -173,4 +66,3 @@ QStringList XlsxTableModel::customRoleNames()
     return res.values();
 }
 
-
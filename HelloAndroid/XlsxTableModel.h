@@ -11,19 +11,17 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
-#include <QList>
-#include <QVector>
 #include <QMap>
 #include <QVariant>
-#include <QAbstractTableModel>
+#include <QIdentityProxyModel>
 
-#include <string>
-#include <vector>
-#include <cstdlib>
+#include "xlsxworksheet.h"
+#include "xlsxworksheetmodel.h"
 
-typedef QList<QVariant> VLIST;
-
-class XlsxTableModel : public QAbstractTableModel
+// The TableView of QtQuick.Controls 1 shows one role per column, so the
+// columns of the worksheet model are given as the roles of its first
+// column. The cells are still read as they are shown, see WorksheetModel.
+class XlsxTableModel : public QIdentityProxyModel
 {
     Q_OBJECT
 
@@ -32,21 +30,14 @@ class XlsxTableModel : public QAbstractTableModel
 public: QStringList customRoleNames();
 
 public: // constrcutor
-    XlsxTableModel(QList<QString> colTitle, QList<VLIST> data, QObject *parent = NULL);
+    XlsxTableModel(QXlsx::Worksheet* sheet, QObject *parent = NULL);
 
 public: // virtual function of parent object
-    int rowCount(const QModelIndex & parent = QModelIndex()) const Q_DECL_OVERRIDE;
-    int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
     QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
 
 protected:
-    void testData(); // test function.
-
-protected:
-    QList<VLIST> m_the_data; // table cell data
-    QList<QString> m_colNames; // column name
-    quint32 m_roleCount; // role count (same as column count)
+    QXlsx::WorksheetModel* m_sheetModel; // cells of the sheet
 
 };
 
@@ -52,10 +52,15 @@ $${QXLSX_HEADERPATH}xlsxabstractooxmlfile.h \
 $${QXLSX_HEADERPATH}xlsxabstractooxmlfile_p.h \
 $${QXLSX_HEADERPATH}xlsxabstractsheet.h \
 $${QXLSX_HEADERPATH}xlsxabstractsheet_p.h \
+$${QXLSX_HEADERPATH}xlsxarrowexporter.h \
+$${QXLSX_HEADERPATH}xlsxarrowexporter_p.h \
+$${QXLSX_HEADERPATH}xlsxarrowstreamwriter_p.h \
+$${QXLSX_HEADERPATH}xlsxcalcchain_p.h \
 $${QXLSX_HEADERPATH}xlsxcell.h \
 $${QXLSX_HEADERPATH}xlsxcellformula.h \
 $${QXLSX_HEADERPATH}xlsxcellformula_p.h \
 $${QXLSX_HEADERPATH}xlsxcellrange.h \
+$${QXLSX_HEADERPATH}xlsxcellrangeindex_p.h \
 $${QXLSX_HEADERPATH}xlsxcellreference.h \
 $${QXLSX_HEADERPATH}xlsxcell_p.h \
 $${QXLSX_HEADERPATH}xlsxchart.h \
@@ -63,22 +68,41 @@ $${QXLSX_HEADERPATH}xlsxchartsheet.h \
 $${QXLSX_HEADERPATH}xlsxchartsheet_p.h \
 $${QXLSX_HEADERPATH}xlsxchart_p.h \
 $${QXLSX_HEADERPATH}xlsxcolor_p.h \
+$${QXLSX_HEADERPATH}xlsxcolumntyper_p.h \
+$${QXLSX_HEADERPATH}xlsxconditionalformatevaluator_p.h \
+$${QXLSX_HEADERPATH}xlsxconditionalformatoverlay.h \
+$${QXLSX_HEADERPATH}xlsxconditionalformatoverlay_p.h \
 $${QXLSX_HEADERPATH}xlsxconditionalformatting.h \
 $${QXLSX_HEADERPATH}xlsxconditionalformatting_p.h \
 $${QXLSX_HEADERPATH}xlsxcontenttypes_p.h \
+$${QXLSX_HEADERPATH}xlsxcsvoptions.h \
+$${QXLSX_HEADERPATH}xlsxcsvreader_p.h \
+$${QXLSX_HEADERPATH}xlsxcsvwriter_p.h \
 $${QXLSX_HEADERPATH}xlsxdatavalidation.h \
 $${QXLSX_HEADERPATH}xlsxdatavalidation_p.h \
+$${QXLSX_HEADERPATH}xlsxdatavalidator_p.h \
 $${QXLSX_HEADERPATH}xlsxdocpropsapp_p.h \
 $${QXLSX_HEADERPATH}xlsxdocpropscore_p.h \
 $${QXLSX_HEADERPATH}xlsxdocument.h \
 $${QXLSX_HEADERPATH}xlsxdocument_p.h \
 $${QXLSX_HEADERPATH}xlsxdrawinganchor_p.h \
 $${QXLSX_HEADERPATH}xlsxdrawing_p.h \
+$${QXLSX_HEADERPATH}xlsxflatbufferbuilder_p.h \
 $${QXLSX_HEADERPATH}xlsxformat.h \
 $${QXLSX_HEADERPATH}xlsxformat_p.h \
+$${QXLSX_HEADERPATH}xlsxformatresolver_p.h \
+$${QXLSX_HEADERPATH}xlsxformulaengine_p.h \
+$${QXLSX_HEADERPATH}xlsxformulaparser_p.h \
+$${QXLSX_HEADERPATH}xlsxgeometryindex_p.h \
 $${QXLSX_HEADERPATH}xlsxglobal.h \
+$${QXLSX_HEADERPATH}xlsxhtmlexporter.h \
+$${QXLSX_HEADERPATH}xlsxhtmlexporter_p.h \
+$${QXLSX_HEADERPATH}xlsxintervalmap_p.h \
 $${QXLSX_HEADERPATH}xlsxmediafile_p.h \
+$${QXLSX_HEADERPATH}xlsxnumberformatter_p.h \
 $${QXLSX_HEADERPATH}xlsxnumformatparser_p.h \
+$${QXLSX_HEADERPATH}xlsxnumericaggregate_p.h \
+$${QXLSX_HEADERPATH}xlsxnumericcodec_p.h \
 $${QXLSX_HEADERPATH}xlsxrelationships_p.h \
 $${QXLSX_HEADERPATH}xlsxrichstring.h \
 $${QXLSX_HEADERPATH}xlsxrichstring_p.h \
@@ -89,8 +113,12 @@ $${QXLSX_HEADERPATH}xlsxtheme_p.h \
 $${QXLSX_HEADERPATH}xlsxutility_p.h \
 $${QXLSX_HEADERPATH}xlsxworkbook.h \
 $${QXLSX_HEADERPATH}xlsxworkbook_p.h \
+$${QXLSX_HEADERPATH}xlsxworkscheduler_p.h \
 $${QXLSX_HEADERPATH}xlsxworksheet.h \
 $${QXLSX_HEADERPATH}xlsxworksheet_p.h \
+$${QXLSX_HEADERPATH}xlsxworksheetmodel.h \
+$${QXLSX_HEADERPATH}xlsxworksheetmodel_p.h \
+$${QXLSX_HEADERPATH}xlsxxmlemitter_p.h \
 $${QXLSX_HEADERPATH}xlsxzipreader_p.h \
 $${QXLSX_HEADERPATH}xlsxzipwriter_p.h \
 $${QXLSX_HEADERPATH}xlsxcelllocation.h
@@ -98,24 +126,44 @@ $${QXLSX_HEADERPATH}xlsxcelllocation.h
 SOURCES += \
 $${QXLSX_SOURCEPATH}xlsxabstractooxmlfile.cpp \
 $${QXLSX_SOURCEPATH}xlsxabstractsheet.cpp \
+$${QXLSX_SOURCEPATH}xlsxarrowexporter.cpp \
+$${QXLSX_SOURCEPATH}xlsxarrowstreamwriter.cpp \
+$${QXLSX_SOURCEPATH}xlsxcalcchain.cpp \
 $${QXLSX_SOURCEPATH}xlsxcell.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellformula.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellrange.cpp \
+$${QXLSX_SOURCEPATH}xlsxcellrangeindex.cpp \
 $${QXLSX_SOURCEPATH}xlsxcellreference.cpp \
 $${QXLSX_SOURCEPATH}xlsxchart.cpp \
 $${QXLSX_SOURCEPATH}xlsxchartsheet.cpp \
 $${QXLSX_SOURCEPATH}xlsxcolor.cpp \
+$${QXLSX_SOURCEPATH}xlsxcolumntyper.cpp \
+$${QXLSX_SOURCEPATH}xlsxconditionalformatevaluator.cpp \
+$${QXLSX_SOURCEPATH}xlsxconditionalformatoverlay.cpp \
 $${QXLSX_SOURCEPATH}xlsxconditionalformatting.cpp \
 $${QXLSX_SOURCEPATH}xlsxcontenttypes.cpp \
+$${QXLSX_SOURCEPATH}xlsxcsvoptions.cpp \
+$${QXLSX_SOURCEPATH}xlsxcsvreader.cpp \
+$${QXLSX_SOURCEPATH}xlsxcsvwriter.cpp \
 $${QXLSX_SOURCEPATH}xlsxdatavalidation.cpp \
+$${QXLSX_SOURCEPATH}xlsxdatavalidator.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocpropsapp.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocpropscore.cpp \
 $${QXLSX_SOURCEPATH}xlsxdocument.cpp \
 $${QXLSX_SOURCEPATH}xlsxdrawing.cpp \
 $${QXLSX_SOURCEPATH}xlsxdrawinganchor.cpp \
+$${QXLSX_SOURCEPATH}xlsxflatbufferbuilder.cpp \
 $${QXLSX_SOURCEPATH}xlsxformat.cpp \
+$${QXLSX_SOURCEPATH}xlsxformatresolver.cpp \
+$${QXLSX_SOURCEPATH}xlsxformulaengine.cpp \
+$${QXLSX_SOURCEPATH}xlsxformulaparser.cpp \
+$${QXLSX_SOURCEPATH}xlsxgeometryindex.cpp \
+$${QXLSX_SOURCEPATH}xlsxhtmlexporter.cpp \
 $${QXLSX_SOURCEPATH}xlsxmediafile.cpp \
+$${QXLSX_SOURCEPATH}xlsxnumberformatter.cpp \
 $${QXLSX_SOURCEPATH}xlsxnumformatparser.cpp \
+$${QXLSX_SOURCEPATH}xlsxnumericaggregate.cpp \
+$${QXLSX_SOURCEPATH}xlsxnumericcodec.cpp \
 $${QXLSX_SOURCEPATH}xlsxrelationships.cpp \
 $${QXLSX_SOURCEPATH}xlsxrichstring.cpp \
 $${QXLSX_SOURCEPATH}xlsxsharedstrings.cpp \
@@ -124,11 +172,24 @@ $${QXLSX_SOURCEPATH}xlsxstyles.cpp \
 $${QXLSX_SOURCEPATH}xlsxtheme.cpp \
 $${QXLSX_SOURCEPATH}xlsxutility.cpp \
 $${QXLSX_SOURCEPATH}xlsxworkbook.cpp \
+$${QXLSX_SOURCEPATH}xlsxworkscheduler.cpp \
 $${QXLSX_SOURCEPATH}xlsxworksheet.cpp \
+$${QXLSX_SOURCEPATH}xlsxworksheetmodel.cpp \
+$${QXLSX_SOURCEPATH}xlsxxmlemitter.cpp \
 $${QXLSX_SOURCEPATH}xlsxzipreader.cpp \
 $${QXLSX_SOURCEPATH}xlsxzipwriter.cpp \
 $${QXLSX_SOURCEPATH}xlsxcelllocation.cpp
 
+# SqliteImporter, built when the Qt SQL module is there
+qtHaveModule(sql) {
+    QT += sql
+    HEADERS += \
+    $${QXLSX_HEADERPATH}xlsxsqliteimporter.h \
+    $${QXLSX_HEADERPATH}xlsxsqliteimporter_p.h
+    SOURCES += \
+    $${QXLSX_SOURCEPATH}xlsxsqliteimporter.cpp
+}
+
 
 ######################################################################
 # custom setting for compiler & system
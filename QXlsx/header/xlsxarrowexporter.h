@@ -0,0 +1,43 @@
+// xlsxarrowexporter.h
+
+#ifndef QXLSX_XLSXARROWEXPORTER_H
+#define QXLSX_XLSXARROWEXPORTER_H
+
+#include <QtGlobal>
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class ArrowExporterPrivate;
+
+class ArrowExporter
+{
+	Q_DECLARE_PRIVATE(ArrowExporter)
+public:
+	explicit ArrowExporter(Worksheet *sheet);
+	~ArrowExporter();
+
+	Worksheet *worksheet() const;
+
+	CellRange range() const;
+	void setRange(const CellRange &range);
+	bool hasHeaderRow() const;
+	void setHeaderRow(bool header);
+	int batchSize() const;
+	void setBatchSize(int rows);
+
+	bool exportStream(QIODevice *device);
+
+private:
+	Q_DISABLE_COPY(ArrowExporter)
+	ArrowExporterPrivate * const d_ptr;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXARROWEXPORTER_H
@@ -0,0 +1,61 @@
+// xlsxarrowexporter_p.h
+
+#ifndef XLSXARROWEXPORTER_P_H
+#define XLSXARROWEXPORTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxarrowexporter.h"
+#include "xlsxarrowstreamwriter_p.h"
+#include "xlsxcolumntyper_p.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Cell;
+struct FormulaValue;
+
+class ArrowExporterPrivate
+{
+	Q_DECLARE_PUBLIC(ArrowExporter)
+public:
+	ArrowExporterPrivate(ArrowExporter *p, Worksheet *sheet);
+
+	bool writeStream(ArrowStreamWriter &writer);
+	void setFields(const CellRange &range, int firstDataRow);
+	void fillBatch(const CellRange &range, int firstRow, int lastRow);
+	void setValue(ArrowColumnData &column, ArrowField::Type type, int row, const Cell *cell);
+	int stringIndex(const Cell *cell, const FormulaValue &value);
+	qint64 timestampOf(double serial) const;
+
+	ArrowExporter *q_ptr;
+	Worksheet *sheet;
+	CellRange range;
+	bool headerRow;
+	int batchSize;
+
+	// State of the current export
+	bool date1904;
+	QVector<ArrowField> fields;
+	QVector<ArrowColumnData> columns;
+	int stringCount;                 // strings of the dictionary so far, the shared strings first
+	QHash<QString, int> otherStrings; // strings of the dictionary which aren't shared strings
+	ArrowStringData newStrings;      // added to the dictionary by the current batch
+	ColumnTyper *typer;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXARROWEXPORTER_P_H
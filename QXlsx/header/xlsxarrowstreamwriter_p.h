@@ -0,0 +1,96 @@
+// xlsxarrowstreamwriter_p.h
+
+#ifndef XLSXARROWSTREAMWRITER_P_H
+#define XLSXARROWSTREAMWRITER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxflatbufferbuilder_p.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+struct ArrowField
+{
+    // String is a dictionary encoded utf8 column, with int32 indexes
+    // into the dictionary 0 shared by all the string columns.
+    enum Type { Int64, Float64, Boolean, Timestamp, String };
+
+    ArrowField() : type(String) {}
+
+    QString name;
+    Type type;
+};
+
+// Buffers of a column of a record batch
+struct ArrowColumnData
+{
+    ArrowColumnData() : nullCount(0) {}
+
+    QByteArray validity; // one bit per row, set for the rows which have a value
+    QByteArray values;   // bits of the booleans, int32 indexes of the strings, or 8 bytes a value
+    qint64 nullCount;
+};
+
+// Strings of a dictionary batch
+struct ArrowStringData
+{
+    ArrowStringData() { clear(); }
+
+    void clear();
+    void append(const QString &string);
+
+    QByteArray offsets;  // int32 start of each string in data, and the end of the last one
+    QByteArray data;
+    int count;
+};
+
+/*
+ * Writes the messages of an Arrow IPC stream: the schema, the
+ * dictionaries and the record batches, each one as soon as it is
+ * given, and the end of the stream.
+ *
+ * The metadata of the messages are flatbuffers, built with
+ * FlatBufferBuilder, so no Arrow library is needed.
+ */
+class ArrowStreamWriter
+{
+public:
+    explicit ArrowStreamWriter(QIODevice *device);
+
+    bool writeSchema(const QVector<ArrowField> &fields);
+    bool writeDictionary(const ArrowStringData &strings, bool delta);
+    bool writeRecordBatch(qint64 length, const QVector<ArrowColumnData> &columns);
+    bool writeEndOfStream();
+
+    bool hasError() const { return m_error; }
+
+private:
+    int recordBatch(qint64 length, const QVector<qint64> &nodes,
+                    const QVector<const QByteArray *> &buffers, qint64 *bodyLength);
+    bool writeMessage(quint8 headerType, int header, qint64 bodyLength);
+    bool writeBody(const QVector<const QByteArray *> &buffers);
+    bool write(const char *data, qint64 size);
+
+    QIODevice *m_device;
+    bool m_error;
+    FlatBufferBuilder m_builder;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXARROWSTREAMWRITER_P_H
@@ -0,0 +1,58 @@
+// xlsxcalcchain_p.h
+
+#ifndef XLSXCALCCHAIN_P_H
+#define XLSXCALCCHAIN_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxabstractooxmlfile.h"
+
+#include <QVector>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * The calcChain part: the formula cells of the workbook, in the order
+ * they were calculated last.
+ */
+class CalcChain : public AbstractOOXmlFile
+{
+public:
+    struct Entry
+    {
+        int sheetId;
+        int row;
+        int column;
+        bool newLevel; // first cell of a new dependency level
+        bool array;    // anchor of an array formula
+    };
+
+    CalcChain(CreateFlag flag);
+
+    void clear();
+    void addCell(int sheetId, int row, int column, bool newLevel=false, bool array=false);
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int count() const { return m_entries.size(); }
+    const Entry &entry(int index) const { return m_entries[index]; }
+
+    void saveToXmlFile(QIODevice *device) const;
+    bool loadFromXmlFile(QIODevice *device);
+
+private:
+    QVector<Entry> m_entries;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCALCCHAIN_P_H
@@ -15,6 +15,7 @@ class CellFormulaPrivate;
 class CellRange;
 class Worksheet;
 class WorksheetPrivate;
+class FormulaEngine;
 
 class   CellFormula
 {
@@ -46,6 +47,7 @@ public:
 private:
     friend class Worksheet;
     friend class WorksheetPrivate;
+    friend class FormulaEngine;
     QExplicitlySharedDataPointer<CellFormulaPrivate> d;
 };
 
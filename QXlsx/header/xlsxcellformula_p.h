@@ -39,6 +39,7 @@
 #include "xlsxglobal.h"
 #include "xlsxcellformula.h"
 #include "xlsxcellrange.h"
+#include "xlsxformulaparser_p.h"
 
 #include <QSharedData>
 #include <QString>
@@ -52,11 +53,17 @@ public:
     CellFormulaPrivate(const CellFormulaPrivate &other);
     ~CellFormulaPrivate();
 
+    const FormulaExpression &expression() const;
+    void setFormulaText(const QString &text);
+
     QString formula; //formula contents
     CellFormula::FormulaType type;
     CellRange reference;
     bool ca; //Calculate Cell
     int si;  //Shared group index
+
+    mutable FormulaExpression parsedFormula; //parsed on first use
+    mutable bool parsed;
 };
 
 QT_END_NAMESPACE_XLSX
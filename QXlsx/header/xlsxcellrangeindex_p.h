@@ -0,0 +1,79 @@
+// xlsxcellrangeindex_p.h
+
+#ifndef XLSXCELLRANGEINDEX_P_H
+#define XLSXCELLRANGEINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * R-tree of cell ranges, each with an int value, such as the index of
+ * the merge, data validation or conditional formatting it belongs to.
+ *
+ * Finding the ranges which overlap a cell or a range takes logarithmic
+ * time, as long as the ranges don't pile up on each other.
+ */
+class CellRangeIndex
+{
+public:
+    CellRangeIndex();
+    ~CellRangeIndex();
+
+    void insert(const CellRange &range, int value);
+    bool remove(const CellRange &range, int value);
+    void clear();
+
+    bool isEmpty() const { return m_size == 0; }
+    int size() const { return m_size; }
+
+    bool intersects(const CellRange &range) const;
+    QVector<int> find(const CellRange &range) const;
+    QVector<int> find(int row, int column) const;
+
+private:
+    Q_DISABLE_COPY(CellRangeIndex)
+
+    struct Rect
+    {
+        int firstRow;
+        int firstColumn;
+        int lastRow;
+        int lastColumn;
+    };
+
+    struct Entry
+    {
+        Rect rect;
+        int value;
+    };
+
+    struct Node;
+
+    static Rect toRect(const CellRange &range);
+    static Node *insertEntry(Node *node, const Entry &entry);
+    static Node *splitNode(Node *node);
+    static bool removeEntry(Node *node, const Entry &entry, QVector<Entry> *orphans);
+    static void collectEntries(const Node *node, QVector<Entry> *entries);
+    static bool search(const Node *node, const Rect &rect, QVector<int> *values);
+
+    Node *m_root;
+    int m_size;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCELLRANGEINDEX_P_H
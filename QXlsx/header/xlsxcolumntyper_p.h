@@ -0,0 +1,60 @@
+// xlsxcolumntyper_p.h
+
+#ifndef XLSXCOLUMNTYPER_P_H
+#define XLSXCOLUMNTYPER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+#include "xlsxnumberformatter_p.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class Cell;
+struct FormulaValue;
+
+/*
+ * Chooses a type for each column of a range of a worksheet, for the
+ * exports to typed columns: a column whose values are all integers,
+ * numbers, dates or booleans gets that type, any other column is of
+ * text. Dates among other numbers stay numbers.
+ */
+class ColumnTyper
+{
+public:
+    enum Type { Integer, Number, DateTime, Boolean, Text };
+
+    explicit ColumnTyper(Worksheet *sheet);
+
+    QStringList columnNames(const CellRange &range, bool headerRow);
+    QVector<Type> columnTypes(const CellRange &range, int firstDataRow);
+
+    bool isDate(const Cell *cell);
+    QString textOf(const Cell *cell, const FormulaValue &value);
+    bool isDate1904() const { return m_date1904; }
+
+private:
+    Worksheet *m_sheet;
+    bool m_date1904;
+    QHash<int, bool> m_dateStyles; // by xf index
+    NumberFormatter m_numbers;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCOLUMNTYPER_P_H
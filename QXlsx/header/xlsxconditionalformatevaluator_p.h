@@ -0,0 +1,146 @@
+// xlsxconditionalformatevaluator_p.h
+
+#ifndef XLSXCONDITIONALFORMATEVALUATOR_P_H
+#define XLSXCONDITIONALFORMATEVALUATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxformat.h"
+#include "xlsxconditionalformatting.h"
+#include "xlsxconditionalformatoverlay.h"
+#include "xlsxcellrangeindex_p.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QColor>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class XlsxCfRuleData;
+
+/*
+ * Evaluates the conditional formattings of a worksheet for its cells.
+ *
+ * The rules are taken by priority, until one which holds has
+ * stopIfTrue set. The statistics of a rule over its ranges, such as
+ * the minimum, the maximum, the percentiles, the average or the counts
+ * of the values, are computed the first time a cell needs them, then
+ * used for all the cells of the rule.
+ *
+ * The cells are seen with their cached values, so the workbook should
+ * be calculated first.
+ */
+class ConditionalFormatEvaluator
+{
+public:
+    explicit ConditionalFormatEvaluator(Worksheet *sheet);
+    ~ConditionalFormatEvaluator();
+
+    ConditionalFormatOverlay overlayAt(int row, int column) const;
+    QMap<int, QMap<int, ConditionalFormatOverlay> > overlays(const CellRange &cells = CellRange()) const;
+
+private:
+    Q_DISABLE_COPY(ConditionalFormatEvaluator)
+
+    enum RuleType {
+        CellIs,
+        Expression,
+        ContainsText,
+        NotContainsText,
+        BeginsWith,
+        EndsWith,
+        ContainsBlanks,
+        NotContainsBlanks,
+        ContainsErrors,
+        NotContainsErrors,
+        DuplicateValues,
+        UniqueValues,
+        Top10,
+        AboveAverage,
+        ColorScale,
+        DataBar,
+        Unsupported
+    };
+
+    struct Threshold
+    {
+        ConditionalFormatting::ValueObjectType type;
+        double number;                          // of VOT_Num, VOT_Percent and VOT_Percentile
+        FormulaEngine::RangeFormula formula;    // of VOT_Formula
+    };
+
+    // Of the values of the ranges of a rule
+    struct Statistics
+    {
+        Statistics() : ready(false), mean(0), deviation(0) {}
+
+        bool ready;
+        QVector<double> numbers;    // ascending
+        double mean;
+        double deviation;
+        QHash<QString, int> counts; // per value key, for duplicates
+        double limits[3];           // top/bottom threshold, or the scale thresholds
+    };
+
+    struct Rule
+    {
+        Rule() : type(Unsupported), stopIfTrue(false), rank(10), bottom(false), percent(false),
+            above(true), equalAverage(false), stdDev(0), stops(0), hideValue(false) {}
+
+        RuleType type;
+        bool stopIfTrue;
+        QList<CellRange> ranges;
+        Format format;
+
+        QString op;                             // of CellIs
+        QString text;                           // of the text rules
+        FormulaEngine::RangeFormula formula1;
+        FormulaEngine::RangeFormula formula2;
+
+        int rank;
+        bool bottom;
+        bool percent;
+
+        bool above;
+        bool equalAverage;
+        int stdDev;
+
+        int stops;                              // thresholds of the color scale or the data bar
+        Threshold thresholds[3];
+        QColor colors[3];
+        bool hideValue;
+
+        mutable Statistics statistics;
+    };
+
+    Rule makeRule(const ConditionalFormatting &cf, const XlsxCfRuleData &data) const;
+    const Statistics &statistics(const Rule &rule) const;
+    double thresholdValue(const Rule &rule, const Statistics &statistics, int index) const;
+    FormulaValue valueAt(int row, int column) const;
+    bool apply(const Rule &rule, int row, int column, const FormulaValue &value,
+               ConditionalFormatOverlay *overlay) const;
+    bool holds(const Rule &rule, int row, int column, const FormulaValue &value) const;
+
+    Worksheet *m_sheet;
+    const FormulaEngine *m_engine;
+    bool m_date1904;
+    QVector<Rule> m_rules;      // by priority
+    CellRangeIndex m_index;     // ranges of the rules, with their indexes in m_rules
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCONDITIONALFORMATEVALUATOR_P_H
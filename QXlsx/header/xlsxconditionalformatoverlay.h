@@ -0,0 +1,40 @@
+// xlsxconditionalformatoverlay.h
+
+#ifndef QXLSX_XLSXCONDITIONALFORMATOVERLAY_H
+#define QXLSX_XLSXCONDITIONALFORMATOVERLAY_H
+
+#include <QtGlobal>
+#include <QColor>
+#include <QSharedDataPointer>
+
+#include "xlsxglobal.h"
+#include "xlsxformat.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class ConditionalFormatOverlayPrivate;
+
+class ConditionalFormatOverlay
+{
+public:
+    ConditionalFormatOverlay();
+    ConditionalFormatOverlay(const ConditionalFormatOverlay &other);
+    ~ConditionalFormatOverlay();
+    ConditionalFormatOverlay &operator=(const ConditionalFormatOverlay &other);
+
+    bool isEmpty() const;
+
+    Format format() const;
+    QColor scaleColor() const;
+    QColor dataBarColor() const;
+    double dataBarLength() const;
+    bool isValueHidden() const;
+
+private:
+    friend class ConditionalFormatEvaluator;
+    QSharedDataPointer<ConditionalFormatOverlayPrivate> d;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXCONDITIONALFORMATOVERLAY_H
@@ -0,0 +1,38 @@
+// xlsxconditionalformatoverlay_p.h
+
+#ifndef XLSXCONDITIONALFORMATOVERLAY_P_H
+#define XLSXCONDITIONALFORMATOVERLAY_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxconditionalformatoverlay.h"
+
+#include <QSharedData>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class ConditionalFormatOverlayPrivate : public QSharedData
+{
+public:
+    ConditionalFormatOverlayPrivate();
+    ConditionalFormatOverlayPrivate(const ConditionalFormatOverlayPrivate &other);
+    ~ConditionalFormatOverlayPrivate();
+
+    Format format;
+    QColor scaleColor;
+    QColor dataBarColor;
+    double dataBarLength;
+    bool hideValue;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCONDITIONALFORMATOVERLAY_P_H
@@ -105,6 +105,7 @@ public:
 
 private:
     friend class Worksheet;
+    friend class ConditionalFormatEvaluator;
     friend class ::ConditionalFormattingTest;
 
 private:
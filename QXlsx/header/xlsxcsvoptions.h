@@ -0,0 +1,34 @@
+// xlsxcsvoptions.h
+
+#ifndef QXLSX_XLSXCSVOPTIONS_H
+#define QXLSX_XLSXCSVOPTIONS_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class CsvOptions
+{
+public:
+    CsvOptions();
+
+    static CsvOptions tsv();
+
+    char delimiter;
+    char quoteChar;
+    QByteArray lineTerminator;
+    bool writeByteOrderMark;
+    bool applyNumberFormats;
+    bool inferTypes;
+    int threadCount;
+
+    CellRange range;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXCSVOPTIONS_H
@@ -0,0 +1,110 @@
+// xlsxcsvreader_p.h
+
+#ifndef XLSXCSVREADER_P_H
+#define XLSXCSVREADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcsvoptions.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class WorkScheduler;
+
+struct CsvField
+{
+    enum Type { Number, Boolean, Date, Time, DateTime, String };
+
+    int row;        // record, from the first one of the chunk
+    int column;     // field, from the first one of the record
+    Type type;
+    double number;  // numbers, booleans, and serial numbers of dates
+    int string;     // index in the strings of the chunk
+};
+
+/*
+ * Fields parsed from a run of whole records. Each distinct text is only
+ * decoded once, and the fields which hold it share it.
+ */
+struct CsvChunk
+{
+    CsvChunk() : records(0) {}
+
+    QVector<CsvField> fields;
+    QVector<QString> strings;
+    int records;
+};
+
+/*
+ * Reads CSV from a device, a batch of records at a time.
+ *
+ * A batch of input is split into chunks which start at the beginning of
+ * a record, and the chunks are parsed on the threads of a WorkScheduler.
+ * Where a record begins follows from whether the line break before it
+ * is inside a quoted field, with the rule of the parser: a quote
+ * character opens a quoted field at the start of a field only, and is
+ * kept as it is anywhere else. Each chunk is first scanned in parallel
+ * from each state a field may be in at its start, so only the search
+ * for the line break after the end of each chunk is sequential.
+ */
+class CsvReader
+{
+public:
+    CsvReader(QIODevice *device, const CsvOptions &options, bool date1904);
+    ~CsvReader();
+
+    bool readBatch();
+    const QVector<CsvChunk> &chunks() const { return m_chunks; }
+    bool hasError() const { return m_error; }
+
+    static bool parseNumber(const char *data, int size, double *value);
+    static bool parseDateTime(const char *data, int size, bool date1904, CsvField::Type *type, double *value);
+
+private:
+    Q_DISABLE_COPY(CsvReader)
+
+    // Where split() is in the fields of a record
+    enum ScanState { FieldStart, Unquoted, Quoted, QuoteInQuoted, ScanStates };
+
+    void fill(int size);
+    void split(int sliceCount);
+    int parse(const char *begin, const char *end, bool complete, CsvChunk *chunk) const;
+    void addField(const char *data, int size, int row, int column,
+                  CsvChunk *chunk, QHash<QByteArray, int> *strings) const;
+
+    QIODevice *m_device;
+    CsvOptions m_options;
+    bool m_date1904;
+    bool m_atEnd;
+    bool m_error;
+    QScopedPointer<WorkScheduler> m_scheduler;
+
+    // Input of the current batch, which starts at the beginning of a
+    // record, and the offsets at which its chunks start and end
+    QByteArray m_data;
+    QVector<int> m_boundaries;
+    int m_consumed;
+
+    QVector<CsvChunk> m_chunks;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCSVREADER_P_H
@@ -0,0 +1,79 @@
+// xlsxcsvwriter_p.h
+
+#ifndef XLSXCSVWRITER_P_H
+#define XLSXCSVWRITER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcsvoptions.h"
+#include "xlsxformat.h"
+#include "xlsxnumberformatter_p.h"
+
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+struct FormulaValue;
+
+/*
+ * Writes records of fields to a device as CSV, in UTF-8.
+ *
+ * The output goes through a buffer of fixed size, which is written to
+ * the device whenever it is full, so the memory used doesn't depend on
+ * the size of the data.
+ */
+class CsvWriter
+{
+public:
+    CsvWriter(QIODevice *device, const CsvOptions &options, bool date1904);
+
+    void writeField(const FormulaValue &value, const Format &format);
+    void writeEmptyField();
+    void writeEmptyRecord(int fields);
+    void endRecord();
+
+    bool flush();
+    bool hasError() const { return m_error; }
+
+private:
+    void writeNumber(double value, const Format &format);
+    void writeText(const QString &text);
+    void writeLatin1(const char *data, int size);
+    void separate();
+
+    inline void put(char c)
+    {
+        if (m_used == BufferSize)
+            flushBuffer();
+        m_data[m_used++] = c;
+    }
+    void flushBuffer();
+
+    enum { BufferSize = 64 * 1024 };
+
+    QIODevice *m_device;
+    CsvOptions m_options;
+    NumberFormatter m_numbers;
+    bool m_error;
+    int m_fields;   // fields written to the current record
+
+    QByteArray m_buffer;
+    char *m_data;
+    int m_used;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXCSVWRITER_P_H
@@ -0,0 +1,99 @@
+// xlsxdatavalidator_p.h
+
+#ifndef XLSXDATAVALIDATOR_P_H
+#define XLSXDATAVALIDATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxdatavalidation.h"
+#include "xlsxcellrange.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QSet>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class CellRangeIndex;
+
+/*
+ * Checks the cells of a worksheet against its data validations.
+ *
+ * The cells are run through once, and the validations covering each
+ * of them are looked up in the index of their ranges. The members of
+ * the lists, either written in the formula or taken from a range, are
+ * gathered in a hash set beforehand, as are the bounds which are plain
+ * numbers.
+ *
+ * Empty cells only break the validations which don't allow blanks, and
+ * are only looked for within the used range of the sheet.
+ */
+class DataValidator
+{
+public:
+    struct Violation
+    {
+        int row;
+        int column;
+        int validation; // index in the validations
+    };
+
+    DataValidator(Worksheet *sheet, const FormulaEngine *engine, const QList<DataValidation> &validations,
+                  const CellRangeIndex &index);
+    ~DataValidator();
+
+    QVector<Violation> validate() const;
+
+private:
+    Q_DISABLE_COPY(DataValidator)
+
+    struct Bound
+    {
+        Bound() : constant(false), number(0) {}
+
+        bool constant;
+        double number;
+        FormulaEngine::RangeFormula formula;
+    };
+
+    struct Rule
+    {
+        Rule() : type(DataValidation::None), op(DataValidation::Between), allowBlank(true), acceptsAll(false) {}
+
+        DataValidation::ValidationType type;
+        DataValidation::ValidationOperator op;
+        bool allowBlank;
+        bool acceptsAll;    // the rule can't be checked, such as a list of an unsupported formula
+        QList<CellRange> ranges;
+        Bound first;
+        Bound second;
+        QSet<QString> members;
+    };
+
+    Rule makeRule(const DataValidation &validation) const;
+    void addMembers(const FormulaValue &source, Rule *rule) const;
+    bool bound(const Bound &bound, int row, int column, double *number) const;
+    bool isValid(const Rule &rule, int row, int column, const FormulaValue &value) const;
+
+    Worksheet *m_sheet;
+    const FormulaEngine *m_engine;
+    const CellRangeIndex &m_index;
+    bool m_date1904;
+    QVector<Rule> m_rules;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXDATAVALIDATOR_P_H
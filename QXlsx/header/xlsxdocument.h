@@ -42,6 +42,7 @@ public:
 	QVariant read(int row, int col) const;
 	
 	bool insertImage(int row, int col, const QImage &image);
+	bool insertImage(int row, int col, const QByteArray &data, const QString &mimeType);
 	
 	Chart *insertChart(int row, int col, const QSize &size);
 	
@@ -76,6 +76,7 @@ public:
     DrawingAnchor(Drawing *drawing, ObjectType objectType);
     virtual ~DrawingAnchor();
     void setObjectPicture(const QImage &img);
+    void setObjectPicture(const QByteArray &data, const QString &suffix, const QString &mimeType);
 	
     void setObjectGraphicFrame(QSharedPointer<Chart> chart);
 
@@ -0,0 +1,69 @@
+// xlsxflatbufferbuilder_p.h
+
+#ifndef XLSXFLATBUFFERBUILDER_P_H
+#define XLSXFLATBUFFERBUILDER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QByteArray>
+#include <QPair>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Builds a FlatBuffers buffer, as the metadata of the Arrow IPC
+ * messages are, without the FlatBuffers library.
+ *
+ * As with the library the buffer is built from its end: the strings,
+ * vectors and tables are created before the tables which refer to
+ * them, and are referred to by the int returned, their distance from
+ * the end of the buffer. Only one table can be built at a time.
+ */
+class FlatBufferBuilder
+{
+public:
+    FlatBufferBuilder();
+
+    void clear();
+
+    int createString(const QByteArray &utf8);
+    int createOffsetVector(const QVector<int> &objects);
+    int createStructVector(const QVector<qint64> &values);
+
+    void startTable();
+    void addBool(int slot, bool value) { addScalar(slot, value ? 1 : 0, 1); }
+    void addUInt8(int slot, quint8 value) { addScalar(slot, value, 1); }
+    void addInt16(int slot, qint16 value) { addScalar(slot, quint16(value), 2); }
+    void addInt32(int slot, qint32 value) { addScalar(slot, quint32(value), 4); }
+    void addInt64(int slot, qint64 value) { addScalar(slot, quint64(value), 8); }
+    void addOffset(int slot, int object);
+    int endTable();
+
+    QByteArray finish(int root);
+
+private:
+    int size() const { return m_reversed.size(); }
+    void align(int size, int alignment);
+    void push(quint64 value, int size);
+    void pushOffset(int object);
+    void addScalar(int slot, quint64 value, int size);
+
+    QByteArray m_reversed; // the buffer, last byte first
+    QVector<QPair<int, int> > m_fields; // slot and position of the fields of the current table
+    int m_tableStart;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXFLATBUFFERBUILDER_P_H
@@ -0,0 +1,58 @@
+// xlsxformatresolver_p.h
+
+#ifndef XLSXFORMATRESOLVER_P_H
+#define XLSXFORMATRESOLVER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxformat.h"
+#include "xlsxworksheet_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Format a cell is displayed with: its own format, else the format of
+ * its row, else the one of its column, else the default format.
+ *
+ * The run of rows and the run of columns last looked up are kept, so
+ * that going through the cells row by row, from left to right, mostly
+ * takes no lookup at all.
+ */
+class FormatResolver
+{
+public:
+    FormatResolver(const IntervalMap<XlsxRowInfo> &rowsInfo, const IntervalMap<XlsxColumnInfo> &colsInfo);
+
+    Format format(int row, int column, const Format &cellFormat);
+
+private:
+    const Format &rowFormat(int row);
+    const Format &columnFormat(int column);
+
+    template <typename T>
+    static void findRun(const IntervalMap<T> &map, int index, int *first, int *last, Format *format);
+
+    const IntervalMap<XlsxRowInfo> &m_rowsInfo;
+    const IntervalMap<XlsxColumnInfo> &m_colsInfo;
+
+    // Rows and columns covered by the cached formats
+    int m_firstRow;
+    int m_lastRow;
+    Format m_rowFormat;
+    int m_firstColumn;
+    int m_lastColumn;
+    Format m_columnFormat;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXFORMATRESOLVER_P_H
@@ -0,0 +1,271 @@
+// xlsxformulaengine_p.h
+
+#ifndef XLSXFORMULAENGINE_P_H
+#define XLSXFORMULAENGINE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxcellformula.h"
+#include "xlsxformulaparser_p.h"
+#include "xlsxnumericaggregate_p.h"
+#include "xlsxcellrangeindex_p.h"
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+#include <QPair>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Workbook;
+class Worksheet;
+class Cell;
+class CalcChain;
+
+/*
+ * Value of a formula operand or result.
+ */
+struct FormulaValue
+{
+    enum Type {
+        Blank,
+        Number,
+        String,
+        Boolean,
+        Error,  // text holds the error, such as "#DIV/0!"
+        Area,   // cells firstRow:lastRow x firstColumn:lastColumn of sheet
+        Array   // elements, row by row
+    };
+
+    FormulaValue() : type(Blank), number(0), sheet(0),
+        firstRow(0), firstColumn(0), lastRow(0), lastColumn(0), columns(0) {}
+
+    static FormulaValue fromNumber(double number);
+    static FormulaValue fromString(const QString &text);
+    static FormulaValue fromBoolean(bool value);
+    static FormulaValue fromError(const char *error);
+    static FormulaValue fromArea(Worksheet *sheet, int firstRow, int firstColumn, int lastRow, int lastColumn);
+
+    bool isError() const { return type == Error; }
+
+    Type type;
+    double number;
+    QString text;
+
+    Worksheet *sheet;
+    int firstRow;
+    int firstColumn;
+    int lastRow;
+    int lastColumn;
+
+    QVector<FormulaValue> elements;
+    int columns;
+};
+
+/*
+ * Calculation engine of a workbook.
+ *
+ * The formulas of all the worksheets are kept in a dependency graph,
+ * built the first time the workbook is calculated. From then on, every
+ * change of a cell marks the formulas which depend on it as dirty, and
+ * recalculate() only evaluates the dirty formulas, precedents first.
+ *
+ * The results are stored as the cached values of the cells, which are
+ * written to the <v> elements when the workbook is saved.
+ *
+ * Evaluating a formula only reads the cells and writes its own cell,
+ * so independent formulas are evaluated on several threads.
+ *
+ * The numbers of the columns aggregated over large areas are kept in
+ * contiguous arrays, which SUM, AVERAGE, MIN, MAX and COUNT run through
+ * with vector instructions. An array is dropped when a cell of its
+ * column changes.
+ */
+class FormulaEngine
+{
+    struct Program;
+
+public:
+    /*
+     * Formula of a conditional formatting or a data validation. Its
+     * relative references are written for the cell at row and column,
+     * and move with the cell it is evaluated for.
+     */
+    class RangeFormula
+    {
+    public:
+        RangeFormula() : sheet(0), row(0), column(0) {}
+        bool isValid() const { return program && program->supported; }
+
+    private:
+        friend class FormulaEngine;
+
+        CellFormula formula;
+        QSharedPointer<const Program> program;
+        Worksheet *sheet;
+        int row;
+        int column;
+    };
+
+    explicit FormulaEngine(Workbook *workbook);
+    ~FormulaEngine();
+
+    void cellChanged(Worksheet *sheet, int row, int column);
+    void cachedValuesLoaded();
+    void invalidate();
+
+    int recalculate();
+
+    void buildCalcChain(CalcChain *chain);
+
+    bool aggregateArea(const FormulaValue &area, bool date1904, NumericAggregate *result, FormulaValue *error) const;
+
+    RangeFormula compileRangeFormula(const QString &text, Worksheet *sheet, int row, int column) const;
+    FormulaValue evaluateRangeFormula(const RangeFormula &formula, int row, int column, bool intersect = true) const;
+
+    static const QMap<int, QMap<int, QSharedPointer<Cell> > > &cellTable(Worksheet *sheet);
+    static FormulaValue valueOf(const Cell *cell, bool date1904);
+    static QString textOf(const FormulaValue &value);
+    static QString valueKey(const FormulaValue &value);
+    static int compare(const FormulaValue &a, const FormulaValue &b);
+
+private:
+    Q_DISABLE_COPY(FormulaEngine)
+
+    struct CellKey
+    {
+        CellKey() : sheet(0), row(0), column(0) {}
+        CellKey(Worksheet *sheet, int row, int column) : sheet(sheet), row(row), column(column) {}
+        bool operator==(const CellKey &other) const
+        {
+            return sheet == other.sheet && row == other.row && column == other.column;
+        }
+
+        Worksheet *sheet;
+        int row;
+        int column;
+    };
+    friend uint qHash(const CellKey &key, uint seed);
+
+    struct AreaKey
+    {
+        Worksheet *sheet;
+        int firstRow;
+        int firstColumn;
+        int lastRow;
+        int lastColumn;
+        int node; // -1 once removed
+    };
+
+    // What the tokens of an expression refer to, shared by the cells of
+    // a shared formula.
+    struct Program
+    {
+        Program() : supported(true), isVolatile(false), aggregatesAreas(false) {}
+
+        QVector<short> functions;            // per token, function of the Function tokens
+        QVector<Worksheet *> sheets;         // per token, sheet of the Reference tokens
+        QHash<int, FormulaValue> names;      // token index -> value of the defined name
+        bool supported;
+        bool isVolatile;
+        bool aggregatesAreas;                // uses SUM, AVERAGE, MIN, MAX or COUNT
+    };
+
+    struct Node
+    {
+        Node() : sheet(0), row(0), column(0), rowOffset(0), columnOffset(0), dirty(false) {}
+
+        Worksheet *sheet; // 0 when the slot is free
+        int row;
+        int column;
+
+        CellFormula formula; // the cell formula, or the root of a shared formula
+        int rowOffset;
+        int columnOffset;
+        QSharedPointer<const Program> program;
+
+        QVector<CellKey> cells;  // precedent cells
+        QVector<int> areas;      // precedent areas, in m_areas
+        bool dirty;
+    };
+
+    typedef QHash<QPair<const void *, Worksheet *>, QSharedPointer<const Program> > ProgramCache;
+
+    // Numbers of the cells of a column, from its first non-empty cell
+    struct NumericColumn
+    {
+        NumericColumn() : firstRow(0), date1904(false) {}
+
+        int firstRow;
+        bool date1904;
+        QVector<double> values;   // per row, NaN if the cell is not a number
+        QVector<int> errorRows;   // rows of the error cells, ascending
+        QVector<QString> errors;
+    };
+
+    struct Context
+    {
+        Worksheet *sheet;
+        int row;
+        int column;
+        bool date1904;
+    };
+
+    void build();
+    QVector<QVector<int> > sortLevels(const QVector<int> &indexes, const QVector<char> &members) const;
+    void updateNode(const CellKey &key);
+    int addNode(const CellKey &key, Cell *cell, ProgramCache *programs);
+    void removeNode(int index);
+    void markDirty(int index);
+    void markDependentsDirty(const CellKey &key);
+    void appendAreaDependents(const CellKey &key, QVector<int> *nodes) const;
+
+    bool cellFormula(const CellKey &key, Cell *cell, CellFormula *formula, int *rowOffset, int *columnOffset) const;
+    QSharedPointer<const Program> compile(const FormulaExpression &expression, Worksheet *sheet) const;
+    Worksheet *findSheet(const QString &name) const;
+    bool resolveName(const QString &name, Worksheet *sheet, FormulaValue *value) const;
+    FormulaReference offsetReference(const FormulaReference &ref, int rowOffset, int columnOffset, bool *valid) const;
+
+    QSharedPointer<const NumericColumn> numericColumn(Worksheet *sheet, int column, bool date1904) const;
+    void dropNumericColumn(Worksheet *sheet, int column);
+    void prepareNumericColumns(const QVector<int> &level, bool date1904) const;
+
+    void evaluateNode(const Node &node) const;
+    FormulaValue evaluate(const Node &node, const Context &context) const;
+    FormulaValue callFunction(int function, const FormulaValue *args, int count, const Context &context) const;
+
+    Workbook *m_workbook;
+    bool m_built;
+    bool m_allDirty;
+    QVector<CellKey> m_pending;
+
+    QVector<Node> m_nodes;
+    QVector<int> m_freeNodes;
+    QHash<CellKey, int> m_nodeIndex;
+    QHash<Worksheet *, QMap<int, QMap<int, int> > > m_sheetNodes;
+    QHash<CellKey, QVector<int> > m_cellDependents;
+    QVector<AreaKey> m_areas;
+    QVector<int> m_freeAreas;
+    QHash<Worksheet *, QSharedPointer<CellRangeIndex> > m_areaIndex; // slots of m_areas by their cells
+    QVector<int> m_dirty; // may hold removed nodes, and duplicates once their slots are reused
+
+    // Only built outside of the concurrent evaluation, so that the
+    // calculation threads merely read it.
+    mutable QHash<Worksheet *, QHash<int, QSharedPointer<const NumericColumn> > > m_numericColumns;
+    bool m_evaluatingConcurrently;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXFORMULAENGINE_P_H
@@ -0,0 +1,129 @@
+// xlsxformulaparser_p.h
+
+#ifndef XLSXFORMULAPARSER_P_H
+#define XLSXFORMULAPARSER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Cell or area referenced by a formula, such as A1, $B$2:C10,
+ * Sheet2!A:A or 3:5.
+ */
+struct FormulaReference
+{
+    enum Flag {
+        FirstRowAbsolute = 0x01,
+        FirstColumnAbsolute = 0x02,
+        LastRowAbsolute = 0x04,
+        LastColumnAbsolute = 0x08,
+        WholeColumns = 0x10, // A:C, rows are not used
+        WholeRows = 0x20,    // 1:3, columns are not used
+        Area = 0x40          // written with a ':', even for A1:A1
+    };
+
+    int firstRow;
+    int firstColumn;
+    int lastRow;
+    int lastColumn;
+    int flags;
+
+    // Sheet prefix, without the '!', such as "'My Sheet'" or
+    // "Sheet1:Sheet3". Empty for the current sheet.
+    int sheetPosition;
+    int sheetLength;
+
+    inline bool isArea() const { return flags & (Area | WholeColumns | WholeRows); }
+    inline bool hasSheet() const { return sheetLength > 0; }
+};
+
+/*
+ * One item of a parsed formula.
+ *
+ * Positions and lengths refer to the formula text, so that the
+ * tokens don't hold any string themselves.
+ */
+struct FormulaToken
+{
+    enum Type {
+        Number,              // number
+        String,              // "text", the quotes included
+        Boolean,             // number is 0 or 1
+        Error,               // #N/A, #DIV/0!, ...
+        Reference,           // ref
+        Name,                // defined name
+        StructuredReference, // Table1[[#This Row],[Price]]
+        Missing,             // omitted argument, as in IF(A1,,1)
+        Array,               // {1,2;3,4}: argumentCount elements, columns per row
+        Function,            // name, takes argumentCount operands
+        Operator             // op
+    };
+
+    enum OperatorType {
+        Add, Subtract, Multiply, Divide, Power, Concat,
+        Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual,
+        Range, Union, Intersection,
+        Negate, Plus, Percent, ImplicitIntersection, Spill
+    };
+
+    Type type;
+    OperatorType op;
+    int position;
+    int length;
+    int argumentCount;
+    int columns;
+    double number;
+    FormulaReference ref;
+};
+
+/*
+ * Excel formula in reverse polish notation.
+ *
+ * The expression is parsed once and then cached by CellFormulaPrivate,
+ * to be walked by reference rewriting, dependency extraction and
+ * evaluation without scanning the text again.
+ */
+class FormulaExpression
+{
+public:
+    FormulaExpression();
+
+    static FormulaExpression parse(const QString &formula);
+
+    bool isValid() const { return m_errorPosition == -1; }
+    int errorPosition() const { return m_errorPosition; }
+
+    const QString &text() const { return m_text; }
+    const QVector<FormulaToken> &tokens() const { return m_tokens; }
+
+    QString tokenText(const FormulaToken &token) const;
+    QString stringValue(const FormulaToken &token) const;
+    QString sheetName(const FormulaToken &token) const;
+
+    QString offsetReferences(int rowOffset, int columnOffset) const;
+
+private:
+    friend class FormulaParser;
+
+    QString m_text;
+    QVector<FormulaToken> m_tokens;
+    int m_errorPosition;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXFORMULAPARSER_P_H
@@ -0,0 +1,65 @@
+// xlsxgeometryindex_p.h
+
+#ifndef XLSXGEOMETRYINDEX_P_H
+#define XLSXGEOMETRYINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Prefix sums of the sizes of rows or columns, in pixels, kept in a
+ * Fenwick tree. Only the runs of rows or columns which have their own
+ * size are stored, all the others have the default size.
+ *
+ * The position of a row or column, and the row or column at a given
+ * position, are found in logarithmic time. Changing the size of an
+ * existing run takes logarithmic time too.
+ */
+class GeometryIndex
+{
+public:
+    GeometryIndex();
+
+    void clear(int defaultSize);
+    void append(int first, int last, int size);
+    bool update(int first, int last, int size);
+
+    int defaultSize() const { return m_defaultSize; }
+    int size(int index) const;
+    int offset(int index) const;
+    int indexAt(int position, int *remainder = 0) const;
+
+private:
+    struct Run
+    {
+        int first;
+        int last;
+        int size;
+    };
+
+    int runAt(int index) const;
+    int previousLast(int run) const;
+    int extent(int run) const;
+    int prefix(int count) const;
+
+    QVector<Run> m_runs;
+    QVector<int> m_tree; // 1-based, node i covers runs (i - lowbit(i), i]
+    int m_defaultSize;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXGEOMETRYINDEX_P_H
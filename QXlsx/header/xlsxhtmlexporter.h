@@ -0,0 +1,48 @@
+// xlsxhtmlexporter.h
+
+#ifndef QXLSX_XLSXHTMLEXPORTER_H
+#define QXLSX_XLSXHTMLEXPORTER_H
+
+#include <QtGlobal>
+#include <QString>
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class HtmlExporterPrivate;
+
+class HtmlExporter
+{
+	Q_DECLARE_PRIVATE(HtmlExporter)
+public:
+	explicit HtmlExporter(Worksheet *sheet);
+	~HtmlExporter();
+
+	Worksheet *worksheet() const;
+
+	CellRange range() const;
+	void setRange(const CellRange &range);
+	void setRowRange(int firstRow, int lastRow);
+	QString classPrefix() const;
+	bool setClassPrefix(const QString &prefix);
+	int chunkSize() const;
+	void setChunkSize(int size);
+	bool isConditionalFormattingEnabled() const;
+	void setConditionalFormattingEnabled(bool enable);
+
+	bool exportTable(QIODevice *device);
+	bool exportDocument(QIODevice *device);
+
+private:
+	Q_DISABLE_COPY(HtmlExporter)
+	HtmlExporterPrivate * const d_ptr;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXHTMLEXPORTER_H
@@ -0,0 +1,65 @@
+// xlsxhtmlexporter_p.h
+
+#ifndef XLSXHTMLEXPORTER_P_H
+#define XLSXHTMLEXPORTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxhtmlexporter.h"
+#include "xlsxformat.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class ConditionalFormatOverlay;
+
+class HtmlExporterPrivate
+{
+	Q_DECLARE_PUBLIC(HtmlExporter)
+public:
+	HtmlExporterPrivate(HtmlExporter *p, Worksheet *sheet);
+
+	bool writeTable();
+	void collectStyles(const CellRange &range);
+	int styleClass(const Format &format, bool add);
+	static QString formatCss(const Format &format);
+	static QString overlayCss(const ConditionalFormatOverlay &overlay);
+
+	void append(const QString &html) { text.append(html); }
+	void append(const char *html) { text.append(QLatin1String(html)); }
+	void appendNumber(int value) { text.append(QString::number(value)); }
+	void appendEscaped(const QString &value);
+	bool flush(bool force);
+
+	HtmlExporter *q_ptr;
+	Worksheet *sheet;
+	CellRange range;
+	QString prefix;
+	int chunkSize;
+	bool conditionalFormatting;
+
+	// State of the current export
+	QIODevice *device;
+	QString text;   // written to the device every chunkSize characters
+	bool error;
+	QHash<int, int> classesByXf;
+	QHash<QByteArray, int> classesByKey;
+	QVector<Format> classFormats;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXHTMLEXPORTER_P_H
@@ -0,0 +1,164 @@
+// xlsxintervalmap_p.h
+
+#ifndef XLSXINTERVALMAP_P_H
+#define XLSXINTERVALMAP_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QMap>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Values of runs of rows or columns. Updating a range splits the runs
+ * at its ends, then neighbouring runs with equal values are joined and
+ * runs with the default value are dropped, so that the same properties
+ * over a whole sheet take a single run.
+ *
+ * T must have a default constructor and operator==.
+ */
+template <typename T>
+class IntervalMap
+{
+public:
+    struct Run
+    {
+        int first;
+        int last;
+        T value;
+    };
+
+    typedef typename QMap<int, Run>::const_iterator const_iterator;
+
+    bool isEmpty() const { return m_runs.isEmpty(); }
+    int runCount() const { return m_runs.size(); }
+    void clear() { m_runs.clear(); }
+
+    const_iterator constBegin() const { return m_runs.constBegin(); }
+    const_iterator constEnd() const { return m_runs.constEnd(); }
+
+    // Returns the first run which ends at or after index
+    const_iterator lowerBound(int index) const
+    {
+        const_iterator it = m_runs.upperBound(index);
+        if (it != m_runs.constBegin()) {
+            const_iterator previous = it - 1;
+            if (previous->last >= index)
+                return previous;
+        }
+        return it;
+    }
+
+    // Returns the run which covers index, or constEnd()
+    const_iterator constFind(int index) const
+    {
+        const_iterator it = lowerBound(index);
+        if (it != m_runs.constEnd() && it->first > index)
+            return m_runs.constEnd();
+        return it;
+    }
+
+    const T *find(int index) const
+    {
+        const_iterator it = constFind(index);
+        return it != m_runs.constEnd() ? &it->value : 0;
+    }
+
+    T value(int index, const T &defaultValue = T()) const
+    {
+        const T *v = find(index);
+        return v ? *v : defaultValue;
+    }
+
+    void insert(int first, int last, const T &value)
+    {
+        update(first, last, [&value](T &v) { v = value; });
+    }
+
+    // Calls function on the values of all the runs within [first, last],
+    // the rows or columns without a run get a default value first.
+    template <typename Function>
+    void update(int first, int last, Function function)
+    {
+        if (first > last)
+            return;
+
+        split(first);
+        split(last + 1);
+
+        typename QMap<int, Run>::iterator it = m_runs.lowerBound(first);
+        int index = first;
+        while (index <= last) {
+            if (it != m_runs.end() && it->first == index) {
+                function(it->value);
+                index = it->last + 1;
+                ++it;
+            } else {
+                Run run;
+                run.first = index;
+                run.last = it != m_runs.end() && it->first <= last ? it->first - 1 : last;
+                run.value = T();
+                function(run.value);
+                index = run.last + 1;
+                it = m_runs.insert(run.first, run);
+                ++it;
+            }
+        }
+
+        normalize(first, last);
+    }
+
+private:
+    // Makes a run start at index, if a run covers it
+    void split(int index)
+    {
+        typename QMap<int, Run>::iterator it = m_runs.upperBound(index);
+        if (it == m_runs.begin())
+            return;
+        --it;
+        if (it->first < index && it->last >= index) {
+            Run tail = *it;
+            tail.first = index;
+            it->last = index - 1;
+            m_runs.insert(index, tail);
+        }
+    }
+
+    // Joins the equal runs and drops the default ones around [first, last]
+    void normalize(int first, int last)
+    {
+        const T defaultValue = T();
+        typename QMap<int, Run>::iterator it = m_runs.lowerBound(first);
+        if (it != m_runs.begin())
+            --it;
+        while (it != m_runs.end() && it->first <= last + 1) {
+            if (it->value == defaultValue) {
+                it = m_runs.erase(it);
+                continue;
+            }
+            typename QMap<int, Run>::iterator next = it + 1;
+            if (next != m_runs.end() && next->first == it->last + 1 && next->value == it->value) {
+                it->last = next->last;
+                m_runs.erase(next);
+            } else {
+                it = next;
+            }
+        }
+    }
+
+    QMap<int, Run> m_runs; // first -> run
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXINTERVALMAP_P_H
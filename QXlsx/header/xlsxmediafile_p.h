@@ -59,7 +59,7 @@ public:
     bool isIndexValid() const;
     int index() const;
     void setIndex(int idx);
-    QByteArray hashKey() const;
+    uint hashKey() const;
 
     void setFileName(const QString &name);
     QString fileName() const;
@@ -72,7 +72,7 @@ private:
 
     int m_index;
     bool m_indexValid;
-    QByteArray m_hashKey;
+    uint m_hashKey;
 };
 
 } // namespace QXlsx
@@ -0,0 +1,68 @@
+// xlsxnumberformatter_p.h
+
+#ifndef XLSXNUMBERFORMATTER_P_H
+#define XLSXNUMBERFORMATTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+#include "xlsxformat.h"
+
+#include <QHash>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+// Large enough for any output of NumberFormatter::format().
+const int XLSX_NUMBER_TEXT_BUFFER_SIZE = 48;
+
+/*
+ * Writes numbers as text, the way their number format shows them, as
+ * far as a plain text can: dates and times as ISO 8601 strings, and the
+ * other numbers with the decimals and the percent sign of the format.
+ *
+ * How the numbers of a style are written is only worked out once, for
+ * the first number of that style.
+ */
+class NumberFormatter
+{
+public:
+    explicit NumberFormatter(bool date1904);
+
+    int format(double value, const Format &format, char *buffer);
+
+private:
+    struct Style
+    {
+        enum Kind { General, Fixed, DateTime };
+
+        Style() : kind(General), decimals(0), percent(false) {}
+
+        Kind kind;
+        int decimals;
+        bool percent;
+    };
+
+    const Style &style(const Format &format);
+    static Style parseStyle(const Format &format);
+
+    static int formatFixed(double value, int decimals, char *buffer);
+    int formatDateTime(double value, char *buffer) const;
+
+    bool m_date1904;
+
+    // By xf index
+    QHash<int, Style> m_styles;
+    Style m_uncachedStyle;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXNUMBERFORMATTER_P_H
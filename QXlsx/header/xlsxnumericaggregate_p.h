@@ -0,0 +1,61 @@
+// xlsxnumericaggregate_p.h
+
+#ifndef XLSXNUMERICAGGREGATE_P_H
+#define XLSXNUMERICAGGREGATE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <limits>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Sum, minimum, maximum and count of a set of numbers.
+ */
+struct NumericAggregate
+{
+    NumericAggregate()
+        : sum(0), minimum(std::numeric_limits<double>::infinity()),
+          maximum(-std::numeric_limits<double>::infinity()), count(0) {}
+
+    void add(double value)
+    {
+        sum += value;
+        if (value < minimum)
+            minimum = value;
+        if (value > maximum)
+            maximum = value;
+        ++count;
+    }
+
+    void add(const NumericAggregate &other)
+    {
+        sum += other.sum;
+        if (other.minimum < minimum)
+            minimum = other.minimum;
+        if (other.maximum > maximum)
+            maximum = other.maximum;
+        count += other.count;
+    }
+
+    double sum;
+    double minimum;
+    double maximum;
+    qint64 count;
+};
+
+void aggregateNumbers(const double *values, qint64 size, NumericAggregate *result);
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXNUMERICAGGREGATE_P_H
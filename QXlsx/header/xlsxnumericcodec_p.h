@@ -0,0 +1,35 @@
+// xlsxnumericcodec_p.h
+
+#ifndef XLSXNUMERICCODEC_P_H
+#define XLSXNUMERICCODEC_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+class QChar;
+class QString;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+// Large enough for any output of formatXsdDouble(), including the '\0'.
+const int XLSX_DOUBLE_BUFFER_SIZE = 32;
+
+int formatXsdDouble(double value, char *buffer);
+QString xsdDoubleToString(double value);
+
+double parseXsdDouble(const char *data, int size, bool *ok=0);
+double parseXsdDouble(const QChar *data, int size, bool *ok=0);
+double parseXsdDouble(const QString &value, bool *ok=0);
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXNUMERICCODEC_P_H
@@ -42,6 +42,7 @@
 #include <QHash>
 #include <QStringList>
 #include <QSharedPointer>
+#include <QVector>
 
 class QIODevice;
 class QXmlStreamReader;
@@ -49,23 +50,14 @@ class QXmlStreamWriter;
 
 namespace QXlsx {
 
-class XlsxSharedStringInfo
-{
-public:
-    XlsxSharedStringInfo(int index=0, int count = 1) :
-        index(index), count(count)
-    {
-    }
-
-    int index;
-    int count;
-};
+class XmlEmitter;
 
 class  SharedStrings : public AbstractOOXmlFile
 {
 public:
     SharedStrings(CreateFlag flag);
     int count() const;
+    int uniqueCount() const;
     bool isEmpty() const;
     
     int addSharedString(const QString &string);
@@ -73,6 +65,8 @@ public:
     void removeSharedString(const QString &string);
     void removeSharedString(const RichString &string);
     void incRefByStringIndex(int idx);
+    int compact(const QVector<int> &refCounts);
+    int droppedCount() const;
 
     int getSharedStringIndex(const QString &string) const;
     int getSharedStringIndex(const RichString &string) const;
@@ -88,10 +82,15 @@ private:
     void readPlainStringPart(QXmlStreamReader &reader, RichString &rich); // <v>
     Format readRichStringPart_rPr(QXmlStreamReader &reader);
     void writeRichStringPart_rPr(QXmlStreamWriter &writer, const Format &format) const;
+    void writeTextElement(XmlEmitter &emitter, const QString &text) const;
+    void ensureStringTable() const;
 
-    QHash<RichString, XlsxSharedStringInfo> m_stringTable; //for fast lookup
+    mutable QHash<RichString, int> m_stringTable; //for fast lookup, string -> index
+    mutable bool m_stringTableDirty; //m_stringTable must be rebuilt from m_stringList
     QList<RichString> m_stringList;
+    QVector<int> m_stringRefCounts; //reference count of each string, indexed as m_stringList
     int m_stringCount;
+    int m_droppedCount; //items dropped by the last compact()
 };
 
 }
@@ -0,0 +1,48 @@
+// xlsxsqliteimporter.h
+
+#ifndef QXLSX_XLSXSQLITEIMPORTER_H
+#define QXLSX_XLSXSQLITEIMPORTER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+#include "xlsxglobal.h"
+#include "xlsxcellrange.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Document;
+class Worksheet;
+class SqliteImporterPrivate;
+
+class SqliteImporter
+{
+	Q_DECLARE_PRIVATE(SqliteImporter)
+public:
+	explicit SqliteImporter(const QSqlDatabase &database);
+	~SqliteImporter();
+
+	QSqlDatabase database() const;
+
+	bool hasHeaderRow() const;
+	void setHeaderRow(bool header);
+	int batchSize() const;
+	void setBatchSize(int rows);
+	bool replacesTables() const;
+	void setReplaceTables(bool replace);
+
+	bool importSheet(Worksheet *sheet, const QString &table = QString(), const CellRange &range = CellRange());
+	bool importDocument(Document *document);
+
+	QSqlError lastError() const;
+
+private:
+	Q_DISABLE_COPY(SqliteImporter)
+	SqliteImporterPrivate * const d_ptr;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXSQLITEIMPORTER_H
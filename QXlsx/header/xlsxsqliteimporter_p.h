@@ -0,0 +1,46 @@
+// xlsxsqliteimporter_p.h
+
+#ifndef XLSXSQLITEIMPORTER_P_H
+#define XLSXSQLITEIMPORTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxsqliteimporter.h"
+#include "xlsxcolumntyper_p.h"
+
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class SqliteImporterPrivate
+{
+	Q_DECLARE_PUBLIC(SqliteImporter)
+public:
+	SqliteImporterPrivate(SqliteImporter *p, const QSqlDatabase &database);
+
+	bool importRange(Worksheet *sheet, const QString &table, const CellRange &range);
+	bool createTable(const QString &table, const QStringList &names, const QVector<ColumnTyper::Type> &types);
+	bool fail(const QSqlError &error);
+	static QString quoted(const QString &identifier);
+
+	SqliteImporter *q_ptr;
+	QSqlDatabase database;
+	bool headerRow;
+	int batchSize;
+	bool replaceTables;
+	QSqlError lastError;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXSQLITEIMPORTER_P_H
@@ -49,6 +49,7 @@ class Chartsheet;
 class Worksheet;
 
 class WorkbookPrivate;
+class FormulaEngine;
 class Workbook : public AbstractOOXmlFile
 {
     Q_DECLARE_PRIVATE(Workbook)
@@ -81,6 +82,12 @@ public:
     QString defaultDateFormat() const;
     void setDefaultDateFormat(const QString &format);
 
+    bool isFormulaCalculationEnabled() const;
+    void setFormulaCalculationEnabled(bool enable=true);
+    int calculationThreadCount() const;
+    void setCalculationThreadCount(int count);
+    int recalculate();
+
     //internal used member
     void addMediaFile(QSharedPointer<MediaFile> media, bool force=false);
     QList<QSharedPointer<MediaFile> > mediaFiles() const;
@@ -93,6 +100,8 @@ private:
     friend class WorksheetPrivate;
     friend class Document;
     friend class DocumentPrivate;
+    friend class FormulaEngine;
+    friend class ConditionalFormatEvaluator;
 
     Workbook(Workbook::CreateFlag flag);
 
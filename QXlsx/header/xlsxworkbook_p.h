@@ -41,8 +41,11 @@
 #include "xlsxtheme_p.h"
 #include "xlsxsimpleooxmlfile_p.h"
 #include "xlsxrelationships_p.h"
+#include "xlsxformulaengine_p.h"
+#include "xlsxcalcchain_p.h"
 
 #include <QSharedPointer>
+#include <QHash>
 #include <QPair>
 #include <QStringList>
 
@@ -78,13 +81,19 @@ public:
     QSharedPointer<Styles> styles;
     QSharedPointer<Theme> theme;
     QList<QSharedPointer<MediaFile> > mediaFiles;
+    QMultiHash<uint, int> mediaFileIndex; // hash key -> index of the media files
+    int indexedMediaFiles;
     QList<QSharedPointer<Chart> > chartFiles;
     QList<XlsxDefineNameData> definedNamesList;
+    QSharedPointer<FormulaEngine> formulaEngine;
+    QSharedPointer<CalcChain> calcChain;
 
     bool strings_to_numbers_enabled;
     bool strings_to_hyperlinks_enabled;
     bool html_to_richstring_enabled;
     bool date1904;
+    bool formula_calculation_enabled;
+    int calculation_thread_count;
     QString defaultDateFormat;
 
     int x_window;
@@ -0,0 +1,81 @@
+// xlsxworkscheduler_p.h
+
+#ifndef XLSXWORKSCHEDULER_P_H
+#define XLSXWORKSCHEDULER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <functional>
+
+class QThread;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Runs batches of independent tasks on a fixed set of threads.
+ *
+ * The tasks 0 to count-1 of a batch are dealt out to the threads in
+ * equal slices. A thread takes the tasks of its own slice from the
+ * front, and once it runs out of them, steals the back half of the
+ * slice of another thread. run() returns when all the tasks are done.
+ *
+ * The calling thread takes part in the work, so a scheduler of one
+ * thread starts no thread at all.
+ */
+class WorkScheduler
+{
+public:
+    explicit WorkScheduler(int threadCount);
+    ~WorkScheduler();
+
+    int threadCount() const { return m_slices.size(); }
+
+    void run(int count, const std::function<void (int)> &task);
+
+private:
+    Q_DISABLE_COPY(WorkScheduler)
+    friend class WorkSchedulerThread;
+
+    struct Slice
+    {
+        Slice() : begin(0), end(0) {}
+
+        QMutex mutex;
+        int begin;
+        int end;
+    };
+
+    void work(int self);
+    bool take(int self, int *first, int *last);
+    bool steal(int self);
+    void workerLoop(int self);
+
+    QVector<Slice *> m_slices;
+    QVector<QThread *> m_threads;
+    const std::function<void (int)> *m_task;
+
+    QMutex m_mutex;
+    QWaitCondition m_started;
+    QWaitCondition m_finished;
+    int m_generation;
+    int m_running;
+    bool m_stopping;
+};
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXWORKSCHEDULER_P_H
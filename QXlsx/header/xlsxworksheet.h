@@ -17,8 +17,10 @@
 #include <QObject>
 #include <QStringList>
 #include <QMap>
+#include <QPair>
 #include <QVariant>
 #include <QPointF>
+#include <QRect>
 #include <QSharedPointer>
 #include <QIODevice>
 #include <QDateTime>
@@ -30,6 +32,8 @@
 #include "xlsxcellrange.h"
 #include "xlsxcellreference.h"
 #include "xlsxcelllocation.h"
+#include "xlsxcsvoptions.h"
+#include "xlsxconditionalformatoverlay.h"
 
 class WorksheetTest;
 
@@ -54,11 +58,26 @@ class Worksheet : public AbstractSheet
 private:
     friend class DocumentPrivate;
     friend class Workbook;
+    friend class FormulaEngine;
+    friend class ConditionalFormatEvaluator;
+    friend class HtmlExporterPrivate;
+    friend class ArrowExporterPrivate;
+    friend class ColumnTyper;
+    friend class SqliteImporterPrivate;
+    friend class WorksheetModelPrivate;
     friend class ::WorksheetTest;
     Worksheet(const QString &sheetName, int sheetId, Workbook *book, CreateFlag flag);
     Worksheet *copy(const QString &distName, int distId) const;
 
 public:
+    enum AggregateOperation {
+        AO_Sum,
+        AO_Average,
+        AO_Min,
+        AO_Max,
+        AO_Count
+    };
+
     ~Worksheet();
 
 public:
@@ -104,11 +123,17 @@ public:
     Cell *cellAt(int row, int column) const;
 
     bool insertImage(int row, int column, const QImage &image);
+    bool insertImage(int row, int column, const QByteArray &data, const QString &mimeType);
     Chart *insertChart(int row, int column, const QSize &size);
 
     bool mergeCells(const CellRange &range, const Format &format=Format());
     bool unmergeCells(const CellRange &range);
     QList<CellRange> mergedCells() const;
+    CellRange mergedRangeAt(int row, int column) const;
+
+    QList<ConditionalFormatting> conditionalFormatsAt(int row, int column) const;
+    QList<DataValidation> dataValidationsAt(int row, int column) const;
+    QList<QPair<CellReference, DataValidation> > validateData() const;
 
     bool setColumnWidth(const CellRange& range, double width);
     bool setColumnFormat(const CellRange& range, const Format &format);
@@ -129,11 +154,21 @@ public:
     Format rowFormat(int row);
     bool isRowHidden(int row);
 
+    Format effectiveFormat(const CellReference &row_column) const;
+    Format effectiveFormat(int row, int column) const;
+    ConditionalFormatOverlay conditionalFormatOverlayAt(const CellReference &row_column) const;
+    ConditionalFormatOverlay conditionalFormatOverlayAt(int row, int column) const;
+    QMap<int, QMap<int, ConditionalFormatOverlay> > conditionalFormatOverlays(const CellRange &range = CellRange()) const;
+    QRect cellRect(int row, int column) const;
+    CellReference cellAtPosition(const QPoint &pos, QPoint *offset = 0) const;
+
     bool groupRows(int rowFirst, int rowLast, bool collapsed = true);
     bool groupColumns(int colFirst, int colLast, bool collapsed = true);
     bool groupColumns(const CellRange &range, bool collapsed = true);
     CellRange dimension() const;
 
+    QVariant aggregate(const CellRange &range, AggregateOperation operation) const;
+
     bool isWindowProtected() const;
     void setWindowProtected(bool protect);
     bool isFormulasVisible() const;
@@ -158,6 +193,9 @@ public:
 
     QVector<CellLocation> getFullCells(int* maxRow, int* maxCol);
 
+    bool exportCsv(QIODevice *device, const CsvOptions &options = CsvOptions()) const;
+    bool importCsv(QIODevice *device, const CsvOptions &options = CsvOptions());
+
 private:
     void saveToXmlFile(QIODevice *device) const;
     bool loadFromXmlFile(QIODevice *device);
@@ -40,6 +40,7 @@
 #include <QObject>
 #include <QString>
 #include <QVector>
+#include <QHash>
 #include <QImage>
 #include <QSharedPointer>
 #include <QRegularExpression>
@@ -50,6 +51,9 @@
 #include "xlsxdatavalidation.h"
 #include "xlsxconditionalformatting.h"
 #include "xlsxcellformula.h"
+#include "xlsxcellrangeindex_p.h"
+#include "xlsxgeometryindex_p.h"
+#include "xlsxintervalmap_p.h"
 
 class QXmlStreamWriter;
 class QXmlStreamReader;
@@ -61,6 +65,7 @@ const int XLSX_COLUMN_MAX = 16384;
 const int XLSX_STRING_MAX = 32767;
 
 class SharedStrings;
+class XmlEmitter;
 
 struct XlsxHyperlinkData
 {
@@ -127,6 +132,12 @@ struct XlsxRowInfo
 
     }
 
+    bool operator==(const XlsxRowInfo &other) const
+    {
+        return customHeight == other.customHeight && height == other.height && hidden == other.hidden
+                && outlineLevel == other.outlineLevel && collapsed == other.collapsed && format == other.format;
+    }
+
     bool customHeight;
     double height;
     Format format;
@@ -137,14 +148,19 @@ struct XlsxRowInfo
 
 struct XlsxColumnInfo
 {
-    XlsxColumnInfo(int firstColumn=0, int lastColumn=1, double width=0, const Format &format=Format(), bool hidden=false) :
-        firstColumn(firstColumn), lastColumn(lastColumn), customWidth(false), width(width), format(format), hidden(hidden)
+    XlsxColumnInfo(double width=0, const Format &format=Format(), bool hidden=false) :
+        customWidth(false), width(width), format(format), hidden(hidden)
       , outlineLevel(0), collapsed(false)
     {
 
     }
-    int firstColumn;
-    int lastColumn;
+
+    bool operator==(const XlsxColumnInfo &other) const
+    {
+        return customWidth == other.customWidth && width == other.width && hidden == other.hidden
+                && outlineLevel == other.outlineLevel && collapsed == other.collapsed && format == other.format;
+    }
+
     bool customWidth;
     double width;    
     Format format;
@@ -153,6 +169,18 @@ struct XlsxColumnInfo
     bool collapsed;
 };
 
+// Run of formulas down a column which only differ by the shifting of
+// their relative references, written as one shared formula.
+struct SharedFormulaRun
+{
+    int firstRow;
+    int lastRow;
+    CellFormula master; // formula of the first row, refers to the whole run
+    CellFormula child;  // formula of the other rows
+};
+
+typedef QHash<int, QVector<SharedFormulaRun> > SharedFormulaRuns; // column -> runs, top down
+
 // #ifndef QMapIntSharedPointerCell
 // typedef QMap<int, QSharedPointer<Cell> > QMapIntSharedPointerCell;
 // #endif
@@ -169,12 +197,14 @@ public:
     int checkDimensions(int row, int col, bool ignore_row=false, bool ignore_col=false);
     Format cellFormat(int row, int col) const;
     QString generateDimensionString() const;
-    void calculateSpans() const;
-    void splitColsInfo(int colFirst, int colLast);
+    void setCell(int row, int col, const QSharedPointer<Cell> &cell);
     void validateDimension();
 
+    const XlsxRowInfo *defaultRowInfo() const;
     void saveXmlSheetData(QXmlStreamWriter &writer) const;
-    void saveXmlCellData(QXmlStreamWriter &writer, int row, int col, QSharedPointer<Cell> cell) const;
+    void saveXmlCellData(XmlEmitter &emitter, int row, int col, const QSharedPointer<Cell> &cell, const CellFormula &formula, const Format &format) const;
+    void saveXmlCellFormula(XmlEmitter &emitter, const CellFormula &formula) const;
+    SharedFormulaRuns findSharedFormulaRuns() const;
     void saveXmlMergeCells(QXmlStreamWriter &writer) const;
     void saveXmlHyperlinks(QXmlStreamWriter &writer) const;
     void saveXmlDrawings(QXmlStreamWriter &writer) const;
@@ -182,6 +212,12 @@ public:
 
     int rowPixelsSize(int row) const;
     int colPixelsSize(int col) const;
+    int rowInfoPixels(const XlsxRowInfo &info) const;
+    int columnInfoPixels(const XlsxColumnInfo &info) const;
+    const GeometryIndex &rowGeometryIndex() const;
+    const GeometryIndex &columnGeometryIndex() const;
+    void updateRowGeometry(int rowFirst, int rowLast);
+    void updateColumnGeometry(int colFirst, int colLast);
 
     void loadXmlSheetData(QXmlStreamReader &reader);
     void loadXmlColumnsInfo(QXmlStreamReader &reader);
@@ -191,12 +227,15 @@ public:
     void loadXmlSheetViews(QXmlStreamReader &reader);
     void loadXmlHyperlinks(QXmlStreamReader &reader);
 
-    QList<QSharedPointer<XlsxRowInfo> > getRowInfoList(int rowFirst, int rowLast);
-    QList<QSharedPointer<XlsxColumnInfo> > getColumnInfoList(int colFirst, int colLast);
-    QList<int> getColumnIndexes(int colFirst, int colLast);
+    bool isRowRangeValid(int &rowFirst, int &rowLast);
     bool isColumnRangeValid(int colFirst, int colLast);
 
+    void appendMerge(const CellRange &range);
+    void appendDataValidation(const DataValidation &validation);
+    void appendConditionalFormatting(const ConditionalFormatting &cf);
+
     SharedStrings *sharedStrings() const;
+    void markSharedStrings(QVector<int> &refCounts) const;
 
 public:
     QMap<int, QMap<int, QSharedPointer<Cell> > > cellTable;
@@ -204,21 +243,30 @@ public:
     QMap<int, QMap<int, QString> > comments;
     QMap<int, QMap<int, QSharedPointer<XlsxHyperlinkData> > > urlTable;
     QList<CellRange> merges;
-    QMap<int, QSharedPointer<XlsxRowInfo> > rowsInfo;
-    QMap<int, QSharedPointer<XlsxColumnInfo> > colsInfo;
-    QMap<int, QSharedPointer<XlsxColumnInfo> > colsInfoHelper;
+    IntervalMap<XlsxRowInfo> rowsInfo;
+    IntervalMap<XlsxColumnInfo> colsInfo;
 
     QList<DataValidation> dataValidationsList;
     QList<ConditionalFormatting> conditionalFormattingList;
 
+    // Ranges of the lists above, with their indexes in the lists
+    CellRangeIndex mergeIndex;
+    CellRangeIndex dataValidationIndex;
+    CellRangeIndex conditionalFormattingIndex;
+
     QMap<int, CellFormula> sharedFormulaMap; // shared formula map
 
     CellRange dimension;
     int previous_row;
 
-    mutable QMap<int, QString> row_spans;
-    QMap<int, double> row_sizes;
-    QMap<int, double> col_sizes;
+    QMap<int, QPair<int, int> > row_spans; //block of 16 rows -> first and last column
+
+    // Pixel positions of the rows and columns, rebuilt from the runs of
+    // rowsInfo and colsInfo when they are dirty
+    mutable GeometryIndex rowGeometry;
+    mutable GeometryIndex columnGeometry;
+    mutable bool rowGeometryDirty;
+    mutable bool columnGeometryDirty;
 
     int outline_row_level;
     int outline_col_level;
@@ -268,6 +316,7 @@ public:
 private:
 
     static double calculateColWidth(int characters);
+    static int columnWidthPixels(double width);
 };
 
 QT_END_NAMESPACE_XLSX
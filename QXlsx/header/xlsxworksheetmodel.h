@@ -0,0 +1,51 @@
+// xlsxworksheetmodel.h
+
+#ifndef QXLSX_XLSXWORKSHEETMODEL_H
+#define QXLSX_XLSXWORKSHEETMODEL_H
+
+#include <QtGlobal>
+#include <QObject>
+#include <QVariant>
+#include <QAbstractTableModel>
+
+#include "xlsxglobal.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Worksheet;
+class WorksheetModelPrivate;
+
+class WorksheetModel : public QAbstractTableModel
+{
+	Q_OBJECT
+	Q_DECLARE_PRIVATE(WorksheetModel)
+public:
+	explicit WorksheetModel(Worksheet *sheet, QObject *parent = NULL);
+	~WorksheetModel();
+
+	Worksheet *worksheet() const;
+
+	int pageSize() const;
+	void setPageSize(int rows);
+	int displayCacheSize() const;
+	void setDisplayCacheSize(int cells);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+	bool canFetchMore(const QModelIndex &parent) const;
+	void fetchMore(const QModelIndex &parent);
+
+public slots:
+	void reload();
+
+private:
+	Q_DISABLE_COPY(WorksheetModel)
+	WorksheetModelPrivate * const d_ptr;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // QXLSX_XLSXWORKSHEETMODEL_H
@@ -0,0 +1,64 @@
+// xlsxworksheetmodel_p.h
+
+#ifndef XLSXWORKSHEETMODEL_P_H
+#define XLSXWORKSHEETMODEL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxworksheetmodel.h"
+#include "xlsxformat.h"
+#include "xlsxformatresolver_p.h"
+#include "xlsxnumberformatter_p.h"
+
+#include <QCache>
+#include <QScopedPointer>
+#include <QString>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class WorksheetModelPrivate
+{
+	Q_DECLARE_PUBLIC(WorksheetModel)
+public:
+	// What the views ask of a cell, worked out once
+	struct CellDisplay
+	{
+		QString text;
+		Format format;  // effective format
+		bool number;    // aligned to the right if the format doesn't say
+	};
+
+	WorksheetModelPrivate(WorksheetModel *p, Worksheet *sheet);
+
+	void updateSize();
+	CellDisplay cellDisplay(int row, int column) const;
+	QVariant formatData(const Format &format, int role) const;
+
+	WorksheetModel *q_ptr;
+	Worksheet *sheet;
+
+	int lastRow;     // last row of the sheet
+	int fetchedRows; // rows shown so far
+	int columns;
+	int pageSize;
+
+	// Made again by reload(), as they keep the formats they have seen
+	QScopedPointer<FormatResolver> formats;
+	QScopedPointer<NumberFormatter> numbers;
+
+	// By (row << 16) | column
+	mutable QCache<quint64, CellDisplay> displayCache;
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXWORKSHEETMODEL_P_H
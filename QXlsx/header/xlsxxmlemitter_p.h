@@ -0,0 +1,85 @@
+// xlsxxmlemitter_p.h
+
+#ifndef XLSXXMLEMITTER_P_H
+#define XLSXXMLEMITTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt Xlsx API.  It exists for the convenience
+// of the Qt Xlsx.  This header file may change from
+// version to version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "xlsxglobal.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstring>
+
+class QIODevice;
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Buffered UTF-8 xml writer for the big parts of the package.
+ *
+ * Unlike QXmlStreamWriter, nothing is tracked: the caller writes the
+ * markup itself, while the emitter escapes the text and the attribute
+ * values the same way QXmlStreamWriter does, and converts them to UTF-8
+ * in one pass.
+ */
+class XmlEmitter
+{
+public:
+    explicit XmlEmitter(QIODevice *device);
+    ~XmlEmitter();
+
+    void writeStartDocument();
+
+    // string literal, such as "<row r=\""
+    template <int N>
+    inline void writeRaw(const char (&literal)[N])
+    {
+        writeRaw(literal, N - 1);
+    }
+    inline void writeRaw(const char *data, int size)
+    {
+        if (m_size + size > m_buffer.size())
+            reserve(size);
+        std::memcpy(m_data + m_size, data, size);
+        m_size += size;
+    }
+    inline void writeRaw(const QByteArray &data)
+    {
+        writeRaw(data.constData(), data.size());
+    }
+    void writeLatin1(const QString &string);
+
+    void writeText(const QString &text);
+    void writeAttributeValue(const QString &value);
+    void writeInteger(qint64 value);
+    void writeDouble(double value);
+    void writeCellReference(int row, int column);
+
+    void flush();
+
+private:
+    Q_DISABLE_COPY(XmlEmitter)
+    void reserve(int size);
+    void writeEscaped(const QString &string, bool attribute);
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    char *m_data;
+    int m_size;
+};
+
+char *escapeXmlToUtf8(const ushort *src, int size, char *dst, bool attribute);
+
+QT_END_NAMESPACE_XLSX
+#endif // XLSXXMLEMITTER_P_H
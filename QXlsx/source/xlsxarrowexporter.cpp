@@ -0,0 +1,378 @@
+// xlsxarrowexporter.cpp
+
+#include "xlsxarrowexporter.h"
+#include "xlsxarrowexporter_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxcell.h"
+#include "xlsxcell_p.h"
+#include "xlsxsharedstrings_p.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QIODevice>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int defaultBatchSize = 64 * 1024;
+
+const qint64 millisecondsPerDay = 24 * 60 * 60 * 1000;
+
+} //namespace
+
+ArrowExporterPrivate::ArrowExporterPrivate(ArrowExporter *p, Worksheet *sheet)
+	: q_ptr(p), sheet(sheet), headerRow(true), batchSize(defaultBatchSize)
+	, date1904(false), stringCount(0), typer(0)
+{
+}
+
+/*
+ * Writes the schema, the dictionary of the strings, and the record
+ * batches of the range.
+ */
+bool ArrowExporterPrivate::writeStream(ArrowStreamWriter &writer)
+{
+	WorksheetPrivate *sd = sheet->d_func();
+
+	const CellRange r = range.isValid() ? range : sd->dimension;
+	if (!r.isValid())
+		return writer.writeSchema(QVector<ArrowField>()) && writer.writeEndOfStream();
+
+	const int firstDataRow = headerRow ? r.firstRow() + 1 : r.firstRow();
+	setFields(r, firstDataRow);
+	if (!writer.writeSchema(fields))
+		return false;
+
+	bool hasStrings = false;
+	for (int i = 0; i < fields.size(); ++i)
+		hasStrings |= fields[i].type == ArrowField::String;
+
+	if (hasStrings) {
+		// The indexes of the shared strings are their indexes in the dictionary
+		const QList<RichString> sharedStrings = sd->sharedStrings()->getSharedStrings();
+		ArrowStringData strings;
+		foreach (const RichString &string, sharedStrings)
+			strings.append(string.toPlainString());
+		stringCount = strings.count;
+		if (!writer.writeDictionary(strings, false))
+			return false;
+	}
+
+	columns.resize(fields.size());
+	for (int first = firstDataRow; first <= r.lastRow(); first += batchSize) {
+		const int last = qMin(r.lastRow(), first + batchSize - 1);
+		fillBatch(r, first, last);
+
+		if (newStrings.count) {
+			if (!writer.writeDictionary(newStrings, true))
+				return false;
+			newStrings.clear();
+		}
+		if (!writer.writeRecordBatch(last - first + 1, columns))
+			return false;
+	}
+	return writer.writeEndOfStream();
+}
+
+/*
+ * Names the columns after the header row, if any, and gives them the
+ * types of their values from \a firstDataRow on.
+ */
+void ArrowExporterPrivate::setFields(const CellRange &range, int firstDataRow)
+{
+	const QStringList names = typer->columnNames(range, headerRow);
+	const QVector<ColumnTyper::Type> types = typer->columnTypes(range, firstDataRow);
+
+	fields.resize(types.size());
+	for (int i = 0; i < types.size(); ++i) {
+		fields[i].name = names[i];
+		switch (types[i]) {
+		case ColumnTyper::Integer:
+			fields[i].type = ArrowField::Int64;
+			break;
+		case ColumnTyper::Number:
+			fields[i].type = ArrowField::Float64;
+			break;
+		case ColumnTyper::DateTime:
+			fields[i].type = ArrowField::Timestamp;
+			break;
+		case ColumnTyper::Boolean:
+			fields[i].type = ArrowField::Boolean;
+			break;
+		default:
+			fields[i].type = ArrowField::String;
+			break;
+		}
+	}
+}
+
+/*
+ * Fills the buffers of the columns with the rows \a firstRow to
+ * \a lastRow of \a range. The rows and cells missing are null.
+ */
+void ArrowExporterPrivate::fillBatch(const CellRange &range, int firstRow, int lastRow)
+{
+	WorksheetPrivate *sd = sheet->d_func();
+	const int length = lastRow - firstRow + 1;
+	const int bitmapSize = (length + 7) / 8;
+
+	for (int i = 0; i < columns.size(); ++i) {
+		ArrowColumnData &column = columns[i];
+		column.validity.fill(0, bitmapSize);
+		switch (fields[i].type) {
+		case ArrowField::Boolean:
+			column.values.fill(0, bitmapSize);
+			break;
+		case ArrowField::String:
+			column.values.fill(0, 4 * length);
+			break;
+		default:
+			column.values.fill(0, 8 * length);
+			break;
+		}
+		column.nullCount = length;
+	}
+
+	typedef QMap<int, QSharedPointer<Cell> > CellRow;
+	QMap<int, CellRow>::const_iterator rowIt = sd->cellTable.lowerBound(firstRow);
+	for (; rowIt != sd->cellTable.constEnd() && rowIt.key() <= lastRow; ++rowIt) {
+		const int row = rowIt.key() - firstRow;
+		CellRow::const_iterator it = rowIt->lowerBound(range.firstColumn());
+		for (; it != rowIt->constEnd() && it.key() <= range.lastColumn(); ++it) {
+			const int i = it.key() - range.firstColumn();
+			setValue(columns[i], fields[i].type, row, it.value().data());
+		}
+	}
+}
+
+/*
+ * Puts the value of \a cell at \a row of \a column.
+ */
+void ArrowExporterPrivate::setValue(ArrowColumnData &column, ArrowField::Type type, int row, const Cell *cell)
+{
+	const FormulaValue value = FormulaEngine::valueOf(cell, date1904);
+	if (value.type == FormulaValue::Blank)
+		return;
+
+	uchar *values = reinterpret_cast<uchar *>(column.values.data());
+	switch (type) {
+	case ArrowField::Int64:
+		if (value.type != FormulaValue::Number)
+			return;
+		qToLittleEndian<qint64>(qint64(value.number), values + 8 * row);
+		break;
+	case ArrowField::Float64: {
+		if (value.type != FormulaValue::Number)
+			return;
+		quint64 bits;
+		std::memcpy(&bits, &value.number, sizeof(bits));
+		qToLittleEndian<quint64>(bits, values + 8 * row);
+		break;
+	}
+	case ArrowField::Timestamp:
+		if (value.type != FormulaValue::Number)
+			return;
+		qToLittleEndian<qint64>(timestampOf(value.number), values + 8 * row);
+		break;
+	case ArrowField::Boolean:
+		if (value.type != FormulaValue::Boolean)
+			return;
+		if (value.number != 0)
+			values[row / 8] |= uchar(1 << (row % 8));
+		break;
+	default:
+		qToLittleEndian<qint32>(stringIndex(cell, value), values + 4 * row);
+		break;
+	}
+
+	column.validity.data()[row / 8] |= char(1 << (row % 8));
+	--column.nullCount;
+}
+
+/*
+ * Returns the index in the dictionary of the text of \a cell, whose
+ * value is \a value. The shared strings are at their own index, the
+ * other strings are added to the dictionary the first time they are
+ * seen.
+ */
+int ArrowExporterPrivate::stringIndex(const Cell *cell, const FormulaValue &value)
+{
+	SharedStrings *sst = sheet->d_func()->sharedStrings();
+
+	if (cell->cellType() == Cell::SharedStringType) {
+		const int index = cell->isRichString()
+				? sst->getSharedStringIndex(cell->d_ptr->richString)
+				: sst->getSharedStringIndex(cell->value().toString());
+		if (index >= 0 && index < stringCount)
+			return index;
+	}
+
+	const QString text = typer->textOf(cell, value);
+	const int shared = sst->getSharedStringIndex(text);
+	if (shared >= 0 && shared < stringCount)
+		return shared;
+
+	QHash<QString, int>::const_iterator it = otherStrings.constFind(text);
+	if (it != otherStrings.constEnd())
+		return it.value();
+
+	otherStrings.insert(text, stringCount);
+	newStrings.append(text);
+	return stringCount++;
+}
+
+/*
+ * Milliseconds since 1970-01-01 of the date and time given by the
+ * \a serial number of a cell.
+ */
+qint64 ArrowExporterPrivate::timestampOf(double serial) const
+{
+	//1900-03-01 is serial 61, as Excel counts a 1900-02-29 which doesn't exist
+	double days;
+	if (date1904)
+		days = serial - 24107;
+	else
+		days = serial < 61 ? serial - 25568 : serial - 25569;
+	return qint64(std::floor(days * millisecondsPerDay + 0.5));
+}
+
+/*!
+  \class ArrowExporter
+  \inmodule QtXlsx
+  \brief Writes the cells of a worksheet as an Apache Arrow IPC stream.
+
+  The cells are written in columns of typed values, as pandas, DuckDB
+  and the other Arrow readers load them without parsing: a column
+  whose values are all integers, numbers, dates or booleans becomes an
+  int64, double, timestamp[ms] or bool column, any other column a
+  column of strings. Empty cells are null.
+
+  The string columns are dictionary encoded. The dictionary starts
+  with the shared strings of the workbook, so a shared string cell is
+  written as its own index; the other strings are added to the
+  dictionary by delta dictionary batches as they are met.
+
+  The rows are written by record batches of batchSize() rows, each
+  one written as soon as it is filled, so the memory used doesn't grow
+  with the number of rows.
+
+  \sa HtmlExporter, Worksheet::exportCsv()
+*/
+
+/*!
+  Creates an exporter of the cells of \a sheet.
+ */
+ArrowExporter::ArrowExporter(Worksheet *sheet)
+	: d_ptr(new ArrowExporterPrivate(this, sheet))
+{
+}
+
+/*!
+  Destroys the exporter.
+ */
+ArrowExporter::~ArrowExporter()
+{
+	delete d_ptr;
+}
+
+/*!
+  Returns the worksheet which is exported.
+ */
+Worksheet *ArrowExporter::worksheet() const
+{
+	Q_D(const ArrowExporter);
+	return d->sheet;
+}
+
+/*!
+  Returns the cells which are exported. An invalid range, the default,
+  stands for the whole dimension of the sheet.
+ */
+CellRange ArrowExporter::range() const
+{
+	Q_D(const ArrowExporter);
+	return d->range;
+}
+
+/*!
+  Exports the cells of \a range only.
+ */
+void ArrowExporter::setRange(const CellRange &range)
+{
+	Q_D(ArrowExporter);
+	d->range = range;
+}
+
+/*!
+  Returns true if the first row of the range holds the names of the
+  columns, which is the default.
+ */
+bool ArrowExporter::hasHeaderRow() const
+{
+	Q_D(const ArrowExporter);
+	return d->headerRow;
+}
+
+/*!
+  Takes the names of the columns from the first row of the range if
+  \a header is true. Otherwise, and for the empty cells of the header
+  row, the columns are named after their letters.
+ */
+void ArrowExporter::setHeaderRow(bool header)
+{
+	Q_D(ArrowExporter);
+	d->headerRow = header;
+}
+
+/*!
+  Returns the number of rows of a record batch. The default is 65536.
+ */
+int ArrowExporter::batchSize() const
+{
+	Q_D(const ArrowExporter);
+	return d->batchSize;
+}
+
+/*!
+  Sets the number of rows of a record batch to \a rows.
+ */
+void ArrowExporter::setBatchSize(int rows)
+{
+	Q_D(ArrowExporter);
+	if (rows > 0)
+		d->batchSize = rows;
+}
+
+/*!
+  Writes the stream to \a device.
+
+  Returns false if the device can't be written to.
+ */
+bool ArrowExporter::exportStream(QIODevice *device)
+{
+	Q_D(ArrowExporter);
+	if (!d->sheet || !device || !device->isWritable())
+		return false;
+
+	ColumnTyper typer(d->sheet);
+	d->typer = &typer;
+	d->date1904 = typer.isDate1904();
+
+	ArrowStreamWriter writer(device);
+	const bool ok = d->writeStream(writer);
+
+	d->fields.clear();
+	d->columns.clear();
+	d->stringCount = 0;
+	d->otherStrings.clear();
+	d->newStrings.clear();
+	d->typer = 0;
+	return ok;
+}
+
+QT_END_NAMESPACE_XLSX
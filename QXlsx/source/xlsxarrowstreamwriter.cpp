@@ -0,0 +1,250 @@
+// xlsxarrowstreamwriter.cpp
+
+#include "xlsxarrowstreamwriter_p.h"
+
+#include <QIODevice>
+#include <QtEndian>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+// See Message.fbs and Schema.fbs of the Arrow format
+enum MessageHeader { HeaderSchema = 1, HeaderDictionaryBatch = 2, HeaderRecordBatch = 3 };
+enum TypeId { TypeInt = 2, TypeFloatingPoint = 3, TypeUtf8 = 5, TypeBool = 6, TypeTimestamp = 10 };
+
+const qint16 metadataVersionV5 = 4;
+const qint16 endiannessLittle = 0;
+const qint16 precisionDouble = 2;
+const qint16 timeUnitMillisecond = 1;
+const qint64 dictionaryId = 0;
+
+const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// The buffers and the metadata start at multiples of 8 bytes
+inline qint64 padded(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+
+} //namespace
+
+void ArrowStringData::clear()
+{
+    offsets.resize(4);
+    qToLittleEndian<qint32>(0, reinterpret_cast<uchar *>(offsets.data()));
+    data.resize(0);
+    count = 0;
+}
+
+void ArrowStringData::append(const QString &string)
+{
+    data.append(string.toUtf8());
+    const int size = offsets.size();
+    offsets.resize(size + 4);
+    qToLittleEndian<qint32>(data.size(), reinterpret_cast<uchar *>(offsets.data() + size));
+    ++count;
+}
+
+/*!
+ * \internal
+ * \class ArrowStreamWriter
+ */
+
+ArrowStreamWriter::ArrowStreamWriter(QIODevice *device)
+    : m_device(device), m_error(false)
+{
+}
+
+bool ArrowStreamWriter::writeSchema(const QVector<ArrowField> &fields)
+{
+    m_builder.clear();
+
+    QVector<int> fieldTables;
+    for (int i = 0; i < fields.size(); ++i) {
+        const ArrowField &field = fields[i];
+        const int name = m_builder.createString(field.name.toUtf8());
+        const int children = m_builder.createOffsetVector(QVector<int>());
+
+        quint8 typeId;
+        int dictionary = 0;
+        m_builder.startTable();
+        switch (field.type) {
+        case ArrowField::Int64:
+            typeId = TypeInt;
+            m_builder.addInt32(0, 64);  // bitWidth
+            m_builder.addBool(1, true); // is_signed
+            break;
+        case ArrowField::Float64:
+            typeId = TypeFloatingPoint;
+            m_builder.addInt16(0, precisionDouble);
+            break;
+        case ArrowField::Boolean:
+            typeId = TypeBool;
+            break;
+        case ArrowField::Timestamp:
+            typeId = TypeTimestamp;
+            m_builder.addInt16(0, timeUnitMillisecond); // without timezone
+            break;
+        default:
+            typeId = TypeUtf8;
+            break;
+        }
+        const int type = m_builder.endTable();
+
+        if (field.type == ArrowField::String) {
+            m_builder.startTable();
+            m_builder.addInt32(0, 32);
+            m_builder.addBool(1, true);
+            const int indexType = m_builder.endTable();
+
+            m_builder.startTable();
+            m_builder.addInt64(0, dictionaryId);
+            m_builder.addOffset(1, indexType);
+            m_builder.addBool(2, false); // isOrdered
+            dictionary = m_builder.endTable();
+        }
+
+        m_builder.startTable();
+        m_builder.addOffset(0, name);
+        m_builder.addBool(1, true); // nullable
+        m_builder.addUInt8(2, typeId);
+        m_builder.addOffset(3, type);
+        if (dictionary)
+            m_builder.addOffset(4, dictionary);
+        m_builder.addOffset(5, children);
+        fieldTables.append(m_builder.endTable());
+    }
+    const int fieldVector = m_builder.createOffsetVector(fieldTables);
+
+    m_builder.startTable();
+    m_builder.addInt16(0, endiannessLittle);
+    m_builder.addOffset(1, fieldVector);
+    const int schema = m_builder.endTable();
+
+    return writeMessage(HeaderSchema, schema, 0);
+}
+
+/*
+ * Writes the strings of the dictionary shared by the string columns,
+ * or, if \a delta is true, strings added to it.
+ */
+bool ArrowStreamWriter::writeDictionary(const ArrowStringData &strings, bool delta)
+{
+    m_builder.clear();
+
+    const QByteArray validity; // no null strings
+    QVector<const QByteArray *> buffers;
+    buffers << &validity << &strings.offsets << &strings.data;
+    QVector<qint64> nodes;
+    nodes << strings.count << 0;
+
+    qint64 bodyLength;
+    const int batch = recordBatch(strings.count, nodes, buffers, &bodyLength);
+
+    m_builder.startTable();
+    m_builder.addInt64(0, dictionaryId);
+    m_builder.addOffset(1, batch);
+    m_builder.addBool(2, delta);
+    const int header = m_builder.endTable();
+
+    return writeMessage(HeaderDictionaryBatch, header, bodyLength) && writeBody(buffers);
+}
+
+bool ArrowStreamWriter::writeRecordBatch(qint64 length, const QVector<ArrowColumnData> &columns)
+{
+    m_builder.clear();
+
+    static const QByteArray noValidity;
+    QVector<const QByteArray *> buffers;
+    QVector<qint64> nodes;
+    for (int i = 0; i < columns.size(); ++i) {
+        const ArrowColumnData &column = columns[i];
+        nodes << length << column.nullCount;
+        //The bitmap can be left out when all the rows have a value
+        buffers << (column.nullCount ? &column.validity : &noValidity) << &column.values;
+    }
+
+    qint64 bodyLength;
+    const int header = recordBatch(length, nodes, buffers, &bodyLength);
+    return writeMessage(HeaderRecordBatch, header, bodyLength) && writeBody(buffers);
+}
+
+bool ArrowStreamWriter::writeEndOfStream()
+{
+    uchar marker[8];
+    qToLittleEndian<quint32>(0xFFFFFFFF, marker);
+    qToLittleEndian<qint32>(0, marker + 4);
+    return write(reinterpret_cast<const char *>(marker), 8);
+}
+
+/*
+ * Builds a RecordBatch table of \a length rows, with the \a nodes
+ * (length and null count of each column) and the \a buffers that
+ * will follow as the body, whose size is put in \a bodyLength.
+ */
+int ArrowStreamWriter::recordBatch(qint64 length, const QVector<qint64> &nodes,
+                                   const QVector<const QByteArray *> &buffers, qint64 *bodyLength)
+{
+    QVector<qint64> bufferFields;
+    qint64 offset = 0;
+    for (int i = 0; i < buffers.size(); ++i) {
+        bufferFields << offset << buffers[i]->size();
+        offset += padded(buffers[i]->size());
+    }
+    *bodyLength = offset;
+
+    const int nodeVector = m_builder.createStructVector(nodes);
+    const int bufferVector = m_builder.createStructVector(bufferFields);
+
+    m_builder.startTable();
+    m_builder.addInt64(0, length);
+    m_builder.addOffset(1, nodeVector);
+    m_builder.addOffset(2, bufferVector);
+    return m_builder.endTable();
+}
+
+/*
+ * Writes a message whose header is the \a header table of
+ * \a headerType, followed by \a bodyLength bytes of body.
+ */
+bool ArrowStreamWriter::writeMessage(quint8 headerType, int header, qint64 bodyLength)
+{
+    m_builder.startTable();
+    m_builder.addInt16(0, metadataVersionV5);
+    m_builder.addUInt8(1, headerType);
+    m_builder.addOffset(2, header);
+    m_builder.addInt64(3, bodyLength);
+    const QByteArray metadata = m_builder.finish(m_builder.endTable());
+
+    //Continuation marker, then the size of the padded metadata
+    const qint64 metadataSize = padded(metadata.size());
+    uchar prefix[8];
+    qToLittleEndian<quint32>(0xFFFFFFFF, prefix);
+    qToLittleEndian<qint32>(qint32(metadataSize), prefix + 4);
+
+    return write(reinterpret_cast<const char *>(prefix), 8)
+        && write(metadata.constData(), metadata.size())
+        && write(padding, metadataSize - metadata.size());
+}
+
+bool ArrowStreamWriter::writeBody(const QVector<const QByteArray *> &buffers)
+{
+    for (int i = 0; i < buffers.size(); ++i) {
+        const qint64 size = buffers[i]->size();
+        if (!write(buffers[i]->constData(), size) || !write(padding, padded(size) - size))
+            return false;
+    }
+    return true;
+}
+
+bool ArrowStreamWriter::write(const char *data, qint64 size)
+{
+    if (m_error)
+        return false;
+    if (size > 0 && m_device->write(data, size) != size)
+        m_error = true;
+    return !m_error;
+}
+
+QT_END_NAMESPACE_XLSX
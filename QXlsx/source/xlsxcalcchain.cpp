@@ -0,0 +1,85 @@
+// xlsxcalcchain.cpp
+
+#include "xlsxcalcchain_p.h"
+#include "xlsxcellreference.h"
+#include "xlsxxmlemitter_p.h"
+
+#include <QXmlStreamReader>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*!
+ * \internal
+ * \class CalcChain
+ */
+
+CalcChain::CalcChain(CreateFlag flag)
+    : AbstractOOXmlFile(flag)
+{
+}
+
+void CalcChain::clear()
+{
+    m_entries.clear();
+}
+
+void CalcChain::addCell(int sheetId, int row, int column, bool newLevel, bool array)
+{
+    const Entry entry = { sheetId, row, column, newLevel, array };
+    m_entries.append(entry);
+}
+
+/*
+ * The sheet id is only written when it differs from the one of the
+ * previous cell, as Excel does.
+ */
+void CalcChain::saveToXmlFile(QIODevice *device) const
+{
+    XmlEmitter emitter(device);
+
+    emitter.writeStartDocument();
+    emitter.writeRaw("<calcChain xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">");
+    int sheetId = -1;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const Entry &entry = m_entries[i];
+        emitter.writeRaw("<c r=\"");
+        emitter.writeCellReference(entry.row, entry.column);
+        if (entry.sheetId != sheetId) {
+            emitter.writeRaw("\" i=\"");
+            emitter.writeInteger(entry.sheetId);
+            sheetId = entry.sheetId;
+        }
+        if (entry.newLevel)
+            emitter.writeRaw("\" l=\"1");
+        if (entry.array)
+            emitter.writeRaw("\" a=\"1");
+        emitter.writeRaw("\"/>");
+    }
+    emitter.writeRaw("</calcChain>");
+    emitter.flush();
+}
+
+bool CalcChain::loadFromXmlFile(QIODevice *device)
+{
+    m_entries.clear();
+
+    QXmlStreamReader reader(device);
+    int sheetId = 0;
+    while (!reader.atEnd()) {
+        QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::StartElement && reader.name() == QLatin1String("c")) {
+            QXmlStreamAttributes attributes = reader.attributes();
+            if (attributes.hasAttribute(QLatin1String("i")))
+                sheetId = attributes.value(QLatin1String("i")).toString().toInt();
+            const CellReference ref(attributes.value(QLatin1String("r")).toString());
+            if (!ref.isValid())
+                continue;
+            addCell(sheetId, ref.row(), ref.column(),
+                    attributes.value(QLatin1String("l")) == QLatin1String("1"),
+                    attributes.value(QLatin1String("a")) == QLatin1String("1"));
+        }
+    }
+    return !reader.hasError();
+}
+
+QT_END_NAMESPACE_XLSX
@@ -15,7 +15,7 @@
 QT_BEGIN_NAMESPACE_XLSX
 
 CellFormulaPrivate::CellFormulaPrivate(const QString &formula_, const CellRange &ref_, CellFormula::FormulaType type_)
-    :formula(formula_), type(type_), reference(ref_), ca(false), si(0)
+    :formula(formula_), type(type_), reference(ref_), ca(false), si(0), parsed(false)
 {
     //Remove the formula '=' sign if exists
     if (formula.startsWith(QLatin1String("=")))
@@ -28,6 +28,7 @@ CellFormulaPrivate::CellFormulaPrivate(const CellFormulaPrivate &other)
     : QSharedData(other)
     , formula(other.formula), type(other.type), reference(other.reference)
     , ca(other.ca), si(other.si)
+    , parsedFormula(other.parsedFormula), parsed(other.parsed)
 {
 
 }
@@ -37,6 +38,25 @@ CellFormulaPrivate::~CellFormulaPrivate()
 
 }
 
+/*
+ * Returns the parsed formula. The text is parsed once, the
+ * expression is then shared by all the copies of the formula.
+ */
+const FormulaExpression &CellFormulaPrivate::expression() const
+{
+    if (!parsed) {
+        parsedFormula = FormulaExpression::parse(formula);
+        parsed = true;
+    }
+    return parsedFormula;
+}
+
+void CellFormulaPrivate::setFormulaText(const QString &text)
+{
+    formula = text;
+    parsed = false;
+}
+
 /*!
   \class CellFormula
   \inmodule QtXlsx
@@ -428,7 +448,7 @@ bool CellFormula::loadFromXml(QXmlStreamReader &reader)
         }
     }
 
-    d->formula = reader.readElementText(); // read formula
+    d->setFormulaText(reader.readElementText()); // read formula
 
     return true;
 }
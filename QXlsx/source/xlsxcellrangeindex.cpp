@@ -0,0 +1,430 @@
+// xlsxcellrangeindex.cpp
+
+#include "xlsxcellrangeindex_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int maxEntries = 16;
+const int minEntries = 6;
+
+} //namespace
+
+struct CellRangeIndex::Node
+{
+    explicit Node(bool leaf) : leaf(leaf), count(0) {}
+    ~Node()
+    {
+        if (!leaf) {
+            for (int i = 0; i < count; ++i)
+                delete children[i];
+        }
+    }
+
+    Rect bounds() const
+    {
+        Rect result = rects[0];
+        for (int i = 1; i < count; ++i) {
+            result.firstRow = qMin(result.firstRow, rects[i].firstRow);
+            result.firstColumn = qMin(result.firstColumn, rects[i].firstColumn);
+            result.lastRow = qMax(result.lastRow, rects[i].lastRow);
+            result.lastColumn = qMax(result.lastColumn, rects[i].lastColumn);
+        }
+        return result;
+    }
+
+    void append(const Rect &rect, Node *child, int value)
+    {
+        rects[count] = rect;
+        children[count] = child;
+        values[count] = value;
+        ++count;
+    }
+
+    // Moves the last entry to the place of entry i
+    void take(int i)
+    {
+        --count;
+        rects[i] = rects[count];
+        children[i] = children[count];
+        values[i] = values[count];
+    }
+
+    bool leaf;
+    int count;
+    // One more than the maximum, until the node is split
+    Rect rects[maxEntries + 1];
+    Node *children[maxEntries + 1];
+    int values[maxEntries + 1];
+};
+
+namespace {
+
+template <typename Rect>
+inline bool overlaps(const Rect &a, const Rect &b)
+{
+    return a.firstRow <= b.lastRow && b.firstRow <= a.lastRow
+            && a.firstColumn <= b.lastColumn && b.firstColumn <= a.lastColumn;
+}
+
+template <typename Rect>
+inline bool contains(const Rect &outer, const Rect &inner)
+{
+    return outer.firstRow <= inner.firstRow && inner.lastRow <= outer.lastRow
+            && outer.firstColumn <= inner.firstColumn && inner.lastColumn <= outer.lastColumn;
+}
+
+template <typename Rect>
+inline bool equals(const Rect &a, const Rect &b)
+{
+    return a.firstRow == b.firstRow && a.firstColumn == b.firstColumn
+            && a.lastRow == b.lastRow && a.lastColumn == b.lastColumn;
+}
+
+template <typename Rect>
+inline Rect united(const Rect &a, const Rect &b)
+{
+    Rect result;
+    result.firstRow = qMin(a.firstRow, b.firstRow);
+    result.firstColumn = qMin(a.firstColumn, b.firstColumn);
+    result.lastRow = qMax(a.lastRow, b.lastRow);
+    result.lastColumn = qMax(a.lastColumn, b.lastColumn);
+    return result;
+}
+
+template <typename Rect>
+inline qint64 area(const Rect &rect)
+{
+    return qint64(rect.lastRow - rect.firstRow + 1) * qint64(rect.lastColumn - rect.firstColumn + 1);
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class CellRangeIndex
+ */
+
+CellRangeIndex::CellRangeIndex()
+    : m_root(0), m_size(0)
+{
+}
+
+CellRangeIndex::~CellRangeIndex()
+{
+    delete m_root;
+}
+
+void CellRangeIndex::clear()
+{
+    delete m_root;
+    m_root = 0;
+    m_size = 0;
+}
+
+void CellRangeIndex::insert(const CellRange &range, int value)
+{
+    if (!m_root)
+        m_root = new Node(true);
+
+    const Entry entry = { toRect(range), value };
+    Node *sibling = insertEntry(m_root, entry);
+    if (sibling) {
+        Node *root = new Node(false);
+        root->append(m_root->bounds(), m_root, 0);
+        root->append(sibling->bounds(), sibling, 0);
+        m_root = root;
+    }
+    ++m_size;
+}
+
+/*
+ * Removes the \a range inserted with the \a value. Returns false if
+ * there is no such entry.
+ */
+bool CellRangeIndex::remove(const CellRange &range, int value)
+{
+    if (!m_root)
+        return false;
+
+    const Entry entry = { toRect(range), value };
+    QVector<Entry> orphans;
+    if (!removeEntry(m_root, entry, &orphans))
+        return false;
+    --m_size;
+
+    //A root with a single child is replaced by the child
+    while (!m_root->leaf && m_root->count == 1) {
+        Node *child = m_root->children[0];
+        m_root->count = 0;
+        delete m_root;
+        m_root = child;
+    }
+    if (m_root->count == 0) {
+        delete m_root;
+        m_root = 0;
+    }
+
+    //The entries of the nodes which were too small are inserted again
+    for (int i = 0; i < orphans.size(); ++i) {
+        if (!m_root)
+            m_root = new Node(true);
+        Node *sibling = insertEntry(m_root, orphans[i]);
+        if (sibling) {
+            Node *root = new Node(false);
+            root->append(m_root->bounds(), m_root, 0);
+            root->append(sibling->bounds(), sibling, 0);
+            m_root = root;
+        }
+    }
+    return true;
+}
+
+/*
+ * Returns true if any range of the index overlaps the \a range.
+ */
+bool CellRangeIndex::intersects(const CellRange &range) const
+{
+    return m_root && search(m_root, toRect(range), 0);
+}
+
+/*
+ * Returns the values of the ranges which overlap the \a range, in no
+ * particular order.
+ */
+QVector<int> CellRangeIndex::find(const CellRange &range) const
+{
+    QVector<int> values;
+    if (m_root)
+        search(m_root, toRect(range), &values);
+    return values;
+}
+
+/*
+ * Returns the values of the ranges which contain the cell at \a row
+ * and \a column, in no particular order.
+ */
+QVector<int> CellRangeIndex::find(int row, int column) const
+{
+    QVector<int> values;
+    if (m_root) {
+        const Rect rect = { row, column, row, column };
+        search(m_root, rect, &values);
+    }
+    return values;
+}
+
+CellRangeIndex::Rect CellRangeIndex::toRect(const CellRange &range)
+{
+    const Rect rect = { range.firstRow(), range.firstColumn(), range.lastRow(), range.lastColumn() };
+    return rect;
+}
+
+/*
+ * Adds the \a entry to a leaf under the \a node, through the children
+ * which need the least enlargement. Returns the new sibling of the
+ * \a node if it had to be split.
+ */
+CellRangeIndex::Node *CellRangeIndex::insertEntry(Node *node, const Entry &entry)
+{
+    if (node->leaf) {
+        node->append(entry.rect, 0, entry.value);
+    } else {
+        int best = 0;
+        qint64 bestEnlargement = 0;
+        qint64 bestArea = 0;
+        for (int i = 0; i < node->count; ++i) {
+            const qint64 childArea = area(node->rects[i]);
+            const qint64 enlargement = area(united(node->rects[i], entry.rect)) - childArea;
+            if (i == 0 || enlargement < bestEnlargement
+                    || (enlargement == bestEnlargement && childArea < bestArea)) {
+                best = i;
+                bestEnlargement = enlargement;
+                bestArea = childArea;
+            }
+        }
+
+        Node *child = node->children[best];
+        Node *sibling = insertEntry(child, entry);
+        node->rects[best] = child->bounds();
+        if (sibling)
+            node->append(sibling->bounds(), sibling, 0);
+    }
+
+    if (node->count > maxEntries)
+        return splitNode(node);
+    return 0;
+}
+
+/*
+ * Quadratic split of Guttman: the two entries which would waste the
+ * most area together start the two groups, then the entry with the
+ * strongest preference for one group goes next. The \a node keeps the
+ * first group, the second one is returned.
+ */
+CellRangeIndex::Node *CellRangeIndex::splitNode(Node *node)
+{
+    const int count = node->count;
+    Rect rects[maxEntries + 1];
+    Node *children[maxEntries + 1];
+    int values[maxEntries + 1];
+    for (int i = 0; i < count; ++i) {
+        rects[i] = node->rects[i];
+        children[i] = node->children[i];
+        values[i] = node->values[i];
+    }
+
+    int seedA = 0;
+    int seedB = 1;
+    qint64 worstWaste = -1;
+    for (int i = 0; i < count; ++i) {
+        for (int j = i + 1; j < count; ++j) {
+            const qint64 waste = area(united(rects[i], rects[j])) - area(rects[i]) - area(rects[j]);
+            if (waste > worstWaste) {
+                worstWaste = waste;
+                seedA = i;
+                seedB = j;
+            }
+        }
+    }
+
+    Node *sibling = new Node(node->leaf);
+    node->count = 0;
+    node->append(rects[seedA], children[seedA], values[seedA]);
+    sibling->append(rects[seedB], children[seedB], values[seedB]);
+    Rect boundsA = rects[seedA];
+    Rect boundsB = rects[seedB];
+
+    bool assigned[maxEntries + 1] = { false };
+    assigned[seedA] = true;
+    assigned[seedB] = true;
+    int remaining = count - 2;
+
+    while (remaining > 0) {
+        //A group which needs all the remaining entries gets them
+        Node *target = 0;
+        if (node->count + remaining == minEntries)
+            target = node;
+        else if (sibling->count + remaining == minEntries)
+            target = sibling;
+        if (target) {
+            for (int i = 0; i < count; ++i) {
+                if (!assigned[i]) {
+                    target->append(rects[i], children[i], values[i]);
+                    assigned[i] = true;
+                }
+            }
+            break;
+        }
+
+        int next = -1;
+        qint64 growthA = 0;
+        qint64 growthB = 0;
+        qint64 strongest = -1;
+        for (int i = 0; i < count; ++i) {
+            if (assigned[i])
+                continue;
+            const qint64 a = area(united(boundsA, rects[i])) - area(boundsA);
+            const qint64 b = area(united(boundsB, rects[i])) - area(boundsB);
+            const qint64 preference = a > b ? a - b : b - a;
+            if (preference > strongest) {
+                strongest = preference;
+                next = i;
+                growthA = a;
+                growthB = b;
+            }
+        }
+
+        bool toA;
+        if (growthA != growthB)
+            toA = growthA < growthB;
+        else if (area(boundsA) != area(boundsB))
+            toA = area(boundsA) < area(boundsB);
+        else
+            toA = node->count <= sibling->count;
+
+        if (toA) {
+            node->append(rects[next], children[next], values[next]);
+            boundsA = united(boundsA, rects[next]);
+        } else {
+            sibling->append(rects[next], children[next], values[next]);
+            boundsB = united(boundsB, rects[next]);
+        }
+        assigned[next] = true;
+        --remaining;
+    }
+
+    return sibling;
+}
+
+/*
+ * Removes the \a entry from the leaf under the \a node which holds it.
+ * The children left with too few entries are dropped, their entries
+ * are added to the \a orphans to be inserted again.
+ */
+bool CellRangeIndex::removeEntry(Node *node, const Entry &entry, QVector<Entry> *orphans)
+{
+    if (node->leaf) {
+        for (int i = 0; i < node->count; ++i) {
+            if (node->values[i] == entry.value && equals(node->rects[i], entry.rect)) {
+                node->take(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (int i = 0; i < node->count; ++i) {
+        if (!contains(node->rects[i], entry.rect))
+            continue;
+        Node *child = node->children[i];
+        if (!removeEntry(child, entry, orphans))
+            continue;
+
+        if (child->count < minEntries) {
+            collectEntries(child, orphans);
+            node->take(i);
+            delete child;
+        } else {
+            node->rects[i] = child->bounds();
+        }
+        return true;
+    }
+    return false;
+}
+
+void CellRangeIndex::collectEntries(const Node *node, QVector<Entry> *entries)
+{
+    for (int i = 0; i < node->count; ++i) {
+        if (node->leaf) {
+            const Entry entry = { node->rects[i], node->values[i] };
+            entries->append(entry);
+        } else {
+            collectEntries(node->children[i], entries);
+        }
+    }
+}
+
+/*
+ * Appends the values of the ranges under the \a node which overlap the
+ * \a rect to \a values. Without \a values, stops at the first one and
+ * returns true.
+ */
+bool CellRangeIndex::search(const Node *node, const Rect &rect, QVector<int> *values)
+{
+    for (int i = 0; i < node->count; ++i) {
+        if (!overlaps(node->rects[i], rect))
+            continue;
+        if (node->leaf) {
+            if (!values)
+                return true;
+            values->append(node->values[i]);
+        } else if (search(node->children[i], rect, values) && !values) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,170 @@
+// xlsxcolumntyper.cpp
+
+#include "xlsxcolumntyper_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxcell.h"
+#include "xlsxcellreference.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QSet>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+// What the cells of a column hold
+enum ValueKind {
+    NumberKind = 0x1,
+    DateKind = 0x2,
+    BooleanKind = 0x4,
+    TextKind = 0x8
+};
+
+// Doubles beyond hold no odd integers anymore
+const double maxExactInteger = 9007199254740992.0;
+
+} //namespace
+
+/*!
+ * \internal
+ * \class ColumnTyper
+ */
+
+ColumnTyper::ColumnTyper(Worksheet *sheet)
+    : m_sheet(sheet), m_date1904(sheet->workbook()->isDate1904()), m_numbers(m_date1904)
+{
+}
+
+/*
+ * Returns the names of the columns of \a range: the texts of its first
+ * row if \a headerRow is true, otherwise, and for the empty or repeated
+ * texts, the letters of the columns. The names differ from each other
+ * regardless of case, as SQL column names have to.
+ */
+QStringList ColumnTyper::columnNames(const CellRange &range, bool headerRow)
+{
+    QStringList names;
+    QSet<QString> used;
+    for (int column = range.firstColumn(); column <= range.lastColumn(); ++column) {
+        QString name;
+        if (headerRow) {
+            if (const Cell *cell = m_sheet->cellAt(range.firstRow(), column))
+                name = FormulaEngine::textOf(FormulaEngine::valueOf(cell, m_date1904)).trimmed();
+        }
+        if (name.isEmpty() || used.contains(name.toLower())) {
+            QString letters = CellReference(1, column).toString();
+            letters.chop(1);
+            name = name.isEmpty() ? letters : name + QLatin1Char('_') + letters;
+
+            //The name made may be the text of another column, as "B" or "a_C"
+            const QString base = name;
+            for (int n = 2; used.contains(name.toLower()); ++n)
+                name = base + QLatin1Char('_') + QString::number(n);
+        }
+        used.insert(name.toLower());
+        names.append(name);
+    }
+    return names;
+}
+
+/*
+ * Returns the type of each column of \a range, from the values of its
+ * cells from \a firstDataRow on.
+ */
+QVector<ColumnTyper::Type> ColumnTyper::columnTypes(const CellRange &range, int firstDataRow)
+{
+    WorksheetPrivate *sd = m_sheet->d_func();
+    const int columnCount = range.columnCount();
+
+    QVector<int> kinds(columnCount, 0);
+    QVector<bool> integral(columnCount, true);
+
+    typedef QMap<int, QSharedPointer<Cell> > CellRow;
+    QMap<int, CellRow>::const_iterator rowIt = sd->cellTable.lowerBound(firstDataRow);
+    for (; rowIt != sd->cellTable.constEnd() && rowIt.key() <= range.lastRow(); ++rowIt) {
+        CellRow::const_iterator it = rowIt->lowerBound(range.firstColumn());
+        for (; it != rowIt->constEnd() && it.key() <= range.lastColumn(); ++it) {
+            const int i = it.key() - range.firstColumn();
+            const Cell *cell = it.value().data();
+            const FormulaValue value = FormulaEngine::valueOf(cell, m_date1904);
+            switch (value.type) {
+            case FormulaValue::Blank:
+                break;
+            case FormulaValue::Number:
+                if (isDate(cell)) {
+                    kinds[i] |= DateKind;
+                } else {
+                    kinds[i] |= NumberKind;
+                    if (integral[i])
+                        integral[i] = std::floor(value.number) == value.number && std::fabs(value.number) < maxExactInteger;
+                }
+                break;
+            case FormulaValue::Boolean:
+                kinds[i] |= BooleanKind;
+                break;
+            default:
+                kinds[i] |= TextKind;
+                break;
+            }
+        }
+    }
+
+    QVector<Type> types(columnCount, Text);
+    for (int i = 0; i < columnCount; ++i) {
+        switch (kinds[i]) {
+        case NumberKind:
+            types[i] = integral[i] ? Integer : Number;
+            break;
+        case NumberKind | DateKind:
+            types[i] = Number;
+            break;
+        case DateKind:
+            types[i] = DateTime;
+            break;
+        case BooleanKind:
+            types[i] = Boolean;
+            break;
+        default:
+            break;
+        }
+    }
+    return types;
+}
+
+/*
+ * Returns true if the number format of \a cell shows dates or times.
+ */
+bool ColumnTyper::isDate(const Cell *cell)
+{
+    const Format format = cell->format();
+    if (!format.isValid())
+        return false;
+    if (!format.xfIndexValid())
+        return format.isDateTimeFormat();
+
+    QHash<int, bool>::const_iterator it = m_dateStyles.constFind(format.xfIndex());
+    if (it != m_dateStyles.constEnd())
+        return it.value();
+    const bool date = format.isDateTimeFormat();
+    m_dateStyles.insert(format.xfIndex(), date);
+    return date;
+}
+
+/*
+ * The \a value of \a cell as text, for the columns of text: numbers
+ * with the decimals of their format, dates as ISO 8601 strings.
+ */
+QString ColumnTyper::textOf(const Cell *cell, const FormulaValue &value)
+{
+    if (value.type != FormulaValue::Number)
+        return FormulaEngine::textOf(value);
+
+    char buffer[XLSX_NUMBER_TEXT_BUFFER_SIZE];
+    return QString::fromLatin1(buffer, m_numbers.format(value.number, cell->format(), buffer));
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,488 @@
+// xlsxconditionalformatevaluator.cpp
+
+#include "xlsxconditionalformatevaluator_p.h"
+#include "xlsxconditionalformatting_p.h"
+#include "xlsxconditionalformatoverlay_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxworkbook_p.h"
+#include "xlsxcolor_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+typedef QMap<int, QMap<int, QSharedPointer<Cell> > > CellTable;
+
+bool isTrue(const FormulaValue &value)
+{
+    return (value.type == FormulaValue::Number || value.type == FormulaValue::Boolean) && value.number != 0;
+}
+
+QColor ruleColor(const XlsxCfRuleData &data, int attribute)
+{
+    if (!data.attrs.contains(attribute))
+        return QColor();
+    return data.attrs[attribute].value<XlsxColor>().rgbColor();
+}
+
+/*
+ * Percentile of the ascending \a numbers, interpolated like PERCENTILE.
+ */
+double percentile(const QVector<double> &numbers, double fraction)
+{
+    fraction = qBound(0.0, fraction, 1.0);
+    const double position = fraction * (numbers.size() - 1);
+    const int below = int(std::floor(position));
+    if (below + 1 >= numbers.size())
+        return numbers.last();
+    return numbers[below] + (position - below) * (numbers[below + 1] - numbers[below]);
+}
+
+QColor interpolate(const QColor &from, const QColor &to, double fraction)
+{
+    return QColor::fromRgbF(from.redF() + (to.redF() - from.redF()) * fraction,
+                            from.greenF() + (to.greenF() - from.greenF()) * fraction,
+                            from.blueF() + (to.blueF() - from.blueF()) * fraction);
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class ConditionalFormatEvaluator
+ */
+
+ConditionalFormatEvaluator::ConditionalFormatEvaluator(Worksheet *sheet)
+    : m_sheet(sheet), m_engine(sheet->workbook()->d_func()->formulaEngine.data()),
+      m_date1904(sheet->workbook()->isDate1904())
+{
+    //The rules of equal priority keep the order of the sheet
+    QMap<int, QVector<Rule> > rulesByPriority;
+    const QList<ConditionalFormatting> &formattings = sheet->d_func()->conditionalFormattingList;
+    for (int i = 0; i < formattings.size(); ++i) {
+        const ConditionalFormatting &cf = formattings[i];
+        if (cf.ranges().isEmpty())
+            continue;
+        for (int j = 0; j < cf.d->cfRules.size(); ++j) {
+            const XlsxCfRuleData &data = *cf.d->cfRules[j];
+            rulesByPriority[data.priority].append(makeRule(cf, data));
+        }
+    }
+
+    for (QMap<int, QVector<Rule> >::const_iterator it = rulesByPriority.constBegin();
+         it != rulesByPriority.constEnd(); ++it) {
+        for (int i = 0; i < it->size(); ++i) {
+            const Rule &rule = it->at(i);
+            foreach (const CellRange &range, rule.ranges)
+                m_index.insert(range, m_rules.size());
+            m_rules.append(rule);
+        }
+    }
+}
+
+ConditionalFormatEvaluator::~ConditionalFormatEvaluator()
+{
+}
+
+/*
+ * Returns what the conditional formattings make of the cell at \a row
+ * and \a column.
+ */
+ConditionalFormatOverlay ConditionalFormatEvaluator::overlayAt(int row, int column) const
+{
+    ConditionalFormatOverlay overlay;
+    QVector<int> rules = m_index.find(row, column);
+    if (rules.isEmpty())
+        return overlay;
+    std::sort(rules.begin(), rules.end());
+    rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+
+    const FormulaValue value = valueAt(row, column);
+    for (int i = 0; i < rules.size(); ++i) {
+        const Rule &rule = m_rules[rules[i]];
+        if (apply(rule, row, column, value, &overlay) && rule.stopIfTrue)
+            break;
+    }
+    return overlay;
+}
+
+/*
+ * Returns the overlays of the cells of \a cells, or of the used range if
+ * \a cells is invalid, which the conditional formattings change, row by
+ * row.
+ */
+QMap<int, QMap<int, ConditionalFormatOverlay> > ConditionalFormatEvaluator::overlays(const CellRange &cells) const
+{
+    QMap<int, QMap<int, ConditionalFormatOverlay> > overlays;
+    CellRange used = m_sheet->dimension();
+    if (!used.isValid())
+        return overlays;
+    if (cells.isValid()) {
+        used = CellRange(qMax(cells.firstRow(), used.firstRow()), qMax(cells.firstColumn(), used.firstColumn()),
+                         qMin(cells.lastRow(), used.lastRow()), qMin(cells.lastColumn(), used.lastColumn()));
+        if (!used.isValid())
+            return overlays;
+    }
+
+    QSet<quint64> stopped;
+    for (int i = 0; i < m_rules.size(); ++i) {
+        const Rule &rule = m_rules[i];
+        foreach (const CellRange &range, rule.ranges) {
+            const int firstRow = qMax(range.firstRow(), used.firstRow());
+            const int lastRow = qMin(range.lastRow(), used.lastRow());
+            const int firstColumn = qMax(range.firstColumn(), used.firstColumn());
+            const int lastColumn = qMin(range.lastColumn(), used.lastColumn());
+            for (int row = firstRow; row <= lastRow; ++row) {
+                for (int column = firstColumn; column <= lastColumn; ++column) {
+                    const quint64 key = (quint64(row) << 32) | quint64(column);
+                    if (!stopped.isEmpty() && stopped.contains(key))
+                        continue;
+
+                    ConditionalFormatOverlay overlay = overlays.value(row).value(column);
+                    if (!apply(rule, row, column, valueAt(row, column), &overlay))
+                        continue;
+                    overlays[row][column] = overlay;
+                    if (rule.stopIfTrue)
+                        stopped.insert(key);
+                }
+            }
+        }
+    }
+    return overlays;
+}
+
+ConditionalFormatEvaluator::Rule ConditionalFormatEvaluator::makeRule(const ConditionalFormatting &cf, const XlsxCfRuleData &data) const
+{
+    Rule rule;
+    rule.ranges = cf.ranges();
+    rule.format = data.dxfFormat;
+    rule.stopIfTrue = data.attrs.value(XlsxCfRuleData::A_stopIfTrue).toBool();
+
+    //Relative references of the formulas are written for the top left cell
+    const CellRange &first = rule.ranges.first();
+    const int row = first.firstRow();
+    const int column = first.firstColumn();
+    if (data.attrs.contains(XlsxCfRuleData::A_formula1))
+        rule.formula1 = m_engine->compileRangeFormula(data.attrs[XlsxCfRuleData::A_formula1].toString(), m_sheet, row, column);
+    if (data.attrs.contains(XlsxCfRuleData::A_formula2))
+        rule.formula2 = m_engine->compileRangeFormula(data.attrs[XlsxCfRuleData::A_formula2].toString(), m_sheet, row, column);
+
+    const QString type = data.attrs.value(XlsxCfRuleData::A_type).toString();
+    if (type == QLatin1String("cellIs")) {
+        rule.type = CellIs;
+        rule.op = data.attrs.value(XlsxCfRuleData::A_operator).toString();
+    } else if (type == QLatin1String("expression")) {
+        rule.type = Expression;
+    } else if (type == QLatin1String("containsText")) {
+        rule.type = ContainsText;
+    } else if (type == QLatin1String("notContainsText")) {
+        rule.type = NotContainsText;
+    } else if (type == QLatin1String("beginsWith")) {
+        rule.type = BeginsWith;
+    } else if (type == QLatin1String("endsWith")) {
+        rule.type = EndsWith;
+    } else if (type == QLatin1String("containsBlanks")) {
+        rule.type = ContainsBlanks;
+    } else if (type == QLatin1String("notContainsBlanks")) {
+        rule.type = NotContainsBlanks;
+    } else if (type == QLatin1String("containsErrors")) {
+        rule.type = ContainsErrors;
+    } else if (type == QLatin1String("notContainsErrors")) {
+        rule.type = NotContainsErrors;
+    } else if (type == QLatin1String("duplicateValues")) {
+        rule.type = DuplicateValues;
+    } else if (type == QLatin1String("uniqueValues")) {
+        rule.type = UniqueValues;
+    } else if (type == QLatin1String("top10")) {
+        rule.type = Top10;
+        rule.rank = data.attrs.value(XlsxCfRuleData::A_rank, 10).toInt();
+        rule.bottom = data.attrs.value(XlsxCfRuleData::A_bottom).toString() == QLatin1String("1");
+        rule.percent = data.attrs.value(XlsxCfRuleData::A_percent).toString() == QLatin1String("1");
+    } else if (type == QLatin1String("aboveAverage")) {
+        rule.type = AboveAverage;
+        rule.above = data.attrs.value(XlsxCfRuleData::A_aboveAverage).toString() != QLatin1String("0");
+        rule.equalAverage = data.attrs.value(XlsxCfRuleData::A_equalAverage).toString() == QLatin1String("1");
+        rule.stdDev = data.attrs.value(XlsxCfRuleData::A_stdDev).toInt();
+    } else if (type == QLatin1String("colorScale") || type == QLatin1String("dataBar")) {
+        rule.type = type == QLatin1String("colorScale") ? ColorScale : DataBar;
+        rule.hideValue = data.attrs.contains(XlsxCfRuleData::A_hideData);
+        static const int cfvos[] = { XlsxCfRuleData::A_cfvo1, XlsxCfRuleData::A_cfvo2, XlsxCfRuleData::A_cfvo3 };
+        static const int colors[] = { XlsxCfRuleData::A_color1, XlsxCfRuleData::A_color2, XlsxCfRuleData::A_color3 };
+        const int stops = rule.type == ColorScale && data.attrs.contains(XlsxCfRuleData::A_cfvo3) ? 3 : 2;
+        for (int i = 0; i < stops; ++i) {
+            const XlsxCfVoData cfvo = data.attrs.value(cfvos[i]).value<XlsxCfVoData>();
+            Threshold &threshold = rule.thresholds[i];
+            threshold.type = cfvo.type;
+            threshold.number = 0;
+            if (cfvo.type == ConditionalFormatting::VOT_Formula) {
+                threshold.formula = m_engine->compileRangeFormula(cfvo.value, m_sheet, row, column);
+            } else {
+                bool ok;
+                const double number = parseXsdDouble(cfvo.value, &ok);
+                if (ok) {
+                    threshold.number = number;
+                } else if (cfvo.type == ConditionalFormatting::VOT_Num) {
+                    //A cell reference or any other formula
+                    threshold.type = ConditionalFormatting::VOT_Formula;
+                    threshold.formula = m_engine->compileRangeFormula(cfvo.value, m_sheet, row, column);
+                }
+            }
+        }
+        for (int i = 0; i < (rule.type == ColorScale ? stops : 1); ++i)
+            rule.colors[i] = ruleColor(data, colors[i]);
+        rule.stops = stops;
+    }
+
+    if (rule.type >= ContainsText && rule.type <= EndsWith)
+        rule.text = data.attrs.value(XlsxCfRuleData::A_text).toString();
+    return rule;
+}
+
+/*
+ * Statistics of the \a rule over the non-empty cells of its ranges,
+ * computed the first time.
+ */
+const ConditionalFormatEvaluator::Statistics &ConditionalFormatEvaluator::statistics(const Rule &rule) const
+{
+    Statistics &statistics = rule.statistics;
+    if (statistics.ready)
+        return statistics;
+    statistics.ready = true;
+
+    const bool counting = rule.type == DuplicateValues || rule.type == UniqueValues;
+    const CellTable &table = FormulaEngine::cellTable(m_sheet);
+    foreach (const CellRange &range, rule.ranges) {
+        for (CellTable::const_iterator it = table.lowerBound(range.firstRow());
+             it != table.constEnd() && it.key() <= range.lastRow(); ++it) {
+            const QMap<int, QSharedPointer<Cell> > &columns = it.value();
+            for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = columns.lowerBound(range.firstColumn());
+                 cell != columns.constEnd() && cell.key() <= range.lastColumn(); ++cell) {
+                const FormulaValue value = FormulaEngine::valueOf(cell->data(), m_date1904);
+                if (counting) {
+                    if (value.type != FormulaValue::Blank)
+                        ++statistics.counts[FormulaEngine::valueKey(value)];
+                } else if (value.type == FormulaValue::Number) {
+                    statistics.numbers.append(value.number);
+                }
+            }
+        }
+    }
+
+    QVector<double> &numbers = statistics.numbers;
+    std::sort(numbers.begin(), numbers.end());
+    if (numbers.isEmpty())
+        return statistics;
+
+    double sum = 0;
+    for (int i = 0; i < numbers.size(); ++i)
+        sum += numbers[i];
+    statistics.mean = sum / numbers.size();
+    if (numbers.size() > 1) {
+        double squares = 0;
+        for (int i = 0; i < numbers.size(); ++i)
+            squares += (numbers[i] - statistics.mean) * (numbers[i] - statistics.mean);
+        statistics.deviation = std::sqrt(squares / (numbers.size() - 1));
+    }
+
+    if (rule.type == Top10) {
+        int count = rule.percent ? int(qint64(numbers.size()) * rule.rank / 100) : rule.rank;
+        count = qBound(1, count, numbers.size());
+        statistics.limits[0] = rule.bottom ? numbers[count - 1] : numbers[numbers.size() - count];
+    } else if (rule.type == ColorScale || rule.type == DataBar) {
+        for (int i = 0; i < rule.stops; ++i)
+            statistics.limits[i] = thresholdValue(rule, statistics, i);
+    }
+    return statistics;
+}
+
+double ConditionalFormatEvaluator::thresholdValue(const Rule &rule, const Statistics &statistics, int index) const
+{
+    const Threshold &threshold = rule.thresholds[index];
+    const double minimum = statistics.numbers.first();
+    const double maximum = statistics.numbers.last();
+    switch (threshold.type) {
+    case ConditionalFormatting::VOT_Min:
+        return minimum;
+    case ConditionalFormatting::VOT_Max:
+        return maximum;
+    case ConditionalFormatting::VOT_Num:
+        return threshold.number;
+    case ConditionalFormatting::VOT_Percent:
+        return minimum + (maximum - minimum) * threshold.number / 100;
+    case ConditionalFormatting::VOT_Percentile:
+        return percentile(statistics.numbers, threshold.number / 100);
+    case ConditionalFormatting::VOT_Formula: {
+        const CellRange &first = rule.ranges.first();
+        const FormulaValue value = m_engine->evaluateRangeFormula(threshold.formula, first.firstRow(), first.firstColumn());
+        if (value.type == FormulaValue::Number)
+            return value.number;
+        return index == 0 ? minimum : maximum;
+    }
+    default:
+        return index == 0 ? minimum : maximum;
+    }
+}
+
+FormulaValue ConditionalFormatEvaluator::valueAt(int row, int column) const
+{
+    const CellTable &table = FormulaEngine::cellTable(m_sheet);
+    CellTable::const_iterator it = table.constFind(row);
+    if (it == table.constEnd())
+        return FormulaValue();
+    QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constFind(column);
+    if (cell == it->constEnd())
+        return FormulaValue();
+    return FormulaEngine::valueOf(cell->data(), m_date1904);
+}
+
+/*
+ * Adds what the \a rule makes of the cell at \a row and \a column to
+ * the \a overlay. Returns false if the rule doesn't hold for the cell.
+ */
+bool ConditionalFormatEvaluator::apply(const Rule &rule, int row, int column, const FormulaValue &value,
+                                       ConditionalFormatOverlay *overlay) const
+{
+    if (rule.type == ColorScale || rule.type == DataBar) {
+        if (value.type != FormulaValue::Number)
+            return false;
+        const Statistics &numbers = statistics(rule);
+        if (numbers.numbers.isEmpty())
+            return false;
+        const double *limits = numbers.limits;
+
+        if (rule.type == DataBar) {
+            if (overlay->d->dataBarLength >= 0)
+                return true;
+            double length;
+            if (limits[1] > limits[0])
+                length = qBound(0.0, (value.number - limits[0]) / (limits[1] - limits[0]), 1.0);
+            else
+                length = value.number >= limits[1] ? 1.0 : 0.0;
+            overlay->d->dataBarLength = length;
+            overlay->d->dataBarColor = rule.colors[0];
+            overlay->d->hideValue = rule.hideValue;
+            return true;
+        }
+
+        if (overlay->d->scaleColor.isValid())
+            return true;
+        const int last = rule.stops - 1;
+        if (value.number <= limits[0]) {
+            overlay->d->scaleColor = rule.colors[0];
+        } else if (value.number >= limits[last]) {
+            overlay->d->scaleColor = rule.colors[last];
+        } else {
+            int stop = 0;
+            while (stop + 1 < last && value.number > limits[stop + 1])
+                ++stop;
+            const double span = limits[stop + 1] - limits[stop];
+            const double fraction = span > 0 ? (value.number - limits[stop]) / span : 1.0;
+            overlay->d->scaleColor = interpolate(rule.colors[stop], rule.colors[stop + 1], fraction);
+        }
+        return true;
+    }
+
+    if (!holds(rule, row, column, value))
+        return false;
+
+    //The formats of the rules before take precedence
+    Format format = rule.format;
+    format.mergeFormat(overlay->d->format);
+    overlay->d->format = format;
+    return true;
+}
+
+bool ConditionalFormatEvaluator::holds(const Rule &rule, int row, int column, const FormulaValue &value) const
+{
+    switch (rule.type) {
+    case CellIs: {
+        const FormulaValue first = m_engine->evaluateRangeFormula(rule.formula1, row, column);
+        if (first.isError() || value.isError())
+            return false;
+        const int order = FormulaEngine::compare(value, first);
+        if (rule.op == QLatin1String("lessThan"))
+            return order < 0;
+        if (rule.op == QLatin1String("lessThanOrEqual"))
+            return order <= 0;
+        if (rule.op == QLatin1String("equal"))
+            return order == 0;
+        if (rule.op == QLatin1String("notEqual"))
+            return order != 0;
+        if (rule.op == QLatin1String("greaterThanOrEqual"))
+            return order >= 0;
+        if (rule.op == QLatin1String("greaterThan"))
+            return order > 0;
+        if (rule.op == QLatin1String("between") || rule.op == QLatin1String("notBetween")) {
+            const FormulaValue second = m_engine->evaluateRangeFormula(rule.formula2, row, column);
+            if (second.isError())
+                return false;
+            const bool swapped = FormulaEngine::compare(first, second) > 0;
+            const FormulaValue &low = swapped ? second : first;
+            const FormulaValue &high = swapped ? first : second;
+            const bool between = FormulaEngine::compare(value, low) >= 0 && FormulaEngine::compare(value, high) <= 0;
+            return rule.op == QLatin1String("between") ? between : !between;
+        }
+        return false;
+    }
+    case Expression:
+        return isTrue(m_engine->evaluateRangeFormula(rule.formula1, row, column));
+    case ContainsText:
+        return !value.isError() && FormulaEngine::textOf(value).contains(rule.text, Qt::CaseInsensitive);
+    case NotContainsText:
+        return value.isError() || !FormulaEngine::textOf(value).contains(rule.text, Qt::CaseInsensitive);
+    case BeginsWith:
+        return !value.isError() && FormulaEngine::textOf(value).startsWith(rule.text, Qt::CaseInsensitive);
+    case EndsWith:
+        return !value.isError() && FormulaEngine::textOf(value).endsWith(rule.text, Qt::CaseInsensitive);
+    case ContainsBlanks:
+        return value.type == FormulaValue::Blank
+                || (value.type == FormulaValue::String && value.text.trimmed().isEmpty());
+    case NotContainsBlanks:
+        return !(value.type == FormulaValue::Blank
+                 || (value.type == FormulaValue::String && value.text.trimmed().isEmpty()));
+    case ContainsErrors:
+        return value.isError();
+    case NotContainsErrors:
+        return !value.isError();
+    case DuplicateValues:
+    case UniqueValues: {
+        if (value.type == FormulaValue::Blank)
+            return false;
+        const int count = statistics(rule).counts.value(FormulaEngine::valueKey(value));
+        return rule.type == DuplicateValues ? count > 1 : count == 1;
+    }
+    case Top10: {
+        if (value.type != FormulaValue::Number)
+            return false;
+        const Statistics &numbers = statistics(rule);
+        if (numbers.numbers.isEmpty())
+            return false;
+        return rule.bottom ? value.number <= numbers.limits[0] : value.number >= numbers.limits[0];
+    }
+    case AboveAverage: {
+        if (value.type != FormulaValue::Number)
+            return false;
+        const Statistics &numbers = statistics(rule);
+        if (numbers.numbers.isEmpty())
+            return false;
+        if (rule.above) {
+            const double limit = numbers.mean + rule.stdDev * numbers.deviation;
+            return rule.equalAverage ? value.number >= limit : value.number > limit;
+        }
+        const double limit = numbers.mean - rule.stdDev * numbers.deviation;
+        return rule.equalAverage ? value.number <= limit : value.number < limit;
+    }
+    default:
+        return false;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,122 @@
+// xlsxconditionalformatoverlay.cpp
+
+#include "xlsxconditionalformatoverlay.h"
+#include "xlsxconditionalformatoverlay_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+ConditionalFormatOverlayPrivate::ConditionalFormatOverlayPrivate()
+    : dataBarLength(-1), hideValue(false)
+{
+}
+
+ConditionalFormatOverlayPrivate::ConditionalFormatOverlayPrivate(const ConditionalFormatOverlayPrivate &other)
+    : QSharedData(other)
+    , format(other.format), scaleColor(other.scaleColor), dataBarColor(other.dataBarColor)
+    , dataBarLength(other.dataBarLength), hideValue(other.hideValue)
+{
+}
+
+ConditionalFormatOverlayPrivate::~ConditionalFormatOverlayPrivate()
+{
+}
+
+/*!
+  \class ConditionalFormatOverlay
+  \inmodule QtXlsx
+  \brief What the conditional formattings of a worksheet make of a cell,
+  as given by Worksheet::conditionalFormatOverlayAt().
+
+  The overlay goes on top of the effective format of the cell, see
+  Worksheet::effectiveFormat().
+*/
+
+/*!
+  Creates an overlay which changes nothing.
+ */
+ConditionalFormatOverlay::ConditionalFormatOverlay()
+    : d(new ConditionalFormatOverlayPrivate)
+{
+}
+
+/*!
+  Creates a copy of \a other.
+ */
+ConditionalFormatOverlay::ConditionalFormatOverlay(const ConditionalFormatOverlay &other)
+    : d(other.d)
+{
+}
+
+/*!
+  Destroys the overlay.
+ */
+ConditionalFormatOverlay::~ConditionalFormatOverlay()
+{
+}
+
+/*!
+  Assigns \a other to this overlay and returns a reference to it.
+ */
+ConditionalFormatOverlay &ConditionalFormatOverlay::operator=(const ConditionalFormatOverlay &other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+  Returns true if the overlay changes nothing of the cell.
+ */
+bool ConditionalFormatOverlay::isEmpty() const
+{
+    return !d->format.isValid() && !d->scaleColor.isValid() && d->dataBarLength < 0;
+}
+
+/*!
+  Returns the formats of the rules which hold for the cell; where
+  several of them set the same property, the rule of highest priority
+  wins.
+ */
+Format ConditionalFormatOverlay::format() const
+{
+    return d->format;
+}
+
+/*!
+  Returns the background given by a color scale, or an invalid color
+  if no color scale applies.
+ */
+QColor ConditionalFormatOverlay::scaleColor() const
+{
+    return d->scaleColor;
+}
+
+/*!
+  Returns the color of the data bar.
+
+  \sa dataBarLength()
+ */
+QColor ConditionalFormatOverlay::dataBarColor() const
+{
+    return d->dataBarColor;
+}
+
+/*!
+  Returns the part of the width of the cell the data bar is drawn over,
+  from 0 to 1, or -1 when no data bar applies.
+
+  \sa dataBarColor()
+ */
+double ConditionalFormatOverlay::dataBarLength() const
+{
+    return d->dataBarLength;
+}
+
+/*!
+  Returns true if the data bar is shown without the value of the cell.
+ */
+bool ConditionalFormatOverlay::isValueHidden() const
+{
+    return d->hideValue;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,58 @@
+// xlsxcsvoptions.cpp
+
+#include "xlsxcsvoptions.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*!
+  \class CsvOptions
+  \inmodule QtXlsx
+  \brief Settings of the CSV files written by Worksheet::exportCsv() and
+  read by Worksheet::importCsv().
+
+  The fields are separated by \c delimiter, a comma by default, and the
+  records by \c lineTerminator, "\r\n" by default as in RFC 4180. The
+  fields which hold the delimiter, the quote character or a line break
+  are put between \c quoteChar, and the quote characters inside them are
+  doubled. The text is written in UTF-8, after a byte order mark if
+  \c writeByteOrderMark is set.
+
+  When \c applyNumberFormats is set, the default, the numbers are written
+  with the decimals of their number format, the percentages with a '%',
+  and the dates and times as ISO 8601 strings. Otherwise the numbers are
+  written as they are stored, and the dates as serial numbers.
+
+  Only the cells of \c range are written; by default, the whole
+  dimension of the sheet.
+
+  When reading, the input is taken as UTF-8, with or without a byte
+  order mark, and the records may end with "\r\n" or "\n" whatever
+  \c lineTerminator is. The fields which look like numbers, logical values,
+  and ISO 8601 dates and times are written as such if \c inferTypes is
+  set, the default; the others are written as text. The records are
+  parsed on \c threadCount threads, by default one per processor core,
+  and the first one goes to the top left cell of \c range, A1 by
+  default. The fields outside of \c range are left out.
+*/
+
+/*!
+  Creates the settings of a comma separated file.
+ */
+CsvOptions::CsvOptions()
+    : delimiter(','), quoteChar('"'), lineTerminator("\r\n")
+    , writeByteOrderMark(false), applyNumberFormats(true)
+    , inferTypes(true), threadCount(0)
+{
+}
+
+/*!
+  Returns the settings of a tab separated file.
+ */
+CsvOptions CsvOptions::tsv()
+{
+    CsvOptions options;
+    options.delimiter = '\t';
+    return options;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,511 @@
+// xlsxcsvreader.cpp
+
+#include "xlsxcsvreader_p.h"
+#include "xlsxworkscheduler_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QIODevice>
+#include <QThread>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int sliceSize = 1024 * 1024;
+const int slicesPerThread = 4;
+
+// Digits kept by a double; longer numbers, such as identifiers, are
+// kept as text
+const int maxNumberDigits = 15;
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/*
+ * Value of the \a count digits at \a data, or -1 if they aren't all
+ * digits.
+ */
+int readDigits(const char *data, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!isDigit(data[i]))
+            return -1;
+        value = value * 10 + (data[i] - '0');
+    }
+    return value;
+}
+
+/*
+ * Days from 1970-01-01 to the date \a year-\a month-\a day of the
+ * proleptic Gregorian calendar.
+ */
+qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return qint64(era) * 146097 + dayOfEra - 719468;
+}
+
+int daysInMonth(int year, int month)
+{
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))
+        return 29;
+    return days[month - 1];
+}
+
+inline bool equalsIgnoreCase(const char *data, int size, const char *upper)
+{
+    for (int i = 0; i < size; ++i) {
+        const char c = data[i] >= 'a' && data[i] <= 'z' ? char(data[i] - 'a' + 'A') : data[i];
+        if (c != upper[i])
+            return false;
+    }
+    return upper[size] == '\0';
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class CsvReader
+ */
+
+CsvReader::CsvReader(QIODevice *device, const CsvOptions &options, bool date1904)
+    : m_device(device), m_options(options), m_date1904(date1904)
+    , m_atEnd(false), m_error(false), m_consumed(0)
+{
+    const int threads = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+    m_scheduler.reset(new WorkScheduler(qMax(threads, 1)));
+}
+
+CsvReader::~CsvReader()
+{
+}
+
+/*
+ * Reads and parses the next batch of records into chunks(). Returns
+ * false once the whole input has been read.
+ */
+bool CsvReader::readBatch()
+{
+    bool first = !m_atEnd && m_data.isEmpty() && m_consumed == 0;
+    const int sliceCount = m_scheduler->threadCount() * slicesPerThread;
+    int batchSize = sliceCount * sliceSize;
+
+    for (;;) {
+        fill(batchSize);
+        if (first && m_data.startsWith("\xEF\xBB\xBF"))
+            m_data.remove(0, 3);
+        first = false;
+
+        m_chunks.clear();
+        if (m_data.isEmpty())
+            return false;
+
+        split(sliceCount);
+        m_chunks.resize(sliceCount);
+
+        QVector<int> consumed(sliceCount);
+        const char *data = m_data.constData();
+        m_scheduler->run(sliceCount, [&](int i) {
+            const int begin = m_boundaries.at(i);
+            const int end = m_boundaries.at(i + 1);
+            const bool complete = m_atEnd || end < m_data.size();
+            consumed[i] = parse(data + begin, data + end, complete, &m_chunks[i]);
+        });
+
+        //Only the first chunk which runs to the end of the input may
+        //have left a record out; the chunks after it are empty
+        int last = 0;
+        while (m_boundaries.at(last + 1) < m_data.size())
+            ++last;
+        m_consumed = m_boundaries.at(last) + consumed.at(last);
+        if (m_consumed > 0 || m_atEnd)
+            return true;
+
+        // Not even one whole record: read on
+        batchSize = m_data.size() * 2;
+    }
+}
+
+/*
+ * Drops the input parsed so far, and reads until \a size bytes are
+ * buffered or the input ends. A read error ends the input too, and
+ * is kept for hasError().
+ */
+void CsvReader::fill(int size)
+{
+    if (m_consumed) {
+        m_data.remove(0, m_consumed);
+        m_consumed = 0;
+    }
+
+    int used = m_data.size();
+    if (m_atEnd || used >= size)
+        return;
+
+    m_data.resize(size);
+    while (used < size) {
+        const qint64 n = m_device->read(m_data.data() + used, size - used);
+        if (n > 0) {
+            used += int(n);
+        } else if (n < 0) {
+            m_error = true;
+            m_atEnd = true;
+            break;
+        } else if (!m_device->waitForReadyRead(-1)) {
+            m_atEnd = true;
+            break;
+        }
+    }
+    m_data.resize(used);
+}
+
+/*
+ * Splits the input into \a sliceCount chunks of about the same size,
+ * each starting at the beginning of a record.
+ */
+void CsvReader::split(int sliceCount)
+{
+    const char *data = m_data.constData();
+    const int size = m_data.size();
+
+    //The states parse() goes through, as far as where records end goes:
+    //a quote character only opens a quoted field at the start of a field
+    quint8 next[ScanStates][256];
+    for (int c = 0; c < 256; ++c) {
+        const char ch = char(c);
+        const bool separator = ch == m_options.delimiter || ch == '\n';
+        const bool quote = ch == m_options.quoteChar;
+        next[FieldStart][c] = quote ? Quoted : separator ? FieldStart : Unquoted;
+        next[Unquoted][c] = separator ? FieldStart : Unquoted;
+        next[Quoted][c] = quote ? QuoteInQuoted : Quoted;
+        next[QuoteInQuoted][c] = quote ? Quoted : separator ? FieldStart : Unquoted;
+    }
+
+    QVector<int> starts(sliceCount + 1);
+    for (int i = 0; i <= sliceCount; ++i)
+        starts[i] = int(qint64(size) * i / sliceCount);
+
+    //State at the end of each slice, for each state at its start
+    QVector<quint8> ends(sliceCount * ScanStates);
+    m_scheduler->run(sliceCount, [&](int i) {
+        quint8 states[ScanStates] = { FieldStart, Unquoted, Quoted, QuoteInQuoted };
+        for (int pos = starts.at(i); pos < starts.at(i + 1); ++pos) {
+            const uchar c = uchar(data[pos]);
+            for (int s = 0; s < ScanStates; ++s)
+                states[s] = next[states[s]][c];
+        }
+        for (int s = 0; s < ScanStates; ++s)
+            ends[i * ScanStates + s] = states[s];
+    });
+
+    m_boundaries.resize(sliceCount + 1);
+    m_boundaries[0] = 0;
+    m_boundaries[sliceCount] = size;
+
+    quint8 state = FieldStart;
+    for (int i = 1; i < sliceCount; ++i) {
+        state = ends.at((i - 1) * ScanStates + state);
+        if (m_boundaries.at(i - 1) > starts.at(i)) {
+            //The record found for the previous chunk starts beyond this one
+            m_boundaries[i] = m_boundaries.at(i - 1);
+            continue;
+        }
+
+        int boundary = size;
+        quint8 scan = state;
+        for (int pos = starts.at(i); pos < size; ++pos) {
+            scan = next[scan][uchar(data[pos])];
+            if (data[pos] == '\n' && scan == FieldStart) {
+                boundary = pos + 1;
+                break;
+            }
+        }
+        m_boundaries[i] = boundary;
+    }
+}
+
+/*
+ * Parses the records from \a begin to \a end into \a chunk. Unless the
+ * input is \a complete, a record which runs to \a end may go on in the
+ * next batch, so it is left out.
+ *
+ * Returns the number of bytes parsed.
+ */
+int CsvReader::parse(const char *begin, const char *end, bool complete, CsvChunk *chunk) const
+{
+    const char delimiter = m_options.delimiter;
+    const char quote = m_options.quoteChar;
+
+    QHash<QByteArray, int> strings;
+    QByteArray unquoted;
+
+    const char *p = begin;
+    const char *record = begin;
+    int recordFields = 0;
+    int row = 0;
+    int column = 0;
+    bool incomplete = false;
+
+    while (p < end) {
+        const char *data;
+        int size;
+
+        if (*p == quote) {
+            const char *q = p + 1;
+            const char *segment = q;
+            bool escaped = false;
+            bool closed = false;
+            while (q < end) {
+                if (*q == quote) {
+                    if (q + 1 < end && q[1] == quote) {
+                        if (!escaped)
+                            unquoted.clear();
+                        unquoted.append(segment, int(q + 1 - segment));
+                        q += 2;
+                        segment = q;
+                        escaped = true;
+                        continue;
+                    }
+                    //The doubled quote may be split by the end of the batch
+                    closed = q + 1 < end || complete;
+                    break;
+                }
+                ++q;
+            }
+            if (!closed && !complete) {
+                incomplete = true;
+                break;
+            }
+
+            if (escaped) {
+                unquoted.append(segment, int(q - segment));
+                data = unquoted.constData();
+                size = unquoted.size();
+            } else {
+                data = p + 1;
+                size = int(q - p - 1);
+            }
+
+            //Whatever follows the closing quote is dropped
+            p = closed ? q + 1 : q;
+            while (p < end && *p != delimiter && *p != '\n')
+                ++p;
+        } else {
+            data = p;
+            while (p < end && *p != delimiter && *p != '\n')
+                ++p;
+            size = int(p - data);
+            if (size && data[size - 1] == '\r' && (p == end || *p == '\n'))
+                --size;
+        }
+
+        if (p == end && !complete) {
+            incomplete = true;
+            break;
+        }
+
+        addField(data, size, row, column, chunk, &strings);
+
+        if (p == end) {
+            //Last record, without a line break
+            ++row;
+            record = p;
+            break;
+        }
+
+        if (*p == delimiter) {
+            ++p;
+            ++column;
+            if (p == end) {
+                if (!complete) {
+                    incomplete = true;
+                    break;
+                }
+                ++row;
+                record = p;
+            }
+            continue;
+        }
+
+        ++p;
+        ++row;
+        column = 0;
+        record = p;
+        recordFields = chunk->fields.size();
+    }
+
+    if (incomplete)
+        chunk->fields.resize(recordFields);
+    chunk->records = row;
+    return int(record - begin);
+}
+
+/*
+ * Adds the field of \a size bytes at \a data, with the type it looks
+ * like. Empty fields are left out.
+ */
+void CsvReader::addField(const char *data, int size, int row, int column,
+                         CsvChunk *chunk, QHash<QByteArray, int> *strings) const
+{
+    if (size == 0)
+        return;
+
+    CsvField field;
+    field.row = row;
+    field.column = column;
+    field.number = 0;
+    field.string = -1;
+
+    if (m_options.inferTypes) {
+        if (parseNumber(data, size, &field.number)) {
+            field.type = CsvField::Number;
+            chunk->fields.append(field);
+            return;
+        }
+        if (equalsIgnoreCase(data, size, "TRUE") || equalsIgnoreCase(data, size, "FALSE")) {
+            field.type = CsvField::Boolean;
+            field.number = size == 4 ? 1 : 0;
+            chunk->fields.append(field);
+            return;
+        }
+        if (parseDateTime(data, size, m_date1904, &field.type, &field.number)) {
+            chunk->fields.append(field);
+            return;
+        }
+    }
+
+    //Looked up without copying the bytes; only new texts are decoded
+    QHash<QByteArray, int>::const_iterator it = strings->constFind(QByteArray::fromRawData(data, size));
+    if (it != strings->constEnd()) {
+        field.string = it.value();
+    } else {
+        field.string = chunk->strings.size();
+        strings->insert(QByteArray(data, size), field.string);
+        chunk->strings.append(QString::fromUtf8(data, size));
+    }
+    field.type = CsvField::String;
+    chunk->fields.append(field);
+}
+
+/*
+ * Parses a decimal number. Numbers with a leading zero, such as postal
+ * codes, and numbers with more digits than a double keeps are not taken
+ * as numbers.
+ */
+bool CsvReader::parseNumber(const char *data, int size, double *value)
+{
+    int i = 0;
+    if (size > 0 && (data[0] == '-' || data[0] == '+'))
+        i = 1;
+    if (i == size)
+        return false;
+    if (data[i] == '0' && i + 1 < size && isDigit(data[i + 1]))
+        return false;
+
+    int digits = 0;
+    bool exponent = false;
+    for (; i < size; ++i) {
+        const char c = data[i];
+        if (isDigit(c)) {
+            if (!exponent)
+                ++digits;
+        } else if (c == 'e' || c == 'E') {
+            exponent = true;
+        } else if (c != '.' && c != '-' && c != '+') {
+            return false;
+        }
+    }
+    if (digits == 0 || digits > maxNumberDigits)
+        return false;
+
+    bool ok = false;
+    *value = parseXsdDouble(data, size, &ok);
+    return ok && std::isfinite(*value);
+}
+
+/*
+ * Parses an ISO 8601 date "yyyy-mm-dd", time "hh:mm[:ss[.zzz]]", or
+ * date and time separated by 'T' or a space, into a serial number.
+ */
+bool CsvReader::parseDateTime(const char *data, int size, bool date1904, CsvField::Type *type, double *value)
+{
+    double serial = 0;
+    int pos = 0;
+    bool hasDate = false;
+
+    if (size >= 10 && data[4] == '-' && data[7] == '-') {
+        const int year = readDigits(data, 4);
+        const int month = readDigits(data + 5, 2);
+        const int day = readDigits(data + 8, 2);
+        if (year < 0 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month))
+            return false;
+
+        qint64 days;
+        if (date1904) {
+            days = daysFromCivil(year, month, day) - daysFromCivil(1904, 1, 1);
+            if (days < 0)
+                return false;
+        } else {
+            days = daysFromCivil(year, month, day) - daysFromCivil(1899, 12, 30);
+            if (days < 61)
+                days -= 1; // before the 1900-02-29 the 1900 date system has
+            if (days < 1)
+                return false;
+        }
+
+        serial = double(days);
+        hasDate = true;
+        pos = 10;
+        if (pos == size) {
+            *type = CsvField::Date;
+            *value = serial;
+            return true;
+        }
+        if (data[pos] != 'T' && data[pos] != ' ')
+            return false;
+        ++pos;
+    }
+
+    if (size - pos < 5 || data[pos + 2] != ':')
+        return false;
+    const int hour = readDigits(data + pos, 2);
+    const int minute = readDigits(data + pos + 3, 2);
+    int second = 0;
+    double fraction = 0;
+    pos += 5;
+    if (pos < size) {
+        if (size - pos < 3 || data[pos] != ':')
+            return false;
+        second = readDigits(data + pos + 1, 2);
+        pos += 3;
+        if (pos < size) {
+            if (data[pos] != '.' || pos + 1 == size)
+                return false;
+            double scale = 0.1;
+            for (++pos; pos < size; ++pos, scale /= 10) {
+                if (!isDigit(data[pos]))
+                    return false;
+                fraction += (data[pos] - '0') * scale;
+            }
+        }
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59)
+        return false;
+
+    *type = hasDate ? CsvField::DateTime : CsvField::Time;
+    *value = serial + (hour * 3600 + minute * 60 + second + fraction) / 86400.0;
+    return true;
+}
+
+QT_END_NAMESPACE_XLSX
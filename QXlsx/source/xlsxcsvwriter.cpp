@@ -0,0 +1,173 @@
+// xlsxcsvwriter.cpp
+
+#include "xlsxcsvwriter_p.h"
+#include "xlsxformulaengine_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QIODevice>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*!
+ * \internal
+ * \class CsvWriter
+ */
+
+CsvWriter::CsvWriter(QIODevice *device, const CsvOptions &options, bool date1904)
+    : m_device(device), m_options(options), m_numbers(date1904)
+    , m_error(false), m_fields(0), m_used(0)
+{
+    m_buffer.resize(BufferSize);
+    m_data = m_buffer.data();
+
+    if (m_options.writeByteOrderMark)
+        writeLatin1("\xEF\xBB\xBF", 3);
+}
+
+/*
+ * Writes \a value as the next field of the record. Numbers are written
+ * according to \a format, the format the cell is displayed with.
+ */
+void CsvWriter::writeField(const FormulaValue &value, const Format &format)
+{
+    separate();
+
+    switch (value.type) {
+    case FormulaValue::Number:
+        writeNumber(value.number, format);
+        break;
+    case FormulaValue::Boolean:
+        if (value.number)
+            writeLatin1("TRUE", 4);
+        else
+            writeLatin1("FALSE", 5);
+        break;
+    case FormulaValue::String:
+    case FormulaValue::Error:
+        writeText(value.text);
+        break;
+    default:
+        break;
+    }
+}
+
+void CsvWriter::writeEmptyField()
+{
+    separate();
+}
+
+/*
+ * Writes a record of \a fields empty fields.
+ */
+void CsvWriter::writeEmptyRecord(int fields)
+{
+    for (int i = 0; i < fields; ++i)
+        separate();
+    endRecord();
+}
+
+void CsvWriter::endRecord()
+{
+    writeLatin1(m_options.lineTerminator.constData(), m_options.lineTerminator.size());
+    m_fields = 0;
+}
+
+/*
+ * Writes what is left in the buffer to the device. Returns false if
+ * the device failed to take all the data written so far.
+ */
+bool CsvWriter::flush()
+{
+    flushBuffer();
+    return !m_error;
+}
+
+void CsvWriter::flushBuffer()
+{
+    if (m_used && !m_error && m_device->write(m_data, m_used) != m_used)
+        m_error = true;
+    m_used = 0;
+}
+
+void CsvWriter::separate()
+{
+    if (m_fields++)
+        put(m_options.delimiter);
+}
+
+void CsvWriter::writeNumber(double value, const Format &format)
+{
+    char buffer[XLSX_NUMBER_TEXT_BUFFER_SIZE];
+    if (m_options.applyNumberFormats)
+        writeLatin1(buffer, m_numbers.format(value, format, buffer));
+    else
+        writeLatin1(buffer, formatXsdDouble(value, buffer));
+}
+
+/*
+ * Writes \a text encoded in UTF-8, quoted if it holds the delimiter,
+ * the quote character or a line break.
+ */
+void CsvWriter::writeText(const QString &text)
+{
+    const ushort *data = text.utf16();
+    const int size = text.size();
+    const ushort delimiter = uchar(m_options.delimiter);
+    const ushort quote = uchar(m_options.quoteChar);
+
+    bool quoted = false;
+    for (int i = 0; i < size && !quoted; ++i) {
+        const ushort c = data[i];
+        quoted = c == delimiter || c == quote || c == '\n' || c == '\r';
+    }
+
+    if (quoted)
+        put(m_options.quoteChar);
+
+    for (int i = 0; i < size; ++i) {
+        uint u = data[i];
+        if (u < 0x80) {
+            if (quoted && u == quote)
+                put(char(u));
+            put(char(u));
+        } else if (u < 0x800) {
+            put(char(0xc0 | (u >> 6)));
+            put(char(0x80 | (u & 0x3f)));
+        } else {
+            if (QChar::isSurrogate(u)) {
+                if (QChar::isHighSurrogate(u) && i + 1 < size && QChar::isLowSurrogate(data[i + 1])) {
+                    u = QChar::surrogateToUcs4(ushort(u), data[++i]);
+                    put(char(0xf0 | (u >> 18)));
+                    put(char(0x80 | ((u >> 12) & 0x3f)));
+                    put(char(0x80 | ((u >> 6) & 0x3f)));
+                    put(char(0x80 | (u & 0x3f)));
+                    continue;
+                }
+                u = QChar::ReplacementCharacter;
+            }
+            put(char(0xe0 | (u >> 12)));
+            put(char(0x80 | ((u >> 6) & 0x3f)));
+            put(char(0x80 | (u & 0x3f)));
+        }
+    }
+
+    if (quoted)
+        put(m_options.quoteChar);
+}
+
+void CsvWriter::writeLatin1(const char *data, int size)
+{
+    while (size > 0) {
+        if (m_used == BufferSize)
+            flushBuffer();
+        const int n = qMin(size, int(BufferSize) - m_used);
+        memcpy(m_data + m_used, data, n);
+        m_used += n;
+        data += n;
+        size -= n;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,321 @@
+// xlsxdatavalidator.cpp
+
+#include "xlsxdatavalidator_p.h"
+#include "xlsxcellrangeindex_p.h"
+#include "xlsxnumericcodec_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworkbook.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+typedef QMap<int, QMap<int, QSharedPointer<Cell> > > CellTable;
+
+/*
+ * Member of a list written in its formula, such as "Yes,No" or "1,2,3".
+ */
+FormulaValue listItem(const QString &text)
+{
+    const QString item = text.trimmed();
+    bool ok;
+    const double number = parseXsdDouble(item, &ok);
+    if (ok)
+        return FormulaValue::fromNumber(number);
+    return FormulaValue::fromString(item);
+}
+
+inline bool isBlank(const FormulaValue &value)
+{
+    return value.type == FormulaValue::Blank || (value.type == FormulaValue::String && value.text.isEmpty());
+}
+
+bool compare(DataValidation::ValidationOperator op, double value, double first, double second)
+{
+    switch (op) {
+    case DataValidation::Between:
+        return value >= qMin(first, second) && value <= qMax(first, second);
+    case DataValidation::NotBetween:
+        return value < qMin(first, second) || value > qMax(first, second);
+    case DataValidation::Equal:
+        return value == first;
+    case DataValidation::NotEqual:
+        return value != first;
+    case DataValidation::LessThan:
+        return value < first;
+    case DataValidation::LessThanOrEqual:
+        return value <= first;
+    case DataValidation::GreaterThan:
+        return value > first;
+    case DataValidation::GreaterThanOrEqual:
+        return value >= first;
+    default:
+        return true;
+    }
+}
+
+bool lessThan(const DataValidator::Violation &a, const DataValidator::Violation &b)
+{
+    if (a.row != b.row)
+        return a.row < b.row;
+    if (a.column != b.column)
+        return a.column < b.column;
+    return a.validation < b.validation;
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class DataValidator
+ */
+
+DataValidator::DataValidator(Worksheet *sheet, const FormulaEngine *engine, const QList<DataValidation> &validations,
+                             const CellRangeIndex &index)
+    : m_sheet(sheet), m_engine(engine), m_index(index), m_date1904(sheet->workbook()->isDate1904())
+{
+    m_rules.reserve(validations.size());
+    for (int i = 0; i < validations.size(); ++i)
+        m_rules.append(makeRule(validations[i]));
+}
+
+DataValidator::~DataValidator()
+{
+}
+
+/*
+ * Returns the cells which break a validation, row by row.
+ */
+QVector<DataValidator::Violation> DataValidator::validate() const
+{
+    QVector<Violation> violations;
+    if (m_rules.isEmpty())
+        return violations;
+
+    const CellTable &table = FormulaEngine::cellTable(m_sheet);
+    for (CellTable::const_iterator it = table.constBegin(); it != table.constEnd(); ++it) {
+        const int row = it.key();
+        for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constBegin(); cell != it->constEnd(); ++cell) {
+            const int column = cell.key();
+            QVector<int> rules = m_index.find(row, column);
+            if (rules.isEmpty())
+                continue;
+            if (rules.size() > 1) {
+                std::sort(rules.begin(), rules.end());
+                rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+            }
+
+            const FormulaValue value = FormulaEngine::valueOf(cell->data(), m_date1904);
+            for (int i = 0; i < rules.size(); ++i) {
+                if (!isValid(m_rules[rules[i]], row, column, value)) {
+                    const Violation violation = { row, column, rules[i] };
+                    violations.append(violation);
+                }
+            }
+        }
+    }
+
+    //The cells which don't exist are blank
+    const CellRange used = m_sheet->dimension();
+    bool sorted = true;
+    for (int i = 0; i < m_rules.size() && used.isValid(); ++i) {
+        const Rule &rule = m_rules[i];
+        if (rule.allowBlank || rule.acceptsAll)
+            continue;
+        foreach (const CellRange &range, rule.ranges) {
+            const int lastRow = qMin(range.lastRow(), used.lastRow());
+            const int firstColumn = qMax(range.firstColumn(), used.firstColumn());
+            const int lastColumn = qMin(range.lastColumn(), used.lastColumn());
+            for (int row = qMax(range.firstRow(), used.firstRow()); row <= lastRow; ++row) {
+                CellTable::const_iterator it = table.constFind(row);
+                for (int column = firstColumn; column <= lastColumn; ++column) {
+                    if (it != table.constEnd() && it->contains(column))
+                        continue;
+                    const Violation violation = { row, column, i };
+                    violations.append(violation);
+                    sorted = false;
+                }
+            }
+        }
+    }
+
+    if (!sorted) {
+        std::sort(violations.begin(), violations.end(), lessThan);
+        //A cell in two ranges of a rule is reported once
+        QVector<Violation>::iterator end = std::unique(violations.begin(), violations.end(),
+            [](const Violation &a, const Violation &b) {
+                return a.row == b.row && a.column == b.column && a.validation == b.validation;
+            });
+        violations.erase(end, violations.end());
+    }
+    return violations;
+}
+
+DataValidator::Rule DataValidator::makeRule(const DataValidation &validation) const
+{
+    Rule rule;
+    rule.type = validation.validationType();
+    rule.op = validation.validationOperator();
+    rule.allowBlank = validation.allowBlank();
+    rule.ranges = validation.ranges();
+    if (rule.ranges.isEmpty() || rule.type == DataValidation::None) {
+        rule.acceptsAll = true;
+        return rule;
+    }
+
+    //Relative references of the formulas are written for the top left cell
+    const int row = rule.ranges.first().firstRow();
+    const int column = rule.ranges.first().firstColumn();
+    QString formulas[2] = { validation.formula1(), validation.formula2() };
+    Bound *bounds[2] = { &rule.first, &rule.second };
+    for (int i = 0; i < 2; ++i) {
+        QString &text = formulas[i];
+        if (text.startsWith(QLatin1Char('=')))
+            text.remove(0, 1);
+        bool ok;
+        const double number = parseXsdDouble(text.trimmed(), &ok);
+        if (ok) {
+            bounds[i]->constant = true;
+            bounds[i]->number = number;
+        } else if (!text.isEmpty()) {
+            bounds[i]->formula = m_engine->compileRangeFormula(text, m_sheet, row, column);
+        }
+    }
+
+    if (rule.type == DataValidation::List) {
+        if (rule.first.constant)
+            rule.members.insert(FormulaEngine::valueKey(FormulaValue::fromNumber(rule.first.number)));
+        else if (rule.first.formula.isValid())
+            addMembers(m_engine->evaluateRangeFormula(rule.first.formula, row, column, false), &rule);
+        else
+            rule.acceptsAll = true;
+    } else if (rule.type == DataValidation::Custom) {
+        if (!rule.first.formula.isValid())
+            rule.acceptsAll = true;
+    }
+    return rule;
+}
+
+/*
+ * Adds the members of the list given by the \a source, the value of its
+ * formula, to the \a rule.
+ */
+void DataValidator::addMembers(const FormulaValue &source, Rule *rule) const
+{
+    switch (source.type) {
+    case FormulaValue::String:
+        foreach (const QString &item, source.text.split(QLatin1Char(',')))
+            rule->members.insert(FormulaEngine::valueKey(listItem(item)));
+        break;
+    case FormulaValue::Area: {
+        const CellTable &table = FormulaEngine::cellTable(source.sheet);
+        for (CellTable::const_iterator it = table.lowerBound(source.firstRow);
+             it != table.constEnd() && it.key() <= source.lastRow; ++it) {
+            for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->lowerBound(source.firstColumn);
+                 cell != it->constEnd() && cell.key() <= source.lastColumn; ++cell) {
+                const FormulaValue value = FormulaEngine::valueOf(cell->data(), m_date1904);
+                if (!isBlank(value))
+                    rule->members.insert(FormulaEngine::valueKey(value));
+            }
+        }
+        break;
+    }
+    case FormulaValue::Array:
+        for (int i = 0; i < source.elements.size(); ++i) {
+            if (!isBlank(source.elements[i]))
+                rule->members.insert(FormulaEngine::valueKey(source.elements[i]));
+        }
+        break;
+    case FormulaValue::Number:
+    case FormulaValue::Boolean:
+        rule->members.insert(FormulaEngine::valueKey(source));
+        break;
+    default:
+        rule->acceptsAll = true;
+        break;
+    }
+}
+
+/*
+ * Value of the \a bound for the cell at \a row and \a column. Returns
+ * false if it isn't a number.
+ */
+bool DataValidator::bound(const Bound &bound, int row, int column, double *number) const
+{
+    if (bound.constant) {
+        *number = bound.number;
+        return true;
+    }
+    if (!bound.formula.isValid())
+        return false;
+    const FormulaValue value = m_engine->evaluateRangeFormula(bound.formula, row, column);
+    if (value.type != FormulaValue::Number)
+        return false;
+    *number = value.number;
+    return true;
+}
+
+bool DataValidator::isValid(const Rule &rule, int row, int column, const FormulaValue &value) const
+{
+    if (rule.acceptsAll)
+        return true;
+    if (isBlank(value))
+        return rule.allowBlank;
+
+    switch (rule.type) {
+    case DataValidation::List: {
+        if (value.isError())
+            return false;
+        if (rule.members.contains(FormulaEngine::valueKey(value)))
+            return true;
+        //Numbers typed as text match the numbers of the list
+        if (value.type == FormulaValue::String) {
+            bool ok;
+            const double number = parseXsdDouble(value.text.trimmed(), &ok);
+            return ok && rule.members.contains(FormulaEngine::valueKey(FormulaValue::fromNumber(number)));
+        }
+        return false;
+    }
+    case DataValidation::Custom: {
+        const FormulaValue result = m_engine->evaluateRangeFormula(rule.first.formula, row, column);
+        return (result.type == FormulaValue::Boolean || result.type == FormulaValue::Number) && result.number != 0;
+    }
+    case DataValidation::TextLength:
+    case DataValidation::Whole:
+    case DataValidation::Decimal:
+    case DataValidation::Date:
+    case DataValidation::Time: {
+        double number;
+        if (rule.type == DataValidation::TextLength) {
+            if (value.isError())
+                return false;
+            number = FormulaEngine::textOf(value).size();
+        } else {
+            if (value.type != FormulaValue::Number)
+                return false;
+            number = value.number;
+            if (rule.type == DataValidation::Whole && number != std::floor(number))
+                return false;
+        }
+
+        double first = 0;
+        double second = 0;
+        const bool needsSecond = rule.op == DataValidation::Between || rule.op == DataValidation::NotBetween;
+        //Bounds which can't be worked out don't reject anything
+        if (!bound(rule.first, row, column, &first))
+            return true;
+        if (needsSecond && !bound(rule.second, row, column, &second))
+            return true;
+        return compare(rule.op, number, first, second);
+    }
+    default:
+        return true;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
@@ -27,6 +27,7 @@
 #include "xlsxdocument_p.h"
 #include "xlsxworkbook.h"
 #include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
 #include "xlsxcontenttypes_p.h"
 #include "xlsxrelationships_p.h"
 #include "xlsxstyles_p.h"
@@ -208,6 +209,9 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
 		sheet->loadFromXmlData(zipReader.fileData(sheet->filePath()));
 	}
 
+	//the values of the formulas were calculated by the application which saved them
+	workbook->d_func()->formulaEngine->cachedValuesLoaded();
+
 	//load external links
 	for (int i=0; i<workbook->d_func()->externalLinks.count(); ++i) {
 		SimpleOOXmlFile *link = workbook->d_func()->externalLinks[i].data();
@@ -260,6 +264,31 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
 	DocPropsApp docPropsApp(DocPropsApp::F_NewFromScratch);
 	DocPropsCore docPropsCore(DocPropsCore::F_NewFromScratch);
 
+	// store the values of the formulas changed since the last calculation,
+	// and list the formula cells in the order they are calculated.
+	// Without calculation, no calc chain is written, and the application
+	// opening the document builds its own.
+	CalcChain *calcChain = workbook->d_func()->calcChain.data();
+	if (workbook->isFormulaCalculationEnabled()) {
+		workbook->recalculate();
+		workbook->d_func()->formulaEngine->buildCalcChain(calcChain);
+	} else {
+		calcChain->clear();
+	}
+
+	// drop the shared strings which are no longer used by any cell,
+	// this must be done before the worksheets are saved.
+	SharedStrings *sst = workbook->sharedStrings();
+	if (!sst->isEmpty()) {
+		QVector<int> refCounts(sst->uniqueCount(), 0);
+		for (int i = 0; i < workbook->sheetCount(); ++i) {
+			AbstractSheet *sheet = workbook->sheet(i);
+			if (sheet->sheetType() == AbstractSheet::ST_WorkSheet)
+				static_cast<Worksheet *>(sheet)->d_func()->markSharedStrings(refCounts);
+		}
+		sst->compact(refCounts);
+	}
+
 	// save worksheet xml files
 	QList<QSharedPointer<AbstractSheet> > worksheets = workbook->getSheetsByTypes(AbstractSheet::ST_WorkSheet);
 	if (!worksheets.isEmpty())
@@ -338,9 +367,11 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
 		zipWriter.addFile(QStringLiteral("xl/sharedStrings.xml"), workbook->sharedStrings()->saveToXmlData());
 	}
 
-    // save calc chain [dev16]
-    contentTypes->addCalcChain();
-    zipWriter.addFile(QStringLiteral("xl/calcChain.xml"), workbook->styles()->saveToXmlData());
+	// save calc chain xml file
+	if (!calcChain->isEmpty()) {
+		contentTypes->addCalcChain();
+		zipWriter.addFile(QStringLiteral("xl/calcChain.xml"), calcChain->saveToXmlData());
+	}
 
 	// save styles xml file
 	contentTypes->addStyles();
@@ -504,6 +535,19 @@ bool Document::insertImage(int row, int column, const QImage &image)
 	return false;
 }
 
+/*!
+ * Insert an image encoded as \a data, of the given \a mimeType, to
+ * current active worksheet at the position \a row, \a column.
+ * The data is stored as it is.
+ * Returns ture if success.
+ */
+bool Document::insertImage(int row, int column, const QByteArray &data, const QString &mimeType)
+{
+	if (Worksheet *sheet = currentWorksheet())
+		return sheet->insertImage(row, column, data, mimeType);
+	return false;
+}
+
 /*!
  * Creates an chart with the given \a size and insert it to the current
  * active worksheet at the position \a row, \a col.
@@ -89,7 +89,16 @@ void DrawingAnchor::setObjectPicture(const QImage &img)
     buffer.open(QIODevice::WriteOnly);
     img.save(&buffer, "PNG");
 
-    m_pictureFile = QSharedPointer<MediaFile>(new MediaFile(ba, QStringLiteral("png"), QStringLiteral("image/png")));
+    setObjectPicture(ba, QStringLiteral("png"), QStringLiteral("image/png"));
+}
+
+/*
+ * Uses the encoded image \a data as it is, stored in a media file with
+ * the given \a suffix and \a mimeType.
+ */
+void DrawingAnchor::setObjectPicture(const QByteArray &data, const QString &suffix, const QString &mimeType)
+{
+    m_pictureFile = QSharedPointer<MediaFile>(new MediaFile(data, suffix, mimeType));
     m_drawing->workbook->addMediaFile(m_pictureFile);
 
     m_objectType = Picture;
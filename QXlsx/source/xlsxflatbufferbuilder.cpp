@@ -0,0 +1,151 @@
+// xlsxflatbufferbuilder.cpp
+
+#include "xlsxflatbufferbuilder_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*!
+ * \internal
+ * \class FlatBufferBuilder
+ */
+
+FlatBufferBuilder::FlatBufferBuilder()
+    : m_tableStart(0)
+{
+}
+
+void FlatBufferBuilder::clear()
+{
+    m_reversed.resize(0);
+    m_fields.clear();
+    m_tableStart = 0;
+}
+
+/*
+ * Pads the buffer so that an object of \a size bytes put in front of it
+ * starts at a multiple of \a alignment.
+ */
+void FlatBufferBuilder::align(int size, int alignment)
+{
+    while ((m_reversed.size() + size) % alignment)
+        m_reversed.append('\0');
+}
+
+/*
+ * Puts the \a size low bytes of \a value in front of the buffer, in
+ * little endian order.
+ */
+void FlatBufferBuilder::push(quint64 value, int size)
+{
+    align(size, size);
+    for (int i = size - 1; i >= 0; --i)
+        m_reversed.append(char(value >> (8 * i)));
+}
+
+/*
+ * Puts a reference to \a object in front of the buffer. The references
+ * are relative to where they are, and point to the end of the buffer.
+ */
+void FlatBufferBuilder::pushOffset(int object)
+{
+    align(4, 4);
+    push(quint32(size() + 4 - object), 4);
+}
+
+int FlatBufferBuilder::createString(const QByteArray &utf8)
+{
+    align(utf8.size() + 1, 4);
+    m_reversed.append('\0');
+    for (int i = utf8.size() - 1; i >= 0; --i)
+        m_reversed.append(utf8[i]);
+    push(quint32(utf8.size()), 4);
+    return size();
+}
+
+int FlatBufferBuilder::createOffsetVector(const QVector<int> &objects)
+{
+    align(4 * objects.size(), 4);
+    for (int i = objects.size() - 1; i >= 0; --i)
+        pushOffset(objects[i]);
+    push(quint32(objects.size()), 4);
+    return size();
+}
+
+/*
+ * Creates a vector of structs made of two longs, as the FieldNode and
+ * Buffer structs of Arrow are, from their fields in \a values.
+ */
+int FlatBufferBuilder::createStructVector(const QVector<qint64> &values)
+{
+    align(8 * values.size(), 8);
+    for (int i = values.size() - 1; i >= 0; --i)
+        push(quint64(values[i]), 8);
+    push(quint32(values.size() / 2), 4);
+    return size();
+}
+
+void FlatBufferBuilder::startTable()
+{
+    m_fields.clear();
+    m_tableStart = size();
+}
+
+void FlatBufferBuilder::addScalar(int slot, quint64 value, int size)
+{
+    push(value, size);
+    m_fields.append(qMakePair(slot, this->size()));
+}
+
+void FlatBufferBuilder::addOffset(int slot, int object)
+{
+    pushOffset(object);
+    m_fields.append(qMakePair(slot, size()));
+}
+
+/*
+ * Ends the current table and writes its vtable in front of it. Returns
+ * the table.
+ */
+int FlatBufferBuilder::endTable()
+{
+    push(0, 4); //offset of the vtable, set below
+    const int table = size();
+
+    int slots = 0;
+    for (int i = 0; i < m_fields.size(); ++i)
+        slots = qMax(slots, m_fields[i].first + 1);
+    QVector<quint16> offsets(slots, 0);
+    for (int i = 0; i < m_fields.size(); ++i)
+        offsets[m_fields[i].first] = quint16(table - m_fields[i].second);
+
+    for (int i = slots - 1; i >= 0; --i)
+        push(offsets[i], 2);
+    push(quint16(table - m_tableStart), 2);
+    push(quint16(4 + 2 * slots), 2);
+    const int vtable = size();
+
+    const qint32 vtableOffset = vtable - table;
+    for (int i = 0; i < 4; ++i)
+        m_reversed[table - 1 - i] = char(vtableOffset >> (8 * i));
+
+    m_fields.clear();
+    return table;
+}
+
+/*
+ * Puts the reference to the \a root table at the start of the buffer,
+ * and returns the buffer.
+ */
+QByteArray FlatBufferBuilder::finish(int root)
+{
+    align(4, 8);
+    pushOffset(root);
+
+    QByteArray buffer(m_reversed.size(), Qt::Uninitialized);
+    std::reverse_copy(m_reversed.constBegin(), m_reversed.constEnd(), buffer.begin());
+    return buffer;
+}
+
+QT_END_NAMESPACE_XLSX
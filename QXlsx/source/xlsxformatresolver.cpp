@@ -0,0 +1,70 @@
+// xlsxformatresolver.cpp
+
+#include "xlsxformatresolver_p.h"
+
+#include <limits>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*!
+ * \internal
+ * \class FormatResolver
+ */
+
+FormatResolver::FormatResolver(const IntervalMap<XlsxRowInfo> &rowsInfo, const IntervalMap<XlsxColumnInfo> &colsInfo)
+    : m_rowsInfo(rowsInfo), m_colsInfo(colsInfo)
+    , m_firstRow(1), m_lastRow(0), m_firstColumn(1), m_lastColumn(0)
+{
+}
+
+/*
+ * Returns the format of the cell at (\a row, \a column), which has its
+ * own \a cellFormat.
+ */
+Format FormatResolver::format(int row, int column, const Format &cellFormat)
+{
+    if (!cellFormat.isEmpty())
+        return cellFormat;
+
+    const Format &format = rowFormat(row);
+    if (!format.isEmpty())
+        return format;
+    return columnFormat(column);
+}
+
+const Format &FormatResolver::rowFormat(int row)
+{
+    if (row < m_firstRow || row > m_lastRow)
+        findRun(m_rowsInfo, row, &m_firstRow, &m_lastRow, &m_rowFormat);
+    return m_rowFormat;
+}
+
+const Format &FormatResolver::columnFormat(int column)
+{
+    if (column < m_firstColumn || column > m_lastColumn)
+        findRun(m_colsInfo, column, &m_firstColumn, &m_lastColumn, &m_columnFormat);
+    return m_columnFormat;
+}
+
+/*
+ * Finds the format of the row or column \a index in \a map, along with
+ * the rows or columns [\a first, \a last] which share it. Between two
+ * runs, that is the whole gap.
+ */
+template <typename T>
+void FormatResolver::findRun(const IntervalMap<T> &map, int index, int *first, int *last, Format *format)
+{
+    typename IntervalMap<T>::const_iterator it = map.lowerBound(index);
+    if (it != map.constEnd() && it->first <= index) {
+        *first = it->first;
+        *last = it->last;
+        *format = it->value.format;
+        return;
+    }
+
+    *last = it != map.constEnd() ? it->first - 1 : std::numeric_limits<int>::max();
+    *first = it != map.constBegin() ? (it - 1)->last + 1 : std::numeric_limits<int>::min();
+    *format = Format();
+}
+
+QT_END_NAMESPACE_XLSX
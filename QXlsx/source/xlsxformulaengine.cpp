@@ -0,0 +1,2270 @@
+// xlsxformulaengine.cpp
+
+#include "xlsxformulaengine_p.h"
+#include "xlsxformulaparser_p.h"
+#include "xlsxnumericcodec_p.h"
+#include "xlsxcellformula_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxworkbook_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxcell.h"
+#include "xlsxcell_p.h"
+#include "xlsxutility_p.h"
+#include "xlsxworkscheduler_p.h"
+#include "xlsxcalcchain_p.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QThread>
+#include <qnumeric.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+typedef QMap<int, QMap<int, QSharedPointer<Cell> > > CellTable;
+
+const int maxRow = 1048576;
+const int maxColumn = 16384;
+
+// Smaller levels are not worth waking the calculation threads for
+const int minParallelLevel = 256;
+
+// Smaller areas are walked cell by cell rather than through the
+// numeric columns
+const int minNumericAreaRows = 64;
+
+const char errorNull[] = "#NULL!";
+const char errorDivZero[] = "#DIV/0!";
+const char errorValue[] = "#VALUE!";
+const char errorRef[] = "#REF!";
+const char errorName[] = "#NAME?";
+const char errorNum[] = "#NUM!";
+const char errorNA[] = "#N/A";
+
+enum Function {
+    UnknownFunction = -1,
+    Abs, And, Average, Concatenate, Count, CountA, CountIf, Date, Day,
+    EDate, EOMonth, If, IfError, Index, Int, Len, Match, Max, Min,
+    Mod, Month, Not, Now, Or, Round, Sum, SumIf, Today, VLookup,
+    Weekday, Year
+};
+
+struct FunctionInfo
+{
+    const char *name;
+    Function function;
+    int minArgs;
+    int maxArgs;
+    bool isVolatile;
+};
+
+//Sorted by name
+const FunctionInfo functionTable[] = {
+    { "ABS", Abs, 1, 1, false },
+    { "AND", And, 1, 255, false },
+    { "AVERAGE", Average, 1, 255, false },
+    { "CONCATENATE", Concatenate, 1, 255, false },
+    { "COUNT", Count, 1, 255, false },
+    { "COUNTA", CountA, 1, 255, false },
+    { "COUNTIF", CountIf, 2, 2, false },
+    { "DATE", Date, 3, 3, false },
+    { "DAY", Day, 1, 1, false },
+    { "EDATE", EDate, 2, 2, false },
+    { "EOMONTH", EOMonth, 2, 2, false },
+    { "IF", If, 1, 3, false },
+    { "IFERROR", IfError, 2, 2, false },
+    { "INDEX", Index, 2, 3, false },
+    { "INT", Int, 1, 1, false },
+    { "LEN", Len, 1, 1, false },
+    { "MATCH", Match, 2, 3, false },
+    { "MAX", Max, 1, 255, false },
+    { "MIN", Min, 1, 255, false },
+    { "MOD", Mod, 2, 2, false },
+    { "MONTH", Month, 1, 1, false },
+    { "NOT", Not, 1, 1, false },
+    { "NOW", Now, 0, 0, true },
+    { "OR", Or, 1, 255, false },
+    { "ROUND", Round, 2, 2, false },
+    { "SUM", Sum, 1, 255, false },
+    { "SUMIF", SumIf, 2, 3, false },
+    { "TODAY", Today, 0, 0, true },
+    { "VLOOKUP", VLookup, 3, 4, false },
+    { "WEEKDAY", Weekday, 1, 2, false },
+    { "YEAR", Year, 1, 1, false }
+};
+
+const FunctionInfo *findFunction(const QString &name)
+{
+    QString key = name.toUpper();
+    if (key.startsWith(QLatin1String("_XLFN.")))
+        key = key.mid(6);
+    const QByteArray latin1 = key.toLatin1();
+
+    int first = 0;
+    int last = int(sizeof(functionTable) / sizeof(functionTable[0])) - 1;
+    while (first <= last) {
+        const int middle = (first + last) / 2;
+        const int c = qstrcmp(latin1.constData(), functionTable[middle].name);
+        if (c == 0)
+            return &functionTable[middle];
+        if (c < 0)
+            last = middle - 1;
+        else
+            first = middle + 1;
+    }
+    return 0;
+}
+
+inline const CellTable &cellTable(Worksheet *sheet)
+{
+    return FormulaEngine::cellTable(sheet);
+}
+
+inline const Cell *cellAt(Worksheet *sheet, int row, int column)
+{
+    const CellTable &table = cellTable(sheet);
+    CellTable::const_iterator it = table.constFind(row);
+    if (it == table.constEnd())
+        return 0;
+    QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constFind(column);
+    if (cell == it->constEnd())
+        return 0;
+    return cell->data();
+}
+
+/*
+ * Serial numbers of the dates. In the 1900 date system, the serial
+ * number 60 is the 29th February 1900 which Excel believes exists.
+ */
+double dateToSerial(const QDate &date, bool date1904)
+{
+    if (date1904)
+        return double(date.toJulianDay() - QDate(1904, 1, 1).toJulianDay());
+    qint64 days = date.toJulianDay() - QDate(1899, 12, 31).toJulianDay();
+    if (days >= 60)
+        ++days;
+    return double(days);
+}
+
+bool serialToDate(double serial, bool date1904, int *year, int *month, int *day)
+{
+    if (serial < 0 || serial > 2958465.0)
+        return false;
+    qint64 days = qint64(std::floor(serial));
+    if (!date1904) {
+        if (days == 60) {
+            *year = 1900;
+            *month = 2;
+            *day = 29;
+            return true;
+        }
+        if (days > 60)
+            --days;
+    }
+    QDate date = date1904 ? QDate(1904, 1, 1).addDays(days) : QDate(1899, 12, 31).addDays(days);
+    date.getDate(year, month, day);
+    return true;
+}
+
+QString numberToText(double number)
+{
+    if (number == std::floor(number) && std::fabs(number) < 1e15)
+        return QString::number(qint64(number));
+    QString text = QString::number(number, 'g', 15);
+    return text.toUpper();
+}
+
+/*
+ * Whether the formula of the \a cell is written to its worksheet, which
+ * drops the formulas of the string and date cells.
+ */
+bool isFormulaSaved(const Cell *cell)
+{
+    switch (cell->d_ptr->cellType) {
+    case Cell::SharedStringType:
+    case Cell::InlineStringType:
+    case Cell::DateType:
+        return false;
+    default:
+        return cell->d_ptr->formula.isValid();
+    }
+}
+
+/*
+ * Value of the cell, as seen by the formulas.
+ */
+FormulaValue cellValue(const Cell *cell, bool date1904)
+{
+    if (!cell)
+        return FormulaValue();
+
+    const QVariant &value = cell->d_ptr->value;
+    switch (cell->d_ptr->cellType) {
+    case Cell::BooleanType:
+        return FormulaValue::fromBoolean(value.toBool());
+    case Cell::ErrorType: {
+        FormulaValue error;
+        error.type = FormulaValue::Error;
+        error.text = value.toString();
+        return error;
+    }
+    case Cell::SharedStringType:
+    case Cell::InlineStringType:
+    case Cell::StringType:
+        return FormulaValue::fromString(value.toString());
+    default:
+        break;
+    }
+
+    switch (value.type()) {
+    case QVariant::Invalid:
+        return FormulaValue();
+    case QVariant::Double:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return FormulaValue::fromNumber(value.toDouble());
+    case QVariant::Bool:
+        return FormulaValue::fromBoolean(value.toBool());
+    case QVariant::DateTime:
+        return FormulaValue::fromNumber(datetimeToNumber(value.toDateTime(), date1904));
+    case QVariant::Date:
+        return FormulaValue::fromNumber(dateToSerial(value.toDate(), date1904));
+    case QVariant::Time:
+        return FormulaValue::fromNumber(timeToNumber(value.toTime()));
+    default:
+        break;
+    }
+
+    //Loaded values are kept as text
+    const QString text = value.toString();
+    if (text.isEmpty())
+        return FormulaValue();
+    bool ok;
+    double number = parseXsdDouble(text, &ok);
+    if (ok)
+        return FormulaValue::fromNumber(number);
+    if (cell->d_ptr->cellType == Cell::DateType)
+        return FormulaValue::fromNumber(datetimeToNumber(QDateTime::fromString(text, Qt::ISODate), date1904));
+    return FormulaValue::fromString(text);
+}
+
+/*
+ * Calls \a f(row, column, value) for the non-empty cells of the \a area.
+ */
+template <typename F>
+void forEachCell(const FormulaValue &area, bool date1904, F f)
+{
+    const CellTable &table = cellTable(area.sheet);
+    for (CellTable::const_iterator it = table.lowerBound(area.firstRow);
+         it != table.constEnd() && it.key() <= area.lastRow; ++it) {
+        const QMap<int, QSharedPointer<Cell> > &columns = it.value();
+        for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = columns.lowerBound(area.firstColumn);
+             cell != columns.constEnd() && cell.key() <= area.lastColumn; ++cell) {
+            FormulaValue value = cellValue(cell->data(), date1904);
+            if (value.type != FormulaValue::Blank)
+                f(it.key(), cell.key(), value);
+        }
+    }
+}
+
+/*
+ * The \a area clipped to the cells used by its sheet.
+ */
+FormulaValue usedArea(const FormulaValue &area)
+{
+    FormulaValue used = area;
+    const CellRange dimension = area.sheet->dimension();
+    if (!dimension.isValid()) {
+        used.lastRow = used.firstRow;
+        used.lastColumn = used.firstColumn;
+        return used;
+    }
+    used.lastRow = qMax(used.firstRow, qMin(used.lastRow, dimension.lastRow()));
+    used.lastColumn = qMax(used.firstColumn, qMin(used.lastColumn, dimension.lastColumn()));
+    return used;
+}
+
+int rowCount(const FormulaValue &value)
+{
+    if (value.type == FormulaValue::Area)
+        return value.lastRow - value.firstRow + 1;
+    if (value.type == FormulaValue::Array)
+        return value.elements.size() / value.columns;
+    return 1;
+}
+
+int columnCount(const FormulaValue &value)
+{
+    if (value.type == FormulaValue::Area)
+        return value.lastColumn - value.firstColumn + 1;
+    if (value.type == FormulaValue::Array)
+        return value.columns;
+    return 1;
+}
+
+FormulaValue elementAt(const FormulaValue &value, int row, int column, bool date1904)
+{
+    if (value.type == FormulaValue::Area)
+        return cellValue(cellAt(value.sheet, value.firstRow + row, value.firstColumn + column), date1904);
+    if (value.type == FormulaValue::Array)
+        return value.elements.at(row * value.columns + column);
+    return value;
+}
+
+/*
+ * Converts an area or an array to a single value. Like the formulas
+ * of Excel 2007, a single row or column is intersected with the row or
+ * column of the formula cell.
+ */
+FormulaValue scalar(const FormulaValue &value, int row, int column, bool date1904)
+{
+    if (value.type == FormulaValue::Array)
+        return value.elements.isEmpty() ? FormulaValue::fromError(errorValue) : value.elements.first();
+    if (value.type != FormulaValue::Area)
+        return value;
+
+    if (value.firstRow == value.lastRow && value.firstColumn == value.lastColumn)
+        return cellValue(cellAt(value.sheet, value.firstRow, value.firstColumn), date1904);
+    if (value.firstColumn == value.lastColumn && row >= value.firstRow && row <= value.lastRow)
+        return cellValue(cellAt(value.sheet, row, value.firstColumn), date1904);
+    if (value.firstRow == value.lastRow && column >= value.firstColumn && column <= value.lastColumn)
+        return cellValue(cellAt(value.sheet, value.firstRow, column), date1904);
+    return FormulaValue::fromError(errorValue);
+}
+
+bool toNumber(const FormulaValue &value, double *number, FormulaValue *error)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+        *number = value.number;
+        return true;
+    case FormulaValue::Boolean:
+        *number = value.number;
+        return true;
+    case FormulaValue::Blank:
+        *number = 0;
+        return true;
+    case FormulaValue::String: {
+        bool ok;
+        *number = parseXsdDouble(value.text.trimmed(), &ok);
+        if (ok)
+            return true;
+        *error = FormulaValue::fromError(errorValue);
+        return false;
+    }
+    case FormulaValue::Error:
+        *error = value;
+        return false;
+    default:
+        *error = FormulaValue::fromError(errorValue);
+        return false;
+    }
+}
+
+QString toText(const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+        return numberToText(value.number);
+    case FormulaValue::Boolean:
+        return value.number ? QStringLiteral("TRUE") : QStringLiteral("FALSE");
+    case FormulaValue::String:
+        return value.text;
+    default:
+        return QString();
+    }
+}
+
+bool toBoolean(const FormulaValue &value, bool *result, FormulaValue *error)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+    case FormulaValue::Boolean:
+        *result = value.number != 0;
+        return true;
+    case FormulaValue::Blank:
+        *result = false;
+        return true;
+    case FormulaValue::String:
+        if (value.text.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0) {
+            *result = true;
+            return true;
+        }
+        if (value.text.compare(QLatin1String("FALSE"), Qt::CaseInsensitive) == 0) {
+            *result = false;
+            return true;
+        }
+        *error = FormulaValue::fromError(errorValue);
+        return false;
+    case FormulaValue::Error:
+        *error = value;
+        return false;
+    default:
+        *error = FormulaValue::fromError(errorValue);
+        return false;
+    }
+}
+
+FormulaValue numberResult(double number)
+{
+    if (!qIsFinite(number))
+        return FormulaValue::fromError(errorNum);
+    return FormulaValue::fromNumber(number);
+}
+
+/*
+ * Compares as Excel sorts: numbers, then text, then logical values.
+ * Text is compared case-insensitively, blanks are 0, "" or FALSE.
+ */
+int compareValues(const FormulaValue &a, const FormulaValue &b)
+{
+    FormulaValue left = a;
+    FormulaValue right = b;
+    if (left.type == FormulaValue::Blank) {
+        if (right.type == FormulaValue::String)
+            left = FormulaValue::fromString(QString());
+        else if (right.type == FormulaValue::Boolean)
+            left = FormulaValue::fromBoolean(false);
+        else
+            left = FormulaValue::fromNumber(0);
+    }
+    if (right.type == FormulaValue::Blank) {
+        if (left.type == FormulaValue::String)
+            right = FormulaValue::fromString(QString());
+        else if (left.type == FormulaValue::Boolean)
+            right = FormulaValue::fromBoolean(false);
+        else
+            right = FormulaValue::fromNumber(0);
+    }
+
+    static const int rank[] = { 0, 0, 1, 2, 3, 3, 3 };
+    if (left.type != right.type)
+        return rank[left.type] < rank[right.type] ? -1 : 1;
+    if (left.type == FormulaValue::String)
+        return left.text.compare(right.text, Qt::CaseInsensitive);
+    if (left.number < right.number)
+        return -1;
+    return left.number > right.number ? 1 : 0;
+}
+
+/*
+ * Condition of the SUMIF and COUNTIF functions, and of the lookups
+ * with wildcards, such as ">=10", "<>", "app*" or 42.
+ */
+class Criteria
+{
+public:
+    enum Comparison { Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual };
+
+    explicit Criteria(const FormulaValue &criteria)
+        : m_comparison(Equal), m_wildcard(false)
+    {
+        if (criteria.type != FormulaValue::String) {
+            m_value = criteria;
+            return;
+        }
+
+        QString text = criteria.text;
+        static const struct { const char *prefix; Comparison comparison; } prefixes[] = {
+            { "<=", LessEqual }, { ">=", GreaterEqual }, { "<>", NotEqual },
+            { "<", Less }, { ">", Greater }, { "=", Equal }
+        };
+        for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+            if (text.startsWith(QLatin1String(prefixes[i].prefix))) {
+                m_comparison = prefixes[i].comparison;
+                text = text.mid(int(qstrlen(prefixes[i].prefix)));
+                break;
+            }
+        }
+
+        bool ok;
+        double number = parseXsdDouble(text.trimmed(), &ok);
+        if (text.isEmpty()) {
+            m_value = FormulaValue();
+        } else if (ok) {
+            m_value = FormulaValue::fromNumber(number);
+        } else if (text.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0) {
+            m_value = FormulaValue::fromBoolean(true);
+        } else if (text.compare(QLatin1String("FALSE"), Qt::CaseInsensitive) == 0) {
+            m_value = FormulaValue::fromBoolean(false);
+        } else {
+            m_value = FormulaValue::fromString(text);
+            if ((m_comparison == Equal || m_comparison == NotEqual) && hasWildcards(text)) {
+                m_wildcard = true;
+                m_pattern = wildcardExpression(text);
+            }
+        }
+    }
+
+    static bool hasWildcards(const QString &text)
+    {
+        return text.contains(QLatin1Char('*')) || text.contains(QLatin1Char('?')) || text.contains(QLatin1Char('~'));
+    }
+
+    bool matches(const FormulaValue &value) const
+    {
+        if (m_comparison == Equal)
+            return isEqual(value);
+        if (m_comparison == NotEqual)
+            return !isEqual(value);
+
+        if (value.type != m_value.type || value.type == FormulaValue::Blank)
+            return false;
+        const int c = compareValues(value, m_value);
+        switch (m_comparison) {
+        case Less: return c < 0;
+        case LessEqual: return c <= 0;
+        case Greater: return c > 0;
+        default: return c >= 0;
+        }
+    }
+
+private:
+    bool isEqual(const FormulaValue &value) const
+    {
+        if (m_value.type == FormulaValue::Blank)
+            return value.type == FormulaValue::Blank || (value.type == FormulaValue::String && value.text.isEmpty());
+        if (value.type != m_value.type)
+            return false;
+        if (m_wildcard)
+            return m_pattern.match(value.text).hasMatch();
+        return compareValues(value, m_value) == 0;
+    }
+
+    static QRegularExpression wildcardExpression(const QString &text)
+    {
+        QString pattern = QStringLiteral("^");
+        for (int i = 0; i < text.size(); ++i) {
+            const QChar c = text.at(i);
+            if (c == QLatin1Char('~') && i + 1 < text.size())
+                pattern += QRegularExpression::escape(text.at(++i));
+            else if (c == QLatin1Char('*'))
+                pattern += QLatin1String(".*");
+            else if (c == QLatin1Char('?'))
+                pattern += QLatin1Char('.');
+            else
+                pattern += QRegularExpression::escape(c);
+        }
+        pattern += QLatin1Char('$');
+        return QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption
+                                  | QRegularExpression::DotMatchesEverythingOption);
+    }
+
+    Comparison m_comparison;
+    FormulaValue m_value;
+    bool m_wildcard;
+    QRegularExpression m_pattern;
+};
+
+/*
+ * SUM, AVERAGE, MIN, MAX, COUNT and COUNTA. The numbers in the areas
+ * and arrays are used, while the arguments given directly are
+ * converted to numbers.
+ */
+FormulaValue aggregate(const FormulaEngine *engine, Function function, const FormulaValue *args, int count, bool date1904)
+{
+    NumericAggregate numbers;
+    int values = 0;
+    FormulaValue error;
+    bool failed = false;
+
+    auto addValue = [&](int, int, const FormulaValue &value) {
+        ++values;
+        if (value.type == FormulaValue::Number) {
+            numbers.add(value.number);
+        } else if (value.type == FormulaValue::Error && !failed && function != Count && function != CountA) {
+            error = value;
+            failed = true;
+        }
+    };
+
+    for (int i = 0; i < count; ++i) {
+        const FormulaValue &arg = args[i];
+        if (arg.type == FormulaValue::Area) {
+            //COUNTA also counts the text and the logical values
+            FormulaValue areaError;
+            if (function != CountA && rowCount(arg) >= minNumericAreaRows
+                    && engine->aggregateArea(arg, date1904, &numbers, &areaError)) {
+                if (areaError.isError() && !failed && function != Count) {
+                    error = areaError;
+                    failed = true;
+                }
+            } else {
+                forEachCell(arg, date1904, addValue);
+            }
+        } else if (arg.type == FormulaValue::Array) {
+            for (int j = 0; j < arg.elements.size(); ++j) {
+                if (arg.elements[j].type != FormulaValue::Blank)
+                    addValue(0, 0, arg.elements[j]);
+            }
+        } else if (arg.type == FormulaValue::Blank) {
+            //omitted argument
+            if (function == Sum || function == Average || function == Count)
+                numbers.add(0);
+        } else {
+            ++values;
+            double number;
+            FormulaValue argError;
+            if (toNumber(arg, &number, &argError))
+                numbers.add(number);
+            else if (!failed && function != Count && function != CountA) {
+                error = argError;
+                failed = true;
+            }
+        }
+    }
+
+    if (failed)
+        return error;
+
+    switch (function) {
+    case Sum:
+        return numberResult(numbers.sum);
+    case Average:
+        if (!numbers.count)
+            return FormulaValue::fromError(errorDivZero);
+        return numberResult(numbers.sum / numbers.count);
+    case Min:
+        return FormulaValue::fromNumber(numbers.count ? numbers.minimum : 0);
+    case Max:
+        return FormulaValue::fromNumber(numbers.count ? numbers.maximum : 0);
+    case Count:
+        return FormulaValue::fromNumber(double(numbers.count));
+    default:
+        return FormulaValue::fromNumber(values);
+    }
+}
+
+/*
+ * SUMIF and COUNTIF
+ */
+FormulaValue conditionalAggregate(Function function, const FormulaValue *args, int count, bool date1904)
+{
+    const FormulaValue &range = args[0];
+    if (range.type != FormulaValue::Area)
+        return FormulaValue::fromError(errorValue);
+    if (args[1].isError())
+        return args[1];
+
+    const Criteria criteria(args[1]);
+    FormulaValue sumRange = range;
+    if (function == SumIf && count > 2 && args[2].type != FormulaValue::Blank) {
+        if (args[2].type != FormulaValue::Area)
+            return FormulaValue::fromError(errorValue);
+        //Same size as the range, from the top left cell of the sum range
+        sumRange = args[2];
+        sumRange.lastRow = sumRange.firstRow + range.lastRow - range.firstRow;
+        sumRange.lastColumn = sumRange.firstColumn + range.lastColumn - range.firstColumn;
+    }
+
+    double sum = 0;
+    double matched = 0;
+    auto addMatch = [&](int row, int column) {
+        ++matched;
+        if (function == SumIf) {
+            const FormulaValue value = cellValue(cellAt(sumRange.sheet, sumRange.firstRow + row - range.firstRow,
+                                                        sumRange.firstColumn + column - range.firstColumn), date1904);
+            if (value.type == FormulaValue::Number)
+                sum += value.number;
+        }
+    };
+
+    if (criteria.matches(FormulaValue())) {
+        //Blank cells match as well, so every cell is checked
+        const FormulaValue used = usedArea(range);
+        for (int row = used.firstRow; row <= used.lastRow; ++row) {
+            for (int column = used.firstColumn; column <= used.lastColumn; ++column) {
+                if (criteria.matches(cellValue(cellAt(range.sheet, row, column), date1904)))
+                    addMatch(row, column);
+            }
+        }
+        if (function == CountIf) {
+            //and the ones outside the used area
+            matched += double(rowCount(range)) * columnCount(range) - double(rowCount(used)) * columnCount(used);
+        }
+    } else {
+        forEachCell(range, date1904, [&](int row, int column, const FormulaValue &value) {
+            if (criteria.matches(value))
+                addMatch(row, column);
+        });
+    }
+
+    return numberResult(function == SumIf ? sum : matched);
+}
+
+/*
+ * Returns the position of \a value in the single row or column
+ * \a vector, or -1. Like MATCH, \a type 1 finds the largest value
+ * less than or equal to \a value in an ascending vector, -1 the
+ * smallest value greater than or equal to it in a descending one,
+ * and 0 the first equal value.
+ */
+int lookup(const FormulaValue &value, const FormulaValue &vector, bool byRow, int type, bool date1904)
+{
+    const int size = byRow ? columnCount(vector) : rowCount(vector);
+    auto at = [&](int i) {
+        return byRow ? elementAt(vector, 0, i, date1904) : elementAt(vector, i, 0, date1904);
+    };
+
+    if (type == 0) {
+        if (value.type == FormulaValue::String && Criteria::hasWildcards(value.text)) {
+            const Criteria criteria(value);
+            for (int i = 0; i < size; ++i) {
+                if (criteria.matches(at(i)))
+                    return i;
+            }
+            return -1;
+        }
+        if (vector.type == FormulaValue::Area) {
+            //Only the non-empty cells can match
+            int found = -1;
+            FormulaValue line = vector;
+            if (byRow)
+                line.lastRow = line.firstRow;
+            else
+                line.lastColumn = line.firstColumn;
+            forEachCell(line, date1904, [&](int row, int column, const FormulaValue &element) {
+                if (found == -1 && element.type == value.type && compareValues(element, value) == 0)
+                    found = byRow ? column - vector.firstColumn : row - vector.firstRow;
+            });
+            return found;
+        }
+        for (int i = 0; i < size; ++i) {
+            const FormulaValue element = at(i);
+            if (element.type == value.type && compareValues(element, value) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    if (type < 0) {
+        int found = -1;
+        for (int i = 0; i < size; ++i) {
+            const FormulaValue element = at(i);
+            if (element.type == FormulaValue::Blank)
+                continue;
+            if (compareValues(element, value) < 0)
+                break;
+            found = i;
+        }
+        return found;
+    }
+
+    //Binary search of the ascending vector
+    int first = 0;
+    int last = size - 1;
+    int found = -1;
+    while (first <= last) {
+        const int middle = first + (last - first) / 2;
+        const FormulaValue element = at(middle);
+        if (element.type != FormulaValue::Blank && compareValues(element, value) <= 0) {
+            found = middle;
+            first = middle + 1;
+        } else {
+            last = middle - 1;
+        }
+    }
+    return found;
+}
+
+} //namespace
+
+FormulaValue FormulaValue::fromNumber(double number)
+{
+    FormulaValue value;
+    value.type = Number;
+    value.number = number;
+    return value;
+}
+
+FormulaValue FormulaValue::fromString(const QString &text)
+{
+    FormulaValue value;
+    value.type = String;
+    value.text = text;
+    return value;
+}
+
+FormulaValue FormulaValue::fromBoolean(bool boolean)
+{
+    FormulaValue value;
+    value.type = Boolean;
+    value.number = boolean ? 1 : 0;
+    return value;
+}
+
+FormulaValue FormulaValue::fromError(const char *error)
+{
+    FormulaValue value;
+    value.type = Error;
+    value.text = QString::fromLatin1(error);
+    return value;
+}
+
+FormulaValue FormulaValue::fromArea(Worksheet *sheet, int firstRow, int firstColumn, int lastRow, int lastColumn)
+{
+    FormulaValue value;
+    value.type = Area;
+    value.sheet = sheet;
+    value.firstRow = firstRow;
+    value.firstColumn = firstColumn;
+    value.lastRow = lastRow;
+    value.lastColumn = lastColumn;
+    return value;
+}
+
+uint qHash(const FormulaEngine::CellKey &key, uint seed)
+{
+    return uint(quintptr(key.sheet) >> 4) ^ (uint(key.row) * 16411u + uint(key.column)) ^ seed;
+}
+
+/*!
+ * \internal
+ * \class FormulaEngine
+ */
+
+FormulaEngine::FormulaEngine(Workbook *workbook)
+    : m_workbook(workbook), m_built(false), m_allDirty(true), m_evaluatingConcurrently(false)
+{
+}
+
+FormulaEngine::~FormulaEngine()
+{
+}
+
+const CellTable &FormulaEngine::cellTable(Worksheet *sheet)
+{
+    return sheet->d_func()->cellTable;
+}
+
+/*
+ * Value of the \a cell, as seen by the formulas.
+ */
+FormulaValue FormulaEngine::valueOf(const Cell *cell, bool date1904)
+{
+    return cellValue(cell, date1904);
+}
+
+/*
+ * The \a value as text, as the text functions see it.
+ */
+QString FormulaEngine::textOf(const FormulaValue &value)
+{
+    return toText(value);
+}
+
+/*
+ * Key which equal values share, as the duplicate values rules and the
+ * lists of data validations compare them: text case-insensitively.
+ * Blanks and areas have an empty key.
+ */
+QString FormulaEngine::valueKey(const FormulaValue &value)
+{
+    switch (value.type) {
+    case FormulaValue::Number:
+        return QLatin1Char('n') + QString::number(value.number, 'g', 17);
+    case FormulaValue::String:
+        return QLatin1Char('s') + value.text.toCaseFolded();
+    case FormulaValue::Boolean:
+        return value.number ? QStringLiteral("bTRUE") : QStringLiteral("bFALSE");
+    case FormulaValue::Error:
+        return QLatin1Char('e') + value.text;
+    default:
+        return QString();
+    }
+}
+
+/*
+ * Compares \a a and \a b as Excel sorts them: numbers, then text, then
+ * logical values.
+ */
+int FormulaEngine::compare(const FormulaValue &a, const FormulaValue &b)
+{
+    return compareValues(a, b);
+}
+
+/*
+ * The cell at \a row and \a column of \a sheet has been written.
+ */
+void FormulaEngine::cellChanged(Worksheet *sheet, int row, int column)
+{
+    dropNumericColumn(sheet, column);
+
+    const CellKey key(sheet, row, column);
+    if (!m_built) {
+        //Until the graph is built, everything is calculated anyway
+        if (!m_allDirty)
+            m_pending.append(key);
+        return;
+    }
+
+    updateNode(key);
+    markDependentsDirty(key);
+}
+
+/*
+ * The cells have been loaded with the values calculated by the
+ * application which saved the document, so only the formulas which
+ * depend on cells changed from now on need to be calculated.
+ */
+void FormulaEngine::cachedValuesLoaded()
+{
+    if (!m_built) {
+        m_allDirty = false;
+        m_pending.clear();
+    }
+}
+
+/*
+ * Drops the graph, so that all the formulas are calculated again.
+ * Used when a sheet is renamed or removed.
+ */
+void FormulaEngine::invalidate()
+{
+    m_built = false;
+    m_allDirty = true;
+    m_pending.clear();
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_nodeIndex.clear();
+    m_sheetNodes.clear();
+    m_cellDependents.clear();
+    m_areas.clear();
+    m_freeAreas.clear();
+    m_areaIndex.clear();
+    m_dirty.clear();
+    m_numericColumns.clear();
+}
+
+/*
+ * Evaluates the dirty formulas, and the volatile ones such as TODAY(),
+ * each of them after the formulas it depends on. Returns the number of
+ * formulas evaluated.
+ *
+ * The formulas are grouped by their depth in the graph of the dirty
+ * formulas. With more than one calculation thread, the large groups are
+ * shared out by a work stealing scheduler; each formula still sees the
+ * same values of its precedents, so the results don't depend on the
+ * number of threads.
+ *
+ * Formulas using functions not supported by the engine, and the ones
+ * which are part of a circular reference, keep their cached values.
+ */
+int FormulaEngine::recalculate()
+{
+    if (!m_built)
+        build();
+
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        const Node &node = m_nodes[i];
+        if (node.sheet && node.program->isVolatile && !node.dirty)
+            markDirty(i);
+    }
+
+    //Drop the nodes removed since they were marked, and the duplicates
+    QVector<char> dirty(m_nodes.size(), 0);
+    int count = 0;
+    for (int i = 0; i < m_dirty.size(); ++i) {
+        const int index = m_dirty[i];
+        if (!m_nodes[index].sheet || !m_nodes[index].dirty || dirty[index])
+            continue;
+        dirty[index] = 1;
+        m_dirty[count++] = index;
+    }
+    m_dirty.resize(count);
+    if (m_dirty.isEmpty())
+        return 0;
+
+    //The formulas of a level only depend on the ones of the previous
+    //levels, so they can be evaluated in any order, and concurrently.
+    const QVector<QVector<int> > levels = sortLevels(m_dirty, dirty);
+
+    int threads = m_workbook->calculationThreadCount();
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    QScopedPointer<WorkScheduler> scheduler;
+    const Node *nodes = m_nodes.constData();
+    const bool date1904 = m_workbook->isDate1904();
+
+    int evaluated = 0;
+    for (int l = 0; l < levels.size(); ++l) {
+        const QVector<int> &level = levels[l];
+        if (threads > 1 && level.size() >= minParallelLevel) {
+            if (!scheduler)
+                scheduler.reset(new WorkScheduler(threads));
+            prepareNumericColumns(level, date1904);
+            const int *indexes = level.constData();
+            m_evaluatingConcurrently = true;
+            scheduler->run(level.size(), [this, nodes, indexes](int i) {
+                evaluateNode(nodes[indexes[i]]);
+            });
+            m_evaluatingConcurrently = false;
+        } else {
+            for (int i = 0; i < level.size(); ++i)
+                evaluateNode(nodes[level[i]]);
+        }
+        evaluated += level.size();
+
+        //The numeric columns built so far may hold the old results
+        for (int i = 0; i < level.size(); ++i)
+            dropNumericColumn(nodes[level[i]].sheet, nodes[level[i]].column);
+    }
+
+    for (int i = 0; i < m_dirty.size(); ++i)
+        m_nodes[m_dirty[i]].dirty = false;
+    m_dirty.clear();
+    return evaluated;
+}
+
+/*
+ * Groups the formulas \a indexes by their depth in the graph formed by
+ * the formulas marked in \a members: the first level holds the ones
+ * which depend on none of the others, the next one the ones which only
+ * depend on the first level, and so on. The formulas which are part of
+ * a circular reference are left out.
+ */
+QVector<QVector<int> > FormulaEngine::sortLevels(const QVector<int> &indexes, const QVector<char> &members) const
+{
+    QVector<int> pendingPrecedents(m_nodes.size(), 0);
+    QVector<QVector<int> > dependents(m_nodes.size());
+    for (int i = 0; i < indexes.size(); ++i) {
+        const int index = indexes[i];
+        const Node &node = m_nodes[index];
+
+        for (int j = 0; j < node.cells.size(); ++j) {
+            const int precedent = m_nodeIndex.value(node.cells[j], -1);
+            if (precedent != -1 && members[precedent]) {
+                dependents[precedent].append(index);
+                ++pendingPrecedents[index];
+            }
+        }
+        for (int j = 0; j < node.areas.size(); ++j) {
+            const AreaKey &area = m_areas[node.areas[j]];
+            QHash<Worksheet *, QMap<int, QMap<int, int> > >::const_iterator sheetNodes = m_sheetNodes.constFind(area.sheet);
+            if (sheetNodes == m_sheetNodes.constEnd())
+                continue;
+            for (QMap<int, QMap<int, int> >::const_iterator it = sheetNodes->lowerBound(area.firstRow);
+                 it != sheetNodes->constEnd() && it.key() <= area.lastRow; ++it) {
+                for (QMap<int, int>::const_iterator it2 = it->lowerBound(area.firstColumn);
+                     it2 != it->constEnd() && it2.key() <= area.lastColumn; ++it2) {
+                    if (members[it2.value()]) {
+                        dependents[it2.value()].append(index);
+                        ++pendingPrecedents[index];
+                    }
+                }
+            }
+        }
+    }
+
+    QVector<QVector<int> > levels;
+    QVector<int> level;
+    for (int i = 0; i < indexes.size(); ++i) {
+        if (pendingPrecedents[indexes[i]] == 0)
+            level.append(indexes[i]);
+    }
+    while (!level.isEmpty()) {
+        QVector<int> next;
+        for (int i = 0; i < level.size(); ++i) {
+            const QVector<int> &nodeDependents = dependents[level[i]];
+            for (int j = 0; j < nodeDependents.size(); ++j) {
+                if (--pendingPrecedents[nodeDependents[j]] == 0)
+                    next.append(nodeDependents[j]);
+            }
+        }
+        levels.append(level);
+        level.swap(next);
+    }
+    return levels;
+}
+
+/*
+ * Fills the \a chain with the formula cells of the workbook, the ones
+ * known to the graph in the order they are calculated, followed by the
+ * array formulas and the circular references.
+ */
+void FormulaEngine::buildCalcChain(CalcChain *chain)
+{
+    chain->clear();
+    if (!m_built)
+        build();
+
+    QVector<int> indexes;
+    QVector<char> members(m_nodes.size(), 0);
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].sheet) {
+            indexes.append(i);
+            members[i] = 1;
+        }
+    }
+
+    QVector<char> listed(m_nodes.size(), 0);
+    const QVector<QVector<int> > levels = sortLevels(indexes, members);
+    for (int l = 0; l < levels.size(); ++l) {
+        const QVector<int> &level = levels[l];
+        bool newLevel = !chain->isEmpty();
+        for (int i = 0; i < level.size(); ++i) {
+            const Node &node = m_nodes[level[i]];
+            const Cell *cell = cellAt(node.sheet, node.row, node.column);
+            if (!cell || !isFormulaSaved(cell))
+                continue;
+            chain->addCell(node.sheet->sheetId(), node.row, node.column, newLevel);
+            listed[level[i]] = 1;
+            newLevel = false;
+        }
+    }
+
+    for (int i = 0; i < m_workbook->sheetCount(); ++i) {
+        AbstractSheet *abstractSheet = m_workbook->sheet(i);
+        if (abstractSheet->sheetType() != AbstractSheet::ST_WorkSheet)
+            continue;
+        Worksheet *sheet = static_cast<Worksheet *>(abstractSheet);
+
+        const CellTable &table = cellTable(sheet);
+        for (CellTable::const_iterator it = table.constBegin(); it != table.constEnd(); ++it) {
+            for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constBegin(); cell != it->constEnd(); ++cell) {
+                const CellFormula &formula = cell.value()->d_ptr->formula;
+                if (!isFormulaSaved(cell->data()) || formula.formulaType() == CellFormula::DataTableType)
+                    continue;
+                const int index = m_nodeIndex.value(CellKey(sheet, it.key(), cell.key()), -1);
+                if (index != -1 && listed[index])
+                    continue;
+                chain->addCell(sheet->sheetId(), it.key(), cell.key(), false,
+                               formula.formulaType() == CellFormula::ArrayType);
+            }
+        }
+    }
+}
+
+void FormulaEngine::build()
+{
+    ProgramCache programs;
+    QVector<int> uncalculated;
+
+    for (int i = 0; i < m_workbook->sheetCount(); ++i) {
+        AbstractSheet *abstractSheet = m_workbook->sheet(i);
+        if (abstractSheet->sheetType() != AbstractSheet::ST_WorkSheet)
+            continue;
+        Worksheet *sheet = static_cast<Worksheet *>(abstractSheet);
+
+        const CellTable &table = cellTable(sheet);
+        for (CellTable::const_iterator it = table.constBegin(); it != table.constEnd(); ++it) {
+            for (QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constBegin(); cell != it->constEnd(); ++cell) {
+                const int index = addNode(CellKey(sheet, it.key(), cell.key()), cell->data(), &programs);
+                if (index == -1)
+                    continue;
+                if (m_allDirty) {
+                    m_nodes[index].dirty = true;
+                    m_dirty.append(index);
+                } else if (!cell.value()->d_ptr->value.isValid()) {
+                    uncalculated.append(index);
+                }
+            }
+        }
+    }
+
+    m_built = true;
+    m_allDirty = false;
+
+    for (int i = 0; i < uncalculated.size(); ++i)
+        markDirty(uncalculated[i]);
+    for (int i = 0; i < m_pending.size(); ++i)
+        markDependentsDirty(m_pending[i]);
+    m_pending.clear();
+}
+
+/*
+ * Brings the node of the cell \a key in line with its formula.
+ */
+void FormulaEngine::updateNode(const CellKey &key)
+{
+    const int index = m_nodeIndex.value(key, -1);
+    if (index != -1)
+        removeNode(index);
+
+    Cell *cell = const_cast<Cell *>(cellAt(key.sheet, key.row, key.column));
+    if (cell)
+        addNode(key, cell, 0);
+}
+
+/*
+ * Adds the node of the formula cell \a key, \a programs caches the
+ * compiled expressions while the graph is built. Returns the index of
+ * the node, or -1 if the cell has no formula to calculate.
+ */
+int FormulaEngine::addNode(const CellKey &key, Cell *cell, ProgramCache *programs)
+{
+    CellFormula formula;
+    int rowOffset;
+    int columnOffset;
+    if (!cellFormula(key, cell, &formula, &rowOffset, &columnOffset))
+        return -1;
+
+    int index;
+    if (!m_freeNodes.isEmpty()) {
+        index = m_freeNodes.takeLast();
+    } else {
+        index = m_nodes.size();
+        m_nodes.append(Node());
+    }
+
+    Node &node = m_nodes[index];
+    node.sheet = key.sheet;
+    node.row = key.row;
+    node.column = key.column;
+    node.formula = formula;
+    node.rowOffset = rowOffset;
+    node.columnOffset = columnOffset;
+    node.dirty = false;
+
+    const FormulaExpression &expression = formula.d->expression();
+    if (programs) {
+        QSharedPointer<const Program> &program = (*programs)[qMakePair<const void *, Worksheet *>(formula.d.data(), key.sheet)];
+        if (!program)
+            program = compile(expression, key.sheet);
+        node.program = program;
+    } else {
+        node.program = compile(expression, key.sheet);
+    }
+
+    m_nodeIndex.insert(key, index);
+    m_sheetNodes[key.sheet][key.row][key.column] = index;
+
+    //Register the precedents
+    const Program &program = *node.program;
+    const QVector<FormulaToken> &tokens = expression.tokens();
+    for (int i = 0; i < tokens.size(); ++i) {
+        FormulaValue area;
+        if (tokens[i].type == FormulaToken::Reference) {
+            bool valid;
+            const FormulaReference ref = offsetReference(tokens[i].ref, rowOffset, columnOffset, &valid);
+            if (!valid || !program.sheets[i])
+                continue;
+            area = FormulaValue::fromArea(program.sheets[i], ref.firstRow, ref.firstColumn, ref.lastRow, ref.lastColumn);
+        } else if (tokens[i].type == FormulaToken::Name) {
+            area = program.names.value(i);
+            if (area.type != FormulaValue::Area)
+                continue;
+        } else {
+            continue;
+        }
+
+        if (area.firstRow == area.lastRow && area.firstColumn == area.lastColumn) {
+            const CellKey precedent(area.sheet, area.firstRow, area.firstColumn);
+            node.cells.append(precedent);
+            m_cellDependents[precedent].append(index);
+        } else {
+            const AreaKey areaKey = { area.sheet, area.firstRow, area.firstColumn, area.lastRow, area.lastColumn, index };
+            int slot;
+            if (!m_freeAreas.isEmpty()) {
+                slot = m_freeAreas.takeLast();
+                m_areas[slot] = areaKey;
+            } else {
+                slot = m_areas.size();
+                m_areas.append(areaKey);
+            }
+            node.areas.append(slot);
+
+            QSharedPointer<CellRangeIndex> &areaIndex = m_areaIndex[area.sheet];
+            if (!areaIndex)
+                areaIndex = QSharedPointer<CellRangeIndex>(new CellRangeIndex);
+            areaIndex->insert(CellRange(area.firstRow, area.firstColumn, area.lastRow, area.lastColumn), slot);
+        }
+    }
+
+    return index;
+}
+
+void FormulaEngine::removeNode(int index)
+{
+    Node &node = m_nodes[index];
+    const CellKey key(node.sheet, node.row, node.column);
+
+    for (int i = 0; i < node.cells.size(); ++i) {
+        QHash<CellKey, QVector<int> >::iterator it = m_cellDependents.find(node.cells[i]);
+        if (it != m_cellDependents.end()) {
+            it->removeOne(index);
+            if (it->isEmpty())
+                m_cellDependents.erase(it);
+        }
+    }
+    for (int i = 0; i < node.areas.size(); ++i) {
+        AreaKey &area = m_areas[node.areas[i]];
+        QHash<Worksheet *, QSharedPointer<CellRangeIndex> >::iterator areaIndex = m_areaIndex.find(area.sheet);
+        if (areaIndex != m_areaIndex.end())
+            (*areaIndex)->remove(CellRange(area.firstRow, area.firstColumn, area.lastRow, area.lastColumn), node.areas[i]);
+        area.node = -1;
+        m_freeAreas.append(node.areas[i]);
+    }
+
+    //A dirty node stays in m_dirty, recalculate() skips it once reset
+
+    m_nodeIndex.remove(key);
+    QMap<int, QMap<int, int> > &sheetNodes = m_sheetNodes[key.sheet];
+    QMap<int, QMap<int, int> >::iterator row = sheetNodes.find(key.row);
+    if (row != sheetNodes.end()) {
+        row->remove(key.column);
+        if (row->isEmpty())
+            sheetNodes.erase(row);
+    }
+
+    node = Node();
+    m_freeNodes.append(index);
+}
+
+/*
+ * Marks the node \a index, and everything which depends on it, dirty.
+ */
+void FormulaEngine::markDirty(int index)
+{
+    QVector<int> stack;
+    stack.append(index);
+    while (!stack.isEmpty()) {
+        const int current = stack.takeLast();
+        Node &node = m_nodes[current];
+        if (!node.sheet || node.dirty)
+            continue;
+        node.dirty = true;
+        m_dirty.append(current);
+
+        const CellKey key(node.sheet, node.row, node.column);
+        QHash<CellKey, QVector<int> >::const_iterator it = m_cellDependents.constFind(key);
+        if (it != m_cellDependents.constEnd())
+            stack += *it;
+        appendAreaDependents(key, &stack);
+    }
+}
+
+/*
+ * Marks the formula of the cell \a key, or the formulas which refer
+ * to the cell if it has none, dirty.
+ */
+void FormulaEngine::markDependentsDirty(const CellKey &key)
+{
+    const int index = m_nodeIndex.value(key, -1);
+    if (index != -1) {
+        markDirty(index);
+        return;
+    }
+
+    QHash<CellKey, QVector<int> >::const_iterator it = m_cellDependents.constFind(key);
+    if (it != m_cellDependents.constEnd()) {
+        const QVector<int> dependents = *it;
+        for (int i = 0; i < dependents.size(); ++i)
+            markDirty(dependents[i]);
+    }
+    QVector<int> areaDependents;
+    appendAreaDependents(key, &areaDependents);
+    for (int i = 0; i < areaDependents.size(); ++i)
+        markDirty(areaDependents[i]);
+}
+
+/*
+ * Appends to \a nodes the formulas referring to an area which holds the
+ * cell \a key, found through the spatial index of the areas.
+ */
+void FormulaEngine::appendAreaDependents(const CellKey &key, QVector<int> *nodes) const
+{
+    QHash<Worksheet *, QSharedPointer<CellRangeIndex> >::const_iterator areaIndex = m_areaIndex.constFind(key.sheet);
+    if (areaIndex == m_areaIndex.constEnd())
+        return;
+
+    const QVector<int> slots = (*areaIndex)->find(key.row, key.column);
+    for (int i = 0; i < slots.size(); ++i) {
+        const int node = m_areas[slots[i]].node;
+        if (node != -1)
+            nodes->append(node);
+    }
+}
+
+/*
+ * Finds the formula to calculate for the cell \a key. The cells of a
+ * shared formula use the expression of the first cell, moved by
+ * \a rowOffset and \a columnOffset.
+ */
+bool FormulaEngine::cellFormula(const CellKey &key, Cell *cell, CellFormula *formula, int *rowOffset, int *columnOffset) const
+{
+    const CellFormula &cellFormula = cell->d_ptr->formula;
+    if (!cellFormula.isValid())
+        return false;
+
+    *rowOffset = 0;
+    *columnOffset = 0;
+    switch (cellFormula.formulaType()) {
+    case CellFormula::NormalType:
+        *formula = cellFormula;
+        return true;
+    case CellFormula::SharedType:
+        if (!cellFormula.formulaText().isEmpty()) {
+            *formula = cellFormula;
+            return true;
+        } else {
+            const CellFormula root = key.sheet->d_func()->sharedFormulaMap.value(cellFormula.sharedIndex());
+            if (!root.isValid() || !root.reference().isValid())
+                return false;
+            *formula = root;
+            *rowOffset = key.row - root.reference().firstRow();
+            *columnOffset = key.column - root.reference().firstColumn();
+            return true;
+        }
+    default:
+        //Array and data table formulas keep the values loaded
+        return false;
+    }
+}
+
+/*
+ * Resolves the functions, sheets and names used by the \a expression
+ * of a formula of \a sheet.
+ */
+QSharedPointer<const FormulaEngine::Program> FormulaEngine::compile(const FormulaExpression &expression, Worksheet *sheet) const
+{
+    QSharedPointer<Program> program(new Program);
+    if (!expression.isValid()) {
+        program->supported = false;
+        return program;
+    }
+
+    const QVector<FormulaToken> &tokens = expression.tokens();
+    program->functions.fill(short(UnknownFunction), tokens.size());
+    program->sheets.fill(0, tokens.size());
+
+    for (int i = 0; i < tokens.size() && program->supported; ++i) {
+        const FormulaToken &token = tokens[i];
+        switch (token.type) {
+        case FormulaToken::Reference:
+            if (token.ref.hasSheet()) {
+                const QString name = expression.sheetName(token);
+                //External workbooks and 3D references are not supported
+                if (name.startsWith(QLatin1Char('[')) || name.contains(QLatin1Char(':')))
+                    program->supported = false;
+                else
+                    program->sheets[i] = findSheet(name);
+            } else {
+                program->sheets[i] = sheet;
+            }
+            break;
+        case FormulaToken::Name: {
+            QString name = expression.tokenText(token);
+            Worksheet *scope = sheet;
+            if (token.ref.hasSheet()) {
+                name = name.mid(name.lastIndexOf(QLatin1Char('!')) + 1);
+                scope = findSheet(expression.sheetName(token));
+            }
+            FormulaValue value;
+            if (scope && resolveName(name, scope, &value))
+                program->names.insert(i, value);
+            else
+                program->supported = false;
+            break;
+        }
+        case FormulaToken::Function: {
+            const FunctionInfo *info = findFunction(expression.tokenText(token));
+            if (!info || token.argumentCount < info->minArgs || token.argumentCount > info->maxArgs) {
+                program->supported = false;
+            } else {
+                program->functions[i] = short(info->function);
+                if (info->isVolatile)
+                    program->isVolatile = true;
+                if (info->function == Sum || info->function == Average || info->function == Min
+                        || info->function == Max || info->function == Count)
+                    program->aggregatesAreas = true;
+            }
+            break;
+        }
+        case FormulaToken::StructuredReference:
+            program->supported = false;
+            break;
+        case FormulaToken::Operator:
+            if (token.op == FormulaToken::Union || token.op == FormulaToken::Spill)
+                program->supported = false;
+            break;
+        default:
+            break;
+        }
+    }
+    return program;
+}
+
+Worksheet *FormulaEngine::findSheet(const QString &name) const
+{
+    for (int i = 0; i < m_workbook->sheetCount(); ++i) {
+        AbstractSheet *sheet = m_workbook->sheet(i);
+        if (sheet->sheetType() == AbstractSheet::ST_WorkSheet
+                && sheet->sheetName().compare(name, Qt::CaseInsensitive) == 0)
+            return static_cast<Worksheet *>(sheet);
+    }
+    return 0;
+}
+
+/*
+ * Resolves the defined \a name as seen from \a sheet: the names local
+ * to the sheet hide the global ones. Only the names which refer to a
+ * cell, an area or a constant are supported.
+ */
+bool FormulaEngine::resolveName(const QString &name, Worksheet *sheet, FormulaValue *value) const
+{
+    const QList<XlsxDefineNameData> &names = m_workbook->d_func()->definedNamesList;
+    const XlsxDefineNameData *found = 0;
+    for (int i = 0; i < names.size(); ++i) {
+        if (names[i].name.compare(name, Qt::CaseInsensitive) != 0)
+            continue;
+        if (names[i].sheetId == sheet->sheetId()) {
+            found = &names[i];
+            break;
+        }
+        if (names[i].sheetId == -1)
+            found = &names[i];
+    }
+    if (!found)
+        return false;
+
+    const FormulaExpression expression = FormulaExpression::parse(found->formula);
+    if (!expression.isValid() || expression.tokens().size() != 1)
+        return false;
+
+    const FormulaToken &token = expression.tokens().first();
+    switch (token.type) {
+    case FormulaToken::Reference: {
+        if (!token.ref.hasSheet())
+            return false;
+        Worksheet *target = findSheet(expression.sheetName(token));
+        bool valid;
+        const FormulaReference ref = offsetReference(token.ref, 0, 0, &valid);
+        if (!target || !valid)
+            *value = FormulaValue::fromError(errorRef);
+        else
+            *value = FormulaValue::fromArea(target, ref.firstRow, ref.firstColumn, ref.lastRow, ref.lastColumn);
+        return true;
+    }
+    case FormulaToken::Number:
+        *value = FormulaValue::fromNumber(token.number);
+        return true;
+    case FormulaToken::Boolean:
+        *value = FormulaValue::fromBoolean(token.number != 0);
+        return true;
+    case FormulaToken::String:
+        *value = FormulaValue::fromString(expression.stringValue(token));
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Moves the relative parts of \a ref, and fills the rows or the columns
+ * of the whole column and whole row references.
+ */
+FormulaReference FormulaEngine::offsetReference(const FormulaReference &ref, int rowOffset, int columnOffset, bool *valid) const
+{
+    FormulaReference result = ref;
+    if (ref.flags & FormulaReference::WholeColumns) {
+        result.firstRow = 1;
+        result.lastRow = maxRow;
+    } else {
+        if (!(ref.flags & FormulaReference::FirstRowAbsolute))
+            result.firstRow += rowOffset;
+        if (!(ref.flags & FormulaReference::LastRowAbsolute))
+            result.lastRow += rowOffset;
+    }
+    if (ref.flags & FormulaReference::WholeRows) {
+        result.firstColumn = 1;
+        result.lastColumn = maxColumn;
+    } else {
+        if (!(ref.flags & FormulaReference::FirstColumnAbsolute))
+            result.firstColumn += columnOffset;
+        if (!(ref.flags & FormulaReference::LastColumnAbsolute))
+            result.lastColumn += columnOffset;
+    }
+
+    if (result.firstRow > result.lastRow)
+        qSwap(result.firstRow, result.lastRow);
+    if (result.firstColumn > result.lastColumn)
+        qSwap(result.firstColumn, result.lastColumn);
+
+    *valid = result.firstRow >= 1 && result.lastRow <= maxRow
+            && result.firstColumn >= 1 && result.lastColumn <= maxColumn;
+    return result;
+}
+
+/*
+ * Adds the numbers of the \a area to \a result. If \a error is given,
+ * it is set to the first error value of the area, row by row.
+ *
+ * Returns false, leaving \a result as is, when the numbers of a column
+ * are not at hand while the formulas are evaluated concurrently.
+ */
+bool FormulaEngine::aggregateArea(const FormulaValue &area, bool date1904, NumericAggregate *result, FormulaValue *error) const
+{
+    const FormulaValue used = usedArea(area);
+    QVector<QSharedPointer<const NumericColumn> > columns;
+    columns.reserve(used.lastColumn - used.firstColumn + 1);
+    for (int column = used.firstColumn; column <= used.lastColumn; ++column) {
+        QSharedPointer<const NumericColumn> numbers = numericColumn(used.sheet, column, date1904);
+        if (!numbers)
+            return false;
+        columns.append(numbers);
+    }
+
+    int errorRow = maxRow + 1;
+    for (int i = 0; i < columns.size(); ++i) {
+        const NumericColumn &numbers = *columns[i];
+        const int first = qMax(used.firstRow - numbers.firstRow, 0);
+        const int last = qMin(used.lastRow - numbers.firstRow + 1, numbers.values.size());
+        if (first < last)
+            aggregateNumbers(numbers.values.constData() + first, last - first, result);
+
+        if (!error)
+            continue;
+        QVector<int>::const_iterator it = std::lower_bound(numbers.errorRows.constBegin(),
+                                                           numbers.errorRows.constEnd(), used.firstRow);
+        if (it != numbers.errorRows.constEnd() && *it <= used.lastRow && *it < errorRow) {
+            errorRow = *it;
+            error->type = FormulaValue::Error;
+            error->text = numbers.errors[int(it - numbers.errorRows.constBegin())];
+        }
+    }
+    return true;
+}
+
+/*
+ * Compiles the formula \a text of \a sheet, without its leading '=',
+ * whose relative references are written for the cell at \a row and
+ * \a column.
+ */
+FormulaEngine::RangeFormula FormulaEngine::compileRangeFormula(const QString &text, Worksheet *sheet, int row, int column) const
+{
+    RangeFormula formula;
+    formula.formula = CellFormula(text);
+    formula.program = compile(formula.formula.d->expression(), sheet);
+    formula.sheet = sheet;
+    formula.row = row;
+    formula.column = column;
+    return formula;
+}
+
+/*
+ * Evaluates the \a formula for the cell at \a row and \a column of its
+ * sheet. If \a intersect is true, an area is intersected with the row or
+ * column of the cell, otherwise areas and arrays are returned as they are.
+ */
+FormulaValue FormulaEngine::evaluateRangeFormula(const RangeFormula &formula, int row, int column, bool intersect) const
+{
+    if (!formula.program || !formula.program->supported)
+        return FormulaValue::fromError(errorName);
+
+    Node node;
+    node.sheet = formula.sheet;
+    node.row = row;
+    node.column = column;
+    node.formula = formula.formula;
+    node.rowOffset = row - formula.row;
+    node.columnOffset = column - formula.column;
+    node.program = formula.program;
+
+    Context context;
+    context.sheet = formula.sheet;
+    context.row = row;
+    context.column = column;
+    context.date1904 = m_workbook->isDate1904();
+    const FormulaValue result = evaluate(node, context);
+    return intersect ? scalar(result, row, column, context.date1904) : result;
+}
+
+/*
+ * The numbers of the \a column of \a sheet, built if need be. Returns
+ * null if they are not built yet while the formulas are evaluated
+ * concurrently.
+ */
+QSharedPointer<const FormulaEngine::NumericColumn> FormulaEngine::numericColumn(Worksheet *sheet, int column, bool date1904) const
+{
+    QHash<Worksheet *, QHash<int, QSharedPointer<const NumericColumn> > >::const_iterator sheetColumns = m_numericColumns.constFind(sheet);
+    if (sheetColumns != m_numericColumns.constEnd()) {
+        QSharedPointer<const NumericColumn> numbers = sheetColumns->value(column);
+        if (numbers && numbers->date1904 == date1904)
+            return numbers;
+    }
+    if (m_evaluatingConcurrently)
+        return QSharedPointer<const NumericColumn>();
+
+    QSharedPointer<NumericColumn> numbers(new NumericColumn);
+    numbers->date1904 = date1904;
+    const double notNumber = std::numeric_limits<double>::quiet_NaN();
+    const CellTable &table = cellTable(sheet);
+    for (CellTable::const_iterator it = table.constBegin(); it != table.constEnd(); ++it) {
+        QMap<int, QSharedPointer<Cell> >::const_iterator cell = it->constFind(column);
+        if (cell == it->constEnd())
+            continue;
+        const FormulaValue value = cellValue(cell->data(), date1904);
+        if (value.type == FormulaValue::Number) {
+            if (numbers->values.isEmpty())
+                numbers->firstRow = it.key();
+            const int offset = it.key() - numbers->firstRow;
+            while (numbers->values.size() < offset)
+                numbers->values.append(notNumber);
+            numbers->values.append(value.number);
+        } else if (value.type == FormulaValue::Error) {
+            numbers->errorRows.append(it.key());
+            numbers->errors.append(value.text);
+        }
+    }
+
+    m_numericColumns[sheet].insert(column, numbers);
+    return numbers;
+}
+
+void FormulaEngine::dropNumericColumn(Worksheet *sheet, int column)
+{
+    if (m_numericColumns.isEmpty())
+        return;
+    QHash<Worksheet *, QHash<int, QSharedPointer<const NumericColumn> > >::iterator it = m_numericColumns.find(sheet);
+    if (it == m_numericColumns.end())
+        return;
+    it->remove(column);
+    if (it->isEmpty())
+        m_numericColumns.erase(it);
+}
+
+/*
+ * Builds the numeric columns of the large areas aggregated by the
+ * formulas of the \a level, before the level is shared out to the
+ * calculation threads.
+ */
+void FormulaEngine::prepareNumericColumns(const QVector<int> &level, bool date1904) const
+{
+    for (int i = 0; i < level.size(); ++i) {
+        const Node &node = m_nodes[level[i]];
+        if (!node.program->aggregatesAreas)
+            continue;
+        for (int j = 0; j < node.areas.size(); ++j) {
+            const AreaKey &key = m_areas[node.areas[j]];
+            if (key.lastRow - key.firstRow + 1 < minNumericAreaRows)
+                continue;
+            const FormulaValue used = usedArea(FormulaValue::fromArea(key.sheet, key.firstRow, key.firstColumn,
+                                                                      key.lastRow, key.lastColumn));
+            for (int column = used.firstColumn; column <= used.lastColumn; ++column)
+                numericColumn(used.sheet, column, date1904);
+        }
+    }
+}
+
+/*
+ * Evaluates the formula of \a node, and stores the result as the
+ * value of its cell.
+ */
+void FormulaEngine::evaluateNode(const Node &node) const
+{
+    if (!node.program->supported)
+        return;
+    Cell *cell = const_cast<Cell *>(cellAt(node.sheet, node.row, node.column));
+    if (!cell)
+        return;
+
+    Context context;
+    context.sheet = node.sheet;
+    context.row = node.row;
+    context.column = node.column;
+    context.date1904 = m_workbook->isDate1904();
+
+    const FormulaValue result = scalar(evaluate(node, context), node.row, node.column, context.date1904);
+    CellPrivate *d = cell->d_ptr;
+    switch (result.type) {
+    case FormulaValue::Number:
+        d->cellType = Cell::NumberType;
+        d->value = result.number;
+        break;
+    case FormulaValue::String:
+        d->cellType = Cell::StringType;
+        d->value = result.text;
+        break;
+    case FormulaValue::Boolean:
+        d->cellType = Cell::BooleanType;
+        d->value = result.number != 0;
+        break;
+    case FormulaValue::Error:
+        d->cellType = Cell::ErrorType;
+        d->value = result.text;
+        break;
+    default:
+        //A formula referring to an empty cell shows 0
+        d->cellType = Cell::NumberType;
+        d->value = 0.0;
+        break;
+    }
+}
+
+FormulaValue FormulaEngine::evaluate(const Node &node, const Context &context) const
+{
+    const FormulaExpression &expression = node.formula.d->expression();
+    const QVector<FormulaToken> &tokens = expression.tokens();
+    const Program &program = *node.program;
+
+    QVector<FormulaValue> stack;
+    stack.reserve(8);
+
+    for (int i = 0; i < tokens.size(); ++i) {
+        const FormulaToken &token = tokens[i];
+        switch (token.type) {
+        case FormulaToken::Number:
+            stack.append(FormulaValue::fromNumber(token.number));
+            break;
+        case FormulaToken::String:
+            stack.append(FormulaValue::fromString(expression.stringValue(token)));
+            break;
+        case FormulaToken::Boolean:
+            stack.append(FormulaValue::fromBoolean(token.number != 0));
+            break;
+        case FormulaToken::Error: {
+            FormulaValue error;
+            error.type = FormulaValue::Error;
+            error.text = expression.tokenText(token).toUpper();
+            stack.append(error);
+            break;
+        }
+        case FormulaToken::Reference: {
+            bool valid;
+            const FormulaReference ref = offsetReference(token.ref, node.rowOffset, node.columnOffset, &valid);
+            if (!valid || !program.sheets[i])
+                stack.append(FormulaValue::fromError(errorRef));
+            else
+                stack.append(FormulaValue::fromArea(program.sheets[i], ref.firstRow, ref.firstColumn, ref.lastRow, ref.lastColumn));
+            break;
+        }
+        case FormulaToken::Name:
+            stack.append(program.names.value(i, FormulaValue::fromError(errorName)));
+            break;
+        case FormulaToken::Missing:
+            stack.append(FormulaValue());
+            break;
+        case FormulaToken::Array: {
+            FormulaValue array;
+            array.type = FormulaValue::Array;
+            array.columns = qMax(token.columns, 1);
+            array.elements = stack.mid(stack.size() - token.argumentCount);
+            stack.resize(stack.size() - token.argumentCount);
+            stack.append(array);
+            break;
+        }
+        case FormulaToken::Function: {
+            const int count = token.argumentCount;
+            FormulaValue result = callFunction(program.functions[i], stack.constData() + stack.size() - count, count, context);
+            stack.resize(stack.size() - count);
+            stack.append(result);
+            break;
+        }
+        case FormulaToken::Operator: {
+            if (token.op == FormulaToken::Negate || token.op == FormulaToken::Plus
+                    || token.op == FormulaToken::Percent || token.op == FormulaToken::ImplicitIntersection) {
+                FormulaValue &operand = stack.last();
+                if (token.op == FormulaToken::ImplicitIntersection) {
+                    operand = scalar(operand, context.row, context.column, context.date1904);
+                    break;
+                }
+                const FormulaValue value = scalar(operand, context.row, context.column, context.date1904);
+                if (token.op == FormulaToken::Plus) {
+                    operand = value;
+                    break;
+                }
+                double number;
+                FormulaValue error;
+                if (!toNumber(value, &number, &error))
+                    operand = error;
+                else
+                    operand = FormulaValue::fromNumber(token.op == FormulaToken::Negate ? -number : number / 100);
+                break;
+            }
+
+            const FormulaValue right = stack.takeLast();
+            FormulaValue &left = stack.last();
+
+            if (token.op == FormulaToken::Range || token.op == FormulaToken::Intersection) {
+                if (left.isError())
+                    break;
+                if (right.isError()) {
+                    left = right;
+                    break;
+                }
+                if (left.type != FormulaValue::Area || right.type != FormulaValue::Area || left.sheet != right.sheet) {
+                    left = FormulaValue::fromError(errorValue);
+                    break;
+                }
+                if (token.op == FormulaToken::Range) {
+                    left = FormulaValue::fromArea(left.sheet, qMin(left.firstRow, right.firstRow), qMin(left.firstColumn, right.firstColumn),
+                                                  qMax(left.lastRow, right.lastRow), qMax(left.lastColumn, right.lastColumn));
+                } else {
+                    const int firstRow = qMax(left.firstRow, right.firstRow);
+                    const int firstColumn = qMax(left.firstColumn, right.firstColumn);
+                    const int lastRow = qMin(left.lastRow, right.lastRow);
+                    const int lastColumn = qMin(left.lastColumn, right.lastColumn);
+                    if (firstRow > lastRow || firstColumn > lastColumn)
+                        left = FormulaValue::fromError(errorNull);
+                    else
+                        left = FormulaValue::fromArea(left.sheet, firstRow, firstColumn, lastRow, lastColumn);
+                }
+                break;
+            }
+
+            const FormulaValue a = scalar(left, context.row, context.column, context.date1904);
+            const FormulaValue b = scalar(right, context.row, context.column, context.date1904);
+            if (a.isError()) {
+                left = a;
+                break;
+            }
+            if (b.isError()) {
+                left = b;
+                break;
+            }
+
+            switch (token.op) {
+            case FormulaToken::Concat:
+                left = FormulaValue::fromString(toText(a) + toText(b));
+                break;
+            case FormulaToken::Equal:
+                left = FormulaValue::fromBoolean(compareValues(a, b) == 0);
+                break;
+            case FormulaToken::NotEqual:
+                left = FormulaValue::fromBoolean(compareValues(a, b) != 0);
+                break;
+            case FormulaToken::Less:
+                left = FormulaValue::fromBoolean(compareValues(a, b) < 0);
+                break;
+            case FormulaToken::LessEqual:
+                left = FormulaValue::fromBoolean(compareValues(a, b) <= 0);
+                break;
+            case FormulaToken::Greater:
+                left = FormulaValue::fromBoolean(compareValues(a, b) > 0);
+                break;
+            case FormulaToken::GreaterEqual:
+                left = FormulaValue::fromBoolean(compareValues(a, b) >= 0);
+                break;
+            default: {
+                double x;
+                double y;
+                FormulaValue error;
+                if (!toNumber(a, &x, &error) || !toNumber(b, &y, &error)) {
+                    left = error;
+                    break;
+                }
+                switch (token.op) {
+                case FormulaToken::Add:
+                    left = numberResult(x + y);
+                    break;
+                case FormulaToken::Subtract:
+                    left = numberResult(x - y);
+                    break;
+                case FormulaToken::Multiply:
+                    left = numberResult(x * y);
+                    break;
+                case FormulaToken::Divide:
+                    left = y == 0 ? FormulaValue::fromError(errorDivZero) : numberResult(x / y);
+                    break;
+                case FormulaToken::Power:
+                    left = numberResult(std::pow(x, y));
+                    break;
+                default:
+                    left = FormulaValue::fromError(errorValue);
+                    break;
+                }
+                break;
+            }
+            }
+            break;
+        }
+        default:
+            return FormulaValue::fromError(errorValue);
+        }
+    }
+
+    return stack.isEmpty() ? FormulaValue() : stack.last();
+}
+
+FormulaValue FormulaEngine::callFunction(int function, const FormulaValue *args, int count, const Context &context) const
+{
+    const bool date1904 = context.date1904;
+    auto scalarArg = [&](int i) {
+        return scalar(args[i], context.row, context.column, date1904);
+    };
+
+    //Numeric arguments of the functions which take numbers only
+    double numbers[3] = { 0, 0, 0 };
+    switch (function) {
+    case Abs: case Int: case Round: case Mod: case Date: case Year: case Month: case Day:
+    case Weekday: case EDate: case EOMonth:
+        for (int i = 0; i < count && i < 3; ++i) {
+            FormulaValue error;
+            if (!toNumber(scalarArg(i), &numbers[i], &error))
+                return error;
+        }
+        break;
+    default:
+        break;
+    }
+
+    switch (function) {
+    case Sum:
+    case Average:
+    case Min:
+    case Max:
+    case Count:
+    case CountA:
+        return aggregate(this, Function(function), args, count, date1904);
+
+    case SumIf:
+    case CountIf:
+        return conditionalAggregate(Function(function), args, count, date1904);
+
+    case If: {
+        bool condition;
+        FormulaValue error;
+        if (!toBoolean(scalarArg(0), &condition, &error))
+            return error;
+        if (condition)
+            return count > 1 ? args[1] : FormulaValue::fromBoolean(true);
+        return count > 2 ? args[2] : FormulaValue::fromBoolean(false);
+    }
+
+    case IfError: {
+        const FormulaValue value = scalarArg(0);
+        return value.isError() ? args[1] : args[0];
+    }
+
+    case And:
+    case Or: {
+        bool result = function == And;
+        bool any = false;
+        for (int i = 0; i < count; ++i) {
+            QVector<FormulaValue> values;
+            if (args[i].type == FormulaValue::Area) {
+                forEachCell(args[i], date1904, [&](int, int, const FormulaValue &value) {
+                    if (value.type != FormulaValue::String)
+                        values.append(value);
+                });
+            } else if (args[i].type == FormulaValue::Array) {
+                values = args[i].elements;
+            } else {
+                values.append(args[i]);
+            }
+            for (int j = 0; j < values.size(); ++j) {
+                bool value;
+                FormulaValue error;
+                if (!toBoolean(values[j], &value, &error))
+                    return error;
+                any = true;
+                if (function == And)
+                    result = result && value;
+                else
+                    result = result || value;
+            }
+        }
+        if (!any)
+            return FormulaValue::fromError(errorValue);
+        return FormulaValue::fromBoolean(result);
+    }
+
+    case Not: {
+        bool value;
+        FormulaValue error;
+        if (!toBoolean(scalarArg(0), &value, &error))
+            return error;
+        return FormulaValue::fromBoolean(!value);
+    }
+
+    case Abs:
+        return FormulaValue::fromNumber(std::fabs(numbers[0]));
+
+    case Int:
+        return FormulaValue::fromNumber(std::floor(numbers[0]));
+
+    case Round: {
+        const double factor = std::pow(10.0, std::floor(numbers[1]));
+        const double scaled = numbers[0] * factor;
+        //Round half away from zero, tolerating the binary representation
+        const double rounded = scaled < 0 ? -std::floor(-scaled + 0.5 + 1e-9) : std::floor(scaled + 0.5 + 1e-9);
+        return numberResult(rounded / factor);
+    }
+
+    case Mod:
+        if (numbers[1] == 0)
+            return FormulaValue::fromError(errorDivZero);
+        return numberResult(numbers[0] - numbers[1] * std::floor(numbers[0] / numbers[1]));
+
+    case Concatenate: {
+        QString text;
+        for (int i = 0; i < count; ++i) {
+            const FormulaValue value = scalarArg(i);
+            if (value.isError())
+                return value;
+            text += toText(value);
+        }
+        return FormulaValue::fromString(text);
+    }
+
+    case Len: {
+        const FormulaValue value = scalarArg(0);
+        if (value.isError())
+            return value;
+        return FormulaValue::fromNumber(toText(value).size());
+    }
+
+    case VLookup: {
+        const FormulaValue value = scalarArg(0);
+        if (value.isError())
+            return value;
+        if (args[1].isError())
+            return args[1];
+        if (args[1].type != FormulaValue::Area && args[1].type != FormulaValue::Array)
+            return FormulaValue::fromError(errorValue);
+        double column;
+        FormulaValue error;
+        if (!toNumber(scalarArg(2), &column, &error))
+            return error;
+        bool approximate = true;
+        if (count > 3 && args[3].type != FormulaValue::Blank && !toBoolean(scalarArg(3), &approximate, &error))
+            return error;
+
+        const FormulaValue table = args[1].type == FormulaValue::Area ? usedArea(args[1]) : args[1];
+        if (column < 1)
+            return FormulaValue::fromError(errorValue);
+        if (int(column) > columnCount(args[1]))
+            return FormulaValue::fromError(errorRef);
+        const int row = lookup(value, table, false, approximate ? 1 : 0, date1904);
+        if (row == -1)
+            return FormulaValue::fromError(errorNA);
+        return elementAt(table, row, int(column) - 1, date1904);
+    }
+
+    case Match: {
+        const FormulaValue value = scalarArg(0);
+        if (value.isError())
+            return value;
+        if (args[1].isError())
+            return args[1];
+        if (args[1].type != FormulaValue::Area && args[1].type != FormulaValue::Array)
+            return FormulaValue::fromError(errorNA);
+        double type = 1;
+        FormulaValue error;
+        if (count > 2 && args[2].type != FormulaValue::Blank && !toNumber(scalarArg(2), &type, &error))
+            return error;
+
+        const bool byRow = rowCount(args[1]) == 1;
+        if (!byRow && columnCount(args[1]) != 1)
+            return FormulaValue::fromError(errorNA);
+        const FormulaValue vector = args[1].type == FormulaValue::Area ? usedArea(args[1]) : args[1];
+        const int position = lookup(value, vector, byRow, type > 0 ? 1 : (type < 0 ? -1 : 0), date1904);
+        if (position == -1)
+            return FormulaValue::fromError(errorNA);
+        return FormulaValue::fromNumber(position + 1);
+    }
+
+    case Index: {
+        const FormulaValue &array = args[0];
+        if (array.isError())
+            return array;
+        double row;
+        double column = 0;
+        FormulaValue error;
+        if (!toNumber(scalarArg(1), &row, &error))
+            return error;
+        if (count > 2 && !toNumber(scalarArg(2), &column, &error))
+            return error;
+        //INDEX(A1:E1, 3) picks the third column of a single row
+        if (count == 2 && rowCount(array) == 1 && columnCount(array) > 1)
+            qSwap(row, column);
+        if (row < 0 || column < 0 || int(row) > rowCount(array) || int(column) > columnCount(array))
+            return FormulaValue::fromError(errorRef);
+
+        const int r = int(row);
+        const int c = int(column);
+        if (array.type == FormulaValue::Area) {
+            FormulaValue result = array;
+            if (r > 0)
+                result.firstRow = result.lastRow = array.firstRow + r - 1;
+            if (c > 0)
+                result.firstColumn = result.lastColumn = array.firstColumn + c - 1;
+            return result;
+        }
+        if (r == 0 || c == 0) {
+            if (array.type != FormulaValue::Array)
+                return array;
+            return FormulaValue::fromError(errorValue);
+        }
+        return elementAt(array, r - 1, c - 1, date1904);
+    }
+
+    case Date: {
+        int year = int(std::floor(numbers[0]));
+        if (year >= 0 && year < 1900)
+            year += 1900;
+        if (year < 1900 || year > 9999)
+            return FormulaValue::fromError(errorNum);
+        const QDate date = QDate(year, 1, 1).addMonths(int(std::floor(numbers[1])) - 1)
+                .addDays(qint64(std::floor(numbers[2])) - 1);
+        const double serial = dateToSerial(date, date1904);
+        if (serial < 0)
+            return FormulaValue::fromError(errorNum);
+        return FormulaValue::fromNumber(serial);
+    }
+
+    case Year:
+    case Month:
+    case Day: {
+        int year, month, day;
+        if (!serialToDate(numbers[0], date1904, &year, &month, &day))
+            return FormulaValue::fromError(errorNum);
+        return FormulaValue::fromNumber(function == Year ? year : (function == Month ? month : day));
+    }
+
+    case Weekday: {
+        int year, month, day;
+        if (!serialToDate(numbers[0], date1904, &year, &month, &day))
+            return FormulaValue::fromError(errorNum);
+        //1 is Sunday, as in Excel which also believes the 29th February 1900 was a Wednesday
+        const int sunday = (qint64(std::floor(numbers[0])) + (date1904 ? 5 : 6)) % 7 + 1;
+        const int type = count > 1 ? int(numbers[1]) : 1;
+        switch (type) {
+        case 1: return FormulaValue::fromNumber(sunday);
+        case 2: return FormulaValue::fromNumber((sunday + 5) % 7 + 1);
+        case 3: return FormulaValue::fromNumber((sunday + 5) % 7);
+        default: return FormulaValue::fromError(errorNum);
+        }
+    }
+
+    case EDate:
+    case EOMonth: {
+        int year, month, day;
+        if (!serialToDate(numbers[0], date1904, &year, &month, &day))
+            return FormulaValue::fromError(errorNum);
+        QDate date = QDate(year, month, 1).addMonths(int(numbers[1]));
+        if (function == EDate)
+            date = date.addDays(qMin(day, date.daysInMonth()) - 1);
+        else
+            date = date.addDays(date.daysInMonth() - 1);
+        const double serial = dateToSerial(date, date1904);
+        if (!date.isValid() || serial < 0)
+            return FormulaValue::fromError(errorNum);
+        return FormulaValue::fromNumber(serial);
+    }
+
+    case Today:
+        return FormulaValue::fromNumber(dateToSerial(QDate::currentDate(), date1904));
+
+    case Now: {
+        const QDateTime now = QDateTime::currentDateTime();
+        return FormulaValue::fromNumber(dateToSerial(now.date(), date1904) + timeToNumber(now.time()));
+    }
+
+    default:
+        return FormulaValue::fromError(errorName);
+    }
+}
+
+QT_END_NAMESPACE_XLSX
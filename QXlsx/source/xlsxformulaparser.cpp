@@ -0,0 +1,1008 @@
+// xlsxformulaparser.cpp
+
+#include "xlsxformulaparser_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QVector>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Grammar of the formulas stored in the <f> element (ECMA-376 Part 1,
+ * 18.17), parsed with precedence climbing into reverse polish notation:
+ *
+ *   :           range
+ *   (space)     intersection
+ *   ,           union, outside of the function arguments
+ *   - + @       prefix
+ *   %           postfix
+ *   ^
+ *   * /
+ *   + -
+ *   &
+ *   = <> < <= > >=
+ *
+ * All the binary operators are left associative, so 2^3^2 is 64,
+ * and -2^2 is 4, as in Excel.
+ */
+
+namespace {
+
+const int maxRow = 1048576;
+const int maxColumn = 16384;
+
+enum Precedence {
+    ComparisonPrecedence = 1,
+    ConcatPrecedence,
+    AdditivePrecedence,
+    MultiplicativePrecedence,
+    PowerPrecedence,
+    PercentPrecedence,
+    PrefixPrecedence,
+    UnionPrecedence,
+    IntersectionPrecedence,
+    RangePrecedence,
+    SpillPrecedence
+};
+
+int precedence(FormulaToken::OperatorType op)
+{
+    switch (op) {
+    case FormulaToken::Equal:
+    case FormulaToken::NotEqual:
+    case FormulaToken::Less:
+    case FormulaToken::LessEqual:
+    case FormulaToken::Greater:
+    case FormulaToken::GreaterEqual:
+        return ComparisonPrecedence;
+    case FormulaToken::Concat:
+        return ConcatPrecedence;
+    case FormulaToken::Add:
+    case FormulaToken::Subtract:
+        return AdditivePrecedence;
+    case FormulaToken::Multiply:
+    case FormulaToken::Divide:
+        return MultiplicativePrecedence;
+    case FormulaToken::Power:
+        return PowerPrecedence;
+    case FormulaToken::Percent:
+        return PercentPrecedence;
+    case FormulaToken::Negate:
+    case FormulaToken::Plus:
+        return PrefixPrecedence;
+    case FormulaToken::Union:
+        return UnionPrecedence;
+    case FormulaToken::Intersection:
+        return IntersectionPrecedence;
+    case FormulaToken::Range:
+    case FormulaToken::ImplicitIntersection:
+        return RangePrecedence;
+    case FormulaToken::Spill:
+        return SpillPrecedence;
+    }
+    return 0;
+}
+
+inline bool isDigit(ushort c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isAsciiLetter(ushort c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+inline bool isIdentifierStart(ushort c)
+{
+    if (c < 0x80)
+        return isAsciiLetter(c) || c == '_' || c == '\\';
+    return QChar(c).isLetter();
+}
+
+inline bool isIdentifierChar(ushort c)
+{
+    if (c < 0x80)
+        return isAsciiLetter(c) || isDigit(c) || c == '_' || c == '.' || c == '?' || c == '\\';
+    return QChar(c).isLetterOrNumber();
+}
+
+inline bool isSpace(ushort c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline ushort toUpper(ushort c)
+{
+    return (c >= 'a' && c <= 'z') ? ushort(c - 'a' + 'A') : c;
+}
+
+const char *const errorLiterals[] = {
+    "#NULL!", "#DIV/0!", "#VALUE!", "#REF!", "#NAME?", "#NUM!", "#N/A", "#GETTING_DATA"
+};
+
+FormulaToken makeToken(FormulaToken::Type type, int position)
+{
+    FormulaToken token;
+    token.type = type;
+    token.op = FormulaToken::Add;
+    token.position = position;
+    token.length = 0;
+    token.argumentCount = 0;
+    token.columns = 0;
+    token.number = 0;
+    token.ref.firstRow = 0;
+    token.ref.firstColumn = 0;
+    token.ref.lastRow = 0;
+    token.ref.lastColumn = 0;
+    token.ref.flags = 0;
+    token.ref.sheetPosition = 0;
+    token.ref.sheetLength = 0;
+    return token;
+}
+
+void appendColumnName(QString &out, int column)
+{
+    QChar letters[4];
+    int n = 0;
+    while (column) {
+        int remainder = column % 26;
+        if (remainder == 0)
+            remainder = 26;
+        letters[n++] = QLatin1Char(char('A' + remainder - 1));
+        column = (column - 1) / 26;
+    }
+    while (n)
+        out.append(letters[--n]);
+}
+
+} //namespace
+
+/*
+ * Lexer and recursive descent parser, working on the UTF-16 data.
+ */
+class FormulaParser
+{
+public:
+    FormulaParser(FormulaExpression &expression)
+        : m_expression(expression), m_tokens(expression.m_tokens)
+        , m_data(reinterpret_cast<const ushort *>(expression.m_text.constData()))
+        , m_size(expression.m_text.size()), m_pos(0)
+    {
+    }
+
+    bool parse();
+
+private:
+    struct Lexeme
+    {
+        enum Kind {
+            End, Operand, Operator, FunctionStart,
+            OpenParen, CloseParen, OpenBrace, CloseBrace,
+            Comma, Semicolon, Invalid
+        };
+        Kind kind;
+        bool spaceBefore;
+        FormulaToken token;
+    };
+
+    bool fail(int position)
+    {
+        if (m_expression.m_errorPosition == -1)
+            m_expression.m_errorPosition = position;
+        return false;
+    }
+    inline ushort at(int pos) const { return pos < m_size ? m_data[pos] : 0; }
+
+    void advance();
+    bool lexOperand(int start, Lexeme &lexeme);
+    bool lexAfterSheet(int sheetStart, int sheetEnd, Lexeme &lexeme);
+    int scanColumn(int pos, int *column, bool *absolute) const;
+    int scanRow(int pos, int *row, bool *absolute) const;
+    int scanReference(int pos, FormulaReference &ref) const;
+    int scanQuoted(int pos, ushort quote) const;
+    int scanBrackets(int pos) const;
+    int scanIdentifier(int pos) const;
+    int scanNumber(int pos) const;
+    int scanError(int pos) const;
+
+    bool parseExpression(int minPrecedence, bool allowUnion);
+    bool parseUnary(bool allowUnion);
+    bool parsePrimary();
+    bool parseFunction();
+    bool parseArray();
+
+    FormulaExpression &m_expression;
+    QVector<FormulaToken> &m_tokens;
+    const ushort *m_data;
+    int m_size;
+    int m_pos;
+    Lexeme m_current;
+};
+
+/*
+ * Returns the end of the column part of a reference ("$AB"), or -1.
+ */
+int FormulaParser::scanColumn(int pos, int *column, bool *absolute) const
+{
+    *absolute = at(pos) == '$';
+    if (*absolute)
+        ++pos;
+
+    int value = 0;
+    int start = pos;
+    while (pos < m_size && isAsciiLetter(m_data[pos]) && pos - start < 3) {
+        value = value * 26 + (toUpper(m_data[pos]) - 'A' + 1);
+        ++pos;
+    }
+    if (pos == start || value > maxColumn || (pos < m_size && isAsciiLetter(m_data[pos])))
+        return -1;
+    *column = value;
+    return pos;
+}
+
+/*
+ * Returns the end of the row part of a reference ("$12"), or -1.
+ */
+int FormulaParser::scanRow(int pos, int *row, bool *absolute) const
+{
+    *absolute = at(pos) == '$';
+    if (*absolute)
+        ++pos;
+
+    int value = 0;
+    int start = pos;
+    while (pos < m_size && isDigit(m_data[pos])) {
+        value = value * 10 + (m_data[pos] - '0');
+        if (value > maxRow)
+            return -1;
+        ++pos;
+    }
+    if (pos == start || value == 0)
+        return -1;
+    *row = value;
+    return pos;
+}
+
+/*
+ * Returns the end of the A1, A1:B2, A:B or 1:2 reference at \a pos,
+ * or -1 when there is no reference.
+ */
+int FormulaParser::scanReference(int pos, FormulaReference &ref) const
+{
+    int column1, row1, column2, row2;
+    bool columnAbs1, rowAbs1, columnAbs2, rowAbs2;
+    int end = -1;
+
+    int p = scanColumn(pos, &column1, &columnAbs1);
+    if (p != -1) {
+        int q = scanRow(p, &row1, &rowAbs1);
+        if (q != -1) {
+            //Cell, maybe followed by a second one
+            ref.firstRow = ref.lastRow = row1;
+            ref.firstColumn = ref.lastColumn = column1;
+            ref.flags = (rowAbs1 ? FormulaReference::FirstRowAbsolute | FormulaReference::LastRowAbsolute : 0)
+                    | (columnAbs1 ? FormulaReference::FirstColumnAbsolute | FormulaReference::LastColumnAbsolute : 0);
+            end = q;
+
+            if (at(q) == ':') {
+                int p2 = scanColumn(q + 1, &column2, &columnAbs2);
+                int q2 = p2 == -1 ? -1 : scanRow(p2, &row2, &rowAbs2);
+                if (q2 != -1 && !isIdentifierChar(at(q2)) && at(q2) != '(') {
+                    ref.lastRow = row2;
+                    ref.lastColumn = column2;
+                    ref.flags = (rowAbs1 ? FormulaReference::FirstRowAbsolute : 0)
+                            | (columnAbs1 ? FormulaReference::FirstColumnAbsolute : 0)
+                            | (rowAbs2 ? FormulaReference::LastRowAbsolute : 0)
+                            | (columnAbs2 ? FormulaReference::LastColumnAbsolute : 0)
+                            | FormulaReference::Area;
+                    end = q2;
+                }
+            }
+        } else if (at(p) == ':') {
+            //Whole columns
+            int p2 = scanColumn(p + 1, &column2, &columnAbs2);
+            if (p2 != -1 && !isDigit(at(p2))) {
+                ref.firstRow = ref.lastRow = 0;
+                ref.firstColumn = column1;
+                ref.lastColumn = column2;
+                ref.flags = (columnAbs1 ? FormulaReference::FirstColumnAbsolute : 0)
+                        | (columnAbs2 ? FormulaReference::LastColumnAbsolute : 0)
+                        | FormulaReference::WholeColumns;
+                end = p2;
+            }
+        }
+    } else {
+        //Whole rows
+        int q = scanRow(pos, &row1, &rowAbs1);
+        if (q != -1 && at(q) == ':') {
+            int q2 = scanRow(q + 1, &row2, &rowAbs2);
+            if (q2 != -1) {
+                ref.firstColumn = ref.lastColumn = 0;
+                ref.firstRow = row1;
+                ref.lastRow = row2;
+                ref.flags = (rowAbs1 ? FormulaReference::FirstRowAbsolute : 0)
+                        | (rowAbs2 ? FormulaReference::LastRowAbsolute : 0)
+                        | FormulaReference::WholeRows;
+                end = q2;
+            }
+        }
+    }
+
+    //"LOG10(" or "A1B" are not references
+    if (end != -1) {
+        ushort c = at(end);
+        if (isIdentifierChar(c) || c == '(' || c == '[' || c == '!')
+            return -1;
+    }
+    return end;
+}
+
+/*
+ * Returns the end of the quoted text starting at \a pos,
+ * in which a doubled quote stands for the quote itself.
+ */
+int FormulaParser::scanQuoted(int pos, ushort quote) const
+{
+    ++pos;
+    while (pos < m_size) {
+        if (m_data[pos] == quote) {
+            if (at(pos + 1) != quote)
+                return pos + 1;
+            ++pos;
+        }
+        ++pos;
+    }
+    return -1;
+}
+
+/*
+ * Returns the end of the [...] group starting at \a pos. Brackets
+ * can be nested, and "'" escapes the next character.
+ */
+int FormulaParser::scanBrackets(int pos) const
+{
+    int depth = 0;
+    while (pos < m_size) {
+        ushort c = m_data[pos];
+        if (c == '\'') {
+            ++pos;
+        } else if (c == '[') {
+            ++depth;
+        } else if (c == ']') {
+            if (--depth == 0)
+                return pos + 1;
+        }
+        ++pos;
+    }
+    return -1;
+}
+
+int FormulaParser::scanIdentifier(int pos) const
+{
+    ++pos;
+    while (pos < m_size && isIdentifierChar(m_data[pos]))
+        ++pos;
+    return pos;
+}
+
+int FormulaParser::scanNumber(int pos) const
+{
+    while (isDigit(at(pos)))
+        ++pos;
+    if (at(pos) == '.') {
+        ++pos;
+        while (isDigit(at(pos)))
+            ++pos;
+    }
+    if (at(pos) == 'E' || at(pos) == 'e') {
+        int p = pos + 1;
+        if (at(p) == '+' || at(p) == '-')
+            ++p;
+        if (!isDigit(at(p)))
+            return -1;
+        while (isDigit(at(p)))
+            ++p;
+        pos = p;
+    }
+    return pos;
+}
+
+/*
+ * Returns the end of the error literal at \a pos, or -1.
+ */
+int FormulaParser::scanError(int pos) const
+{
+    for (size_t i = 0; i < sizeof(errorLiterals) / sizeof(errorLiterals[0]); ++i) {
+        const char *literal = errorLiterals[i];
+        int n = 0;
+        while (literal[n] && toUpper(at(pos + n)) == ushort(uchar(literal[n])))
+            ++n;
+        if (!literal[n])
+            return pos + n;
+    }
+    return -1;
+}
+
+/*
+ * Lex the reference or the name following the sheet prefix.
+ */
+bool FormulaParser::lexAfterSheet(int sheetStart, int sheetEnd, Lexeme &lexeme)
+{
+    int start = sheetEnd + 1; //skip '!'
+    FormulaToken &token = lexeme.token;
+    token.ref.sheetPosition = sheetStart;
+    token.ref.sheetLength = sheetEnd - sheetStart;
+    token.position = start;
+
+    int end = scanReference(start, token.ref);
+    if (end != -1) {
+        token.type = FormulaToken::Reference;
+    } else if (isIdentifierStart(at(start))) {
+        end = scanIdentifier(start);
+        token.type = FormulaToken::Name;
+    } else if (at(start) == '#' && (end = scanError(start)) != -1) {
+        //Sheet1!#REF!
+        token.type = FormulaToken::Error;
+    } else {
+        return fail(start);
+    }
+
+    token.length = end - start;
+    m_pos = end;
+    return true;
+}
+
+bool FormulaParser::lexOperand(int start, Lexeme &lexeme)
+{
+    FormulaToken &token = lexeme.token;
+    ushort c = m_data[start];
+    int end;
+
+    lexeme.kind = Lexeme::Operand;
+
+    if (c == '"') {
+        end = scanQuoted(start, '"');
+        if (end == -1)
+            return fail(start);
+        token.type = FormulaToken::String;
+    } else if (c == '\'') {
+        //'Sheet name'!A1
+        end = scanQuoted(start, '\'');
+        if (end == -1 || at(end) != '!')
+            return fail(start);
+        return lexAfterSheet(start, end, lexeme);
+    } else if (c == '#') {
+        end = scanError(start);
+        if (end == -1) {
+            //Spill range operator, as in A1#
+            lexeme.kind = Lexeme::Operator;
+            token.type = FormulaToken::Operator;
+            token.op = FormulaToken::Spill;
+            end = start + 1;
+        } else {
+            token.type = FormulaToken::Error;
+        }
+    } else if (isDigit(c) || c == '$' || (c == '.' && isDigit(at(start + 1)))) {
+        end = scanReference(start, token.ref);
+        if (end != -1) {
+            token.type = FormulaToken::Reference;
+        } else if (c == '$') {
+            return fail(start);
+        } else {
+            end = scanNumber(start);
+            if (end == -1)
+                return fail(start);
+            token.type = FormulaToken::Number;
+            token.number = parseXsdDouble(reinterpret_cast<const QChar *>(m_data + start), end - start);
+        }
+    } else if (c == '[') {
+        end = scanBrackets(start);
+        if (end == -1)
+            return fail(start);
+        //[1]Sheet1!A1 refers to an external workbook
+        if (isIdentifierStart(at(end)) || at(end) == '\'') {
+            int sheetEnd = at(end) == '\'' ? scanQuoted(end, '\'') : scanIdentifier(end);
+            if (sheetEnd != -1 && at(sheetEnd) == '!')
+                return lexAfterSheet(start, sheetEnd, lexeme);
+        }
+        token.type = FormulaToken::StructuredReference;
+    } else if (isIdentifierStart(c)) {
+        end = scanReference(start, token.ref);
+        if (end != -1) {
+            token.type = FormulaToken::Reference;
+        } else {
+            end = scanIdentifier(start);
+            ushort next = at(end);
+            if (next == '(') {
+                lexeme.kind = Lexeme::FunctionStart;
+                token.type = FormulaToken::Function;
+                token.length = end - start;
+                m_pos = end + 1;
+                return true;
+            } else if (next == '!') {
+                return lexAfterSheet(start, end, lexeme);
+            } else if (next == ':' && isIdentifierStart(at(end + 1))) {
+                //Sheet1:Sheet3!A1
+                int sheetEnd = scanIdentifier(end + 1);
+                if (at(sheetEnd) == '!')
+                    return lexAfterSheet(start, sheetEnd, lexeme);
+                token.type = FormulaToken::Name;
+            } else if (next == '[') {
+                //Table1[Column]
+                end = scanBrackets(end);
+                if (end == -1)
+                    return fail(start);
+                token.type = FormulaToken::StructuredReference;
+            } else if (end - start == 4 && toUpper(c) == 'T' && toUpper(m_data[start+1]) == 'R'
+                       && toUpper(m_data[start+2]) == 'U' && toUpper(m_data[start+3]) == 'E') {
+                token.type = FormulaToken::Boolean;
+                token.number = 1;
+            } else if (end - start == 5 && toUpper(c) == 'F' && toUpper(m_data[start+1]) == 'A'
+                       && toUpper(m_data[start+2]) == 'L' && toUpper(m_data[start+3]) == 'S'
+                       && toUpper(m_data[start+4]) == 'E') {
+                token.type = FormulaToken::Boolean;
+                token.number = 0;
+            } else {
+                token.type = FormulaToken::Name;
+            }
+        }
+    } else {
+        return fail(start);
+    }
+
+    token.length = end - start;
+    m_pos = end;
+    return true;
+}
+
+void FormulaParser::advance()
+{
+    Lexeme &lexeme = m_current;
+
+    int start = m_pos;
+    while (m_pos < m_size && isSpace(m_data[m_pos]))
+        ++m_pos;
+    lexeme.spaceBefore = m_pos != start;
+    lexeme.token = makeToken(FormulaToken::Operator, m_pos);
+
+    if (m_pos >= m_size) {
+        lexeme.kind = Lexeme::End;
+        return;
+    }
+
+    ushort c = m_data[m_pos];
+    FormulaToken::OperatorType op;
+    int length = 1;
+    switch (c) {
+    case '+': op = FormulaToken::Add; break;
+    case '-': op = FormulaToken::Subtract; break;
+    case '*': op = FormulaToken::Multiply; break;
+    case '/': op = FormulaToken::Divide; break;
+    case '^': op = FormulaToken::Power; break;
+    case '&': op = FormulaToken::Concat; break;
+    case '=': op = FormulaToken::Equal; break;
+    case ':': op = FormulaToken::Range; break;
+    case '%': op = FormulaToken::Percent; break;
+    case '@': op = FormulaToken::ImplicitIntersection; break;
+    case '<':
+        if (at(m_pos + 1) == '=') {
+            op = FormulaToken::LessEqual;
+            length = 2;
+        } else if (at(m_pos + 1) == '>') {
+            op = FormulaToken::NotEqual;
+            length = 2;
+        } else {
+            op = FormulaToken::Less;
+        }
+        break;
+    case '>':
+        if (at(m_pos + 1) == '=') {
+            op = FormulaToken::GreaterEqual;
+            length = 2;
+        } else {
+            op = FormulaToken::Greater;
+        }
+        break;
+    case '(':
+        lexeme.kind = Lexeme::OpenParen;
+        ++m_pos;
+        return;
+    case ')':
+        lexeme.kind = Lexeme::CloseParen;
+        ++m_pos;
+        return;
+    case '{':
+        lexeme.kind = Lexeme::OpenBrace;
+        ++m_pos;
+        return;
+    case '}':
+        lexeme.kind = Lexeme::CloseBrace;
+        ++m_pos;
+        return;
+    case ',':
+        lexeme.kind = Lexeme::Comma;
+        ++m_pos;
+        return;
+    case ';':
+        lexeme.kind = Lexeme::Semicolon;
+        ++m_pos;
+        return;
+    default:
+        if (!lexOperand(m_pos, lexeme))
+            lexeme.kind = Lexeme::Invalid;
+        return;
+    }
+
+    lexeme.kind = Lexeme::Operator;
+    lexeme.token.op = op;
+    lexeme.token.length = length;
+    m_pos += length;
+}
+
+bool FormulaParser::parse()
+{
+    m_tokens.reserve(m_size / 3 + 2);
+    advance();
+    if (m_current.kind == Lexeme::End)
+        return fail(0);
+    if (!parseExpression(0, true))
+        return false;
+    if (m_current.kind != Lexeme::End)
+        return fail(m_current.token.position);
+    return true;
+}
+
+bool FormulaParser::parseExpression(int minPrecedence, bool allowUnion)
+{
+    if (!parseUnary(allowUnion))
+        return false;
+
+    forever {
+        FormulaToken token = m_current.token;
+        bool implicit = false;
+
+        if (m_current.kind == Lexeme::Operator) {
+            if (token.op == FormulaToken::ImplicitIntersection)
+                return fail(token.position);
+            if (token.op == FormulaToken::Percent || token.op == FormulaToken::Spill) {
+                //Postfix
+                if (precedence(token.op) < minPrecedence)
+                    break;
+                m_tokens.append(token);
+                advance();
+                continue;
+            }
+        } else if (m_current.kind == Lexeme::Comma && allowUnion) {
+            token.type = FormulaToken::Operator;
+            token.op = FormulaToken::Union;
+            token.length = 1;
+        } else if (m_current.spaceBefore && (m_current.kind == Lexeme::Operand
+                                             || m_current.kind == Lexeme::FunctionStart
+                                             || m_current.kind == Lexeme::OpenParen)) {
+            //A1:B5 B2:C3
+            token = makeToken(FormulaToken::Operator, m_current.token.position);
+            token.op = FormulaToken::Intersection;
+            implicit = true;
+        } else {
+            break;
+        }
+
+        int prec = precedence(token.op);
+        if (prec < minPrecedence)
+            break;
+        if (!implicit)
+            advance();
+        if (!parseExpression(prec + 1, allowUnion))
+            return false;
+        m_tokens.append(token);
+    }
+    return true;
+}
+
+bool FormulaParser::parseUnary(bool allowUnion)
+{
+    if (m_current.kind == Lexeme::Operator) {
+        FormulaToken token = m_current.token;
+        int prec;
+        if (token.op == FormulaToken::Subtract) {
+            token.op = FormulaToken::Negate;
+            prec = PrefixPrecedence;
+        } else if (token.op == FormulaToken::Add) {
+            token.op = FormulaToken::Plus;
+            prec = PrefixPrecedence;
+        } else if (token.op == FormulaToken::ImplicitIntersection) {
+            prec = RangePrecedence;
+        } else {
+            return fail(token.position);
+        }
+        advance();
+        if (!parseExpression(prec, allowUnion))
+            return false;
+        m_tokens.append(token);
+        return true;
+    }
+    return parsePrimary();
+}
+
+bool FormulaParser::parsePrimary()
+{
+    switch (m_current.kind) {
+    case Lexeme::Operand:
+        m_tokens.append(m_current.token);
+        advance();
+        return true;
+    case Lexeme::OpenParen: {
+        int position = m_current.token.position;
+        advance();
+        //Union is allowed again inside the parentheses: SUM((A1,B1))
+        if (!parseExpression(0, true))
+            return false;
+        if (m_current.kind != Lexeme::CloseParen)
+            return fail(m_current.kind == Lexeme::End ? position : m_current.token.position);
+        advance();
+        return true;
+    }
+    case Lexeme::FunctionStart:
+        return parseFunction();
+    case Lexeme::OpenBrace:
+        return parseArray();
+    default:
+        return fail(m_current.token.position);
+    }
+}
+
+bool FormulaParser::parseFunction()
+{
+    FormulaToken function = m_current.token;
+    advance();
+
+    int count = 0;
+    if (m_current.kind == Lexeme::CloseParen) {
+        advance();
+    } else {
+        forever {
+            if (m_current.kind == Lexeme::Comma || m_current.kind == Lexeme::CloseParen)
+                m_tokens.append(makeToken(FormulaToken::Missing, m_current.token.position));
+            else if (!parseExpression(0, false))
+                return false;
+            ++count;
+
+            if (m_current.kind == Lexeme::Comma) {
+                advance();
+            } else if (m_current.kind == Lexeme::CloseParen) {
+                advance();
+                break;
+            } else {
+                return fail(m_current.token.position);
+            }
+        }
+    }
+
+    function.argumentCount = count;
+    m_tokens.append(function);
+    return true;
+}
+
+/*
+ * {1,2,3;4,5,6}: the elements are constants only.
+ */
+bool FormulaParser::parseArray()
+{
+    FormulaToken array = makeToken(FormulaToken::Array, m_current.token.position);
+    advance();
+
+    int count = 0;
+    int columns = -1;
+    int column = 0;
+    forever {
+        bool negative = false;
+        if (m_current.kind == Lexeme::Operator
+                && (m_current.token.op == FormulaToken::Subtract || m_current.token.op == FormulaToken::Add)) {
+            negative = m_current.token.op == FormulaToken::Subtract;
+            advance();
+            if (m_current.kind != Lexeme::Operand || m_current.token.type != FormulaToken::Number)
+                return fail(m_current.token.position);
+        }
+        if (m_current.kind != Lexeme::Operand)
+            return fail(m_current.token.position);
+
+        FormulaToken element = m_current.token;
+        switch (element.type) {
+        case FormulaToken::Number:
+            if (negative)
+                element.number = -element.number;
+            break;
+        case FormulaToken::String:
+        case FormulaToken::Boolean:
+        case FormulaToken::Error:
+            break;
+        default:
+            return fail(element.position);
+        }
+        m_tokens.append(element);
+        ++count;
+        ++column;
+        advance();
+
+        if (m_current.kind == Lexeme::Comma) {
+            advance();
+        } else if (m_current.kind == Lexeme::Semicolon || m_current.kind == Lexeme::CloseBrace) {
+            if (columns == -1)
+                columns = column;
+            else if (columns != column)
+                return fail(m_current.token.position);
+            column = 0;
+            bool last = m_current.kind == Lexeme::CloseBrace;
+            advance();
+            if (last)
+                break;
+        } else {
+            return fail(m_current.token.position);
+        }
+    }
+
+    array.argumentCount = count;
+    array.columns = columns;
+    array.length = m_current.token.position - array.position;
+    m_tokens.append(array);
+    return true;
+}
+
+/*!
+ * \internal
+ * \class FormulaExpression
+ */
+
+FormulaExpression::FormulaExpression()
+    : m_errorPosition(0)
+{
+}
+
+/*
+ * Parse the \a formula, given without the leading '='.
+ *
+ * On failure, the expression is not valid and errorPosition()
+ * returns the offset of the offending character.
+ */
+FormulaExpression FormulaExpression::parse(const QString &formula)
+{
+    FormulaExpression expression;
+    expression.m_text = formula;
+    expression.m_errorPosition = -1;
+
+    FormulaParser parser(expression);
+    if (!parser.parse())
+        expression.m_tokens.clear();
+    return expression;
+}
+
+QString FormulaExpression::tokenText(const FormulaToken &token) const
+{
+    return m_text.mid(token.position, token.length);
+}
+
+/*
+ * Returns the value of the String \a token, without the
+ * quotes and with the doubled quotes unescaped.
+ */
+QString FormulaExpression::stringValue(const FormulaToken &token) const
+{
+    QString value = m_text.mid(token.position + 1, token.length - 2);
+    if (value.contains(QLatin1Char('"')))
+        value.replace(QLatin1String("\"\""), QLatin1String("\""));
+    return value;
+}
+
+/*
+ * Returns the unquoted sheet name of the Reference or Name \a token,
+ * or an empty string for the current sheet.
+ */
+QString FormulaExpression::sheetName(const FormulaToken &token) const
+{
+    if (!token.ref.hasSheet())
+        return QString();
+
+    QString name = m_text.mid(token.ref.sheetPosition, token.ref.sheetLength);
+    if (name.startsWith(QLatin1Char('\'')) && name.endsWith(QLatin1Char('\''))) {
+        name = name.mid(1, name.size() - 2);
+        name.replace(QLatin1String("''"), QLatin1String("'"));
+    }
+    return name;
+}
+
+/*
+ * Returns the formula text with the relative parts of the references
+ * moved by the given offsets, as when the formula is copied to another
+ * cell. The references which fall off the sheet become #REF!.
+ */
+QString FormulaExpression::offsetReferences(int rowOffset, int columnOffset) const
+{
+    if (!isValid())
+        return m_text;
+
+    QVector<const FormulaToken *> refs;
+    for (int i = 0; i < m_tokens.size(); ++i) {
+        if (m_tokens[i].type == FormulaToken::Reference)
+            refs.append(&m_tokens[i]);
+    }
+    std::sort(refs.begin(), refs.end(), [](const FormulaToken *a, const FormulaToken *b) {
+        return a->position < b->position;
+    });
+
+    QString result;
+    result.reserve(m_text.size() + 8);
+    int copied = 0;
+    for (int i = 0; i < refs.size(); ++i) {
+        const FormulaReference &ref = refs[i]->ref;
+        result.append(m_text.midRef(copied, refs[i]->position - copied));
+        copied = refs[i]->position + refs[i]->length;
+
+        int firstRow = ref.firstRow;
+        int lastRow = ref.lastRow;
+        int firstColumn = ref.firstColumn;
+        int lastColumn = ref.lastColumn;
+        if (!(ref.flags & FormulaReference::WholeColumns)) {
+            if (!(ref.flags & FormulaReference::FirstRowAbsolute))
+                firstRow += rowOffset;
+            if (!(ref.flags & FormulaReference::LastRowAbsolute))
+                lastRow += rowOffset;
+            if (firstRow < 1 || lastRow < 1 || firstRow > maxRow || lastRow > maxRow) {
+                result.append(QLatin1String("#REF!"));
+                continue;
+            }
+        }
+        if (!(ref.flags & FormulaReference::WholeRows)) {
+            if (!(ref.flags & FormulaReference::FirstColumnAbsolute))
+                firstColumn += columnOffset;
+            if (!(ref.flags & FormulaReference::LastColumnAbsolute))
+                lastColumn += columnOffset;
+            if (firstColumn < 1 || lastColumn < 1 || firstColumn > maxColumn || lastColumn > maxColumn) {
+                result.append(QLatin1String("#REF!"));
+                continue;
+            }
+        }
+
+        if (ref.flags & FormulaReference::WholeColumns) {
+            if (ref.flags & FormulaReference::FirstColumnAbsolute)
+                result.append(QLatin1Char('$'));
+            appendColumnName(result, firstColumn);
+            result.append(QLatin1Char(':'));
+            if (ref.flags & FormulaReference::LastColumnAbsolute)
+                result.append(QLatin1Char('$'));
+            appendColumnName(result, lastColumn);
+        } else if (ref.flags & FormulaReference::WholeRows) {
+            if (ref.flags & FormulaReference::FirstRowAbsolute)
+                result.append(QLatin1Char('$'));
+            result.append(QString::number(firstRow));
+            result.append(QLatin1Char(':'));
+            if (ref.flags & FormulaReference::LastRowAbsolute)
+                result.append(QLatin1Char('$'));
+            result.append(QString::number(lastRow));
+        } else {
+            if (ref.flags & FormulaReference::FirstColumnAbsolute)
+                result.append(QLatin1Char('$'));
+            appendColumnName(result, firstColumn);
+            if (ref.flags & FormulaReference::FirstRowAbsolute)
+                result.append(QLatin1Char('$'));
+            result.append(QString::number(firstRow));
+            if (ref.flags & FormulaReference::Area) {
+                result.append(QLatin1Char(':'));
+                if (ref.flags & FormulaReference::LastColumnAbsolute)
+                    result.append(QLatin1Char('$'));
+                appendColumnName(result, lastColumn);
+                if (ref.flags & FormulaReference::LastRowAbsolute)
+                    result.append(QLatin1Char('$'));
+                result.append(QString::number(lastRow));
+            }
+        }
+    }
+    result.append(m_text.midRef(copied));
+    return result;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,191 @@
+// xlsxgeometryindex.cpp
+
+#include "xlsxgeometryindex_p.h"
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+inline int lowbit(int i)
+{
+    return i & -i;
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class GeometryIndex
+ */
+
+GeometryIndex::GeometryIndex()
+    : m_defaultSize(0)
+{
+    m_tree.append(0);
+}
+
+/*
+ * Removes all the runs, the rows or columns all get \a defaultSize.
+ */
+void GeometryIndex::clear(int defaultSize)
+{
+    m_runs.clear();
+    m_tree.resize(1);
+    m_defaultSize = defaultSize;
+}
+
+/*
+ * Appends the run of rows or columns [\a first, \a last], each of them
+ * \a size pixels. Runs must be appended in order, without overlapping.
+ */
+void GeometryIndex::append(int first, int last, int size)
+{
+    Q_ASSERT(first <= last);
+    Q_ASSERT(m_runs.isEmpty() || m_runs.last().last < first);
+
+    Run run;
+    run.first = first;
+    run.last = last;
+    run.size = size;
+    m_runs.append(run);
+
+    const int i = m_runs.size();
+    m_tree.append(extent(i - 1) + prefix(i - 1) - prefix(i - lowbit(i)));
+}
+
+/*
+ * Sets the size of the run [\a first, \a last] to \a size. Returns
+ * false if there is no such run.
+ */
+bool GeometryIndex::update(int first, int last, int size)
+{
+    const int r = runAt(first);
+    if (r < 0 || m_runs[r].first != first || m_runs[r].last != last)
+        return false;
+
+    Run &run = m_runs[r];
+    const int delta = (size - run.size) * (run.last - run.first + 1);
+    run.size = size;
+    for (int i = r + 1; i < m_tree.size(); i += lowbit(i))
+        m_tree[i] += delta;
+    return true;
+}
+
+/*
+ * Returns the size of the row or column \a index in pixels.
+ */
+int GeometryIndex::size(int index) const
+{
+    const int r = runAt(index);
+    if (r >= 0 && index <= m_runs[r].last)
+        return m_runs[r].size;
+    return m_defaultSize;
+}
+
+/*
+ * Returns the position of the leading edge of the row or column
+ * \a index, in pixels from the leading edge of the first one.
+ */
+int GeometryIndex::offset(int index) const
+{
+    const int r = runAt(index);
+    if (r < 0)
+        return (index - 1) * m_defaultSize;
+
+    const Run &run = m_runs[r];
+    if (index <= run.last) {
+        const int start = prefix(r) + (run.first - previousLast(r) - 1) * m_defaultSize;
+        return start + (index - run.first) * run.size;
+    }
+    return prefix(r + 1) + (index - run.last - 1) * m_defaultSize;
+}
+
+/*
+ * Returns the row or column which covers \a position, the distance from
+ * its leading edge is stored in \a remainder. Rows or columns of zero
+ * size never cover any position.
+ */
+int GeometryIndex::indexAt(int position, int *remainder) const
+{
+    int rest = qMax(position, 0);
+
+    // Number of the runs, with the gaps before them, ending before rest
+    int count = 0;
+    int step = 1;
+    while (step * 2 < m_tree.size())
+        step *= 2;
+    for (; step > 0; step /= 2) {
+        if (count + step < m_tree.size() && m_tree[count + step] <= rest) {
+            count += step;
+            rest -= m_tree[count];
+        }
+    }
+
+    int index;
+    if (count < m_runs.size()) {
+        const Run &run = m_runs[count];
+        const int gap = (run.first - previousLast(count) - 1) * m_defaultSize;
+        if (rest < gap) {
+            index = previousLast(count) + 1 + rest / m_defaultSize;
+            rest %= m_defaultSize;
+        } else {
+            rest -= gap;
+            index = run.first + rest / run.size;
+            rest %= run.size;
+        }
+    } else if (m_defaultSize > 0) {
+        index = previousLast(count) + 1 + rest / m_defaultSize;
+        rest %= m_defaultSize;
+    } else {
+        index = previousLast(count) + 1;
+    }
+
+    if (remainder)
+        *remainder = rest;
+    return index;
+}
+
+/*
+ * Returns the last run which starts at or before \a index, or -1.
+ */
+int GeometryIndex::runAt(int index) const
+{
+    int low = 0;
+    int high = m_runs.size();
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (m_runs[mid].first <= index)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low - 1;
+}
+
+int GeometryIndex::previousLast(int run) const
+{
+    return run > 0 ? m_runs[run - 1].last : 0;
+}
+
+/*
+ * Returns the pixels covered by \a run, including the gap of default
+ * sized rows or columns before it.
+ */
+int GeometryIndex::extent(int run) const
+{
+    const Run &r = m_runs[run];
+    return (r.first - previousLast(run) - 1) * m_defaultSize + (r.last - r.first + 1) * r.size;
+}
+
+/*
+ * Returns the pixels covered by the first \a count runs.
+ */
+int GeometryIndex::prefix(int count) const
+{
+    int sum = 0;
+    for (int i = count; i > 0; i -= lowbit(i))
+        sum += m_tree[i];
+    return sum;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,750 @@
+// xlsxhtmlexporter.cpp
+
+#include "xlsxhtmlexporter.h"
+#include "xlsxhtmlexporter_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxcell.h"
+#include "xlsxformatresolver_p.h"
+#include "xlsxformulaengine_p.h"
+#include "xlsxnumberformatter_p.h"
+#include "xlsxconditionalformatevaluator_p.h"
+
+#include <QIODevice>
+#include <QColor>
+#include <QScopedPointer>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int defaultChunkSize = 16 * 1024;
+
+inline quint64 cellKey(int row, int column)
+{
+	return (quint64(row) << 16) | quint64(column);
+}
+
+// A merged cell, clipped to the exported range
+struct MergedCell
+{
+	CellRange range;
+	int row;      // top left cell of the whole merge, which holds the value
+	int column;
+};
+
+QString borderCss(Format::BorderStyle style, const QColor &color)
+{
+	const char *line;
+	switch (style) {
+	case Format::BorderNone:
+		return QString();
+	case Format::BorderMedium:
+		line = "2px solid";
+		break;
+	case Format::BorderThick:
+		line = "3px solid";
+		break;
+	case Format::BorderDouble:
+		line = "3px double";
+		break;
+	case Format::BorderDotted:
+		line = "1px dotted";
+		break;
+	case Format::BorderDashed:
+	case Format::BorderDashDot:
+	case Format::BorderDashDotDot:
+		line = "1px dashed";
+		break;
+	case Format::BorderMediumDashed:
+	case Format::BorderMediumDashDot:
+	case Format::BorderMediumDashDotDot:
+	case Format::BorderSlantDashDot:
+		line = "2px dashed";
+		break;
+	default:
+		line = "1px solid";
+		break;
+	}
+	return QLatin1String(line) + QLatin1Char(' ')
+		+ (color.isValid() ? color.name() : QStringLiteral("#000"));
+}
+
+// Font names are written quoted in the style sheet
+bool isCssName(const QString &name)
+{
+	if (name.isEmpty())
+		return false;
+	foreach (QChar c, name) {
+		switch (c.unicode()) {
+		case '\'': case '"': case '\\': case '<': case '>': case ';': case '{': case '}':
+			return false;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+// Class names are written as they are in the selectors and the class
+// attributes, so they are limited to [A-Za-z_][A-Za-z0-9_-]*
+bool isCssIdentifier(const QString &name)
+{
+	if (name.isEmpty())
+		return false;
+	for (int i = 0; i < name.size(); ++i) {
+		const ushort c = name[i].unicode();
+		const bool letter = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+		const bool digit = (c >= '0' && c <= '9') || c == '-';
+		if (!letter && (i == 0 || !digit))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * CSS of the font and the fill of \a format, common to the styles and
+ * the differential formats of the conditional formattings.
+ */
+QString fontAndFillCss(const Format &format, bool differential)
+{
+	QString css;
+	if (format.hasFontData()) {
+		if (format.fontBold())
+			css += QLatin1String("font-weight:bold;");
+		if (format.fontItalic())
+			css += QLatin1String("font-style:italic;");
+		const bool underline = format.fontUnderline() != Format::FontUnderlineNone;
+		if (underline || format.fontStrikeOut()) {
+			css += QLatin1String("text-decoration:");
+			if (underline)
+				css += QLatin1String(" underline");
+			if (format.fontStrikeOut())
+				css += QLatin1String(" line-through");
+			css += QLatin1Char(';');
+		}
+		const QString name = format.fontName();
+		if (isCssName(name))
+			css += QLatin1String("font-family:'") + name + QLatin1String("';");
+		if (format.fontSize() > 0)
+			css += QStringLiteral("font-size:%1pt;").arg(format.fontSize());
+		if (format.fontColor().isValid())
+			css += QLatin1String("color:") + format.fontColor().name() + QLatin1Char(';');
+	}
+
+	if (format.fillPattern() != Format::PatternNone) {
+		//Solid fills of the styles are in the foreground color, the ones of
+		//the differential formats in the background color
+		QColor color = differential ? format.patternBackgroundColor() : format.patternForegroundColor();
+		if (!color.isValid())
+			color = differential ? format.patternForegroundColor() : format.patternBackgroundColor();
+		if (color.isValid())
+			css += QLatin1String("background-color:") + color.name() + QLatin1Char(';');
+	}
+	return css;
+}
+
+} //namespace
+
+HtmlExporterPrivate::HtmlExporterPrivate(HtmlExporter *p, Worksheet *sheet)
+	: q_ptr(p), sheet(sheet), prefix(QStringLiteral("xlsx")), chunkSize(defaultChunkSize)
+	, conditionalFormatting(true), device(0), error(false)
+{
+}
+
+/*
+ * Writes the style sheet and the table of the cells of the range.
+ */
+bool HtmlExporterPrivate::writeTable()
+{
+	WorksheetPrivate *sd = sheet->d_func();
+	const bool date1904 = sheet->workbook()->isDate1904();
+
+	CellRange r = range.isValid() ? range : sd->dimension;
+	if (!r.isValid()) {
+		append("<table class=\"");
+		append(prefix);
+		append("\"></table>\n");
+		return flush(true);
+	}
+
+	const GeometryIndex &rowIndex = sd->rowGeometryIndex();
+	const GeometryIndex &columnIndex = sd->columnGeometryIndex();
+	const int columnCount = r.columnCount();
+
+	// Merged cells: the top left one spans the others, which are skipped
+	QHash<quint64, MergedCell> merges;
+	foreach (int index, sd->mergeIndex.find(r)) {
+		const CellRange &merge = sd->merges.at(index);
+		MergedCell cell;
+		cell.range = CellRange(qMax(merge.firstRow(), r.firstRow()), qMax(merge.firstColumn(), r.firstColumn()),
+							   qMin(merge.lastRow(), r.lastRow()), qMin(merge.lastColumn(), r.lastColumn()));
+		cell.row = merge.firstRow();
+		cell.column = merge.firstColumn();
+		//The merged cell starts at its first visible row and column
+		int firstRow = cell.range.firstRow();
+		while (firstRow < cell.range.lastRow() && !rowIndex.size(firstRow))
+			++firstRow;
+		int firstColumn = cell.range.firstColumn();
+		while (firstColumn < cell.range.lastColumn() && !columnIndex.size(firstColumn))
+			++firstColumn;
+		cell.range = CellRange(firstRow, firstColumn, cell.range.lastRow(), cell.range.lastColumn());
+		merges.insert(cellKey(cell.range.firstRow(), cell.range.firstColumn()), cell);
+		if (const Cell *topLeft = sheet->cellAt(cell.row, cell.column))
+			styleClass(topLeft->format(), true);
+	}
+
+	collectStyles(r);
+
+	const QString cellClass = prefix + QLatin1Char('-');
+	append("<style>\n");
+	append("table."); append(prefix); append(" { border-collapse: collapse; table-layout: fixed; }\n");
+	append("table."); append(prefix);
+	append(" td { vertical-align: bottom; white-space: nowrap; overflow: hidden; padding: 0 3px; }\n");
+	append("table."); append(prefix); append(" td."); append(cellClass); append("n { text-align: right; }\n");
+	for (int i = 0; i < classFormats.size(); ++i) {
+		append("table."); append(prefix); append(" td."); append(cellClass);
+		appendNumber(i);
+		append(" { ");
+		append(formatCss(classFormats[i]));
+		append("}\n");
+	}
+	append("</style>\n");
+
+	// Widths of the columns, the hidden ones are left out
+	QVector<int> widths(columnCount);
+	int tableWidth = 0;
+	for (int i = 0; i < columnCount; ++i) {
+		widths[i] = columnIndex.size(r.firstColumn() + i);
+		tableWidth += widths[i];
+	}
+	append("<table class=\""); append(prefix); append("\" style=\"width: ");
+	appendNumber(tableWidth);
+	append("px\">\n<colgroup>");
+	for (int i = 0; i < columnCount; ++i) {
+		if (!widths[i])
+			continue;
+		append("<col style=\"width: ");
+		appendNumber(widths[i]);
+		append("px\">");
+	}
+	append("</colgroup>\n");
+	if (!flush(false))
+		return false;
+
+	QScopedPointer<ConditionalFormatEvaluator> evaluator;
+	if (conditionalFormatting && !sd->conditionalFormattingList.isEmpty())
+		evaluator.reset(new ConditionalFormatEvaluator(sheet));
+
+	FormatResolver formats(sd->rowsInfo, sd->colsInfo);
+	NumberFormatter numbers(date1904);
+	char buffer[XLSX_NUMBER_TEXT_BUFFER_SIZE];
+
+	// Last row of the merged cell covering each column, from above
+	QVector<int> coveredUntil(columnCount, 0);
+
+	typedef QMap<int, QSharedPointer<Cell> > CellRow;
+	QMap<int, CellRow>::const_iterator rowIt = sd->cellTable.lowerBound(r.firstRow());
+	for (int row = r.firstRow(); row <= r.lastRow(); ++row) {
+		const int height = rowIndex.size(row);
+		if (!height)
+			continue;
+
+		while (rowIt != sd->cellTable.constEnd() && rowIt.key() < row)
+			++rowIt;
+		const CellRow *cells = rowIt != sd->cellTable.constEnd() && rowIt.key() == row ? &rowIt.value() : 0;
+
+		if (height != rowIndex.defaultSize()) {
+			append("<tr style=\"height: ");
+			appendNumber(height);
+			append("px\">");
+		} else {
+			append("<tr>");
+		}
+
+		for (int i = 0; i < columnCount; ++i) {
+			const int column = r.firstColumn() + i;
+			if (!widths[i] || coveredUntil[i] >= row)
+				continue;
+
+			int rowSpan = 1;
+			int columnSpan = 1;
+			const Cell *cell = 0;
+			int valueRow = row;
+			int valueColumn = column;
+
+			QHash<quint64, MergedCell>::const_iterator merge = merges.constFind(cellKey(row, column));
+			if (merge != merges.constEnd()) {
+				const CellRange &span = merge->range;
+				rowSpan = 0;
+				for (int k = span.firstRow(); k <= span.lastRow(); ++k)
+					rowSpan += rowIndex.size(k) ? 1 : 0;
+				columnSpan = 0;
+				for (int k = span.firstColumn(); k <= span.lastColumn(); ++k) {
+					columnSpan += widths[k - r.firstColumn()] ? 1 : 0;
+					coveredUntil[k - r.firstColumn()] = span.lastRow();
+				}
+				valueRow = merge->row;
+				valueColumn = merge->column;
+				cell = sheet->cellAt(valueRow, valueColumn);
+			} else if (cells) {
+				CellRow::const_iterator it = cells->constFind(column);
+				if (it != cells->constEnd())
+					cell = it.value().data();
+			}
+
+			const Format format = formats.format(valueRow, valueColumn, cell ? cell->format() : Format());
+			const FormulaValue value = FormulaEngine::valueOf(cell, date1904);
+			const int style = styleClass(format, false);
+
+			append("<td");
+			if (style >= 0 || value.type == FormulaValue::Number) {
+				append(" class=\"");
+				if (value.type == FormulaValue::Number) {
+					append(cellClass);
+					append(style >= 0 ? "n " : "n");
+				}
+				if (style >= 0) {
+					append(cellClass);
+					appendNumber(style);
+				}
+				append("\"");
+			}
+			if (rowSpan > 1) {
+				append(" rowspan=\"");
+				appendNumber(rowSpan);
+				append("\"");
+			}
+			if (columnSpan > 1) {
+				append(" colspan=\"");
+				appendNumber(columnSpan);
+				append("\"");
+			}
+
+			bool hideValue = false;
+			if (evaluator) {
+				const ConditionalFormatOverlay overlay = evaluator->overlayAt(valueRow, valueColumn);
+				if (!overlay.isEmpty()) {
+					append(" style=\"");
+					append(overlayCss(overlay));
+					append("\"");
+					hideValue = overlay.isValueHidden();
+				}
+			}
+			append(">");
+
+			if (!hideValue) {
+				switch (value.type) {
+				case FormulaValue::Number:
+					text.append(QLatin1String(buffer, numbers.format(value.number, format, buffer)));
+					break;
+				case FormulaValue::Boolean:
+					append(value.number ? "TRUE" : "FALSE");
+					break;
+				case FormulaValue::String:
+				case FormulaValue::Error:
+					appendEscaped(value.text);
+					break;
+				default:
+					break;
+				}
+			}
+			append("</td>");
+		}
+		append("</tr>\n");
+
+		if (!flush(false))
+			return false;
+	}
+
+	append("</table>\n");
+	return flush(true);
+}
+
+/*
+ * Gives a class to each format of the cells, rows and columns of
+ * \a range, so that the style sheet can be written before the cells.
+ */
+void HtmlExporterPrivate::collectStyles(const CellRange &range)
+{
+	WorksheetPrivate *sd = sheet->d_func();
+
+	typedef QMap<int, QSharedPointer<Cell> > CellRow;
+	QMap<int, CellRow>::const_iterator rowIt = sd->cellTable.lowerBound(range.firstRow());
+	for (; rowIt != sd->cellTable.constEnd() && rowIt.key() <= range.lastRow(); ++rowIt) {
+		CellRow::const_iterator it = rowIt->lowerBound(range.firstColumn());
+		for (; it != rowIt->constEnd() && it.key() <= range.lastColumn(); ++it)
+			styleClass(it.value()->format(), true);
+	}
+
+	IntervalMap<XlsxRowInfo>::const_iterator rowRun = sd->rowsInfo.lowerBound(range.firstRow());
+	for (; rowRun != sd->rowsInfo.constEnd() && rowRun->first <= range.lastRow(); ++rowRun)
+		styleClass(rowRun->value.format, true);
+
+	IntervalMap<XlsxColumnInfo>::const_iterator columnRun = sd->colsInfo.lowerBound(range.firstColumn());
+	for (; columnRun != sd->colsInfo.constEnd() && columnRun->first <= range.lastColumn(); ++columnRun)
+		styleClass(columnRun->value.format, true);
+}
+
+/*
+ * Returns the class of the cells shown with \a format, -1 for the
+ * default format. A format seen for the first time gets a new class
+ * if \a add is true.
+ */
+int HtmlExporterPrivate::styleClass(const Format &format, bool add)
+{
+	if (format.isEmpty())
+		return -1;
+
+	if (format.xfIndexValid()) {
+		QHash<int, int>::const_iterator it = classesByXf.constFind(format.xfIndex());
+		if (it != classesByXf.constEnd())
+			return it.value();
+		if (!add)
+			return -1;
+		classesByXf.insert(format.xfIndex(), classFormats.size());
+	} else {
+		const QByteArray key = format.formatKey();
+		QHash<QByteArray, int>::const_iterator it = classesByKey.constFind(key);
+		if (it != classesByKey.constEnd())
+			return it.value();
+		if (!add)
+			return -1;
+		classesByKey.insert(key, classFormats.size());
+	}
+
+	classFormats.append(format);
+	return classFormats.size() - 1;
+}
+
+/*
+ * CSS of the cells shown with \a format.
+ */
+QString HtmlExporterPrivate::formatCss(const Format &format)
+{
+	QString css = fontAndFillCss(format, false);
+
+	if (format.hasBorderData()) {
+		const QString left = borderCss(format.leftBorderStyle(), format.leftBorderColor());
+		const QString right = borderCss(format.rightBorderStyle(), format.rightBorderColor());
+		const QString top = borderCss(format.topBorderStyle(), format.topBorderColor());
+		const QString bottom = borderCss(format.bottomBorderStyle(), format.bottomBorderColor());
+		if (!left.isEmpty())
+			css += QLatin1String("border-left:") + left + QLatin1Char(';');
+		if (!right.isEmpty())
+			css += QLatin1String("border-right:") + right + QLatin1Char(';');
+		if (!top.isEmpty())
+			css += QLatin1String("border-top:") + top + QLatin1Char(';');
+		if (!bottom.isEmpty())
+			css += QLatin1String("border-bottom:") + bottom + QLatin1Char(';');
+	}
+
+	if (format.hasAlignmentData()) {
+		switch (format.horizontalAlignment()) {
+		case Format::AlignLeft:
+			css += QLatin1String("text-align:left;");
+			break;
+		case Format::AlignHCenter:
+		case Format::AlignHMerge:
+		case Format::AlignHDistributed:
+			css += QLatin1String("text-align:center;");
+			break;
+		case Format::AlignRight:
+			css += QLatin1String("text-align:right;");
+			break;
+		case Format::AlignHJustify:
+			css += QLatin1String("text-align:justify;");
+			break;
+		default:
+			break;
+		}
+		switch (format.verticalAlignment()) {
+		case Format::AlignTop:
+			css += QLatin1String("vertical-align:top;");
+			break;
+		case Format::AlignVCenter:
+		case Format::AlignVJustify:
+		case Format::AlignVDistributed:
+			css += QLatin1String("vertical-align:middle;");
+			break;
+		default:
+			break;
+		}
+		if (format.textWrap())
+			css += QLatin1String("white-space:pre-wrap;");
+		if (format.indent() > 0)
+			css += QStringLiteral("padding-left:%1px;").arg(3 + 9 * format.indent());
+	}
+	return css;
+}
+
+/*
+ * CSS of what the conditional formattings make of a cell.
+ */
+QString HtmlExporterPrivate::overlayCss(const ConditionalFormatOverlay &overlay)
+{
+	QString css;
+	if (overlay.format().isValid())
+		css = fontAndFillCss(overlay.format(), true);
+	if (overlay.scaleColor().isValid())
+		css += QLatin1String("background-color:") + overlay.scaleColor().name() + QLatin1Char(';');
+	if (overlay.dataBarLength() >= 0) {
+		const QString color = overlay.dataBarColor().isValid() ? overlay.dataBarColor().name() : QStringLiteral("#638ec6");
+		const int percent = qRound(overlay.dataBarLength() * 100);
+		css += QStringLiteral("background-image:linear-gradient(to right,%1 %2%,transparent %2%);")
+			.arg(color).arg(percent);
+	}
+	return css;
+}
+
+/*
+ * Appends \a value with the HTML special characters escaped, and the
+ * line breaks as <br>.
+ */
+void HtmlExporterPrivate::appendEscaped(const QString &value)
+{
+	const QChar *data = value.constData();
+	const int size = value.size();
+	int start = 0;
+	for (int i = 0; i < size; ++i) {
+		const char *entity;
+		switch (data[i].unicode()) {
+		case '&':
+			entity = "&amp;";
+			break;
+		case '<':
+			entity = "&lt;";
+			break;
+		case '>':
+			entity = "&gt;";
+			break;
+		case '"':
+			entity = "&quot;";
+			break;
+		case '\n':
+			entity = "<br>";
+			break;
+		default:
+			continue;
+		}
+		text.append(data + start, i - start);
+		text.append(QLatin1String(entity));
+		start = i + 1;
+	}
+	text.append(data + start, size - start);
+}
+
+/*
+ * Writes the text buffered so far to the device, if there is at least
+ * a chunk of it or if \a force is true.
+ */
+bool HtmlExporterPrivate::flush(bool force)
+{
+	if (error)
+		return false;
+	if (text.isEmpty() || (!force && text.size() < chunkSize))
+		return true;
+
+	const QByteArray data = text.toUtf8();
+	text.resize(0);
+	if (device->write(data) != data.size())
+		error = true;
+	return !error;
+}
+
+/*!
+  \class HtmlExporter
+  \inmodule QtXlsx
+  \brief Writes the cells of a worksheet as an HTML table.
+
+  The table is written to a QIODevice row by row, in chunks of about
+  chunkSize() characters, so a server can send the first rows while the
+  next ones are still being rendered. Nothing of the sheet is copied
+  beforehand, and the memory used doesn't grow with the number of rows.
+
+  Each distinct style of the cells becomes a CSS class, defined in a
+  style sheet written before the table. Merged cells span rows and
+  columns, hidden rows and columns are left out, and the colors, fonts
+  and data bars given by the conditional formattings are written in
+  the style of the cells concerned.
+
+  The numbers are written with the decimals of their number format,
+  and the dates and times as ISO 8601 strings.
+
+  \sa Worksheet::exportCsv()
+*/
+
+/*!
+  Creates an exporter of the cells of \a sheet.
+ */
+HtmlExporter::HtmlExporter(Worksheet *sheet)
+	: d_ptr(new HtmlExporterPrivate(this, sheet))
+{
+}
+
+/*!
+  Destroys the exporter.
+ */
+HtmlExporter::~HtmlExporter()
+{
+	delete d_ptr;
+}
+
+/*!
+  Returns the worksheet which is exported.
+ */
+Worksheet *HtmlExporter::worksheet() const
+{
+	Q_D(const HtmlExporter);
+	return d->sheet;
+}
+
+/*!
+  Returns the cells which are exported. An invalid range, the default,
+  stands for the whole dimension of the sheet.
+ */
+CellRange HtmlExporter::range() const
+{
+	Q_D(const HtmlExporter);
+	return d->range;
+}
+
+/*!
+  Exports the cells of \a range only.
+ */
+void HtmlExporter::setRange(const CellRange &range)
+{
+	Q_D(HtmlExporter);
+	d->range = range;
+}
+
+/*!
+  Exports the rows \a firstRow to \a lastRow only, with the columns of
+  the dimension of the sheet.
+ */
+void HtmlExporter::setRowRange(int firstRow, int lastRow)
+{
+	Q_D(HtmlExporter);
+	const CellRange dimension = d->sheet->dimension();
+	if (!dimension.isValid())
+		d->range = CellRange();
+	else
+		d->range = CellRange(firstRow, dimension.firstColumn(), lastRow, dimension.lastColumn());
+}
+
+/*!
+  Returns the class of the table, which also starts the classes of the
+  cells. The default is "xlsx".
+ */
+QString HtmlExporter::classPrefix() const
+{
+	Q_D(const HtmlExporter);
+	return d->prefix;
+}
+
+/*!
+  Sets the class of the table to \a prefix. The tables of several sheets
+  written to the same page need different classes.
+
+  The prefix must be a CSS identifier made of ASCII letters, digits,
+  '_' and '-', not starting with a digit or '-'. Returns false, keeping
+  the current prefix, otherwise.
+ */
+bool HtmlExporter::setClassPrefix(const QString &prefix)
+{
+	Q_D(HtmlExporter);
+	if (!isCssIdentifier(prefix))
+		return false;
+	d->prefix = prefix;
+	return true;
+}
+
+/*!
+  Returns the number of characters written to the device at a time.
+  The default is 16384.
+ */
+int HtmlExporter::chunkSize() const
+{
+	Q_D(const HtmlExporter);
+	return d->chunkSize;
+}
+
+/*!
+  Sets the number of characters written to the device at a time to
+  \a size.
+ */
+void HtmlExporter::setChunkSize(int size)
+{
+	Q_D(HtmlExporter);
+	if (size > 0)
+		d->chunkSize = size;
+}
+
+/*!
+  Returns true if the conditional formattings of the sheet are applied,
+  which is the default.
+ */
+bool HtmlExporter::isConditionalFormattingEnabled() const
+{
+	Q_D(const HtmlExporter);
+	return d->conditionalFormatting;
+}
+
+/*!
+  Applies the conditional formattings of the sheet if \a enable is true.
+ */
+void HtmlExporter::setConditionalFormattingEnabled(bool enable)
+{
+	Q_D(HtmlExporter);
+	d->conditionalFormatting = enable;
+}
+
+/*!
+  Writes the style sheet and the table of the cells to \a device, to be
+  put in the body of a page.
+
+  Returns false if the device can't be written to.
+ */
+bool HtmlExporter::exportTable(QIODevice *device)
+{
+	Q_D(HtmlExporter);
+	if (!d->sheet || !device || !device->isWritable())
+		return false;
+
+	d->device = device;
+	d->error = false;
+	d->text.reserve(d->chunkSize + 1024);
+	d->classesByXf.clear();
+	d->classesByKey.clear();
+	d->classFormats.clear();
+
+	const bool ok = d->writeTable();
+	d->text.clear();
+	d->device = 0;
+	return ok;
+}
+
+/*!
+  Writes a whole HTML page showing the table of the cells to \a device.
+
+  Returns false if the device can't be written to.
+ */
+bool HtmlExporter::exportDocument(QIODevice *device)
+{
+	Q_D(HtmlExporter);
+	if (!d->sheet || !device || !device->isWritable())
+		return false;
+
+	QString head = QStringLiteral("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>");
+	head += d->sheet->sheetName().toHtmlEscaped();
+	head += QLatin1String("</title>\n</head>\n<body>\n");
+	if (device->write(head.toUtf8()) < 0)
+		return false;
+
+	if (!exportTable(device))
+		return false;
+	return device->write("</body>\n</html>\n") >= 0;
+}
+
+QT_END_NAMESPACE_XLSX
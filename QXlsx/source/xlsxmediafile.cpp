@@ -24,7 +24,7 @@
 ****************************************************************************/
 
 #include "xlsxmediafile_p.h"
-#include <QCryptographicHash>
+#include <QHash>
 
 namespace QXlsx {
 
@@ -32,11 +32,11 @@ MediaFile::MediaFile(const QByteArray &bytes, const QString &suffix, const QStri
     : m_contents(bytes), m_suffix(suffix), m_mimeType(mimeType)
       , m_index(0), m_indexValid(false)
 {
-    m_hashKey = QCryptographicHash::hash(m_contents, QCryptographicHash::Md5);
+    m_hashKey = qHash(m_contents);
 }
 
 MediaFile::MediaFile(const QString &fileName)
-    :m_fileName(fileName), m_index(0), m_indexValid(false)
+    :m_fileName(fileName), m_index(0), m_indexValid(false), m_hashKey(0)
 {
 
 }
@@ -46,7 +46,7 @@ void MediaFile::set(const QByteArray &bytes, const QString &suffix, const QStrin
     m_contents = bytes;
     m_suffix = suffix;
     m_mimeType = mimeType;
-    m_hashKey = QCryptographicHash::hash(m_contents, QCryptographicHash::Md5);
+    m_hashKey = qHash(m_contents);
     m_indexValid = false;
 }
 
@@ -91,7 +91,10 @@ void MediaFile::setIndex(int idx)
     m_indexValid = true;
 }
 
-QByteArray MediaFile::hashKey() const
+/*
+ * Hash of the contents, which only tells the files which differ apart.
+ */
+uint MediaFile::hashKey() const
 {
     return m_hashKey;
 }
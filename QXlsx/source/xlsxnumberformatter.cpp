@@ -0,0 +1,256 @@
+// xlsxnumberformatter.cpp
+
+#include "xlsxnumberformatter_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QDate>
+
+#include <cmath>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int maxDecimals = 15;
+
+const double powersOf10[maxDecimals + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+/*
+ * Writes the last \a width digits of \a value, padded with zeros, to
+ * \a out. Returns the end of the digits.
+ */
+char *writeDigits(char *out, int value, int width)
+{
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = char('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+/*
+ * Number of decimals of the built-in number format \a id, or -1 when
+ * the format doesn't give a fixed number of decimals.
+ */
+int builtinDecimals(int id, bool *percent)
+{
+    *percent = id == 9 || id == 10;
+    switch (id) {
+    case 1: case 3: case 9: case 37: case 38:
+        return 0;
+    case 2: case 4: case 10: case 39: case 40:
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+} //namespace
+
+/*!
+ * \internal
+ * \class NumberFormatter
+ */
+
+NumberFormatter::NumberFormatter(bool date1904)
+    : m_date1904(date1904)
+{
+}
+
+/*
+ * Writes \a value, shown with \a format, to \a buffer, which must hold
+ * at least XLSX_NUMBER_TEXT_BUFFER_SIZE bytes. The text isn't '\0'
+ * terminated.
+ *
+ * Returns the length of the text.
+ */
+int NumberFormatter::format(double value, const Format &format, char *buffer)
+{
+    const Style &s = style(format);
+    if (s.kind == Style::DateTime && value >= 0)
+        return formatDateTime(value, buffer);
+
+    if (s.kind == Style::Fixed) {
+        int size = formatFixed(s.percent ? value * 100 : value, s.decimals, buffer);
+        if (s.percent)
+            buffer[size++] = '%';
+        return size;
+    }
+
+    return formatXsdDouble(value, buffer);
+}
+
+/*
+ * Returns how the numbers of \a format are written, which is worked out
+ * once for each style.
+ */
+const NumberFormatter::Style &NumberFormatter::style(const Format &format)
+{
+    static const Style general;
+    if (format.isEmpty())
+        return general;
+
+    if (!format.xfIndexValid()) {
+        m_uncachedStyle = parseStyle(format);
+        return m_uncachedStyle;
+    }
+
+    QHash<int, Style>::iterator it = m_styles.find(format.xfIndex());
+    if (it == m_styles.end())
+        it = m_styles.insert(format.xfIndex(), parseStyle(format));
+    return it.value();
+}
+
+/*
+ * Works out how the numbers of \a format are written: dates and times
+ * as such, and the others with the number of decimals and the percent
+ * sign of the format. Thousands separators, colors, texts and the
+ * sections of negative numbers are left out, as well as scientific
+ * notation and fractions, which are written as general numbers.
+ */
+NumberFormatter::Style NumberFormatter::parseStyle(const Format &format)
+{
+    Style style;
+    if (format.isDateTimeFormat()) {
+        style.kind = Style::DateTime;
+        return style;
+    }
+
+    const QString code = format.numberFormat();
+    if (code.isEmpty()) {
+        const int decimals = builtinDecimals(format.numberFormatIndex(), &style.percent);
+        if (decimals >= 0) {
+            style.kind = Style::Fixed;
+            style.decimals = decimals;
+        }
+        return style;
+    }
+
+    bool digits = false;
+    bool point = false;
+    int decimals = 0;
+    bool percent = false;
+    for (int i = 0; i < code.size(); ++i) {
+        const ushort c = code.at(i).unicode();
+        if (c == ';')
+            break;
+
+        switch (c) {
+        case '"':
+            while (++i < code.size() && code.at(i) != QLatin1Char('"')) {}
+            break;
+        case '[':
+            while (++i < code.size() && code.at(i) != QLatin1Char(']')) {}
+            break;
+        case '\\':
+        case '_':
+        case '*':
+            ++i; // the next character is literal, or a padding
+            break;
+        case '0':
+        case '#':
+        case '?':
+            digits = true;
+            if (point)
+                ++decimals;
+            break;
+        case '.':
+            point = true;
+            break;
+        case '%':
+            percent = true;
+            break;
+        case 'E':
+        case 'e':
+        case '/':
+        case '@':
+            return style;
+        default:
+            break;
+        }
+    }
+
+    if (digits) {
+        style.kind = Style::Fixed;
+        style.decimals = qMin(decimals, maxDecimals);
+        style.percent = percent;
+    }
+    return style;
+}
+
+/*
+ * Writes \a value rounded to \a decimals decimals, without going
+ * through the locale.
+ */
+int NumberFormatter::formatFixed(double value, int decimals, char *buffer)
+{
+    const double scaled = std::fabs(value) * powersOf10[decimals];
+    if (!(scaled < 1e15))
+        return formatXsdDouble(value, buffer);
+
+    quint64 m = static_cast<quint64>(scaled + 0.5);
+
+    // Written backwards: the decimals, the point, then the integer part
+    char digits[XLSX_NUMBER_TEXT_BUFFER_SIZE];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    for (int i = 0; i < decimals; ++i) {
+        *--p = char('0' + m % 10);
+        m /= 10;
+    }
+    if (decimals)
+        *--p = '.';
+    do {
+        *--p = char('0' + m % 10);
+        m /= 10;
+    } while (m);
+
+    char *out = buffer;
+    if (value < 0 && scaled + 0.5 >= 1)
+        *out++ = '-';
+    std::memcpy(out, p, end - p);
+    return int(out - buffer + (end - p));
+}
+
+/*
+ * Writes the serial number \a value as an ISO 8601 date, time, or both.
+ * Unlike QDateTime, this doesn't depend on the time zone.
+ */
+int NumberFormatter::formatDateTime(double value, char *buffer) const
+{
+    double num = value;
+    if (!m_date1904 && num > 60)
+        num -= 1; // 1900-02-29, which didn't exist
+
+    const qint64 seconds = static_cast<qint64>(num * 86400 + 0.5);
+    const qint64 days = seconds / 86400;
+    const int time = int(seconds % 86400);
+
+    char *p = buffer;
+    if (days > 0) {
+        const QDate epoch = m_date1904 ? QDate(1904, 1, 1) : QDate(1899, 12, 31);
+        int year, month, day;
+        epoch.addDays(days).getDate(&year, &month, &day);
+        p = writeDigits(p, year, 4);
+        *p++ = '-';
+        p = writeDigits(p, month, 2);
+        *p++ = '-';
+        p = writeDigits(p, day, 2);
+    }
+    if (time || days <= 0) {
+        if (p != buffer)
+            *p++ = ' ';
+        p = writeDigits(p, time / 3600, 2);
+        *p++ = ':';
+        p = writeDigits(p, time / 60 % 60, 2);
+        *p++ = ':';
+        p = writeDigits(p, time % 60, 2);
+    }
+    return int(p - buffer);
+}
+
+QT_END_NAMESPACE_XLSX
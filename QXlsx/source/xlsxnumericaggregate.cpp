@@ -0,0 +1,124 @@
+// xlsxnumericaggregate.cpp
+
+#include "xlsxnumericaggregate_p.h"
+
+#include <QtGlobal>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define XLSX_HAVE_SSE2
+#endif
+
+#if defined(__AVX__)
+#  include <immintrin.h>
+#  define XLSX_HAVE_AVX
+#endif
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+void aggregateScalar(const double *values, qint64 size, NumericAggregate *result)
+{
+    for (qint64 i = 0; i < size; ++i) {
+        const double value = values[i];
+        if (value == value)
+            result->add(value);
+    }
+}
+
+#if defined(XLSX_HAVE_AVX)
+qint64 aggregateAvx(const double *values, qint64 size, NumericAggregate *result)
+{
+    const __m256d ones = _mm256_set1_pd(1.0);
+    __m256d sum = _mm256_setzero_pd();
+    __m256d count = _mm256_setzero_pd();
+    __m256d minimum = _mm256_set1_pd(result->minimum);
+    __m256d maximum = _mm256_set1_pd(result->maximum);
+
+    qint64 i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m256d v = _mm256_loadu_pd(values + i);
+        const __m256d ordered = _mm256_cmp_pd(v, v, _CMP_ORD_Q);
+        sum = _mm256_add_pd(sum, _mm256_and_pd(v, ordered));
+        count = _mm256_add_pd(count, _mm256_and_pd(ones, ordered));
+        //min and max return the second operand if either one is NaN
+        minimum = _mm256_min_pd(v, minimum);
+        maximum = _mm256_max_pd(v, maximum);
+    }
+
+    double sums[4], counts[4], minimums[4], maximums[4];
+    _mm256_storeu_pd(sums, sum);
+    _mm256_storeu_pd(counts, count);
+    _mm256_storeu_pd(minimums, minimum);
+    _mm256_storeu_pd(maximums, maximum);
+    for (int j = 0; j < 4; ++j) {
+        NumericAggregate lane;
+        lane.sum = sums[j];
+        lane.minimum = minimums[j];
+        lane.maximum = maximums[j];
+        lane.count = qint64(counts[j]);
+        result->add(lane);
+    }
+    return i;
+}
+#endif
+
+#if defined(XLSX_HAVE_SSE2)
+qint64 aggregateSse2(const double *values, qint64 size, NumericAggregate *result)
+{
+    const __m128d ones = _mm_set1_pd(1.0);
+    __m128d sum = _mm_setzero_pd();
+    __m128d count = _mm_setzero_pd();
+    __m128d minimum = _mm_set1_pd(result->minimum);
+    __m128d maximum = _mm_set1_pd(result->maximum);
+
+    qint64 i = 0;
+    for (; i + 2 <= size; i += 2) {
+        const __m128d v = _mm_loadu_pd(values + i);
+        const __m128d ordered = _mm_cmpord_pd(v, v);
+        sum = _mm_add_pd(sum, _mm_and_pd(v, ordered));
+        count = _mm_add_pd(count, _mm_and_pd(ones, ordered));
+        //min and max return the second operand if either one is NaN
+        minimum = _mm_min_pd(v, minimum);
+        maximum = _mm_max_pd(v, maximum);
+    }
+
+    double sums[2], counts[2], minimums[2], maximums[2];
+    _mm_storeu_pd(sums, sum);
+    _mm_storeu_pd(counts, count);
+    _mm_storeu_pd(minimums, minimum);
+    _mm_storeu_pd(maximums, maximum);
+    for (int j = 0; j < 2; ++j) {
+        NumericAggregate lane;
+        lane.sum = sums[j];
+        lane.minimum = minimums[j];
+        lane.maximum = maximums[j];
+        lane.count = qint64(counts[j]);
+        result->add(lane);
+    }
+    return i;
+}
+#endif
+
+} //namespace
+
+/*
+ * Adds the \a size numbers of \a values to \a result. NaN marks the
+ * entries which are not numbers, they are skipped.
+ *
+ * The numbers are summed in several lanes, so the sum may differ in the
+ * last bits from the one added up from left to right.
+ */
+void aggregateNumbers(const double *values, qint64 size, NumericAggregate *result)
+{
+    qint64 done = 0;
+#if defined(XLSX_HAVE_AVX)
+    done = aggregateAvx(values, size, result);
+#elif defined(XLSX_HAVE_SSE2)
+    done = aggregateSse2(values, size, result);
+#endif
+    aggregateScalar(values + done, size - done, result);
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,334 @@
+// xlsxnumericcodec.cpp
+
+#include "xlsxnumericcodec_p.h"
+
+#include <QtGlobal>
+#include <QString>
+#include <QByteArray>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#  if __has_include(<charconv>)
+#    include <charconv>
+#  endif
+#endif
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#  define XLSX_HAS_FLOAT_TO_CHARS
+#endif
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Numbers of the <v> element are stored as xsd:double.
+ *
+ * On save, the shortest string which reads back to the very same double
+ * is written, so no digits are lost. Most of the values written to a sheet
+ * are integers or have a few decimals (prices, percentages, ...), these
+ * are formatted without any help of the C library.
+ *
+ * On load, the common "[-]digits[.digits][E[-]digits]" strings are parsed
+ * directly when the result can be computed exactly, the other ones are
+ * passed to Qt, which is locale independent too.
+ */
+
+namespace {
+
+// All of these are exactly representable as double.
+const double powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+const int maxFastPowerOf10 = 22;
+const quint64 maxExactMantissa = Q_UINT64_C(1) << 53;
+
+int writeUnsigned(quint64 value, char *buffer)
+{
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    for (int i = 0; i < n; ++i)
+        buffer[i] = digits[n - 1 - i];
+    return n;
+}
+
+#ifndef XLSX_HAS_FLOAT_TO_CHARS
+/*
+ * printf() uses the decimal point of the current C locale,
+ * which is set by QCoreApplication.
+ */
+void normalizeDecimalPoint(char *buffer, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        char ch = buffer[i];
+        if (!((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == 'e' || ch == 'E'))
+            buffer[i] = '.';
+    }
+}
+#endif
+
+/*
+ * Shortest round-trip formatting for the values which can not be
+ * handled by the fast path of formatXsdDouble().
+ */
+int formatGeneric(double value, char *buffer)
+{
+#ifdef XLSX_HAS_FLOAT_TO_CHARS
+    std::to_chars_result result = std::to_chars(buffer, buffer + XLSX_DOUBLE_BUFFER_SIZE - 1, value);
+    *result.ptr = '\0';
+    return int(result.ptr - buffer);
+#else
+    // 15 significant digits are enough for most of the values,
+    // while 17 digits are always enough.
+    int size = 0;
+    for (int precision = 15; precision <= 17; ++precision) {
+        size = std::snprintf(buffer, XLSX_DOUBLE_BUFFER_SIZE, "%.*g", precision, value);
+        normalizeDecimalPoint(buffer, size);
+        if (precision == 17 || parseXsdDouble(buffer, size) == value)
+            break;
+    }
+    return size;
+#endif
+}
+
+inline ushort charCode(char ch)
+{
+    return uchar(ch);
+}
+
+inline ushort charCode(QChar ch)
+{
+    return ch.unicode();
+}
+
+inline bool isXmlSpace(ushort ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+/*
+ * Parse the value when it can be done exactly with one multiplication or
+ * division (see Clinger's "How to read floating point numbers accurately").
+ * Returns false when the caller should fall back to the generic parser.
+ */
+template <typename Char>
+bool parseDoubleFast(const Char *p, const Char *end, double *result)
+{
+    while (p != end && isXmlSpace(charCode(*p)))
+        ++p;
+    while (p != end && isXmlSpace(charCode(end[-1])))
+        --end;
+    if (p == end)
+        return false;
+
+    bool negative = false;
+    if (charCode(*p) == '-' || charCode(*p) == '+') {
+        negative = charCode(*p) == '-';
+        ++p;
+    }
+
+    quint64 mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    for (; p != end; ++p) {
+        ushort ch = charCode(*p);
+        if (ch < '0' || ch > '9')
+            break;
+        mantissa = mantissa * 10 + (ch - '0');
+        if (mantissa && ++significantDigits > 19)
+            return false;
+        hasDigits = true;
+    }
+
+    if (p != end && charCode(*p) == '.') {
+        for (++p; p != end; ++p) {
+            ushort ch = charCode(*p);
+            if (ch < '0' || ch > '9')
+                break;
+            mantissa = mantissa * 10 + (ch - '0');
+            if (mantissa && ++significantDigits > 19)
+                return false;
+            --exponent;
+            hasDigits = true;
+        }
+    }
+
+    if (!hasDigits)
+        return false;
+
+    if (p != end && (charCode(*p) == 'e' || charCode(*p) == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p != end && (charCode(*p) == '-' || charCode(*p) == '+')) {
+            negativeExponent = charCode(*p) == '-';
+            ++p;
+        }
+        if (p == end)
+            return false;
+
+        int exp = 0;
+        for (; p != end; ++p) {
+            ushort ch = charCode(*p);
+            if (ch < '0' || ch > '9')
+                break;
+            exp = exp * 10 + (ch - '0');
+            if (exp > 9999)
+                return false;
+        }
+        exponent += negativeExponent ? -exp : exp;
+    }
+
+    if (p != end)
+        return false;
+
+    double value;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else {
+        if (mantissa > maxExactMantissa)
+            return false;
+        value = static_cast<double>(mantissa);
+        if (exponent > 0) {
+            if (exponent > maxFastPowerOf10)
+                return false;
+            value *= powersOf10[exponent];
+        } else if (exponent < 0) {
+            if (-exponent > maxFastPowerOf10)
+                return false;
+            value /= powersOf10[-exponent];
+        }
+    }
+
+    *result = negative ? -value : value;
+    return true;
+}
+
+} //namespace
+
+/*
+ * Write the shortest string that reads back to \a value into \a buffer,
+ * which must hold at least XLSX_DOUBLE_BUFFER_SIZE bytes. The string is
+ * '\0' terminated and independent of the current locale.
+ *
+ * Returns the length of the string.
+ */
+int formatXsdDouble(double value, char *buffer)
+{
+    if (value != value) {
+        std::strcpy(buffer, "NaN");
+        return 3;
+    }
+
+    char *p = buffer;
+    if (std::signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+
+    if (std::isinf(value)) {
+        std::strcpy(p, "INF");
+        return int(p - buffer) + 3;
+    }
+
+    // Fast path: value == m / 10^k with integer m below 10^15,
+    // so the first k found gives the shortest decimal form.
+    if (value == 0.0 || (value >= 1e-4 && value < 1e15)) {
+        for (int k = 0; k <= 15; ++k) {
+            double scaled = value * powersOf10[k];
+            if (scaled >= 1e15)
+                break;
+
+            double m = std::floor(scaled + 0.5);
+            if (m / powersOf10[k] != value)
+                continue;
+
+            char digits[24];
+            int n = writeUnsigned(static_cast<quint64>(m), digits);
+            if (k == 0) {
+                std::memcpy(p, digits, n);
+                p += n;
+            } else {
+                if (n <= k) {
+                    *p++ = '0';
+                    *p++ = '.';
+                    for (int i = n; i < k; ++i)
+                        *p++ = '0';
+                    std::memcpy(p, digits, n);
+                    p += n;
+                } else {
+                    std::memcpy(p, digits, n - k);
+                    p += n - k;
+                    *p++ = '.';
+                    std::memcpy(p, digits + n - k, k);
+                    p += k;
+                }
+            }
+            *p = '\0';
+            return int(p - buffer);
+        }
+    }
+
+    return int(p - buffer) + formatGeneric(value, p);
+}
+
+/*
+ * Returns the shortest string that reads back to \a value.
+ */
+QString xsdDoubleToString(double value)
+{
+    char buffer[XLSX_DOUBLE_BUFFER_SIZE];
+    int size = formatXsdDouble(value, buffer);
+    return QString::fromLatin1(buffer, size);
+}
+
+/*
+ * Parse the xsd:double in the UTF-8 (or Latin-1) \a data.
+ * Returns 0 and sets \a ok to false on failure.
+ */
+double parseXsdDouble(const char *data, int size, bool *ok)
+{
+    double value;
+    if (parseDoubleFast(data, data + size, &value)) {
+        if (ok)
+            *ok = true;
+        return value;
+    }
+
+    return QByteArray::fromRawData(data, size).trimmed().toDouble(ok);
+}
+
+/*
+ * \overload
+ */
+double parseXsdDouble(const QChar *data, int size, bool *ok)
+{
+    double value;
+    if (parseDoubleFast(data, data + size, &value)) {
+        if (ok)
+            *ok = true;
+        return value;
+    }
+
+    return QString::fromRawData(data, size).toDouble(ok);
+}
+
+/*
+ * \overload
+ */
+double parseXsdDouble(const QString &value, bool *ok)
+{
+    return parseXsdDouble(value.constData(), value.size(), ok);
+}
+
+QT_END_NAMESPACE_XLSX
@@ -27,6 +27,7 @@
 #include "xlsxutility_p.h"
 #include "xlsxformat_p.h"
 #include "xlsxcolor_p.h"
+#include "xlsxxmlemitter_p.h"
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QDir>
@@ -42,12 +43,20 @@ namespace QXlsx {
  *
  * In such case, the size of stringList will larger than stringTable.
  * Duplicated items can be removed once we loaded all the worksheets.
+ *
+ * The reference count of each item is kept in m_stringRefCounts, which
+ * is indexed in the same way as m_stringList. So when the worksheets
+ * are loaded, each shared string cell costs one integer increment only.
+ * The string -> index lookup table is only needed when new strings are
+ * added, so it is built lazily from m_stringList.
  */
 
 SharedStrings::SharedStrings(CreateFlag flag)
     :AbstractOOXmlFile(flag)
 {
     m_stringCount = 0;
+    m_stringTableDirty = false;
+    m_droppedCount = 0;
 }
 
 int SharedStrings::count() const
@@ -55,11 +64,34 @@ int SharedStrings::count() const
     return m_stringCount;
 }
 
+int SharedStrings::uniqueCount() const
+{
+    return m_stringList.size();
+}
+
 bool SharedStrings::isEmpty() const
 {
     return m_stringList.isEmpty();
 }
 
+/*
+ * Rebuild the lookup table from m_stringList if needed.
+ * For duplicated items, the first one wins.
+ */
+void SharedStrings::ensureStringTable() const
+{
+    if (!m_stringTableDirty)
+        return;
+
+    m_stringTable.clear();
+    m_stringTable.reserve(m_stringList.size());
+    for (int i=0; i<m_stringList.size(); ++i) {
+        if (!m_stringTable.contains(m_stringList[i]))
+            m_stringTable.insert(m_stringList[i], i);
+    }
+    m_stringTableDirty = false;
+}
+
 int SharedStrings::addSharedString(const QString &string)
 {
     return addSharedString(RichString(string));
@@ -67,17 +99,19 @@ int SharedStrings::addSharedString(const QString &string)
 
 int SharedStrings::addSharedString(const RichString &string)
 {
+    ensureStringTable();
     m_stringCount += 1;
 
-    if (m_stringTable.contains(string)) {
-        XlsxSharedStringInfo &item = m_stringTable[string];
-        item.count += 1;
-        return item.index;
+    QHash<RichString, int>::const_iterator it = m_stringTable.constFind(string);
+    if (it != m_stringTable.constEnd()) {
+        m_stringRefCounts[it.value()] += 1;
+        return it.value();
     }
 
     int index = m_stringList.size();
-    m_stringTable[string] = XlsxSharedStringInfo(index);
+    m_stringTable.insert(string, index);
     m_stringList.append(string);
+    m_stringRefCounts.append(1);
     return index;
 }
 
@@ -88,7 +122,53 @@ void SharedStrings::incRefByStringIndex(int idx)
         return;
     }
 
-    addSharedString(m_stringList[idx]);
+    m_stringCount += 1;
+    m_stringRefCounts[idx] += 1;
+}
+
+/*
+ * Drop the items which are not referenced any more, and renumber the
+ * remaining ones in one pass. The refCounts is indexed by the current
+ * string index, and replaces the reference counts tracked so far.
+ *
+ * As lookup always returns the first one of duplicated items, the other
+ * duplicated items are dropped too.
+ *
+ * Returns the number of the dropped items.
+ */
+int SharedStrings::compact(const QVector<int> &refCounts)
+{
+    QList<RichString> stringList;
+    QVector<int> stringRefCounts;
+    stringList.reserve(m_stringList.size());
+    stringRefCounts.reserve(m_stringList.size());
+
+    int stringCount = 0;
+    for (int i=0; i<m_stringList.size(); ++i) {
+        int refs = i < refCounts.size() ? refCounts[i] : 0;
+        if (refs <= 0)
+            continue;
+        stringList.append(m_stringList[i]);
+        stringRefCounts.append(refs);
+        stringCount += refs;
+    }
+
+    m_droppedCount = m_stringList.size() - stringList.size();
+    if (m_droppedCount > 0)
+        m_stringTableDirty = true;
+
+    m_stringList = stringList;
+    m_stringRefCounts = stringRefCounts;
+    m_stringCount = stringCount;
+    return m_droppedCount;
+}
+
+/*
+ * Returns the number of items dropped by the last compact().
+ */
+int SharedStrings::droppedCount() const
+{
+    return m_droppedCount;
 }
 
 /*
@@ -104,20 +184,19 @@ void SharedStrings::removeSharedString(const QString &string)
  */
 void SharedStrings::removeSharedString(const RichString &string)
 {
+    ensureStringTable();
     if (!m_stringTable.contains(string))
         return;
 
     m_stringCount -= 1;
 
-    XlsxSharedStringInfo &item = m_stringTable[string];
-    item.count -= 1;
-
-    if (item.count <= 0) {
-        for (int i=item.index+1; i<m_stringList.size(); ++i)
-            m_stringTable[m_stringList[i]].index -= 1;
+    int index = m_stringTable[string];
+    m_stringRefCounts[index] -= 1;
 
-        m_stringList.removeAt(item.index);
-        m_stringTable.remove(string);
+    if (m_stringRefCounts[index] <= 0) {
+        m_stringList.removeAt(index);
+        m_stringRefCounts.remove(index);
+        m_stringTableDirty = true;
     }
 }
 
@@ -128,9 +207,8 @@ int SharedStrings::getSharedStringIndex(const QString &string) const
 
 int SharedStrings::getSharedStringIndex(const RichString &string) const
 {
-    if (m_stringTable.contains(string))
-        return m_stringTable[string].index;
-    return -1;
+    ensureStringTable();
+    return m_stringTable.value(string, -1);
 }
 
 RichString SharedStrings::getSharedString(int index) const
@@ -210,52 +288,65 @@ void SharedStrings::writeRichStringPart_rPr(QXmlStreamWriter &writer, const Form
 
 void SharedStrings::saveToXmlFile(QIODevice *device) const
 {
-    QXmlStreamWriter writer(device);
+    XmlEmitter emitter(device);
 
+    ensureStringTable();
     if (m_stringList.size() != m_stringTable.size()) {
         //Duplicated string items exist in m_stringList
         //Clean up can not be done here, as the indices
         //have been used when we save the worksheets part.
     }
 
-    writer.writeStartDocument(QStringLiteral("1.0"), true);
-    writer.writeStartElement(QStringLiteral("sst"));
-    writer.writeAttribute(QStringLiteral("xmlns"), QStringLiteral("http://schemas.openxmlformats.org/spreadsheetml/2006/main"));
-    writer.writeAttribute(QStringLiteral("count"), QString::number(m_stringCount));
-    writer.writeAttribute(QStringLiteral("uniqueCount"), QString::number(m_stringList.size()));
+    //The output is the same as the one of QXmlStreamWriter
+    emitter.writeStartDocument();
+    emitter.writeRaw("<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"");
+    emitter.writeInteger(m_stringCount);
+    emitter.writeRaw("\" uniqueCount=\"");
+    emitter.writeInteger(m_stringList.size());
+    emitter.writeRaw("\">");
 
-    foreach (RichString string, m_stringList) {
-        writer.writeStartElement(QStringLiteral("si"));
+    for (int idx=0; idx<m_stringList.size(); ++idx) {
+        const RichString &string = m_stringList[idx];
         if (string.isRichString()) {
             //Rich text string
+            emitter.writeRaw("<si>");
             for (int i=0; i<string.fragmentCount(); ++i) {
-                writer.writeStartElement(QStringLiteral("r"));
-                if (string.fragmentFormat(i).hasFontData()) {
+                emitter.writeRaw("<r>");
+                Format format = string.fragmentFormat(i);
+                if (format.hasFontData()) {
+                    //Formatted runs are rare, let QXmlStreamWriter do the job
+                    QByteArray rPr;
+                    QBuffer buffer(&rPr);
+                    buffer.open(QIODevice::WriteOnly);
+                    QXmlStreamWriter writer(&buffer);
                     writer.writeStartElement(QStringLiteral("rPr"));
-                    writeRichStringPart_rPr(writer, string.fragmentFormat(i));
+                    writeRichStringPart_rPr(writer, format);
                     writer.writeEndElement();// rPr
+                    emitter.writeRaw(rPr);
                 }
-                writer.writeStartElement(QStringLiteral("t"));
-                if (isSpaceReserveNeeded(string.fragmentText(i)))
-                    writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-                writer.writeCharacters(string.fragmentText(i));
-                writer.writeEndElement();// t
-
-                writer.writeEndElement(); //r
+                writeTextElement(emitter, string.fragmentText(i));
+                emitter.writeRaw("</r>");
             }
+            emitter.writeRaw("</si>");
         } else {
-            writer.writeStartElement(QStringLiteral("t"));
-            QString pString = string.toPlainString();
-            if (isSpaceReserveNeeded(pString))
-                writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-            writer.writeCharacters(pString);
-            writer.writeEndElement();//t
+            emitter.writeRaw("<si>");
+            writeTextElement(emitter, string.toPlainString());
+            emitter.writeRaw("</si>");
         }
-        writer.writeEndElement();//si
     }
 
-    writer.writeEndElement(); //sst
-    writer.writeEndDocument();
+    emitter.writeRaw("</sst>");
+    emitter.flush();
+}
+
+void SharedStrings::writeTextElement(XmlEmitter &emitter, const QString &text) const
+{
+    if (isSpaceReserveNeeded(text))
+        emitter.writeRaw("<t xml:space=\"preserve\">");
+    else
+        emitter.writeRaw("<t>");
+    emitter.writeText(text);
+    emitter.writeRaw("</t>");
 }
 
 void SharedStrings::readString(QXmlStreamReader &reader)
@@ -274,9 +365,10 @@ void SharedStrings::readString(QXmlStreamReader &reader)
         }
     }
 
-    int idx = m_stringList.size();
-    m_stringTable[richString] = XlsxSharedStringInfo(idx, 0);
+    //The lookup table is rebuilt on demand, see ensureStringTable()
     m_stringList.append(richString);
+    m_stringRefCounts.append(0);
+    m_stringTableDirty = true;
 }
 
 void SharedStrings::readRichStringPart(QXmlStreamReader &reader, RichString &richString)
@@ -377,8 +469,11 @@ bool SharedStrings::loadFromXmlFile(QIODevice *device)
          if (token == QXmlStreamReader::StartElement) {
              if (reader.name() == QLatin1String("sst")) {
                  QXmlStreamAttributes attributes = reader.attributes();
-                 if ((hasUniqueCountAttr = attributes.hasAttribute(QLatin1String("uniqueCount"))))
+                 if ((hasUniqueCountAttr = attributes.hasAttribute(QLatin1String("uniqueCount")))) {
                      count = attributes.value(QLatin1String("uniqueCount")).toString().toInt();
+                     m_stringList.reserve(count);
+                     m_stringRefCounts.reserve(count);
+                 }
              } else if (reader.name() == QLatin1String("si")) {
                  readString(reader);
              }
@@ -390,10 +485,8 @@ bool SharedStrings::loadFromXmlFile(QIODevice *device)
         return false;
     }
 
-    if (m_stringList.size() != m_stringTable.size()) {
-        //qDebug("Warning: Duplicated items exist in shared string table.");
-        //Nothing we can do here, as indices of the strings will be used when loading sheets.
-    }
+    //Note that, duplicated items may exist in the shared string table.
+    //Nothing we can do here, as indices of the strings will be used when loading sheets.
 
     return true;
 }
@@ -0,0 +1,342 @@
+// xlsxsqliteimporter.cpp
+
+#include "xlsxsqliteimporter.h"
+#include "xlsxsqliteimporter_p.h"
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxcell.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QSqlQuery>
+#include <QVariant>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int defaultBatchSize = 10000;
+
+// Declared types of the columns, which give them the SQLite affinity
+// of their values. The dates are ISO 8601 texts, as the date and time
+// functions of SQLite take them.
+const char *sqlType(ColumnTyper::Type type)
+{
+	switch (type) {
+	case ColumnTyper::Integer:
+		return "INTEGER";
+	case ColumnTyper::Number:
+		return "REAL";
+	case ColumnTyper::DateTime:
+		return "DATETIME";
+	case ColumnTyper::Boolean:
+		return "BOOLEAN";
+	default:
+		return "TEXT";
+	}
+}
+
+} //namespace
+
+SqliteImporterPrivate::SqliteImporterPrivate(SqliteImporter *p, const QSqlDatabase &database)
+	: q_ptr(p), database(database), headerRow(true), batchSize(defaultBatchSize), replaceTables(false)
+{
+}
+
+/*
+ * Creates \a table and inserts the rows of \a range of \a sheet into
+ * it, batchSize rows a transaction.
+ */
+bool SqliteImporterPrivate::importRange(Worksheet *sheet, const QString &table, const CellRange &range)
+{
+	WorksheetPrivate *sd = sheet->d_func();
+	const CellRange r = range.isValid() ? range : sd->dimension;
+	if (!r.isValid())
+		return true;
+
+	const int firstDataRow = headerRow ? r.firstRow() + 1 : r.firstRow();
+	const int columnCount = r.columnCount();
+
+	ColumnTyper typer(sheet);
+	const bool date1904 = typer.isDate1904();
+	const QStringList names = typer.columnNames(r, headerRow);
+	const QVector<ColumnTyper::Type> types = typer.columnTypes(r, firstDataRow);
+
+	if (!database.transaction())
+		return fail(database.lastError());
+	if (!createTable(table, names, types))
+		return false;
+
+	QString sql = QLatin1String("INSERT INTO ") + quoted(table) + QLatin1String(" VALUES (");
+	for (int i = 0; i < columnCount; ++i)
+		sql += i ? QLatin1String(", ?") : QLatin1String("?");
+	sql += QLatin1Char(')');
+
+	QSqlQuery insert(database);
+	if (!insert.prepare(sql))
+		return fail(insert.lastError());
+
+	QVector<QVariant> values(columnCount);
+	int pending = 0;
+
+	typedef QMap<int, QSharedPointer<Cell> > CellRow;
+	QMap<int, CellRow>::const_iterator rowIt = sd->cellTable.lowerBound(firstDataRow);
+	for (; rowIt != sd->cellTable.constEnd() && rowIt.key() <= r.lastRow(); ++rowIt) {
+		values.fill(QVariant());
+		bool empty = true;
+
+		CellRow::const_iterator it = rowIt->lowerBound(r.firstColumn());
+		for (; it != rowIt->constEnd() && it.key() <= r.lastColumn(); ++it) {
+			const int i = it.key() - r.firstColumn();
+			const Cell *cell = it.value().data();
+			const FormulaValue value = FormulaEngine::valueOf(cell, date1904);
+			if (value.type == FormulaValue::Blank)
+				continue;
+
+			switch (types[i]) {
+			case ColumnTyper::Integer:
+				if (value.type == FormulaValue::Number)
+					values[i] = qint64(value.number);
+				break;
+			case ColumnTyper::Number:
+				if (value.type == FormulaValue::Number)
+					values[i] = value.number;
+				break;
+			case ColumnTyper::Boolean:
+				if (value.type == FormulaValue::Boolean)
+					values[i] = value.number != 0 ? 1 : 0;
+				break;
+			default:
+				values[i] = typer.textOf(cell, value);
+				break;
+			}
+			empty = false;
+		}
+
+		//Rows without any value in the range aren't inserted
+		if (empty)
+			continue;
+
+		for (int i = 0; i < columnCount; ++i)
+			insert.bindValue(i, values[i]);
+		if (!insert.exec())
+			return fail(insert.lastError());
+
+		if (++pending == batchSize) {
+			if (!database.commit() || !database.transaction())
+				return fail(database.lastError());
+			pending = 0;
+		}
+	}
+
+	if (!database.commit())
+		return fail(database.lastError());
+	return true;
+}
+
+/*
+ * Creates \a table with the columns \a names of \a types, in place of
+ * the existing table of that name if replaceTables is true.
+ */
+bool SqliteImporterPrivate::createTable(const QString &table, const QStringList &names, const QVector<ColumnTyper::Type> &types)
+{
+	QSqlQuery query(database);
+	if (replaceTables && !query.exec(QLatin1String("DROP TABLE IF EXISTS ") + quoted(table)))
+		return fail(query.lastError());
+
+	QString sql = QLatin1String("CREATE TABLE ") + quoted(table) + QLatin1String(" (");
+	for (int i = 0; i < names.size(); ++i) {
+		if (i)
+			sql += QLatin1String(", ");
+		sql += quoted(names[i]) + QLatin1Char(' ') + QLatin1String(sqlType(types[i]));
+	}
+	sql += QLatin1Char(')');
+
+	if (!query.exec(sql))
+		return fail(query.lastError());
+	return true;
+}
+
+/*
+ * Keeps \a error and rolls back the current transaction. Returns false.
+ */
+bool SqliteImporterPrivate::fail(const QSqlError &error)
+{
+	lastError = error;
+	database.rollback();
+	return false;
+}
+
+/*
+ * Returns \a identifier quoted as an SQL name.
+ */
+QString SqliteImporterPrivate::quoted(const QString &identifier)
+{
+	QString name = identifier;
+	name.replace(QLatin1Char('"'), QLatin1String("\"\""));
+	return QLatin1Char('"') + name + QLatin1Char('"');
+}
+
+/*!
+  \class SqliteImporter
+  \inmodule QtXlsx
+  \brief Loads the cells of worksheets into the tables of an SQLite database.
+
+  Each worksheet goes into a table of its own, created by the importer,
+  whose columns are named after the header row of the sheet. A column
+  whose values are all integers, numbers, dates or booleans is declared
+  INTEGER, REAL, DATETIME or BOOLEAN, any other column TEXT. Dates are
+  written as ISO 8601 texts, booleans as 0 and 1, and empty cells as
+  NULL.
+
+  The rows are inserted by a prepared statement, and committed by
+  transactions of batchSize() rows. If anything fails, the current
+  transaction is rolled back and lastError() tells why.
+
+  Only the bundled QSQLITE driver is needed:
+
+  \code
+  QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+  db.setDatabaseName("book.db");
+  db.open();
+
+  SqliteImporter importer(db);
+  importer.importDocument(&xlsx);
+  \endcode
+
+  The importer is only built when the Qt SQL module is available.
+*/
+
+/*!
+  Creates an importer into the open \a database.
+ */
+SqliteImporter::SqliteImporter(const QSqlDatabase &database)
+	: d_ptr(new SqliteImporterPrivate(this, database))
+{
+}
+
+/*!
+  Destroys the importer.
+ */
+SqliteImporter::~SqliteImporter()
+{
+	delete d_ptr;
+}
+
+/*!
+  Returns the database the sheets are imported into.
+ */
+QSqlDatabase SqliteImporter::database() const
+{
+	Q_D(const SqliteImporter);
+	return d->database;
+}
+
+/*!
+  Returns true if the first row of a sheet holds the names of the
+  columns, which is the default.
+ */
+bool SqliteImporter::hasHeaderRow() const
+{
+	Q_D(const SqliteImporter);
+	return d->headerRow;
+}
+
+/*!
+  Takes the names of the columns from the first row of the sheets if
+  \a header is true. Otherwise, and for the empty cells of the header
+  row, the columns are named after their letters.
+ */
+void SqliteImporter::setHeaderRow(bool header)
+{
+	Q_D(SqliteImporter);
+	d->headerRow = header;
+}
+
+/*!
+  Returns the number of rows inserted by a transaction. The default is
+  10000.
+ */
+int SqliteImporter::batchSize() const
+{
+	Q_D(const SqliteImporter);
+	return d->batchSize;
+}
+
+/*!
+  Sets the number of rows inserted by a transaction to \a rows.
+ */
+void SqliteImporter::setBatchSize(int rows)
+{
+	Q_D(SqliteImporter);
+	if (rows > 0)
+		d->batchSize = rows;
+}
+
+/*!
+  Returns true if the existing tables are dropped and created again.
+  By default the import of a sheet fails if its table exists.
+ */
+bool SqliteImporter::replacesTables() const
+{
+	Q_D(const SqliteImporter);
+	return d->replaceTables;
+}
+
+/*!
+  Drops the existing tables of the same names as the sheets imported
+  if \a replace is true.
+ */
+void SqliteImporter::setReplaceTables(bool replace)
+{
+	Q_D(SqliteImporter);
+	d->replaceTables = replace;
+}
+
+/*!
+  Imports the cells of \a sheet, or of its \a range only if it is
+  valid, into the new table \a table, named after the sheet if empty.
+
+  Returns false on failure, see lastError().
+ */
+bool SqliteImporter::importSheet(Worksheet *sheet, const QString &table, const CellRange &range)
+{
+	Q_D(SqliteImporter);
+	if (!sheet)
+		return false;
+
+	d->lastError = QSqlError();
+	return d->importRange(sheet, table.isEmpty() ? sheet->sheetName() : table, range);
+}
+
+/*!
+  Imports every worksheet of \a document into a table named after it.
+
+  Returns false on failure, see lastError(). The sheets imported
+  before stay in the database.
+ */
+bool SqliteImporter::importDocument(Document *document)
+{
+	if (!document)
+		return false;
+
+	foreach (const QString &name, document->sheetNames()) {
+		AbstractSheet *sheet = document->sheet(name);
+		if (!sheet || sheet->sheetType() != AbstractSheet::ST_WorkSheet)
+			continue;
+		if (!importSheet(static_cast<Worksheet *>(sheet), name))
+			return false;
+	}
+	return true;
+}
+
+/*!
+  Returns the error of the last import which failed.
+ */
+QSqlError SqliteImporter::lastError() const
+{
+	Q_D(const SqliteImporter);
+	return d->lastError;
+}
+
+QT_END_NAMESPACE_XLSX
@@ -27,6 +27,9 @@ WorkbookPrivate::WorkbookPrivate(Workbook *q, Workbook::CreateFlag flag) :
     sharedStrings = QSharedPointer<SharedStrings> (new SharedStrings(flag));
     styles = QSharedPointer<Styles>(new Styles(flag));
     theme = QSharedPointer<Theme>(new Theme(flag));
+    formulaEngine = QSharedPointer<FormulaEngine>(new FormulaEngine(q));
+    calcChain = QSharedPointer<CalcChain>(new CalcChain(flag));
+    indexedMediaFiles = 0;
 
     x_window = 240;
     y_window = 15;
@@ -37,6 +40,8 @@ WorkbookPrivate::WorkbookPrivate(Workbook *q, Workbook::CreateFlag flag) :
     strings_to_hyperlinks_enabled = true;
     html_to_richstring_enabled = false;
     date1904 = false;
+    formula_calculation_enabled = true;
+    calculation_thread_count = 1;
     defaultDateFormat = QStringLiteral("yyyy-mm-dd");
     activesheetIndex = 0;
     firstsheet = 0;
@@ -134,6 +139,61 @@ void Workbook::setDefaultDateFormat(const QString &format)
     d->defaultDateFormat = format;
 }
 
+bool Workbook::isFormulaCalculationEnabled() const
+{
+    Q_D(const Workbook);
+    return d->formula_calculation_enabled;
+}
+
+/*!
+  Enable the calculation of the formulas before the workbook is
+  saved, so that their values are stored in the file along with
+  the formulas, for the readers which don't calculate them.
+
+  The default is true
+ */
+void Workbook::setFormulaCalculationEnabled(bool enable)
+{
+    Q_D(Workbook);
+    d->formula_calculation_enabled = enable;
+}
+
+int Workbook::calculationThreadCount() const
+{
+    Q_D(const Workbook);
+    return d->calculation_thread_count;
+}
+
+/*!
+  Set the number of threads used to calculate the formulas to \a count,
+  0 meaning one per processor core. The results are the same whatever
+  the number of threads.
+
+  The default is 1
+ */
+void Workbook::setCalculationThreadCount(int count)
+{
+    Q_D(Workbook);
+    d->calculation_thread_count = qMax(count, 0);
+}
+
+/*!
+  Calculates the formulas whose value may have changed since the
+  last calculation, and returns their number. The results can then
+  be read with Cell::value().
+
+  Only the formulas depending on the cells written since then are
+  evaluated. The formulas loaded from a file keep the values calculated
+  by the application which saved it until one of their cells changes.
+  Formulas using functions the engine doesn't support keep their
+  value as well.
+ */
+int Workbook::recalculate()
+{
+    Q_D(Workbook);
+    return d->formulaEngine->recalculate();
+}
+
 /*!
  * \brief Create a defined name in the workbook.
  * \param name The defined name
@@ -306,6 +366,7 @@ bool Workbook::renameSheet(int index, const QString &newName)
 
     d->sheets[index]->setSheetName(name);
     d->sheetNames[index] = name;
+    d->formulaEngine->invalidate();
     return true;
 }
 
@@ -319,6 +380,7 @@ bool Workbook::deleteSheet(int index)
         return false;
     if (index < 0 || index >= d->sheets.size())
         return false;
+    d->formulaEngine->invalidate();
     d->sheets.removeAt(index);
     d->sheetNames.removeAt(index);
     return true;
@@ -551,6 +613,8 @@ void Workbook::saveToXmlFile(QIODevice *device) const
     d->relationships->addDocumentRelationship(QStringLiteral("/styles"), QStringLiteral("styles.xml"));
     if (!sharedStrings()->isEmpty())
         d->relationships->addDocumentRelationship(QStringLiteral("/sharedStrings"), QStringLiteral("sharedStrings.xml"));
+    if (!d->calcChain->isEmpty())
+        d->relationships->addDocumentRelationship(QStringLiteral("/calcChain"), QStringLiteral("calcChain.xml"));
 }
 
 bool Workbook::loadFromXmlFile(QIODevice *device)
@@ -691,9 +755,17 @@ void Workbook::addMediaFile(QSharedPointer<MediaFile> media, bool force)
 {
     Q_D(Workbook);
     if (!force) {
-        for (int i=0; i<d->mediaFiles.size(); ++i) {
-            if (d->mediaFiles[i]->hashKey() == media->hashKey()) {
-                media->setIndex(i);
+        //The files added since the last time are indexed now, as the
+        //loaded ones get their contents after they are added
+        for (; d->indexedMediaFiles < d->mediaFiles.size(); ++d->indexedMediaFiles) {
+            const int i = d->indexedMediaFiles;
+            d->mediaFileIndex.insert(d->mediaFiles[i]->hashKey(), i);
+        }
+
+        QMultiHash<uint, int>::const_iterator it = d->mediaFileIndex.constFind(media->hashKey());
+        for (; it != d->mediaFileIndex.constEnd() && it.key() == media->hashKey(); ++it) {
+            if (d->mediaFiles[it.value()]->contents() == media->contents()) {
+                media->setIndex(it.value());
                 return;
             }
         }
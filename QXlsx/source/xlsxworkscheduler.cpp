@@ -0,0 +1,205 @@
+// xlsxworkscheduler.cpp
+
+#include "xlsxworkscheduler_p.h"
+
+#include <QThread>
+#include <QMutexLocker>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+// Tasks taken from the own slice at once, to keep the locking cheap
+const int tasksPerTake = 16;
+
+} //namespace
+
+class WorkSchedulerThread : public QThread
+{
+public:
+    WorkSchedulerThread(WorkScheduler *scheduler, int index)
+        : m_scheduler(scheduler), m_index(index)
+    {
+    }
+
+protected:
+    void run()
+    {
+        m_scheduler->workerLoop(m_index);
+    }
+
+private:
+    WorkScheduler *m_scheduler;
+    int m_index;
+};
+
+/*!
+ * \internal
+ * \class WorkScheduler
+ *
+ * Starts \a threadCount - 1 threads, which wait for the batches given
+ * to run().
+ */
+WorkScheduler::WorkScheduler(int threadCount)
+    : m_task(0), m_generation(0), m_running(0), m_stopping(false)
+{
+    threadCount = qMax(threadCount, 1);
+    for (int i = 0; i < threadCount; ++i)
+        m_slices.append(new Slice);
+    for (int i = 1; i < threadCount; ++i) {
+        QThread *thread = new WorkSchedulerThread(this, i);
+        m_threads.append(thread);
+        thread->start();
+    }
+}
+
+WorkScheduler::~WorkScheduler()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_started.wakeAll();
+    }
+    for (int i = 0; i < m_threads.size(); ++i) {
+        m_threads[i]->wait();
+        delete m_threads[i];
+    }
+    qDeleteAll(m_slices);
+}
+
+/*
+ * Calls \a task for each number from 0 to \a count - 1, in any order and
+ * on any of the threads, and returns once they are all done.
+ */
+void WorkScheduler::run(int count, const std::function<void (int)> &task)
+{
+    if (count <= 0)
+        return;
+
+    const int threads = m_slices.size();
+    if (threads == 1) {
+        for (int i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        Slice *slice = m_slices[i];
+        QMutexLocker locker(&slice->mutex);
+        slice->begin = int(qint64(count) * i / threads);
+        slice->end = int(qint64(count) * (i + 1) / threads);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_task = &task;
+        m_running = m_threads.size();
+        ++m_generation;
+        m_started.wakeAll();
+    }
+
+    work(0);
+
+    QMutexLocker locker(&m_mutex);
+    while (m_running > 0)
+        m_finished.wait(&m_mutex);
+    m_task = 0;
+}
+
+void WorkScheduler::workerLoop(int self)
+{
+    int generation = 0;
+    forever {
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_generation == generation && !m_stopping)
+                m_started.wait(&m_mutex);
+            if (m_stopping)
+                return;
+            generation = m_generation;
+        }
+
+        work(self);
+
+        QMutexLocker locker(&m_mutex);
+        if (--m_running == 0)
+            m_finished.wakeAll();
+    }
+}
+
+/*
+ * Runs the tasks of the own slice, then the stolen ones, until there
+ * are no more tasks left to take.
+ */
+void WorkScheduler::work(int self)
+{
+    const std::function<void (int)> &task = *m_task;
+    int first;
+    int last;
+    forever {
+        while (take(self, &first, &last)) {
+            for (int i = first; i < last; ++i)
+                task(i);
+        }
+        if (!steal(self))
+            return;
+    }
+}
+
+bool WorkScheduler::take(int self, int *first, int *last)
+{
+    Slice *slice = m_slices[self];
+    QMutexLocker locker(&slice->mutex);
+    if (slice->begin >= slice->end)
+        return false;
+    *first = slice->begin;
+    *last = qMin(slice->begin + tasksPerTake, slice->end);
+    slice->begin = *last;
+    return true;
+}
+
+/*
+ * Moves the back half of the largest slice of the other threads to the
+ * slice of \a self. Returns false if no task is left to steal.
+ */
+bool WorkScheduler::steal(int self)
+{
+    const int threads = m_slices.size();
+    forever {
+        int victim = -1;
+        int largest = 0;
+        for (int i = 1; i < threads; ++i) {
+            const int candidate = (self + i) % threads;
+            Slice *slice = m_slices[candidate];
+            QMutexLocker locker(&slice->mutex);
+            const int remaining = slice->end - slice->begin;
+            if (remaining > largest) {
+                largest = remaining;
+                victim = candidate;
+            }
+        }
+        if (victim == -1)
+            return false;
+
+        int first;
+        int last;
+        {
+            Slice *slice = m_slices[victim];
+            QMutexLocker locker(&slice->mutex);
+            const int remaining = slice->end - slice->begin;
+            if (remaining <= 0)
+                continue; //taken meanwhile, look again
+            first = slice->end - (remaining + 1) / 2;
+            last = slice->end;
+            slice->end = first;
+        }
+
+        Slice *own = m_slices[self];
+        QMutexLocker locker(&own->mutex);
+        own->begin = first;
+        own->end = last;
+        return true;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
@@ -9,6 +9,7 @@
 #include <QRegularExpression>
 #include <QDebug>
 #include <QBuffer>
+#include <QImageReader>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QTextDocument>
@@ -16,6 +17,7 @@
 #include <QMapIterator>
 #include <QMap>
 
+#include <algorithm>
 #include <cmath>
 
 #include "xlsxrichstring.h"
@@ -23,9 +25,12 @@
 #include "xlsxworksheet.h"
 #include "xlsxworksheet_p.h"
 #include "xlsxworkbook.h"
+#include "xlsxworkbook_p.h"
 #include "xlsxformat.h"
 #include "xlsxformat_p.h"
 #include "xlsxutility_p.h"
+#include "xlsxnumericcodec_p.h"
+#include "xlsxxmlemitter_p.h"
 #include "xlsxsharedstrings_p.h"
 #include "xlsxdrawing_p.h"
 #include "xlsxstyles_p.h"
@@ -33,7 +38,13 @@
 #include "xlsxcell_p.h"
 #include "xlsxcellrange.h"
 #include "xlsxconditionalformatting_p.h"
+#include "xlsxdatavalidator_p.h"
 #include "xlsxdrawinganchor_p.h"
+#include "xlsxformatresolver_p.h"
+#include "xlsxcsvreader_p.h"
+#include "xlsxcsvwriter_p.h"
+#include "xlsxformulaengine_p.h"
+#include "xlsxconditionalformatevaluator_p.h"
 #include "xlsxchart.h"
 #include "xlsxcellformula.h"
 #include "xlsxcellformula_p.h"
@@ -54,6 +65,9 @@ WorksheetPrivate::WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag)
 
 	default_row_height = 15;
 	default_row_zeroed = false;
+
+	rowGeometryDirty = true;
+	columnGeometryDirty = true;
 }
 
 WorksheetPrivate::~WorksheetPrivate()
@@ -61,56 +75,28 @@ WorksheetPrivate::~WorksheetPrivate()
 }
 
 /*
-  Calculate the "spans" attribute of the <row> tag. This is an
-  XLSX optimisation and isn't strictly required. However, it
-  makes comparing files easier. The span is the same for each
-  block of 16 rows.
- */
-void WorksheetPrivate::calculateSpans() const
-{
-	row_spans.clear();
-	int span_min = XLSX_COLUMN_MAX+1;
-	int span_max = -1;
-
-	for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-		if (cellTable.contains(row_num)) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-				if (cellTable[row_num].contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
-		}
-		if (comments.contains(row_num)) {
-			for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-				if (comments[row_num].contains(col_num)) {
-					if (span_max == -1) {
-						span_min = col_num;
-						span_max = col_num;
-					} else {
-						if (col_num < span_min)
-							span_min = col_num;
-						else if (col_num > span_max)
-							span_max = col_num;
-					}
-				}
-			}
-		}
+  Store the cell, and keep the "spans" attribute of the <row> tag
+  up to date. This is an XLSX optimisation and isn't strictly
+  required. However, it makes comparing files easier. The span is
+  the same for each block of 16 rows.
 
-		if (row_num%16 == 0 || row_num == dimension.lastRow()) {
-			if (span_max != -1) {
-				row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-				span_min = XLSX_COLUMN_MAX+1;
-				span_max = -1;
-			}
-		}
+  The formulas which depend on the cell are marked for calculation.
+ */
+void WorksheetPrivate::setCell(int row, int col, const QSharedPointer<Cell> &cell)
+{
+	Q_Q(Worksheet);
+	cellTable[row][col] = cell;
+	workbook->d_func()->formulaEngine->cellChanged(q, row, col);
+
+	const int block = (row - 1) / 16;
+	QMap<int, QPair<int, int> >::iterator it = row_spans.find(block);
+	if (it == row_spans.end()) {
+		row_spans.insert(block, qMakePair(col, col));
+	} else {
+		if (col < it->first)
+			it->first = col;
+		if (col > it->second)
+			it->second = col;
 	}
 }
 
@@ -156,6 +142,16 @@ int WorksheetPrivate::checkDimensions(int row, int col, bool ignore_row, bool ig
   \brief Represent one worksheet in the workbook.
 */
 
+/*!
+  \enum Worksheet::AggregateOperation
+
+  \value AO_Sum
+  \value AO_Average
+  \value AO_Min
+  \value AO_Max
+  \value AO_Count Number of the cells holding a number.
+*/
+
 /*!
  * \internal
  */
@@ -195,11 +191,12 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
 			if (cell->cellType() == Cell::SharedStringType)
 				d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
 
-			sheet_d->cellTable[row][col] = cell;
+			sheet_d->setCell(row, col, cell);
 		}
 	}
 
-	sheet_d->merges = d->merges;
+	foreach (const CellRange &range, d->merges)
+		sheet_d->appendMerge(range);
 //    sheet_d->rowsInfo = d->rowsInfo;
 //    sheet_d->colsInfo = d->colsInfo;
 //    sheet_d->colsInfoHelper = d->colsInfoHelper;
@@ -541,8 +538,11 @@ QVariant Worksheet::read(int row, int column) const
                 int si = cell->formula().sharedIndex();
                 const CellFormula &rootFormula = d->sharedFormulaMap[ si ];
 				CellReference rootCellRef = rootFormula.reference().topLeft();
-				QString rootFormulaText = rootFormula.formulaText();
-				QString newFormulaText = convertSharedFormula(rootFormulaText, rootCellRef, CellReference(row, column));
+				QString newFormulaText;
+				if (rootFormula.isValid() && rootFormula.d->expression().isValid())
+					newFormulaText = rootFormula.d->expression().offsetReferences(row - rootCellRef.row(), column - rootCellRef.column());
+				else
+					newFormulaText = convertSharedFormula(rootFormula.formulaText(), rootCellRef, CellReference(row, column));
 				return QVariant(QLatin1String("=")+newFormulaText);
 			}
 		}
@@ -634,7 +634,7 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
 	d->workbook->styles()->addXfFormat(fmt);
 	QSharedPointer<Cell> cell = QSharedPointer<Cell>(new Cell(value.toPlainString(), Cell::SharedStringType, fmt, this));
 	cell->d_ptr->richString = value;
-	d->cellTable[row][column] = cell;
+	d->setCell(row, column, cell);
 	return true;
 }
 
@@ -702,7 +702,7 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::InlineStringType, fmt, this)));
 	return true;
 }
 
@@ -731,7 +731,7 @@ bool Worksheet::writeNumeric(int row, int column, double value, const Format &fo
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this)));
 	return true;
 }
 
@@ -778,7 +778,7 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 
 	QSharedPointer<Cell> data = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
 	data->d_ptr->formula = formula;
-	d->cellTable[row][column] = data;
+	d->setCell(row, column, data);
 
 	CellRange range = formula.reference();
 	if (formula.formulaType() == CellFormula::SharedType) {
@@ -789,10 +789,11 @@ bool Worksheet::writeFormula(int row, int column, const CellFormula &formula_, c
 				if (!(r==row && c==column)) {
 					if(Cell *cell = cellAt(r, c)) {
 						cell->d_ptr->formula = sf;
+						d->workbook->d_func()->formulaEngine->cellChanged(this, r, c);
 					} else {
 						QSharedPointer<Cell> newCell = QSharedPointer<Cell>(new Cell(result, Cell::NumberType, fmt, this));
 						newCell->d_ptr->formula = sf;
-						d->cellTable[r][c] = newCell;
+						d->setCell(r, c, newCell);
 					}
 				}
 			}
@@ -831,7 +832,7 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
 	d->workbook->styles()->addXfFormat(fmt);
 
 	//Note: NumberType with an invalid QVariant value means blank.
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(QVariant(), Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -860,7 +861,7 @@ bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 
 	Format fmt = format.isValid() ? format : d->cellFormat(row, column);
 	d->workbook->styles()->addXfFormat(fmt);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::BooleanType, fmt, this)));
 
 	return true;
 }
@@ -894,7 +895,7 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
 	double value = datetimeToNumber(dt, d->workbook->isDate1904());
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(value, Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -927,7 +928,7 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
 		fmt.setNumberFormat(QStringLiteral("hh:mm:ss"));
 	d->workbook->styles()->addXfFormat(fmt);
 
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(timeToNumber(t), Cell::NumberType, fmt, this)));
 
 	return true;
 }
@@ -992,7 +993,7 @@ bool Worksheet::writeHyperlink(int row, int column, const QUrl &url, const Forma
 
 	//Write the hyperlink string as normal string.
 	d->sharedStrings()->addSharedString(displayString);
-	d->cellTable[row][column] = QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this));
+	d->setCell(row, column, QSharedPointer<Cell>(new Cell(displayString, Cell::SharedStringType, fmt, this)));
 
 	//Store the hyperlink data in a separate table
 	d->urlTable[row][column] = QSharedPointer<XlsxHyperlinkData>(new XlsxHyperlinkData(XlsxHyperlinkData::External, urlString, locationString, QString(), tip));
@@ -1010,7 +1011,7 @@ bool Worksheet::addDataValidation(const DataValidation &validation)
 	if (validation.ranges().isEmpty() || validation.validationType()==DataValidation::None)
 		return false;
 
-	d->dataValidationsList.append(validation);
+	d->appendDataValidation(validation);
 	return true;
 }
 
@@ -1030,7 +1031,7 @@ bool Worksheet::addConditionalFormatting(const ConditionalFormatting &cf)
 			d->workbook->styles()->addDxfFormat(rule->dxfFormat);
 		rule->priority = 1;
 	}
-	d->conditionalFormattingList.append(cf);
+	d->appendConditionalFormatting(cf);
 	return true;
 }
 
@@ -1062,6 +1063,52 @@ bool Worksheet::insertImage(int row, int column, const QImage &image)
 	return true;
 }
 
+/*!
+ * \overload
+ * Insert an image encoded as \a data, of the given \a mimeType such as
+ * "image/png" or "image/jpeg", at the position \a row, \a column.
+ * The data is stored as it is, only its header is read for the size
+ * of the image.
+ * Returns true on success.
+ */
+bool Worksheet::insertImage(int row, int column, const QByteArray &data, const QString &mimeType)
+{
+	Q_D(Worksheet);
+
+	static const char *const types[][2] = {
+		{ "image/png", "png" },
+		{ "image/jpeg", "jpeg" },
+		{ "image/gif", "gif" },
+		{ "image/bmp", "bmp" },
+		{ "image/tiff", "tiff" }
+	};
+	QString suffix;
+	for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+		if (mimeType == QLatin1String(types[i][0]))
+			suffix = QLatin1String(types[i][1]);
+	}
+	if (suffix.isEmpty() || data.isEmpty())
+		return false;
+
+	QBuffer buffer;
+	buffer.setData(data);
+	buffer.open(QIODevice::ReadOnly);
+	QImageReader reader(&buffer, suffix.toLatin1());
+	const QSize size = reader.size();
+	if (!size.isValid())
+		return false;
+
+	if (!d->drawing)
+		d->drawing = QSharedPointer<Drawing>(new Drawing(this, F_NewFromScratch));
+
+	DrawingOneCellAnchor *anchor = new DrawingOneCellAnchor(d->drawing.data(), DrawingAnchor::Picture);
+	anchor->from = XlsxMarker(row, column, 0, 0);
+	anchor->ext = size * 9525;
+
+	anchor->setObjectPicture(data, suffix, mimeType);
+	return true;
+}
+
 /*!
  * Creates an chart with the given \a size and insert
  * at the position \a row, \a column.
@@ -1106,6 +1153,9 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
 	if (d->checkDimensions(range.firstRow(), range.firstColumn()))
 		return false;
 
+	if (d->mergeIndex.intersects(range))
+		return false;
+
 	if (format.isValid())
 		d->workbook->styles()->addXfFormat(format);
 
@@ -1125,7 +1175,7 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
 		}
 	}
 
-	d->merges.append(range);
+	d->appendMerge(range);
 	return true;
 }
 
@@ -1136,10 +1186,24 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
 bool Worksheet::unmergeCells(const CellRange &range)
 {
 	Q_D(Worksheet);
-	if (!d->merges.contains(range))
+	const QVector<int> candidates = d->mergeIndex.find(range);
+	int index = -1;
+	for (int i = 0; i < candidates.size(); ++i) {
+		if (d->merges[candidates[i]] == range && (index == -1 || candidates[i] < index))
+			index = candidates[i];
+	}
+	if (index == -1)
 		return false;
 
-	d->merges.removeOne(range);
+	//The last merge takes the place of the removed one
+	const int last = d->merges.size() - 1;
+	d->mergeIndex.remove(range, index);
+	if (index != last) {
+		d->mergeIndex.remove(d->merges[last], last);
+		d->mergeIndex.insert(d->merges[last], index);
+		d->merges[index] = d->merges[last];
+	}
+	d->merges.removeLast();
 	return true;
 }
 
@@ -1152,6 +1216,81 @@ QList<CellRange> Worksheet::mergedCells() const
 	return d->merges;
 }
 
+/*!
+  Returns the merged range which contains the cell at \a row and \a column,
+  or an invalid range if the cell is not merged.
+*/
+CellRange Worksheet::mergedRangeAt(int row, int column) const
+{
+	Q_D(const Worksheet);
+	const QVector<int> found = d->mergeIndex.find(row, column);
+	if (found.isEmpty())
+		return CellRange();
+	return d->merges[*std::min_element(found.begin(), found.end())];
+}
+
+/*!
+  Returns the conditional formattings which apply to the cell at \a row
+  and \a column, in the order they were added to the sheet.
+*/
+QList<ConditionalFormatting> Worksheet::conditionalFormatsAt(int row, int column) const
+{
+	Q_D(const Worksheet);
+	QVector<int> found = d->conditionalFormattingIndex.find(row, column);
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+
+	QList<ConditionalFormatting> formattings;
+	for (int i = 0; i < found.size(); ++i)
+		formattings.append(d->conditionalFormattingList[found[i]]);
+	return formattings;
+}
+
+/*!
+  Returns the data validations which apply to the cell at \a row and
+  \a column, in the order they were added to the sheet.
+*/
+QList<DataValidation> Worksheet::dataValidationsAt(int row, int column) const
+{
+	Q_D(const Worksheet);
+	QVector<int> found = d->dataValidationIndex.find(row, column);
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+
+	QList<DataValidation> validations;
+	for (int i = 0; i < found.size(); ++i)
+		validations.append(d->dataValidationsList[found[i]]);
+	return validations;
+}
+
+/*!
+  Checks the cells covered by the data validations of the sheet, and
+  returns the cells which break them, row by row, each with the
+  validation it breaks. Empty cells only break the validations which
+  don't allow blanks, and are only looked for within dimension().
+
+  The cells are seen with their cached values, so formulas should be
+  calculated first.
+*/
+QList<QPair<CellReference, DataValidation> > Worksheet::validateData() const
+{
+	Q_D(const Worksheet);
+	QList<QPair<CellReference, DataValidation> > errors;
+	if (d->dataValidationsList.isEmpty())
+		return errors;
+
+	DataValidator validator(const_cast<Worksheet *>(this), d->workbook->d_func()->formulaEngine.data(),
+							d->dataValidationsList, d->dataValidationIndex);
+	const QVector<DataValidator::Violation> violations = validator.validate();
+	errors.reserve(violations.size());
+	for (int i = 0; i < violations.size(); ++i) {
+		const DataValidator::Violation &violation = violations[i];
+		errors.append(qMakePair(CellReference(violation.row, violation.column),
+								d->dataValidationsList[violation.validation]));
+	}
+	return errors;
+}
+
 /*!
  * \internal
  */
@@ -1202,11 +1341,18 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 	writer.writeEndElement();//sheetView
 	writer.writeEndElement();//sheetViews
 
+	//Properties set on all the rows at once are written as the defaults
+	//of the rows, instead of a <row> for each of the 1048576 rows
+	const XlsxRowInfo *rowDefaults = d->defaultRowInfo();
+
 	writer.writeStartElement(QStringLiteral("sheetFormatPr"));
-	writer.writeAttribute(QStringLiteral("defaultRowHeight"), QString::number(d->default_row_height));
-	if (d->default_row_height != 15)
+	//15 points is the height Excel gives the rows of its default font,
+	//Calibri 11, so only other heights are custom
+	const double defaultRowHeight = rowDefaults && rowDefaults->customHeight ? rowDefaults->height : d->default_row_height;
+	writer.writeAttribute(QStringLiteral("defaultRowHeight"), QString::number(defaultRowHeight));
+	if (defaultRowHeight != 15)
 		writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("1"));
-	if (d->default_row_zeroed)
+	if (d->default_row_zeroed || (rowDefaults && rowDefaults->hidden))
 		writer.writeAttribute(QStringLiteral("zeroHeight"), QStringLiteral("1"));
 	if (d->outline_row_level)
 		writer.writeAttribute(QStringLiteral("outlineLevelRow"), QString::number(d->outline_row_level));
@@ -1216,28 +1362,52 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 	//    writer.writeAttribute("x14ac:dyDescent", "0.25");
 	writer.writeEndElement();//sheetFormatPr
 
-    if (!d->colsInfo.isEmpty())
+	//<sheetFormatPr> has no style, so the format of all the rows goes to
+	//all the columns, which defaultRowInfo() checks have none of their own
+	const Format rowDefaultFormat = rowDefaults ? rowDefaults->format : Format();
+    if (!d->colsInfo.isEmpty() || !rowDefaultFormat.isEmpty())
     {
+		//One <col> for each run of columns with the same properties, and
+		//for the columns between them if they take the format of the rows
 		writer.writeStartElement(QStringLiteral("cols"));
-		QMapIterator<int, QSharedPointer<XlsxColumnInfo> > it(d->colsInfo);
-        while (it.hasNext())
+		int nextColumn = 1;
+		IntervalMap<XlsxColumnInfo>::const_iterator it = d->colsInfo.constBegin();
+		while (it != d->colsInfo.constEnd() || (!rowDefaultFormat.isEmpty() && nextColumn <= XLSX_COLUMN_MAX))
         {
-			it.next();
-			QSharedPointer<XlsxColumnInfo> col_info = it.value();
+			XlsxColumnInfo col_info;
+			int first;
+			int last;
+			bool gap = false;
+			if (it != d->colsInfo.constEnd() && (rowDefaultFormat.isEmpty() || it->first == nextColumn)) {
+				first = it->first;
+				last = it->last;
+				col_info = it->value;
+				++it;
+			} else {
+				first = nextColumn;
+				last = it != d->colsInfo.constEnd() ? it->first - 1 : XLSX_COLUMN_MAX;
+				gap = true;
+			}
+			nextColumn = last + 1;
+			if (col_info.format.isEmpty())
+				col_info.format = rowDefaultFormat;
+
 			writer.writeStartElement(QStringLiteral("col"));
-			writer.writeAttribute(QStringLiteral("min"), QString::number(col_info->firstColumn));
-			writer.writeAttribute(QStringLiteral("max"), QString::number(col_info->lastColumn));
-			if (col_info->width)
-				writer.writeAttribute(QStringLiteral("width"), QString::number(col_info->width, 'g', 15));
-			if (!col_info->format.isEmpty())
-				writer.writeAttribute(QStringLiteral("style"), QString::number(col_info->format.xfIndex()));
-			if (col_info->hidden)
+			writer.writeAttribute(QStringLiteral("min"), QString::number(first));
+			writer.writeAttribute(QStringLiteral("max"), QString::number(last));
+			if (col_info.width)
+				writer.writeAttribute(QStringLiteral("width"), QString::number(col_info.width, 'g', 15));
+			else if (gap)
+				writer.writeAttribute(QStringLiteral("width"), QString::number(d->sheetFormatProps.defaultColWidth, 'g', 15));
+			if (!col_info.format.isEmpty())
+				writer.writeAttribute(QStringLiteral("style"), QString::number(col_info.format.xfIndex()));
+			if (col_info.hidden)
 				writer.writeAttribute(QStringLiteral("hidden"), QStringLiteral("1"));
-			if (col_info->width)
+			if (col_info.width)
 				writer.writeAttribute(QStringLiteral("customWidth"), QStringLiteral("1"));
-			if (col_info->outlineLevel)
-				writer.writeAttribute(QStringLiteral("outlineLevel"), QString::number(col_info->outlineLevel));
-			if (col_info->collapsed)
+			if (col_info.outlineLevel)
+				writer.writeAttribute(QStringLiteral("outlineLevel"), QString::number(col_info.outlineLevel));
+			if (col_info.collapsed)
 				writer.writeAttribute(QStringLiteral("collapsed"), QStringLiteral("1"));
 			writer.writeEndElement();//col
 		}
@@ -1352,95 +1522,204 @@ bool Worksheet::setStartPage(int spagen)
 }
 //}}
 
-void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
+namespace {
+
+void writeTextElement(XmlEmitter &emitter, const QString &text)
 {
-	calculateSpans();
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++)
-    {
-        if (!(cellTable.contains(row_num) || comments.contains(row_num) || rowsInfo.contains(row_num)))
-        {
-			//Only process rows with cell data / comments / formatting
-			continue;
-		}
+	if (isSpaceReserveNeeded(text))
+		emitter.writeRaw("<t xml:space=\"preserve\">");
+	else
+		emitter.writeRaw("<t>");
+	emitter.writeText(text);
+	emitter.writeRaw("</t>");
+}
 
-		int span_index = (row_num-1) / 16;
-		QString span;
-		if (row_spans.contains(span_index))
-			span = row_spans[span_index];
+/*
+  Attributes of the <row> tag for the row properties \a info, the same
+  for all the rows of a run.
+ */
+QByteArray rowInfoXmlAttributes(const XlsxRowInfo &info)
+{
+	QByteArray attributes;
+	if (!info.format.isEmpty()) {
+		attributes += " s=\"";
+		attributes += QByteArray::number(info.format.xfIndex());
+		attributes += "\" customFormat=\"1\"";
+	}
 
-		writer.writeStartElement(QStringLiteral("row"));
-		writer.writeAttribute(QStringLiteral("r"), QString::number(row_num));
+	if (info.customHeight) {
+		attributes += " ht=\"";
+		attributes += QString::number(info.height).toLatin1();
+		attributes += "\" customHeight=\"1\"";
+	} else {
+		attributes += " customHeight=\"0\"";
+	}
 
-		if (!span.isEmpty())
-			writer.writeAttribute(QStringLiteral("spans"), span);
+	if (info.hidden)
+		attributes += " hidden=\"1\"";
+	if (info.outlineLevel > 0) {
+		attributes += " outlineLevel=\"";
+		attributes += QByteArray::number(info.outlineLevel);
+		attributes += "\"";
+	}
+	if (info.collapsed)
+		attributes += " collapsed=\"1\"";
+	return attributes;
+}
 
-        if (rowsInfo.contains(row_num))
-        {
-			QSharedPointer<XlsxRowInfo> rowInfo = rowsInfo[row_num];
-            if (!rowInfo->format.isEmpty())
-            {
-				writer.writeAttribute(QStringLiteral("s"), QString::number(rowInfo->format.xfIndex()));
-				writer.writeAttribute(QStringLiteral("customFormat"), QStringLiteral("1"));
-			}
+} //namespace
 
-			//!Todo: support customHeight from info struct
-			//!Todo: where does this magic number '15' come from?
-			if (rowInfo->customHeight) {
-				writer.writeAttribute(QStringLiteral("ht"), QString::number(rowInfo->height));
-				writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("1"));
-			} else {
-				writer.writeAttribute(QStringLiteral("customHeight"), QStringLiteral("0"));
-			}
+/*
+  Returns the properties of all the rows if they are the same for the
+  whole sheet, and can be written as the defaults of the rows by
+  <sheetFormatPr> and <cols>: neither the outline nor the collapsed
+  state, which only <row> holds, and a format only if no column has one
+  of its own, as the row format comes before the column format.
+ */
+const XlsxRowInfo *WorksheetPrivate::defaultRowInfo() const
+{
+	if (rowsInfo.runCount() != 1)
+		return 0;
+	IntervalMap<XlsxRowInfo>::const_iterator run = rowsInfo.constBegin();
+	if (run->first != 1 || run->last != XLSX_ROW_MAX)
+		return 0;
 
-			if (rowInfo->hidden)
-				writer.writeAttribute(QStringLiteral("hidden"), QStringLiteral("1"));
-			if (rowInfo->outlineLevel > 0)
-				writer.writeAttribute(QStringLiteral("outlineLevel"), QString::number(rowInfo->outlineLevel));
-			if (rowInfo->collapsed)
-				writer.writeAttribute(QStringLiteral("collapsed"), QStringLiteral("1"));
+	const XlsxRowInfo &info = run->value;
+	if (info.outlineLevel > 0 || info.collapsed)
+		return 0;
+	if (!info.format.isEmpty()) {
+		IntervalMap<XlsxColumnInfo>::const_iterator it = colsInfo.constBegin();
+		for (; it != colsInfo.constEnd(); ++it) {
+			if (!it->value.format.isEmpty())
+				return 0;
+		}
+	}
+	return &info;
+}
+
+void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
+{
+	//The rows are written to the device directly. This is safe, as
+	//QXmlStreamWriter doesn't buffer anything.
+	Q_ASSERT(writer.device());
+	XmlEmitter emitter(writer.device());
+	bool sheetDataOpened = false;
+	const SharedFormulaRuns sharedRuns = findSharedFormulaRuns();
+	FormatResolver formats(rowsInfo, colsInfo);
+
+	//Only process rows with cell data / comments / formatting, so walk the
+	//three maps side by side instead of probing each row of the dimension.
+	const int firstRow = dimension.firstRow();
+	const int lastRow = dimension.lastRow();
+	const int firstColumn = dimension.firstColumn();
+	const int lastColumn = dimension.lastColumn();
+
+	QMap<int, QMap<int, QSharedPointer<Cell> > >::const_iterator cellIt = cellTable.lowerBound(firstRow);
+	QMap<int, QMap<int, QString> >::const_iterator commentIt = comments.lowerBound(firstRow);
+	//Rows of the defaults of Worksheet::saveToXmlFile() have no attributes
+	IntervalMap<XlsxRowInfo>::const_iterator rowInfoIt = defaultRowInfo() ? rowsInfo.constEnd() : rowsInfo.lowerBound(firstRow);
+	int rowInfoRow = 0; //next row of the run to write
+	QByteArray rowInfoAttributes; //attributes shared by the rows of the run
+	if (rowInfoIt != rowsInfo.constEnd())
+		rowInfoRow = qMax(rowInfoIt->first, firstRow);
+
+	forever {
+		int row_num = lastRow + 1;
+		if (cellIt != cellTable.constEnd())
+			row_num = qMin(row_num, cellIt.key());
+		if (commentIt != comments.constEnd())
+			row_num = qMin(row_num, commentIt.key());
+		if (rowInfoIt != rowsInfo.constEnd())
+			row_num = qMin(row_num, rowInfoRow);
+		if (row_num > lastRow)
+			break;
+
+		const bool hasCells = cellIt != cellTable.constEnd() && cellIt.key() == row_num;
+		const bool hasRowInfo = rowInfoIt != rowsInfo.constEnd() && rowInfoRow == row_num;
+		if (commentIt != comments.constEnd() && commentIt.key() == row_num)
+			++commentIt;
+
+		if (!sheetDataOpened) {
+			//Finish the <sheetData> start tag
+			writer.writeCharacters(QString());
+			sheetDataOpened = true;
+		}
+
+		emitter.writeRaw("<row r=\"");
+		emitter.writeInteger(row_num);
+		emitter.writeRaw("\"");
+
+		QMap<int, QPair<int, int> >::const_iterator spanIt = row_spans.constFind((row_num-1) / 16);
+		if (spanIt != row_spans.constEnd()) {
+			emitter.writeRaw(" spans=\"");
+			emitter.writeInteger(spanIt->first);
+			emitter.writeRaw(":");
+			emitter.writeInteger(spanIt->second);
+			emitter.writeRaw("\"");
+		}
+
+        if (hasRowInfo)
+        {
+			if (rowInfoRow == qMax(rowInfoIt->first, firstRow))
+				rowInfoAttributes = rowInfoXmlAttributes(rowInfoIt->value);
+			emitter.writeRaw(rowInfoAttributes);
 		}
 
 		//Write cell data if row contains filled cells
-        if (cellTable.contains(row_num))
+		bool rowHasCells = false;
+        if (hasCells)
         {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++)
+			const QMap<int, QSharedPointer<Cell> > &rowCells = cellIt.value();
+			QMap<int, QSharedPointer<Cell> >::const_iterator it = rowCells.lowerBound(firstColumn);
+            for (; it != rowCells.constEnd() && it.key() <= lastColumn; ++it)
             {
-                if (cellTable[row_num].contains(col_num))
-                {
-					saveXmlCellData(writer, row_num, col_num, cellTable[row_num][col_num]);
+				if (!rowHasCells) {
+					emitter.writeRaw(">");
+					rowHasCells = true;
+				}
+				const CellFormula *formula = &it.value()->d_ptr->formula;
+				SharedFormulaRuns::const_iterator runs = sharedRuns.constFind(it.key());
+				if (runs != sharedRuns.constEnd()) {
+					//Last run starting at or above the row
+					QVector<SharedFormulaRun>::const_iterator run = std::upper_bound(runs->constBegin(), runs->constEnd(), row_num,
+						[](int row, const SharedFormulaRun &run) { return row < run.firstRow; });
+					if (run != runs->constBegin() && (--run)->lastRow >= row_num)
+						formula = run->firstRow == row_num ? &run->master : &run->child;
 				}
+				saveXmlCellData(emitter, row_num, it.key(), it.value(), *formula,
+								formats.format(row_num, it.key(), it.value()->format()));
 			}
+			++cellIt;
 		}
-		writer.writeEndElement(); //row
+		if (hasRowInfo && ++rowInfoRow > rowInfoIt->last) {
+			++rowInfoIt;
+			if (rowInfoIt != rowsInfo.constEnd())
+				rowInfoRow = rowInfoIt->first;
+		}
+
+		if (rowHasCells)
+			emitter.writeRaw("</row>");
+		else
+			emitter.writeRaw("/>");
 	}
+
+	emitter.flush();
 }
 
-void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int col, QSharedPointer<Cell> cell) const
+void WorksheetPrivate::saveXmlCellData(XmlEmitter &emitter, int row, int col, const QSharedPointer<Cell> &cell, const CellFormula &formula, const Format &format) const
 {
 	//This is the innermost loop so efficiency is important.
-	QString cell_pos = CellReference(row, col).toString();
-
-	writer.writeStartElement(QStringLiteral("c"));
-	writer.writeAttribute(QStringLiteral("r"), cell_pos);
+	//The output must stay the same as the one of QXmlStreamWriter.
+	emitter.writeRaw("<c r=\"");
+	emitter.writeCellReference(row, col);
+	emitter.writeRaw("\"");
 
 	//Style used by the cell, row or col
-	if (!cell->format().isEmpty())
-		writer.writeAttribute(QStringLiteral("s"), QString::number(cell->format().xfIndex()));
-	else if (rowsInfo.contains(row) && !rowsInfo[row]->format.isEmpty())
-		writer.writeAttribute(QStringLiteral("s"), QString::number(rowsInfo[row]->format.xfIndex()));
-	else if (colsInfoHelper.contains(col) && !colsInfoHelper[col]->format.isEmpty())
-		writer.writeAttribute(QStringLiteral("s"), QString::number(colsInfoHelper[col]->format.xfIndex()));
-
-    // [debugging code] dev34
-    /*
-    if (cell->hasFormula())
-    {
-        int si = cell->formula().d->si;
-        QString strFormula = cell->formula().d->formula;
-
-        // qDebug() << "[hasFormula] cell type " << cell->cellType() ;
-    }
-    */
+	if (!format.isEmpty()) {
+		emitter.writeRaw(" s=\"");
+		emitter.writeInteger(format.xfIndex());
+		emitter.writeRaw("\"");
+	}
 
     if (cell->cellType() == Cell::SharedStringType) // 's'
     {
@@ -1450,115 +1729,223 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer, int row, int co
 		else
 			sst_idx = sharedStrings()->getSharedStringIndex(cell->value().toString());
 
-		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("s"));
-		writer.writeTextElement(QStringLiteral("v"), QString::number(sst_idx));
+		emitter.writeRaw(" t=\"s\"><v>");
+		emitter.writeInteger(sst_idx);
+		emitter.writeRaw("</v></c>");
     }
     else if (cell->cellType() == Cell::InlineStringType) // 'inlineStr'
     {
-		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("inlineStr"));
-		writer.writeStartElement(QStringLiteral("is"));
+		emitter.writeRaw(" t=\"inlineStr\"><is>");
 		if (cell->isRichString()) {
 			//Rich text string
 			RichString string = cell->d_ptr->richString;
             for (int i=0; i<string.fragmentCount(); ++i)
             {
-				writer.writeStartElement(QStringLiteral("r"));
+				emitter.writeRaw("<r>");
                 if (string.fragmentFormat(i).hasFontData())
                 {
-					writer.writeStartElement(QStringLiteral("rPr"));
 					//:Todo
-					writer.writeEndElement();// rPr
+					emitter.writeRaw("<rPr/>");
 				}
-				writer.writeStartElement(QStringLiteral("t"));
-				if (isSpaceReserveNeeded(string.fragmentText(i)))
-					writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-				writer.writeCharacters(string.fragmentText(i));
-				writer.writeEndElement();// t
-				writer.writeEndElement(); // r
+				writeTextElement(emitter, string.fragmentText(i));
+				emitter.writeRaw("</r>");
 			}
         }
         else
         {
-			writer.writeStartElement(QStringLiteral("t"));
-			QString string = cell->value().toString();
-			if (isSpaceReserveNeeded(string))
-				writer.writeAttribute(QStringLiteral("xml:space"), QStringLiteral("preserve"));
-			writer.writeCharacters(string);
-			writer.writeEndElement(); // t
-		}
-		writer.writeEndElement();//is
-    }
-    else if (cell->cellType() == Cell::NumberType) // 'n'
-    {
-        if (cell->hasFormula())
-        {
-            int si = cell->formula().d->si;
-            QString strFormula = cell->formula().d->formula;
-
-            cell->formula().saveToXml(writer);
-        }
-
-        if (cell->value().isValid())
-        {   //note that, invalid value means 'v' is blank
-			double value = cell->value().toDouble();
-			writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
+			writeTextElement(emitter, cell->value().toString());
 		}
+		emitter.writeRaw("</is></c>");
     }
     else if (cell->cellType() == Cell::StringType) // 'str'
     {
-		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("str"));
-		if (cell->hasFormula())
-			cell->formula().saveToXml(writer);
+		emitter.writeRaw(" t=\"str\">");
+		if (formula.isValid())
+			saveXmlCellFormula(emitter, formula);
 
-		writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
+		emitter.writeRaw("<v>");
+		emitter.writeText(cell->value().toString());
+		emitter.writeRaw("</v></c>");
     }
     else if (cell->cellType() == Cell::BooleanType) // 'b'
     {
-		writer.writeAttribute(QStringLiteral("t"), QStringLiteral("b"));
+		emitter.writeRaw(" t=\"b\">");
+		if (formula.isValid())
+			saveXmlCellFormula(emitter, formula);
 
-        // dev34
-        if (cell->hasFormula())
-        {
-            int si = cell->formula().d->si;
-            QString strFormula = cell->formula().d->formula;
-
-            cell->formula().saveToXml(writer);
-        }
-
-		writer.writeTextElement(QStringLiteral("v"), cell->value().toBool() ? QStringLiteral("1") : QStringLiteral("0"));
+		if (cell->value().toBool())
+			emitter.writeRaw("<v>1</v></c>");
+		else
+			emitter.writeRaw("<v>0</v></c>");
 	}
     else if (cell->cellType() == Cell::DateType) // 'd'
     {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("d"));
-
-        QString iso8601DateTime = cell->value().toDateTime().toString( Qt::ISODate );
-        writer.writeTextElement(QStringLiteral("v"), iso8601DateTime );
+		emitter.writeRaw(" t=\"d\"><v>");
+		emitter.writeText(cell->value().toDateTime().toString(Qt::ISODate));
+		emitter.writeRaw("</v></c>");
     }
     else if (cell->cellType() == Cell::ErrorType) // 'e'
     {
-        writer.writeAttribute(QStringLiteral("t"), QStringLiteral("e"));
-        writer.writeTextElement(QStringLiteral("v"), cell->value().toString() );
+		emitter.writeRaw(" t=\"e\">");
+		if (formula.isValid())
+			saveXmlCellFormula(emitter, formula);
+
+		emitter.writeRaw("<v>");
+		emitter.writeText(cell->value().toString());
+		emitter.writeRaw("</v></c>");
     }
-    else // if (cell->cellType() == Cell::CustomType)
+    else // Cell::NumberType ('n') or Cell::CustomType
     {
-        // custom type
-
-        if (cell->hasFormula())
-        {
-            int si = cell->formula().d->si;
-            QString strFormula = cell->formula().d->formula;
+		//note that, invalid value means 'v' is blank
+		bool hasValue = cell->value().isValid();
+		if (!formula.isValid() && !hasValue) {
+			emitter.writeRaw("/>");
+			return;
+		}
 
-            cell->formula().saveToXml(writer);
-        }
+		emitter.writeRaw(">");
+		if (formula.isValid())
+			saveXmlCellFormula(emitter, formula);
 
-        if (cell->value().isValid())
-        {   //note that, invalid value means 'v' is blank
-            double value = cell->value().toDouble();
-            writer.writeTextElement(QStringLiteral("v"), QString::number(value, 'g', 15));
-        }
+		if (hasValue) {
+			emitter.writeRaw("<v>");
+			emitter.writeDouble(cell->value().toDouble());
+			emitter.writeRaw("</v>");
+		}
+		emitter.writeRaw("</c>");
     }
+}
+
+/*
+ * Same as CellFormula::saveToXml(), for the sheet data writer.
+ */
+void WorksheetPrivate::saveXmlCellFormula(XmlEmitter &emitter, const CellFormula &formula) const
+{
+	const CellFormulaPrivate *fd = formula.d.constData();
+
+	switch (fd->type) {
+	case CellFormula::ArrayType:
+		emitter.writeRaw("<f t=\"array\"");
+		break;
+	case CellFormula::SharedType:
+		emitter.writeRaw("<f t=\"shared\"");
+		break;
+	case CellFormula::NormalType:
+		emitter.writeRaw("<f t=\"normal\"");
+		break;
+	case CellFormula::DataTableType:
+		emitter.writeRaw("<f t=\"dataTable\"");
+		break;
+	default: // undefined type
+		return;
+	}
+
+	if (fd->type != CellFormula::NormalType && fd->reference.isValid()) {
+		emitter.writeRaw(" ref=\"");
+		emitter.writeAttributeValue(fd->reference.toString());
+		emitter.writeRaw("\"");
+	}
 
-	writer.writeEndElement(); //c
+	if (fd->ca)
+		emitter.writeRaw(" ca=\"1\"");
+
+	if (fd->type == CellFormula::SharedType) {
+		emitter.writeRaw(" si=\"");
+		emitter.writeInteger(fd->si);
+		emitter.writeRaw("\"");
+	}
+
+	if (fd->formula.isEmpty()) {
+		emitter.writeRaw("/>");
+	} else {
+		emitter.writeRaw(">");
+		emitter.writeText(fd->formula);
+		emitter.writeRaw("</f>");
+	}
+}
+
+/*
+ * Finds the runs of formulas down a column which only differ by the
+ * shifting of their relative references, such as A2*B2, A3*B3, A4*B4,
+ * so that each run is written as one shared formula: the text is only
+ * written for the first row, the other rows refer to it.
+ *
+ * The cells keep their own formulas; the runs only exist in the file.
+ */
+SharedFormulaRuns WorksheetPrivate::findSharedFormulaRuns() const
+{
+	struct OpenRun
+	{
+		int firstRow;
+		int lastRow;
+		const CellFormula *first;
+		const CellFormula *last;
+	};
+
+	SharedFormulaRuns runs;
+	QMap<int, OpenRun> openRuns; //column -> run going on
+	int si = sharedFormulaMap.isEmpty() ? 0 : sharedFormulaMap.lastKey() + 1;
+
+	auto closeRun = [&](int column, const OpenRun &open) {
+		if (open.lastRow == open.firstRow)
+			return;
+		SharedFormulaRun run;
+		run.firstRow = open.firstRow;
+		run.lastRow = open.lastRow;
+		run.master = CellFormula(open.first->formulaText(), CellRange(open.firstRow, column, open.lastRow, column),
+								 CellFormula::SharedType);
+		run.master.d->si = si;
+		run.master.d->ca = open.first->d->ca;
+		run.child = CellFormula(QString(), CellFormula::SharedType);
+		run.child.d->si = si;
+		run.child.d->ca = open.first->d->ca;
+		++si;
+		runs[column].append(run);
+	};
+
+	QMap<int, QMap<int, QSharedPointer<Cell> > >::const_iterator it = cellTable.constBegin();
+	for (; it != cellTable.constEnd(); ++it) {
+		const int row = it.key();
+		QMap<int, QSharedPointer<Cell> >::const_iterator cellIt = it.value().constBegin();
+		for (; cellIt != it.value().constEnd(); ++cellIt) {
+			const CellPrivate *cell = cellIt.value()->d_ptr;
+			const CellFormula &formula = cell->formula;
+			//String and date cells are written without their formulas
+			if (formula.formulaType() != CellFormula::NormalType || !formula.isValid()
+					|| cell->cellType == Cell::SharedStringType || cell->cellType == Cell::InlineStringType
+					|| cell->cellType == Cell::DateType)
+				continue;
+
+			//Structured references are not shifted, Excel doesn't share them
+			const FormulaExpression &expression = formula.d->expression();
+			bool shareable = expression.isValid();
+			for (int i = 0; shareable && i < expression.tokens().size(); ++i) {
+				if (expression.tokens()[i].type == FormulaToken::StructuredReference)
+					shareable = false;
+			}
+
+			const int column = cellIt.key();
+			QMap<int, OpenRun>::iterator open = openRuns.find(column);
+			if (open != openRuns.end()) {
+				if (shareable && open->lastRow == row - 1
+						&& open->last->d->expression().offsetReferences(1, 0) == formula.d->formula) {
+					open->lastRow = row;
+					open->last = &formula;
+					continue;
+				}
+				closeRun(column, *open);
+				openRuns.erase(open);
+			}
+			if (shareable) {
+				const OpenRun run = { row, row, &formula, &formula };
+				openRuns.insert(column, run);
+			}
+		}
+	}
+	for (QMap<int, OpenRun>::const_iterator open = openRuns.constBegin(); open != openRuns.constEnd(); ++open)
+		closeRun(open.key(), open.value());
+
+	return runs;
 }
 
 void WorksheetPrivate::saveXmlMergeCells(QXmlStreamWriter &writer) const
@@ -1640,48 +2027,6 @@ void WorksheetPrivate::saveXmlDrawings(QXmlStreamWriter &writer) const
 	writer.writeAttribute(QStringLiteral("r:id"), QStringLiteral("rId%1").arg(relationships->count()));
 }
 
-void WorksheetPrivate::splitColsInfo(int colFirst, int colLast)
-{
-	// Split current columnInfo, for example, if "A:H" has been set,
-	// we are trying to set "B:D", there should be "A", "B:D", "E:H".
-	// This will be more complex if we try to set "C:F" after "B:D".
-	{
-		QMapIterator<int, QSharedPointer<XlsxColumnInfo> > it(colsInfo);
-		while (it.hasNext()) {
-			it.next();
-			QSharedPointer<XlsxColumnInfo> info = it.value();
-			if (colFirst > info->firstColumn && colFirst <= info->lastColumn) {
-				//split the range,
-				QSharedPointer<XlsxColumnInfo> info2(new XlsxColumnInfo(*info));
-				info->lastColumn = colFirst - 1;
-				info2->firstColumn = colFirst;
-				colsInfo.insert(colFirst, info2);
-				for (int c = info2->firstColumn; c <= info2->lastColumn; ++c)
-					colsInfoHelper[c] = info2;
-
-				break;
-			}
-		}
-	}
-	{
-		QMapIterator<int, QSharedPointer<XlsxColumnInfo> > it(colsInfo);
-		while (it.hasNext()) {
-			it.next();
-			QSharedPointer<XlsxColumnInfo> info = it.value();
-			if (colLast >= info->firstColumn && colLast < info->lastColumn) {
-				QSharedPointer<XlsxColumnInfo> info2(new XlsxColumnInfo(*info));
-				info->lastColumn = colLast;
-				info2->firstColumn = colLast + 1;
-				colsInfo.insert(colLast + 1, info2);
-				for (int c = info2->firstColumn; c <= info2->lastColumn; ++c)
-					colsInfoHelper[c] = info2;
-
-				break;
-			}
-		}
-	}
-}
-
 bool WorksheetPrivate::isColumnRangeValid(int colFirst, int colLast)
 {
 	bool ignore_row = true;
@@ -1698,23 +2043,41 @@ bool WorksheetPrivate::isColumnRangeValid(int colFirst, int colLast)
 	return true;
 }
 
-QList<int> WorksheetPrivate ::getColumnIndexes(int colFirst, int colLast)
+/*
+  Clips [\a rowFirst, \a rowLast] to the rows of a sheet, and extends
+  the dimension over them. Returns false if no row is left.
+ */
+bool WorksheetPrivate::isRowRangeValid(int &rowFirst, int &rowLast)
 {
-	splitColsInfo(colFirst, colLast);
+	rowFirst = qMax(rowFirst, 1);
+	rowLast = qMin(rowLast, XLSX_ROW_MAX);
+	if (rowFirst > rowLast)
+		return false;
 
-	QList<int> nodes;
-	nodes.append(colFirst);
-	for (int col = colFirst; col <= colLast; ++col) {
-		if (colsInfo.contains(col)) {
-			if (nodes.last() != col)
-				nodes.append(col);
-			int nextCol = colsInfo[col]->lastColumn + 1;
-			if (nextCol <= colLast)
-				nodes.append(nextCol);
-		}
-	}
+	int min_col = dimension.firstColumn() < 1 ? 1 : dimension.firstColumn();
+	checkDimensions(rowFirst, min_col, false, true);
+	checkDimensions(rowLast, min_col, false, true);
+	return true;
+}
 
-	return nodes;
+void WorksheetPrivate::appendMerge(const CellRange &range)
+{
+	mergeIndex.insert(range, merges.size());
+	merges.append(range);
+}
+
+void WorksheetPrivate::appendDataValidation(const DataValidation &validation)
+{
+	foreach (const CellRange &range, validation.ranges())
+		dataValidationIndex.insert(range, dataValidationsList.size());
+	dataValidationsList.append(validation);
+}
+
+void WorksheetPrivate::appendConditionalFormatting(const ConditionalFormatting &cf)
+{
+	foreach (const CellRange &range, cf.ranges())
+		conditionalFormattingIndex.insert(range, conditionalFormattingList.size());
+	conditionalFormattingList.append(cf);
 }
 
 /*!
@@ -1763,11 +2126,12 @@ bool Worksheet::setColumnWidth(int colFirst, int colLast, double width)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(colFirst, colLast);
-	foreach(QSharedPointer<XlsxColumnInfo>  columnInfo, columnInfoList)
-	   columnInfo->width = width;
+	if (!d->isColumnRangeValid(colFirst, colLast))
+		return false;
 
-	return (columnInfoList.count() > 0);
+	d->colsInfo.update(colFirst, colLast, [width](XlsxColumnInfo &info) { info.width = width; });
+	d->updateColumnGeometry(colFirst, colLast);
+	return true;
 }
 
 /*!
@@ -1779,16 +2143,12 @@ bool Worksheet::setColumnFormat(int colFirst, int colLast, const Format &format)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(colFirst, colLast);
-	foreach(QSharedPointer<XlsxColumnInfo>  columnInfo, columnInfoList)
-	   columnInfo->format = format;
-
-	if(columnInfoList.count() > 0) {
-	   d->workbook->styles()->addXfFormat(format);
-	   return true;
-	}
+	if (!d->isColumnRangeValid(colFirst, colLast))
+		return false;
 
-	return false;
+	d->colsInfo.update(colFirst, colLast, [&format](XlsxColumnInfo &info) { info.format = format; });
+	d->workbook->styles()->addXfFormat(format);
+	return true;
 }
 
 /*!
@@ -1799,11 +2159,12 @@ bool Worksheet::setColumnHidden(int colFirst, int colLast, bool hidden)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(colFirst, colLast);
-	foreach(QSharedPointer<XlsxColumnInfo>  columnInfo, columnInfoList)
-	   columnInfo->hidden = hidden;
+	if (!d->isColumnRangeValid(colFirst, colLast))
+		return false;
 
-	return (columnInfoList.count() > 0);
+	d->colsInfo.update(colFirst, colLast, [hidden](XlsxColumnInfo &info) { info.hidden = hidden; });
+	d->updateColumnGeometry(colFirst, colLast);
+	return true;
 }
 
 /*!
@@ -1813,9 +2174,8 @@ double Worksheet::columnWidth(int column)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(column, column);
-	if (columnInfoList.count() == 1)
-	   return columnInfoList.at(0)->width ;
+	if (const XlsxColumnInfo *info = d->colsInfo.find(column))
+		return info->width;
 
 	return d->sheetFormatProps.defaultColWidth;
 }
@@ -1827,9 +2187,8 @@ Format Worksheet::columnFormat(int column)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(column, column);
-	if (columnInfoList.count() == 1)
-	   return columnInfoList.at(0)->format;
+	if (const XlsxColumnInfo *info = d->colsInfo.find(column))
+		return info->format;
 
 	return Format();
 }
@@ -1841,9 +2200,8 @@ bool Worksheet::isColumnHidden(int column)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxColumnInfo> > columnInfoList = d->getColumnInfoList(column, column);
-	if (columnInfoList.count() == 1)
-	   return columnInfoList.at(0)->hidden;
+	if (const XlsxColumnInfo *info = d->colsInfo.find(column))
+		return info->hidden;
 
 	return false;
 }
@@ -1859,14 +2217,15 @@ bool Worksheet::setRowHeight(int rowFirst,int rowLast, double height)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxRowInfo> > rowInfoList = d->getRowInfoList(rowFirst,rowLast);
-
-	foreach(QSharedPointer<XlsxRowInfo> rowInfo, rowInfoList) {
-		rowInfo->height = height;
-		rowInfo->customHeight = true;
-	}
+	if (!d->isRowRangeValid(rowFirst, rowLast))
+		return false;
 
-	return rowInfoList.count() > 0;
+	d->rowsInfo.update(rowFirst, rowLast, [height](XlsxRowInfo &info) {
+		info.height = height;
+		info.customHeight = true;
+	});
+	d->updateRowGeometry(rowFirst, rowLast);
+	return true;
 }
 
 /*!
@@ -1879,13 +2238,12 @@ bool Worksheet::setRowFormat(int rowFirst,int rowLast, const Format &format)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxRowInfo> > rowInfoList = d->getRowInfoList(rowFirst,rowLast);
-
-	foreach(QSharedPointer<XlsxRowInfo> rowInfo, rowInfoList)
-		rowInfo->format = format;
+	if (!d->isRowRangeValid(rowFirst, rowLast))
+		return false;
 
+	d->rowsInfo.update(rowFirst, rowLast, [&format](XlsxRowInfo &info) { info.format = format; });
 	d->workbook->styles()->addXfFormat(format);
-	return rowInfoList.count() > 0;
+	return true;
 }
 
 /*!
@@ -1898,11 +2256,12 @@ bool Worksheet::setRowHidden(int rowFirst,int rowLast, bool hidden)
 {
 	Q_D(Worksheet);
 
-	QList <QSharedPointer<XlsxRowInfo> > rowInfoList = d->getRowInfoList(rowFirst,rowLast);
-	foreach(QSharedPointer<XlsxRowInfo> rowInfo, rowInfoList)
-		rowInfo->hidden = hidden;
+	if (!d->isRowRangeValid(rowFirst, rowLast))
+		return false;
 
-	return rowInfoList.count() > 0;
+	d->rowsInfo.update(rowFirst, rowLast, [hidden](XlsxRowInfo &info) { info.hidden = hidden; });
+	d->updateRowGeometry(rowFirst, rowLast);
+	return true;
 }
 
 /*!
@@ -1911,13 +2270,12 @@ bool Worksheet::setRowHidden(int rowFirst,int rowLast, bool hidden)
 double Worksheet::rowHeight(int row)
 {
 	Q_D(Worksheet);
-	int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
 
-	if (d->checkDimensions(row, min_col, false, true) || !d->rowsInfo.contains(row))
+	const XlsxRowInfo *info = d->rowsInfo.find(row);
+	if (!info)
 		return d->sheetFormatProps.defaultRowHeight; //return default on invalid row
 
-
-	return d->rowsInfo[row]->height;
+	return info->height;
 }
 
 /*!
@@ -1926,11 +2284,12 @@ double Worksheet::rowHeight(int row)
 Format Worksheet::rowFormat(int row)
 {
 	Q_D(Worksheet);
-	int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
-	if (d->checkDimensions(row, min_col, false, true) || !d->rowsInfo.contains(row))
+
+	const XlsxRowInfo *info = d->rowsInfo.find(row);
+	if (!info)
 		return Format(); //return default on invalid row
 
-	return d->rowsInfo[row]->format;
+	return info->format;
 }
 
 /*!
@@ -1939,11 +2298,139 @@ Format Worksheet::rowFormat(int row)
 bool Worksheet::isRowHidden(int row)
 {
 	Q_D(Worksheet);
-	int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
-	if (d->checkDimensions(row, min_col, false, true) || !d->rowsInfo.contains(row))
+
+	const XlsxRowInfo *info = d->rowsInfo.find(row);
+	if (!info)
 		return false; //return default on invalid row
 
-	return d->rowsInfo[row]->hidden;
+	return info->hidden;
+}
+
+/*!
+  \overload
+  Returns the format the cell \a row_column is displayed with.
+ */
+Format Worksheet::effectiveFormat(const CellReference &row_column) const
+{
+	if (!row_column.isValid())
+		return Format();
+
+	return effectiveFormat(row_column.row(), row_column.column());
+}
+
+/*!
+  Returns the format the cell at (\a row, \a column) is displayed with:
+  the format of the cell itself, else the one of its row, else the one
+  of its column. The cell doesn't need to exist.
+
+  \sa cellAt(), rowFormat(), columnFormat()
+ */
+Format Worksheet::effectiveFormat(int row, int column) const
+{
+	Q_D(const Worksheet);
+
+	FormatResolver formats(d->rowsInfo, d->colsInfo);
+	const Cell *cell = cellAt(row, column);
+	return formats.format(row, column, cell ? cell->format() : Format());
+}
+
+/*!
+  \overload
+  Returns what the conditional formattings make of the cell \a row_column.
+ */
+ConditionalFormatOverlay Worksheet::conditionalFormatOverlayAt(const CellReference &row_column) const
+{
+	if (!row_column.isValid())
+		return ConditionalFormatOverlay();
+
+	return conditionalFormatOverlayAt(row_column.row(), row_column.column());
+}
+
+/*!
+  Returns what the conditional formattings of the sheet make of the cell
+  at (\a row, \a column): the formats of the rules which hold, and the
+  color scale and the data bar which apply. The cells are seen with the
+  results of their formulas, so the workbook should be calculated first.
+
+  The statistics of the rules, such as the averages or the top values
+  of their ranges, are computed for each call, so use
+  conditionalFormatOverlays() for more than a few cells.
+
+  \sa effectiveFormat(), conditionalFormatOverlays(), conditionalFormatsAt()
+ */
+ConditionalFormatOverlay Worksheet::conditionalFormatOverlayAt(int row, int column) const
+{
+	Q_D(const Worksheet);
+
+	if (d->conditionalFormattingList.isEmpty())
+		return ConditionalFormatOverlay();
+
+	ConditionalFormatEvaluator evaluator(const_cast<Worksheet *>(this));
+	return evaluator.overlayAt(row, column);
+}
+
+/*!
+  Returns what the conditional formattings of the sheet make of the
+  cells of \a range, by row then by column. Only the cells they change
+  are there. The whole dimension of the sheet is evaluated if \a range
+  is invalid, the default.
+
+  The statistics of each rule are computed once for all the cells.
+
+  \sa conditionalFormatOverlayAt()
+ */
+QMap<int, QMap<int, ConditionalFormatOverlay> > Worksheet::conditionalFormatOverlays(const CellRange &range) const
+{
+	Q_D(const Worksheet);
+
+	if (d->conditionalFormattingList.isEmpty())
+		return QMap<int, QMap<int, ConditionalFormatOverlay> >();
+
+	ConditionalFormatEvaluator evaluator(const_cast<Worksheet *>(this));
+	return evaluator.overlays(range);
+}
+
+/*!
+  Returns the area covered by the cell at (\a row, \a column) in pixels,
+  relative to the top left corner of the cell A1. Hidden rows and
+  columns are zero pixels high or wide.
+
+  The positions of the rows and columns are indexed, so this takes
+  logarithmic time in the number of rows and columns which don't have
+  the default size.
+
+  \sa cellAtPosition()
+ */
+QRect Worksheet::cellRect(int row, int column) const
+{
+	Q_D(const Worksheet);
+
+	const GeometryIndex &rows = d->rowGeometryIndex();
+	const GeometryIndex &columns = d->columnGeometryIndex();
+	return QRect(columns.offset(column), rows.offset(row), columns.size(column), rows.size(row));
+}
+
+/*!
+  Returns the cell which covers the pixel \a pos, relative to the top
+  left corner of the cell A1. The position of \a pos within the cell
+  is stored in \a offset if it isn't null.
+
+  \sa cellRect()
+ */
+CellReference Worksheet::cellAtPosition(const QPoint &pos, QPoint *offset) const
+{
+	Q_D(const Worksheet);
+
+	int rowOffset = 0;
+	int columnOffset = 0;
+	int row = d->rowGeometryIndex().indexAt(pos.y(), &rowOffset);
+	int column = d->columnGeometryIndex().indexAt(pos.x(), &columnOffset);
+	if (row > XLSX_ROW_MAX || column > XLSX_COLUMN_MAX)
+		return CellReference();
+
+	if (offset)
+		*offset = QPoint(columnOffset, rowOffset);
+	return CellReference(row, column);
 }
 
 /*!
@@ -1955,22 +2442,14 @@ bool Worksheet::groupRows(int rowFirst, int rowLast, bool collapsed)
 {
 	Q_D(Worksheet);
 
-	for (int row=rowFirst; row<=rowLast; ++row) {
-		if (d->rowsInfo.contains(row)) {
-			d->rowsInfo[row]->outlineLevel += 1;
-		} else {
-			QSharedPointer<XlsxRowInfo> info(new XlsxRowInfo);
-			info->outlineLevel += 1;
-			d->rowsInfo.insert(row, info);
-		}
+	d->rowsInfo.update(rowFirst, rowLast, [collapsed](XlsxRowInfo &info) {
+		info.outlineLevel += 1;
 		if (collapsed)
-			d->rowsInfo[row]->hidden = true;
-	}
-	if (collapsed) {
-		if (!d->rowsInfo.contains(rowLast+1))
-			d->rowsInfo.insert(rowLast+1, QSharedPointer<XlsxRowInfo>(new XlsxRowInfo));
-		d->rowsInfo[rowLast+1]->collapsed = true;
-	}
+			info.hidden = true;
+	});
+	if (collapsed)
+		d->rowsInfo.update(rowLast+1, rowLast+1, [](XlsxRowInfo &info) { info.collapsed = true; });
+	d->rowGeometryDirty = true;
 	return true;
 }
 
@@ -1995,51 +2474,14 @@ bool Worksheet::groupColumns(int colFirst, int colLast, bool collapsed)
 {
 	Q_D(Worksheet);
 
-	d->splitColsInfo(colFirst, colLast);
-
-	QList<int> nodes;
-	nodes.append(colFirst);
-	for (int col = colFirst; col <= colLast; ++col) {
-		if (d->colsInfo.contains(col)) {
-			if (nodes.last() != col)
-				nodes.append(col);
-			int nextCol = d->colsInfo[col]->lastColumn + 1;
-			if (nextCol <= colLast)
-				nodes.append(nextCol);
-		}
-	}
-
-	for (int idx = 0; idx < nodes.size(); ++idx) {
-		int colStart = nodes[idx];
-		if (d->colsInfo.contains(colStart)) {
-			QSharedPointer<XlsxColumnInfo> info = d->colsInfo[colStart];
-			info->outlineLevel += 1;
-			if (collapsed)
-				info->hidden = true;
-		} else {
-			int colEnd = (idx == nodes.size() - 1) ? colLast : nodes[idx+1] - 1;
-			QSharedPointer<XlsxColumnInfo> info(new XlsxColumnInfo(colStart, colEnd));
-			info->outlineLevel += 1;
-			d->colsInfo.insert(colFirst, info);
-			if (collapsed)
-				info->hidden = true;
-			for (int c = colStart; c <= colEnd; ++c)
-				d->colsInfoHelper[c] = info;
-		}
-	}
-
-	if (collapsed) {
-		int col = colLast+1;
-		d->splitColsInfo(col, col);
-		if (d->colsInfo.contains(col))
-			d->colsInfo[col]->collapsed = true;
-		else {
-			QSharedPointer<XlsxColumnInfo> info(new XlsxColumnInfo(col, col));
-			info->collapsed = true;
-			d->colsInfo.insert(col, info);
-			d->colsInfoHelper[col] = info;
-		}
-	}
+	d->colsInfo.update(colFirst, colLast, [collapsed](XlsxColumnInfo &info) {
+		info.outlineLevel += 1;
+		if (collapsed)
+			info.hidden = true;
+	});
+	if (collapsed)
+		d->colsInfo.update(colLast+1, colLast+1, [](XlsxColumnInfo &info) { info.collapsed = true; });
+	d->columnGeometryDirty = true;
 
 	return false;
 }
@@ -2053,6 +2495,47 @@ CellRange Worksheet::dimension() const
 	return d->dimension;
 }
 
+/*!
+ * Returns the sum, average, minimum, maximum or count of the numbers in
+ * the \a range, as given by the \a operation. Text, logical values and
+ * errors are ignored, as by the SUM() family of formula functions.
+ *
+ * The minimum and the maximum of a range without numbers are 0, while
+ * their average is an invalid QVariant.
+ *
+ * The numbers of each column are gathered the first time the column is
+ * aggregated, and kept until one of its cells is written, so that large
+ * ranges can be aggregated again and again quickly.
+ */
+QVariant Worksheet::aggregate(const CellRange &range, AggregateOperation operation) const
+{
+	Q_D(const Worksheet);
+	if (!range.isValid())
+		return QVariant();
+
+	const FormulaValue area = FormulaValue::fromArea(const_cast<Worksheet *>(this), range.firstRow(),
+													 range.firstColumn(), range.lastRow(), range.lastColumn());
+	NumericAggregate numbers;
+	if (!d->workbook->d_func()->formulaEngine->aggregateArea(area, d->workbook->isDate1904(), &numbers, 0))
+		return QVariant();
+
+	switch (operation) {
+	case AO_Sum:
+		return numbers.sum;
+	case AO_Average:
+		if (!numbers.count)
+			return QVariant();
+		return numbers.sum / numbers.count;
+	case AO_Min:
+		return numbers.count ? numbers.minimum : 0.0;
+	case AO_Max:
+		return numbers.count ? numbers.maximum : 0.0;
+	case AO_Count:
+		return numbers.count;
+	}
+	return QVariant();
+}
+
 /*
  Convert the height of a cell from user's units to pixels. If the
  height hasn't been set by the user we use the default value. If
@@ -2060,36 +2543,116 @@ CellRange Worksheet::dimension() const
 */
 int WorksheetPrivate::rowPixelsSize(int row) const
 {
-	double height;
-	if (row_sizes.contains(row))
-		height = row_sizes[row];
-	else
-		height = default_row_height;
-	return static_cast<int>(4.0 / 3.0 *height);
+	if (const XlsxRowInfo *info = rowsInfo.find(row))
+		return rowInfoPixels(*info);
+	return static_cast<int>(4.0 / 3.0 * sheetFormatProps.defaultRowHeight);
 }
 
 /*
- Convert the width of a cell from user's units to pixels. Excel rounds
- the column width to the nearest pixel. If the width hasn't been set
- by the user we use the default value. If the column is hidden it
- has a value of zero.
+ Convert the width of a cell from user's units to pixels. If the width
+ hasn't been set by the user we use the default value. If the column
+ is hidden it has a value of zero.
 */
 int WorksheetPrivate::colPixelsSize(int col) const
+{
+	if (const XlsxColumnInfo *info = colsInfo.find(col))
+		return columnInfoPixels(*info);
+	return columnWidthPixels(sheetFormatProps.defaultColWidth);
+}
+
+int WorksheetPrivate::rowInfoPixels(const XlsxRowInfo &info) const
+{
+	if (info.hidden)
+		return 0;
+	double height = info.customHeight || info.height > 0 ? info.height : sheetFormatProps.defaultRowHeight;
+	return static_cast<int>(4.0 / 3.0 * height);
+}
+
+int WorksheetPrivate::columnInfoPixels(const XlsxColumnInfo &info) const
+{
+	if (info.hidden)
+		return 0;
+	return columnWidthPixels(info.width > 0 ? info.width : sheetFormatProps.defaultColWidth);
+}
+
+/*
+ Excel rounds the column width to the nearest pixel. Without a width
+ the column is 64 pixels wide.
+*/
+int WorksheetPrivate::columnWidthPixels(double width)
 {
 	double max_digit_width = 7.0; //For Calabri 11
 	double padding = 5.0;
-	int pixels = 0;
 
-	if (col_sizes.contains(col)) {
-		double width = col_sizes[col];
-		if (width < 1)
-			pixels = static_cast<int>(width * (max_digit_width + padding) + 0.5);
-		else
-			pixels = static_cast<int>(width * max_digit_width + 0.5) + padding;
-	} else {
-		pixels = 64;
+	if (width <= 0)
+		return 64;
+	if (width < 1)
+		return static_cast<int>(width * (max_digit_width + padding) + 0.5);
+	return static_cast<int>(width * max_digit_width + 0.5) + padding;
+}
+
+/*
+ Returns the pixel positions of the rows, rebuilt from the runs of
+ rowsInfo when they have been split or joined since the last time.
+*/
+const GeometryIndex &WorksheetPrivate::rowGeometryIndex() const
+{
+	if (rowGeometryDirty) {
+		rowGeometry.clear(static_cast<int>(4.0 / 3.0 * sheetFormatProps.defaultRowHeight));
+		IntervalMap<XlsxRowInfo>::const_iterator it = rowsInfo.constBegin();
+		for (; it != rowsInfo.constEnd(); ++it)
+			rowGeometry.append(it->first, it->last, rowInfoPixels(it->value));
+		rowGeometryDirty = false;
 	}
-	return pixels;
+	return rowGeometry;
+}
+
+/*
+ Returns the pixel positions of the columns, one run for each run of
+ colsInfo.
+*/
+const GeometryIndex &WorksheetPrivate::columnGeometryIndex() const
+{
+	if (columnGeometryDirty) {
+		columnGeometry.clear(columnWidthPixels(sheetFormatProps.defaultColWidth));
+		IntervalMap<XlsxColumnInfo>::const_iterator it = colsInfo.constBegin();
+		for (; it != colsInfo.constEnd(); ++it)
+			columnGeometry.append(it->first, it->last, columnInfoPixels(it->value));
+		columnGeometryDirty = false;
+	}
+	return columnGeometry;
+}
+
+/*
+ Refreshes the size of the rows [\a rowFirst, \a rowLast] in the
+ geometry index when they still are one run, otherwise the index is
+ rebuilt by the next lookup.
+*/
+void WorksheetPrivate::updateRowGeometry(int rowFirst, int rowLast)
+{
+	if (rowGeometryDirty)
+		return;
+
+	IntervalMap<XlsxRowInfo>::const_iterator it = rowsInfo.constFind(rowFirst);
+	if (it == rowsInfo.constEnd() || it->first != rowFirst || it->last != rowLast
+			|| !rowGeometry.update(rowFirst, rowLast, rowInfoPixels(it->value)))
+		rowGeometryDirty = true;
+}
+
+/*
+ Refreshes the size of the columns [\a colFirst, \a colLast] in the
+ geometry index when they still are one run, otherwise the index is
+ rebuilt by the next lookup.
+*/
+void WorksheetPrivate::updateColumnGeometry(int colFirst, int colLast)
+{
+	if (columnGeometryDirty)
+		return;
+
+	IntervalMap<XlsxColumnInfo>::const_iterator it = colsInfo.constFind(colFirst);
+	if (it == colsInfo.constEnd() || it->first != colFirst || it->last != colLast
+			|| !columnGeometry.update(colFirst, colLast, columnInfoPixels(it->value)))
+		columnGeometryDirty = true;
 }
 
 void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
@@ -2112,31 +2675,31 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 						|| attributes.hasAttribute(QLatin1String("collapsed"))) 
 				{
 
-					QSharedPointer<XlsxRowInfo> info(new XlsxRowInfo);
+					XlsxRowInfo rowInfo;
 					if (attributes.hasAttribute(QLatin1String("customFormat")) && attributes.hasAttribute(QLatin1String("s"))) {
 						int idx = attributes.value(QLatin1String("s")).toString().toInt();
-						info->format = workbook->styles()->xfFormat(idx);
+						rowInfo.format = workbook->styles()->xfFormat(idx);
 					}
 
 					if (attributes.hasAttribute(QLatin1String("customHeight"))) {
-						info->customHeight = attributes.value(QLatin1String("customHeight")) == QLatin1String("1");
+						rowInfo.customHeight = attributes.value(QLatin1String("customHeight")) == QLatin1String("1");
 						//Row height is only specified when customHeight is set
 						if(attributes.hasAttribute(QLatin1String("ht"))) {
-							info->height = attributes.value(QLatin1String("ht")).toString().toDouble();
+							rowInfo.height = attributes.value(QLatin1String("ht")).toString().toDouble();
 						}
 					}
 
 					//both "hidden" and "collapsed" default are false
-					info->hidden = attributes.value(QLatin1String("hidden")) == QLatin1String("1");
-					info->collapsed = attributes.value(QLatin1String("collapsed")) == QLatin1String("1");
+					rowInfo.hidden = attributes.value(QLatin1String("hidden")) == QLatin1String("1");
+					rowInfo.collapsed = attributes.value(QLatin1String("collapsed")) == QLatin1String("1");
 
 					if (attributes.hasAttribute(QLatin1String("outlineLevel")))
-						info->outlineLevel = attributes.value(QLatin1String("outlineLevel")).toString().toInt();
+						rowInfo.outlineLevel = attributes.value(QLatin1String("outlineLevel")).toString().toInt();
 
 					//"r" is optional too.
 					if (attributes.hasAttribute(QLatin1String("r"))) {
 						int row = attributes.value(QLatin1String("r")).toString().toInt();
-						rowsInfo[row] = info;
+						rowsInfo.insert(row, row, rowInfo);
 					}
 				}
 
@@ -2233,7 +2796,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 							} 
 							else if (cellType == Cell::NumberType) 
 							{
-								cell->d_func()->value = value.toDouble();
+								cell->d_func()->value = parseXsdDouble(value);
 							} 
 							else if (cellType == Cell::BooleanType) 
 							{
@@ -2262,7 +2825,7 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 					}
 				}
 
-				cellTable[pos.row()][pos.column()] = cell;
+				setCell(pos.row(), pos.column(), cell);
 			}
 		}
 	}
@@ -2276,38 +2839,34 @@ void WorksheetPrivate::loadXmlColumnsInfo(QXmlStreamReader &reader)
 		reader.readNextStartElement();
 		if (reader.tokenType() == QXmlStreamReader::StartElement) {
 			if (reader.name() == QLatin1String("col")) {
-				QSharedPointer<XlsxColumnInfo> info(new XlsxColumnInfo);
+				XlsxColumnInfo colInfo;
 
 				QXmlStreamAttributes colAttrs = reader.attributes();
 				int min = colAttrs.value(QLatin1String("min")).toString().toInt();
 				int max = colAttrs.value(QLatin1String("max")).toString().toInt();
-				info->firstColumn = min;
-				info->lastColumn = max;
 
 				//Flag indicating that the column width for the affected column(s) is different from the
 				// default or has been manually set
 				if(colAttrs.hasAttribute(QLatin1String("customWidth"))) {
-					info->customWidth = colAttrs.value(QLatin1String("customWidth")) == QLatin1String("1");
+					colInfo.customWidth = colAttrs.value(QLatin1String("customWidth")) == QLatin1String("1");
 				}
 				//Note, node may have "width" without "customWidth"
 				if (colAttrs.hasAttribute(QLatin1String("width"))) {
 					double width = colAttrs.value(QLatin1String("width")).toString().toDouble();
-					info->width = width;
+					colInfo.width = width;
 				}
 
-				info->hidden = colAttrs.value(QLatin1String("hidden")) == QLatin1String("1");
-				info->collapsed = colAttrs.value(QLatin1String("collapsed")) == QLatin1String("1");
+				colInfo.hidden = colAttrs.value(QLatin1String("hidden")) == QLatin1String("1");
+				colInfo.collapsed = colAttrs.value(QLatin1String("collapsed")) == QLatin1String("1");
 
 				if (colAttrs.hasAttribute(QLatin1String("style"))) {
 					int idx = colAttrs.value(QLatin1String("style")).toString().toInt();
-					info->format = workbook->styles()->xfFormat(idx);
+					colInfo.format = workbook->styles()->xfFormat(idx);
 				}
 				if (colAttrs.hasAttribute(QLatin1String("outlineLevel")))
-					info->outlineLevel = colAttrs.value(QLatin1String("outlineLevel")).toString().toInt();
+					colInfo.outlineLevel = colAttrs.value(QLatin1String("outlineLevel")).toString().toInt();
 
-				colsInfo.insert(min, info);
-				for (int col=min; col<=max; ++col)
-					colsInfoHelper[col] = info;
+				colsInfo.insert(min, max, colInfo);
 			}
 		}
 	}
@@ -2326,7 +2885,7 @@ void WorksheetPrivate::loadXmlMergeCells(QXmlStreamReader &reader)
 			if (reader.name() == QLatin1String("mergeCell")) {
 				QXmlStreamAttributes attrs = reader.attributes();
 				QString rangeStr = attrs.value(QLatin1String("ref")).toString();
-				merges.append(CellRange(rangeStr));
+				appendMerge(CellRange(rangeStr));
 			}
 		}
 	}
@@ -2346,7 +2905,7 @@ void WorksheetPrivate::loadXmlDataValidations(QXmlStreamReader &reader)
 		reader.readNextStartElement();
 		if (reader.tokenType() == QXmlStreamReader::StartElement
 				&& reader.name() == QLatin1String("dataValidation")) {
-			dataValidationsList.append(DataValidation::loadFromXml(reader));
+			appendDataValidation(DataValidation::loadFromXml(reader));
 		}
 	}
 
@@ -2450,52 +3009,6 @@ void WorksheetPrivate::loadXmlHyperlinks(QXmlStreamReader &reader)
 	}
 }
 
-QList <QSharedPointer<XlsxColumnInfo> > WorksheetPrivate::getColumnInfoList(int colFirst, int colLast)
-{
-	QList <QSharedPointer<XlsxColumnInfo> > columnsInfoList;
-	if(isColumnRangeValid(colFirst,colLast))
-	{
-		QList<int> nodes = getColumnIndexes(colFirst, colLast);
-
-		for (int idx = 0; idx < nodes.size(); ++idx) {
-			int colStart = nodes[idx];
-			if (colsInfo.contains(colStart)) {
-				QSharedPointer<XlsxColumnInfo> info = colsInfo[colStart];
-				columnsInfoList.append(info);
-			} else {
-				int colEnd = (idx == nodes.size() - 1) ? colLast : nodes[idx+1] - 1;
-				QSharedPointer<XlsxColumnInfo> info(new XlsxColumnInfo(colStart, colEnd));
-				colsInfo.insert(colFirst, info);
-				columnsInfoList.append(info);
-				for (int c = colStart; c <= colEnd; ++c)
-					colsInfoHelper[c] = info;
-			}
-		}
-	}
-
-	return columnsInfoList;
-}
-
-QList <QSharedPointer<XlsxRowInfo> > WorksheetPrivate::getRowInfoList(int rowFirst, int rowLast)
-{
-	QList <QSharedPointer<XlsxRowInfo> > rowInfoList;
-
-	int min_col = dimension.firstColumn() < 1 ? 1 : dimension.firstColumn();
-
-	for(int row = rowFirst; row <= rowLast; ++row) {
-		if (checkDimensions(row, min_col, false, true))
-			continue;
-
-		QSharedPointer<XlsxRowInfo> rowInfo;
-		if ((rowsInfo[row]).isNull()){
-			rowsInfo[row] = QSharedPointer<XlsxRowInfo>(new XlsxRowInfo());
-		}
-		rowInfoList.append(rowsInfo[row]);
-	}
-
-	return rowInfoList;
-}
-
 bool Worksheet::loadFromXmlFile(QIODevice *device)
 {
 	Q_D(Worksheet);
@@ -2523,7 +3036,7 @@ bool Worksheet::loadFromXmlFile(QIODevice *device)
 			} else if (reader.name() == QLatin1String("conditionalFormatting")) {
 				ConditionalFormatting cf;
 				cf.loadFromXml(reader, workbook()->styles());
-				d->conditionalFormattingList.append(cf);
+				d->appendConditionalFormatting(cf);
 			} else if (reader.name() == QLatin1String("hyperlinks")) {
 				d->loadXmlHyperlinks(reader);
             } else if(reader.name() == QLatin1String("pageSetup")) {
@@ -2588,6 +3101,8 @@ bool Worksheet::loadFromXmlFile(QIODevice *device)
 	}
 
 	d->validateDimension();
+	d->rowGeometryDirty = true;
+	d->columnGeometryDirty = true;
 	return true;
 }
 
@@ -2630,6 +3145,36 @@ SharedStrings *WorksheetPrivate::sharedStrings() const
 	return workbook->sharedStrings();
 }
 
+/*
+ * \internal
+ * Count the references to the shared string table made by the cells
+ * of this sheet. The refCounts is indexed by the shared string index,
+ * which is looked up in the same way as saveXmlCellData() does.
+ */
+void WorksheetPrivate::markSharedStrings(QVector<int> &refCounts) const
+{
+	SharedStrings *sst = sharedStrings();
+
+	QMap<int, QMap<int, QSharedPointer<Cell> > >::const_iterator it = cellTable.constBegin();
+	for (; it != cellTable.constEnd(); ++it) {
+		QMap<int, QSharedPointer<Cell> >::const_iterator it2 = it.value().constBegin();
+		for (; it2 != it.value().constEnd(); ++it2) {
+			const Cell *cell = it2.value().data();
+			if (cell->cellType() != Cell::SharedStringType)
+				continue;
+
+			int sst_idx;
+			if (cell->isRichString())
+				sst_idx = sst->getSharedStringIndex(cell->d_ptr->richString);
+			else
+				sst_idx = sst->getSharedStringIndex(cell->value().toString());
+
+			if (sst_idx >= 0 && sst_idx < refCounts.size())
+				refCounts[sst_idx] += 1;
+		}
+	}
+}
+
 QVector<CellLocation> Worksheet::getFullCells(int* maxRow, int* maxCol)
 {
     Q_D(const Worksheet);
@@ -2696,4 +3241,170 @@ QVector<CellLocation> Worksheet::getFullCells(int* maxRow, int* maxCol)
     return ret;
 }
 
+/*!
+  Writes the cells of the sheet to \a device as comma separated values,
+  one record per row, with the settings of \a options. Rows and cells
+  which don't exist are written as empty records and fields, so that
+  all the records have the same number of fields.
+
+  The rows are written in order through a buffer of fixed size, and the
+  way numbers are formatted is worked out once per style, so the text of
+  the whole sheet is never held in memory.
+
+  Returns false if the device can't be written to.
+
+  \sa CsvOptions
+ */
+bool Worksheet::exportCsv(QIODevice *device, const CsvOptions &options) const
+{
+	Q_D(const Worksheet);
+
+	if (!device || !device->isWritable())
+		return false;
+
+	const bool date1904 = d->workbook->isDate1904();
+	CsvWriter writer(device, options, date1904);
+	const CellRange range = options.range.isValid() ? options.range : d->dimension;
+	if (!range.isValid())
+		return writer.flush();
+
+	const int columns = range.columnCount();
+	FormatResolver formats(d->rowsInfo, d->colsInfo);
+
+	int row = range.firstRow();
+	QMap<int, QMap<int, QSharedPointer<Cell> > >::const_iterator it = d->cellTable.lowerBound(row);
+	for (; it != d->cellTable.constEnd() && it.key() <= range.lastRow(); ++it) {
+		for (; row < it.key(); ++row)
+			writer.writeEmptyRecord(columns);
+
+		int column = range.firstColumn();
+		QMap<int, QSharedPointer<Cell> >::const_iterator cit = it.value().lowerBound(column);
+		for (; cit != it.value().constEnd() && cit.key() <= range.lastColumn(); ++cit) {
+			for (; column < cit.key(); ++column)
+				writer.writeEmptyField();
+
+			const Cell *cell = cit.value().data();
+			const Format format = options.applyNumberFormats ? formats.format(row, column, cell->format()) : Format();
+			writer.writeField(FormulaEngine::valueOf(cell, date1904), format);
+			++column;
+		}
+		for (; column <= range.lastColumn(); ++column)
+			writer.writeEmptyField();
+		writer.endRecord();
+		++row;
+
+		if (writer.hasError())
+			return false;
+	}
+	for (; row <= range.lastRow(); ++row)
+		writer.writeEmptyRecord(columns);
+
+	return writer.flush();
+}
+
+/*!
+  Reads comma separated values from \a device into the sheet, with the
+  settings of \a options: the first record goes to the top left cell
+  of \a options.range, and each field to the cell on its right. Empty
+  fields leave the cells as they are. The records and fields which
+  don't fit in a valid \a options.range are left out.
+
+  The input is read by batches of records, which are parsed on several
+  threads. The texts of each chunk of records are decoded once, then
+  added to the shared strings once, however many cells hold them.
+
+  Returns false if the device can't be read, or if some records don't
+  fit in the sheet.
+
+  \sa exportCsv(), CsvOptions
+ */
+bool Worksheet::importCsv(QIODevice *device, const CsvOptions &options)
+{
+	Q_D(Worksheet);
+
+	if (!device || !device->isReadable())
+		return false;
+
+	const bool clip = options.range.isValid();
+	const int firstRow = clip ? options.range.firstRow() : 1;
+	const int firstColumn = clip ? options.range.firstColumn() : 1;
+	const int lastRow = clip ? options.range.lastRow() : XLSX_ROW_MAX;
+	const int lastColumn = clip ? options.range.lastColumn() : XLSX_COLUMN_MAX;
+
+	Styles *styles = d->workbook->styles();
+	Format general;
+	styles->addXfFormat(general);
+	Format date;
+	date.setNumberFormat(d->workbook->defaultDateFormat());
+	styles->addXfFormat(date);
+	Format time;
+	time.setNumberFormat(QStringLiteral("hh:mm:ss"));
+	styles->addXfFormat(time);
+	Format dateTime;
+	dateTime.setNumberFormat(QStringLiteral("yyyy-mm-dd hh:mm:ss"));
+	styles->addXfFormat(dateTime);
+
+	SharedStrings *sst = d->sharedStrings();
+	CsvReader reader(device, options, d->workbook->isDate1904());
+	bool ok = true;
+	int row = firstRow;
+	while (row <= lastRow && reader.readBatch()) {
+		foreach (const CsvChunk &chunk, reader.chunks()) {
+			//Shared string of each text of the chunk, added on first use
+			QVector<RichString> texts(chunk.strings.size());
+			QVector<int> textIndexes(chunk.strings.size(), -1);
+
+			foreach (const CsvField &field, chunk.fields) {
+				const int r = row + field.row;
+				const int c = firstColumn + field.column;
+				if (clip && (r > lastRow || c > lastColumn))
+					continue;
+				if (d->checkDimensions(r, c)) {
+					ok = false;
+					continue;
+				}
+
+				Cell *cell;
+				switch (field.type) {
+				case CsvField::String: {
+					const int i = field.string;
+					if (textIndexes[i] < 0) {
+						texts[i] = RichString(chunk.strings[i]);
+						textIndexes[i] = sst->addSharedString(texts[i]);
+					} else {
+						sst->incRefByStringIndex(textIndexes[i]);
+					}
+					cell = new Cell(chunk.strings[i], Cell::SharedStringType, general, this);
+					cell->d_ptr->richString = texts[i];
+					break;
+				}
+				case CsvField::Boolean:
+					cell = new Cell(field.number != 0, Cell::BooleanType, general, this);
+					break;
+				case CsvField::Date:
+					cell = new Cell(field.number, Cell::NumberType, date, this);
+					break;
+				case CsvField::Time:
+					cell = new Cell(field.number, Cell::NumberType, time, this);
+					break;
+				case CsvField::DateTime:
+					cell = new Cell(field.number, Cell::NumberType, dateTime, this);
+					break;
+				default:
+					cell = new Cell(field.number, Cell::NumberType, general, this);
+					break;
+				}
+				d->setCell(r, c, QSharedPointer<Cell>(cell));
+			}
+			row += chunk.records;
+		}
+	}
+
+	//Without a range, records beyond the last row of the sheet are lost
+	if (!clip && row > lastRow && reader.readBatch())
+		ok = false;
+
+	return ok && !reader.hasError();
+}
+
 QT_END_NAMESPACE_XLSX
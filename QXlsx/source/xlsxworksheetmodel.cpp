@@ -0,0 +1,333 @@
+// xlsxworksheetmodel.cpp
+
+#include "xlsxworksheetmodel.h"
+#include "xlsxworksheetmodel_p.h"
+#include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxcell.h"
+#include "xlsxcellreference.h"
+#include "xlsxformulaengine_p.h"
+
+#include <QFont>
+#include <QColor>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int defaultPageSize = 1024;
+const int defaultDisplayCacheSize = 65536;
+
+inline quint64 cellKey(int row, int column)
+{
+	return (quint64(row) << 16) | quint64(column);
+}
+
+} //namespace
+
+WorksheetModelPrivate::WorksheetModelPrivate(WorksheetModel *p, Worksheet *sheet)
+	: q_ptr(p), sheet(sheet), lastRow(0), fetchedRows(0), columns(0), pageSize(defaultPageSize)
+	, displayCache(defaultDisplayCacheSize)
+{
+}
+
+/*
+ * Takes the size of the sheet again, the rows already shown stay. The
+ * formats are looked up afresh.
+ */
+void WorksheetModelPrivate::updateSize()
+{
+	CellRange dimension = sheet ? sheet->dimension() : CellRange();
+	lastRow = dimension.isValid() ? dimension.lastRow() : 0;
+	columns = dimension.isValid() ? dimension.lastColumn() : 0;
+	fetchedRows = qMin(qMax(fetchedRows, pageSize), lastRow);
+
+	if (sheet) {
+		WorksheetPrivate *sd = sheet->d_func();
+		formats.reset(new FormatResolver(sd->rowsInfo, sd->colsInfo));
+		numbers.reset(new NumberFormatter(sheet->workbook()->isDate1904()));
+	}
+}
+
+/*
+ * Returns the text and the effective format of the cell at \a row and
+ * \a column, which are kept in the cache. The numbers are shown as
+ * their number format writes them, see NumberFormatter.
+ */
+WorksheetModelPrivate::CellDisplay WorksheetModelPrivate::cellDisplay(int row, int column) const
+{
+	const quint64 key = cellKey(row, column);
+	if (CellDisplay *display = displayCache.object(key))
+		return *display;
+
+	CellDisplay display;
+	const Cell *cell = sheet->cellAt(row, column);
+	display.format = formats->format(row, column, cell ? cell->format() : Format());
+
+	const FormulaValue value = FormulaEngine::valueOf(cell, sheet->workbook()->isDate1904());
+	display.number = value.type == FormulaValue::Number;
+	if (display.number) {
+		char buffer[XLSX_NUMBER_TEXT_BUFFER_SIZE];
+		display.text = QString::fromLatin1(buffer, numbers->format(value.number, display.format, buffer));
+	} else {
+		display.text = FormulaEngine::textOf(value);
+	}
+
+	displayCache.insert(key, new CellDisplay(display));
+	return display;
+}
+
+/*
+ * Returns the \a role data given by \a format, if it has some.
+ */
+QVariant WorksheetModelPrivate::formatData(const Format &format, int role) const
+{
+	if (format.isEmpty())
+		return QVariant();
+
+	switch (role) {
+	case Qt::FontRole:
+		return format.font();
+	case Qt::ForegroundRole:
+		if (format.fontColor().isValid())
+			return format.fontColor();
+		break;
+	case Qt::BackgroundRole:
+		if (format.fillPattern() != Format::PatternNone) {
+			if (format.patternBackgroundColor().isValid())
+				return format.patternBackgroundColor();
+			if (format.patternForegroundColor().isValid())
+				return format.patternForegroundColor();
+		}
+		break;
+	default:
+		break;
+	}
+	return QVariant();
+}
+
+/*!
+  \class WorksheetModel
+  \inmodule QtXlsx
+  \brief Table model of the cells of a worksheet, for the item views.
+
+  Nothing is copied out of the worksheet: the cells are read when the
+  view asks for them, and their texts and formats are kept in a cache of
+  limited size. The rows are shown by pages of pageSize() rows, which
+  the view fetches as it scrolls down, so big sheets open at once.
+
+  Numbers are shown as their number format writes them, with its
+  decimals and percent sign, and dates and times as ISO 8601 strings.
+
+  The fonts, the colors and the alignment of the cells come from their
+  effective format, see Worksheet::effectiveFormat().
+
+  Call reload() after the worksheet has been changed.
+*/
+
+/*!
+  Creates a model of the cells of \a sheet with the given \a parent.
+ */
+WorksheetModel::WorksheetModel(Worksheet *sheet, QObject *parent)
+	: QAbstractTableModel(parent), d_ptr(new WorksheetModelPrivate(this, sheet))
+{
+	Q_D(WorksheetModel);
+	d->updateSize();
+}
+
+/*!
+  Destroys the model.
+ */
+WorksheetModel::~WorksheetModel()
+{
+	delete d_ptr;
+}
+
+/*!
+  Returns the worksheet shown by the model.
+ */
+Worksheet *WorksheetModel::worksheet() const
+{
+	Q_D(const WorksheetModel);
+	return d->sheet;
+}
+
+/*!
+  Returns the number of rows fetched at a time. The default is 1024.
+ */
+int WorksheetModel::pageSize() const
+{
+	Q_D(const WorksheetModel);
+	return d->pageSize;
+}
+
+/*!
+  Sets the number of rows fetched at a time to \a rows.
+ */
+void WorksheetModel::setPageSize(int rows)
+{
+	Q_D(WorksheetModel);
+	if (rows > 0)
+		d->pageSize = rows;
+}
+
+/*!
+  Returns the number of cells whose text and format are kept. The
+  default is 65536.
+ */
+int WorksheetModel::displayCacheSize() const
+{
+	Q_D(const WorksheetModel);
+	return d->displayCache.maxCost();
+}
+
+/*!
+  Sets the number of cells whose text and format are kept to \a cells.
+ */
+void WorksheetModel::setDisplayCacheSize(int cells)
+{
+	Q_D(WorksheetModel);
+	d->displayCache.setMaxCost(cells);
+}
+
+/*!
+  Returns the number of rows fetched so far.
+ */
+int WorksheetModel::rowCount(const QModelIndex &parent) const
+{
+	Q_D(const WorksheetModel);
+	return parent.isValid() ? 0 : d->fetchedRows;
+}
+
+/*!
+  Returns the number of columns, up to the last one of the sheet.
+ */
+int WorksheetModel::columnCount(const QModelIndex &parent) const
+{
+	Q_D(const WorksheetModel);
+	return parent.isValid() ? 0 : d->columns;
+}
+
+/*!
+  Returns the data of the cell at \a index for \a role.
+ */
+QVariant WorksheetModel::data(const QModelIndex &index, int role) const
+{
+	Q_D(const WorksheetModel);
+
+	if (!index.isValid() || !d->sheet)
+		return QVariant();
+
+	const int row = index.row() + 1;
+	const int column = index.column() + 1;
+
+	switch (role) {
+	case Qt::DisplayRole:
+		return d->cellDisplay(row, column).text;
+	case Qt::EditRole:
+		return d->sheet->read(row, column);
+	case Qt::FontRole:
+	case Qt::ForegroundRole:
+	case Qt::BackgroundRole:
+		return d->formatData(d->cellDisplay(row, column).format, role);
+	case Qt::TextAlignmentRole: {
+		const WorksheetModelPrivate::CellDisplay display = d->cellDisplay(row, column);
+		const Format &format = display.format;
+		Qt::Alignment alignment;
+		switch (format.horizontalAlignment()) {
+		case Format::AlignLeft:
+			alignment = Qt::AlignLeft;
+			break;
+		case Format::AlignHCenter:
+		case Format::AlignHMerge:
+		case Format::AlignHDistributed:
+			alignment = Qt::AlignHCenter;
+			break;
+		case Format::AlignRight:
+			alignment = Qt::AlignRight;
+			break;
+		case Format::AlignHJustify:
+			alignment = Qt::AlignJustify;
+			break;
+		default:
+			//General: numbers to the right, the rest to the left
+			alignment = display.number ? Qt::AlignRight : Qt::AlignLeft;
+			break;
+		}
+		switch (format.verticalAlignment()) {
+		case Format::AlignTop:
+			alignment |= Qt::AlignTop;
+			break;
+		case Format::AlignVCenter:
+		case Format::AlignVJustify:
+		case Format::AlignVDistributed:
+			alignment |= Qt::AlignVCenter;
+			break;
+		default:
+			alignment |= Qt::AlignBottom;
+			break;
+		}
+		return int(alignment);
+	}
+	default:
+		return QVariant();
+	}
+}
+
+/*!
+  Returns the names of the columns, "A", "B", ..., and the numbers of
+  the rows, as the \a section headers.
+ */
+QVariant WorksheetModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (role != Qt::DisplayRole)
+		return QAbstractTableModel::headerData(section, orientation, role);
+
+	if (orientation == Qt::Vertical)
+		return section + 1;
+
+	QString name = CellReference(1, section + 1).toString();
+	name.chop(1);
+	return name;
+}
+
+/*!
+  Returns true if the sheet has rows which haven't been fetched yet.
+ */
+bool WorksheetModel::canFetchMore(const QModelIndex &parent) const
+{
+	Q_D(const WorksheetModel);
+	return !parent.isValid() && d->fetchedRows < d->lastRow;
+}
+
+/*!
+  Shows the next pageSize() rows of the sheet.
+ */
+void WorksheetModel::fetchMore(const QModelIndex &parent)
+{
+	Q_D(WorksheetModel);
+	if (parent.isValid() || d->fetchedRows >= d->lastRow)
+		return;
+
+	const int count = qMin(d->pageSize, d->lastRow - d->fetchedRows);
+	beginInsertRows(QModelIndex(), d->fetchedRows, d->fetchedRows + count - 1);
+	d->fetchedRows += count;
+	endInsertRows();
+}
+
+/*!
+  Reads the worksheet again, after it has been changed. The first page
+  of rows is shown.
+ */
+void WorksheetModel::reload()
+{
+	Q_D(WorksheetModel);
+	beginResetModel();
+	d->displayCache.clear();
+	d->fetchedRows = 0;
+	d->updateSize();
+	endResetModel();
+}
+
+QT_END_NAMESPACE_XLSX
@@ -0,0 +1,386 @@
+// xlsxxmlemitter.cpp
+
+#include "xlsxxmlemitter_p.h"
+#include "xlsxnumericcodec_p.h"
+
+#include <QtGlobal>
+#include <QIODevice>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define XLSX_HAVE_SSE2
+#endif
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define XLSX_HAVE_AVX2
+#endif
+
+#if defined(_MSC_VER) && (defined(XLSX_HAVE_SSE2) || defined(XLSX_HAVE_AVX2))
+#  include <intrin.h>
+#endif
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int emitterBufferSize = 64 * 1024;
+
+// Worst case of one UTF-16 code unit is "&quot;"
+const int maxBytesPerUnit = 6;
+
+// Vector loops may store up to 16 bytes ahead of the output
+const int storeSlack = 16;
+
+inline int countTrailingZeros(uint mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return int(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/*
+ * Escape and encode the unit at src[i], which is not a plain ASCII
+ * character. Returns the number of the units consumed.
+ *
+ * Same as QXmlStreamWriter: '<', '>', '&' and '"' are always escaped,
+ * tab, newline and carriage return only in attribute values, and the
+ * characters not allowed in xml are dropped.
+ */
+inline int escapeOne(const ushort *src, int i, int size, char *&dst, bool attribute)
+{
+    ushort c = src[i];
+    if (c < 0x80) {
+        switch (c) {
+        case '<':
+            std::memcpy(dst, "&lt;", 4);
+            dst += 4;
+            break;
+        case '>':
+            std::memcpy(dst, "&gt;", 4);
+            dst += 4;
+            break;
+        case '&':
+            std::memcpy(dst, "&amp;", 5);
+            dst += 5;
+            break;
+        case '"':
+            std::memcpy(dst, "&quot;", 6);
+            dst += 6;
+            break;
+        case '\t':
+            if (attribute) {
+                std::memcpy(dst, "&#9;", 4);
+                dst += 4;
+            } else {
+                *dst++ = '\t';
+            }
+            break;
+        case '\n':
+            if (attribute) {
+                std::memcpy(dst, "&#10;", 5);
+                dst += 5;
+            } else {
+                *dst++ = '\n';
+            }
+            break;
+        case '\r':
+            if (attribute) {
+                std::memcpy(dst, "&#13;", 5);
+                dst += 5;
+            } else {
+                *dst++ = '\r';
+            }
+            break;
+        default:
+            if (c >= 0x20)
+                *dst++ = char(c);
+            //else: not allowed in xml, dropped.
+            break;
+        }
+        return 1;
+    }
+
+    if (c < 0x800) {
+        *dst++ = char(0xC0 | (c >> 6));
+        *dst++ = char(0x80 | (c & 0x3F));
+        return 1;
+    }
+
+    if (c >= 0xD800 && c <= 0xDFFF) {
+        if (c < 0xDC00 && i + 1 < size && src[i+1] >= 0xDC00 && src[i+1] <= 0xDFFF) {
+            uint ucs4 = 0x10000 + ((uint(c) - 0xD800) << 10) + (uint(src[i+1]) - 0xDC00);
+            *dst++ = char(0xF0 | (ucs4 >> 18));
+            *dst++ = char(0x80 | ((ucs4 >> 12) & 0x3F));
+            *dst++ = char(0x80 | ((ucs4 >> 6) & 0x3F));
+            *dst++ = char(0x80 | (ucs4 & 0x3F));
+            return 2;
+        }
+        //Lone surrogate, written as the replacement character like QUtf8 does.
+        c = 0xFFFD;
+    } else if (c >= 0xFFFE) {
+        //Not allowed in xml, dropped.
+        return 1;
+    }
+
+    *dst++ = char(0xE0 | (c >> 12));
+    *dst++ = char(0x80 | ((c >> 6) & 0x3F));
+    *dst++ = char(0x80 | (c & 0x3F));
+    return 1;
+}
+
+// ASCII characters which can be copied as is.
+struct CleanAsciiTable
+{
+    CleanAsciiTable()
+    {
+        for (int c = 0; c < 128; ++c)
+            clean[c] = c >= 0x20 && c != '<' && c != '>' && c != '&' && c != '"';
+    }
+    bool clean[128];
+};
+
+const CleanAsciiTable cleanAscii;
+
+#ifdef XLSX_HAVE_SSE2
+/*
+ * Returns a mask with two bits set for each unit of \a v
+ * which is a plain ASCII character.
+ */
+inline uint cleanMask(__m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(short(0xFF80))), zero);
+    __m128i control = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(short(0xFFE0))), zero);
+    __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16('<')),
+                                                _mm_cmpeq_epi16(v, _mm_set1_epi16('>'))),
+                                   _mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16('&')),
+                                                _mm_cmpeq_epi16(v, _mm_set1_epi16('"'))));
+    __m128i clean = _mm_andnot_si128(_mm_or_si128(control, special), ascii);
+    return uint(_mm_movemask_epi8(clean));
+}
+#endif
+
+#ifdef XLSX_HAVE_AVX2
+inline uint cleanMask(__m256i v)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(short(0xFF80))), zero);
+    __m256i control = _mm256_cmpeq_epi16(_mm256_and_si256(v, _mm256_set1_epi16(short(0xFFE0))), zero);
+    __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(v, _mm256_set1_epi16('<')),
+                                                      _mm256_cmpeq_epi16(v, _mm256_set1_epi16('>'))),
+                                      _mm256_or_si256(_mm256_cmpeq_epi16(v, _mm256_set1_epi16('&')),
+                                                      _mm256_cmpeq_epi16(v, _mm256_set1_epi16('"'))));
+    __m256i clean = _mm256_andnot_si256(_mm256_or_si256(control, special), ascii);
+    return uint(_mm256_movemask_epi8(clean));
+}
+#endif
+
+} //namespace
+
+/*
+ * \internal
+ *
+ * Escape the UTF-16 string \a src for xml and write it as UTF-8 to \a dst,
+ * which must hold at least (size * 6 + 16) bytes.
+ * Returns the end of the written data.
+ *
+ * Runs of plain ASCII characters are checked and copied 16 (AVX2) or
+ * 8 (SSE2) characters at a time, other characters are handled one by one.
+ */
+char *escapeXmlToUtf8(const ushort *src, int size, char *dst, bool attribute)
+{
+    int i = 0;
+
+#ifdef XLSX_HAVE_AVX2
+    while (i + 16 <= size) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        uint mask = cleanMask(v);
+        //Pack to bytes, the dirty ones will be overwritten
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), bytes);
+        if (mask == 0xFFFFFFFFu) {
+            dst += 16;
+            i += 16;
+            continue;
+        }
+        int clean = countTrailingZeros(~mask) / 2;
+        dst += clean;
+        i += clean;
+        i += escapeOne(src, i, size, dst, attribute);
+    }
+#endif
+
+#ifdef XLSX_HAVE_SSE2
+    while (i + 8 <= size) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        uint mask = cleanMask(v);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(v, v));
+        if (mask == 0xFFFFu) {
+            dst += 8;
+            i += 8;
+            continue;
+        }
+        int clean = countTrailingZeros(~mask) / 2;
+        dst += clean;
+        i += clean;
+        i += escapeOne(src, i, size, dst, attribute);
+    }
+#endif
+
+    while (i < size) {
+        ushort c = src[i];
+        if (c < 0x80 && cleanAscii.clean[c]) {
+            *dst++ = char(c);
+            ++i;
+        } else {
+            i += escapeOne(src, i, size, dst, attribute);
+        }
+    }
+
+    return dst;
+}
+
+/*!
+ * \internal
+ * \class XmlEmitter
+ */
+
+XmlEmitter::XmlEmitter(QIODevice *device)
+    : m_device(device), m_buffer(emitterBufferSize, Qt::Uninitialized), m_size(0)
+{
+    m_data = m_buffer.data();
+}
+
+XmlEmitter::~XmlEmitter()
+{
+    flush();
+}
+
+/*
+ * Same as QXmlStreamWriter::writeStartDocument("1.0", true)
+ */
+void XmlEmitter::writeStartDocument()
+{
+    writeRaw("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>");
+}
+
+/*
+ * Write the pending data to the device.
+ */
+void XmlEmitter::flush()
+{
+    if (m_size) {
+        m_device->write(m_data, m_size);
+        m_size = 0;
+    }
+}
+
+/*
+ * Make sure that \a size more bytes can be appended to the buffer.
+ */
+void XmlEmitter::reserve(int size)
+{
+    flush();
+    if (size > m_buffer.size()) {
+        m_buffer.resize(size);
+        m_data = m_buffer.data();
+    }
+}
+
+/*
+ * Write \a string which is known to contain plain ASCII characters
+ * only, such as a cell reference or a number.
+ */
+void XmlEmitter::writeLatin1(const QString &string)
+{
+    const int size = string.size();
+    if (m_size + size > m_buffer.size())
+        reserve(size);
+    const QChar *src = string.constData();
+    for (int i = 0; i < size; ++i)
+        m_data[m_size + i] = src[i].toLatin1();
+    m_size += size;
+}
+
+void XmlEmitter::writeEscaped(const QString &string, bool attribute)
+{
+    const int size = string.size();
+    const int needed = size * maxBytesPerUnit + storeSlack;
+    if (m_size + needed > m_buffer.size())
+        reserve(needed);
+
+    const ushort *src = reinterpret_cast<const ushort *>(string.constData());
+    char *end = escapeXmlToUtf8(src, size, m_data + m_size, attribute);
+    m_size = int(end - m_data);
+}
+
+/*
+ * Write the escaped element content \a text.
+ */
+void XmlEmitter::writeText(const QString &text)
+{
+    writeEscaped(text, false);
+}
+
+/*
+ * Write the escaped attribute \a value, without the quotes.
+ */
+void XmlEmitter::writeAttributeValue(const QString &value)
+{
+    writeEscaped(value, true);
+}
+
+void XmlEmitter::writeInteger(qint64 value)
+{
+    char digits[24];
+    int n = 0;
+    quint64 v = value < 0 ? quint64(0) - quint64(value) : quint64(value);
+    do {
+        digits[n++] = char('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        digits[n++] = '-';
+
+    if (m_size + n > m_buffer.size())
+        reserve(n);
+    for (int i = 0; i < n; ++i)
+        m_data[m_size + i] = digits[n - 1 - i];
+    m_size += n;
+}
+
+/*
+ * Write \a value in its shortest round-trip form.
+ */
+void XmlEmitter::writeDouble(double value)
+{
+    if (m_size + XLSX_DOUBLE_BUFFER_SIZE > m_buffer.size())
+        reserve(XLSX_DOUBLE_BUFFER_SIZE);
+    m_size += formatXsdDouble(value, m_data + m_size);
+}
+
+/*
+ * Same as CellReference(row, column).toString(),
+ * without any temporary string.
+ */
+void XmlEmitter::writeCellReference(int row, int column)
+{
+    char letters[8];
+    int pos = int(sizeof(letters));
+    while (column) {
+        int remainder = column % 26;
+        if (remainder == 0)
+            remainder = 26;
+        letters[--pos] = char('A' + remainder - 1);
+        column = (column - 1) / 26;
+    }
+    writeRaw(letters + pos, int(sizeof(letters)) - pos);
+    writeInteger(row);
+}
+
+QT_END_NAMESPACE_XLSX
@@ -4,35 +4,82 @@
 
 #include <QtGlobal>
 #include <QObject>
-#include <QVector>
-#include <QList>
+#include <QIODevice>
+#include <QTcpSocket>
+#include <QByteArray>
 
 #include "recurse.hpp"
 
 #include "xlsxdocument.h"
-#include "xlsxchartsheet.h"
-#include "xlsxcellrange.h"
-#include "xlsxchart.h"
-#include "xlsxrichstring.h"
 #include "xlsxworkbook.h"
 #include "xlsxabstractsheet.h"
-#include "xlsxcelllocation.h"
-#include "xlsxcell.h"
+#include "xlsxworksheet.h"
+#include "xlsxhtmlexporter.h"
 using namespace QXlsx;
 
-QString getHtml(QString strFilename);
-bool loadXlsx(QString fileName, QString& strHtml);
-QString g_htmlDoc;
+// Sends what is written to it as the chunks of an HTTP response
+// with "Transfer-Encoding: chunked", so the browser shows the first
+// rows of a sheet while the next ones are still being written.
+class ChunkedResponse : public QIODevice
+{
+public:
+    explicit ChunkedResponse(QTcpSocket *socket)
+        : m_socket(socket)
+    {
+        open(QIODevice::WriteOnly);
+    }
+
+    void finish()
+    {
+        m_socket->write("0\r\n\r\n");
+        m_socket->flush();
+    }
+
+protected:
+    qint64 readData(char *, qint64) { return -1; }
+
+    qint64 writeData(const char *data, qint64 size)
+    {
+        if (size <= 0)
+            return 0;
+        m_socket->write(QByteArray::number(size, 16) + "\r\n");
+        m_socket->write(data, size);
+        m_socket->write("\r\n");
+        m_socket->flush();
+        return size;
+    }
+
+private:
+    QTcpSocket *m_socket;
+};
+
+bool writeHtml(Document &xlsxDoc, QIODevice *device);
 
 int main(int argc, char *argv[])
 {
-    g_htmlDoc = getHtml(":/test.xlsx"); // convert from xlsx to html
-
     Recurse::Application app(argc, argv);
 
-    app.use([](auto &ctx)
+    // loaded once, each request streams the sheets from it
+    Document xlsxDoc(":/test.xlsx");
+    if (!xlsxDoc.isLoadPackage())
+    {
+        qDebug() << "failed to load test.xlsx";
+        return (-1);
+    }
+
+    app.use([&xlsxDoc](auto &ctx)
     {
-        ctx.response.send(g_htmlDoc);
+        QTcpSocket *socket = ctx.request.socket;
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/html; charset=utf-8\r\n"
+                      "Transfer-Encoding: chunked\r\n"
+                      "Connection: close\r\n"
+                      "\r\n");
+
+        ChunkedResponse response(socket);
+        writeHtml(xlsxDoc, &response);
+        response.finish();
+        socket->disconnectFromHost();
     });
 
     quint16 listenPort = 3001; // default port
@@ -47,120 +94,28 @@ int main(int argc, char *argv[])
     return 0;
 }
 
-QString getHtml(QString strFilename)
+bool writeHtml(Document &xlsxDoc, QIODevice *device)
 {
-    QString ret;
-
-    ret = ret + QString("<html>\n");
-
-    ret = ret + QString("<head>\n");
-    ret = ret + QString("<title>") + strFilename + QString("</title>\n");
-    ret = ret + QString("<meta http-equiv='Content-Type' content='text/html;charset=UTF-8'>\n" );
-    ret = ret + QString("</head>\n");
-
-    ret = ret + QString("<body>\n");
-
-    QString strTableStyle = \
-        "<style>\n"\
-        " table { border-collapse: collapse; } \n"\
-        " td, th { border: 1px solid black; } \n"\
-        "</style>\n";
-    ret = ret + strTableStyle;
-
-    if (!loadXlsx(strFilename, ret))
-        return QString("");
-
-    ret = ret + QString("</body>\n");
-
-    ret = ret + QString("</html>\n");
-
-    qDebug() <<  ret << "\n";
-
-    return ret;
-}
-
-bool loadXlsx(QString fileName, QString& strHtml)
-{
-    // tried to load xlsx using temporary document
-    QXlsx::Document xlsxTmp( fileName );
-    if ( !xlsxTmp.isLoadPackage() )
-    {
-        return false; // failed to load
-    }
-
-    // load new xlsx using new document
-    QXlsx::Document xlsxDoc( fileName );
-    xlsxDoc.isLoadPackage();
+    device->write("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+                  "<title>test.xlsx</title>\n</head>\n<body>\n");
 
     int sheetIndexNumber = 0;
-    foreach( QString curretnSheetName, xlsxDoc.sheetNames() )
+    foreach( QString currentSheetName, xlsxDoc.sheetNames() )
     {
-        QXlsx::AbstractSheet* currentSheet = xlsxDoc.sheet( curretnSheetName );
-        if ( NULL == currentSheet )
+        AbstractSheet* currentSheet = xlsxDoc.sheet( currentSheetName );
+        if ( NULL == currentSheet || currentSheet->sheetType() != AbstractSheet::ST_WorkSheet )
             continue;
 
-        // get full cells of sheet
-        int maxRow = -1;
-        int maxCol = -1;
-        currentSheet->workbook()->setActiveSheet( sheetIndexNumber );
-        Worksheet* wsheet = (Worksheet*) currentSheet->workbook()->activeSheet();
-        if ( NULL == wsheet )
-            continue;
+        Worksheet* wsheet = static_cast<Worksheet*>( currentSheet );
+        device->write("<b>" + wsheet->sheetName().toHtmlEscaped().toUtf8() + "</b><br>\n");
 
-        QString strSheetName = wsheet->sheetName(); // sheet name
-        strHtml = strHtml + QString("<b>") + strSheetName + QString("</b><br>\n"); // UTF-8
-
-        strHtml = strHtml + QString("<table>");
-
-        QVector<CellLocation> clList = wsheet->getFullCells( &maxRow, &maxCol );
-
-        QVector< QVector<QString> > cellValues;
-        for (int rc = 0; rc < maxRow; rc++)
-        {
-            QVector<QString> tempValue;
-            for (int cc = 0; cc < maxCol; cc++)
-            {
-                tempValue.push_back(QString(""));
-            }
-            cellValues.push_back(tempValue);
-        }
-
-        for ( int ic = 0; ic < clList.size(); ++ic )
-         {
-            // cell location
-            CellLocation cl = clList.at(ic);
-
-            int row = cl.row - 1;
-            int col = cl.col - 1;
-
-            QSharedPointer<Cell> ptrCell = cl.cell; // cell pointer
-
-            // value of cell
-            QVariant var = cl.cell.data()->value();
-            QString str = var.toString();
-
-            cellValues[row][col] = str;
-        }
-
-        QString strTableRecord;
-        for (int rc = 0; rc < maxRow; rc++)
-        {
-            strTableRecord = strTableRecord + QString("<tr>");
-            for (int cc = 0; cc < maxCol; cc++)
-            {
-                QString strTemp = cellValues[rc][cc];
-                strTableRecord = strTableRecord + QString("<td>");
-                strTableRecord = strTableRecord + strTemp; // UTF-8
-                strTableRecord = strTableRecord + QString("</td>");
-            }
-            strTableRecord = strTableRecord + QString("</tr>\n");
-        }
-        strHtml = strHtml + strTableRecord;
-
-        strHtml = strHtml + QString("</table>\n");
-
-        sheetIndexNumber++;
+        // each table needs its own classes on the page
+        HtmlExporter exporter( wsheet );
+        exporter.setClassPrefix( QString("sheet%1").arg(sheetIndexNumber++) );
+        if ( !exporter.exportTable( device ) )
+            return false;
     }
 
+    device->write("</body>\n</html>\n");
     return true;
 }
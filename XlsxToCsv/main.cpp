@@ -0,0 +1,103 @@
+// main.cpp
+// QXlsx // MIT License // https://github.com/j2doll/QXlsx
+//
+// Converts a sheet of an xlsx file to CSV or TSV.
+// Without an output file, the records are written to the standard output.
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QtCore>
+#include <QFile>
+
+#include <iostream>
+using namespace std;
+
+#include "xlsxdocument.h"
+#include "xlsxworksheet.h"
+#include "xlsxcsvoptions.h"
+using namespace QXlsx;
+
+static int usage()
+{
+    cout << "usage: XlsxToCsv [--sheet name] [--tsv] [--bom] [--raw] [--range A1:D10] input.xlsx [output.csv]" << endl
+         << "  --sheet  sheet to convert, the current one by default" << endl
+         << "  --tsv    separate the fields with tabs" << endl
+         << "  --bom    start with a UTF-8 byte order mark" << endl
+         << "  --raw    write the numbers as stored, without their number formats" << endl
+         << "  --range  cells to convert, the whole sheet by default" << endl;
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    CsvOptions options;
+    QString sheetName;
+    QStringList files;
+    while (!args.isEmpty())
+    {
+        QString arg = args.takeFirst();
+        if (arg == "--tsv")
+            options.delimiter = '\t';
+        else if (arg == "--bom")
+            options.writeByteOrderMark = true;
+        else if (arg == "--raw")
+            options.applyNumberFormats = false;
+        else if (arg == "--sheet" && !args.isEmpty())
+            sheetName = args.takeFirst();
+        else if (arg == "--range" && !args.isEmpty())
+            options.range = CellRange(args.takeFirst());
+        else if (arg.startsWith("--"))
+            return usage();
+        else
+            files.append(arg);
+    }
+    if (files.isEmpty() || files.size() > 2)
+        return usage();
+
+    Document xlsx(files.at(0));
+    if (!xlsx.load())
+    {
+        cerr << "cannot read " << qPrintable(files.at(0)) << endl;
+        return 2;
+    }
+    if (!sheetName.isEmpty() && !xlsx.selectSheet(sheetName))
+    {
+        cerr << "no sheet " << qPrintable(sheetName) << endl;
+        return 2;
+    }
+    Worksheet *sheet = xlsx.currentWorksheet();
+    if (!sheet)
+    {
+        cerr << "the sheet is not a worksheet" << endl;
+        return 2;
+    }
+
+    QFile output;
+    bool opened;
+    if (files.size() > 1)
+    {
+        output.setFileName(files.at(1));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    else
+    {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened)
+    {
+        cerr << "cannot write " << qPrintable(files.value(1, "to the standard output")) << endl;
+        return 2;
+    }
+
+    if (!sheet->exportCsv(&output, options))
+    {
+        cerr << "write error" << endl;
+        return 3;
+    }
+    return 0;
+}